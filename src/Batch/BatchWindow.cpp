@@ -6,7 +6,7 @@ BatchWindow::BatchWindow(QWidget *parent, const QString &fileName)
     this->setObjectName("Batch Window");
 
     qRegisterMetaType<Message>("Message");
-    qRegisterMetaType<GriddedData>("GriddedData");
+    qRegisterMetaType<GriddedDataPtr>("GriddedDataPtr");
     qRegisterMetaType<VortexList>("VortexList");
 
     std::cout << "Starting main window ... \n";
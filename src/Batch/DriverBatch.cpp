@@ -108,7 +108,7 @@ bool DriverBatch::run()
     connect(pollThread, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)));
 
     connect(pollThread, SIGNAL(newVCP(const int)),diagPanel, SLOT(updateVCP(const int)));
-    connect(pollThread, SIGNAL(newCappi(GriddedData)),cappiDisplay, SLOT(constructImage(GriddedData)),Qt::DirectConnection);
+    connect(pollThread, SIGNAL(newCappi(GriddedDataPtr)),cappiDisplay, SLOT(constructImage(GriddedDataPtr)),Qt::DirectConnection);
 
     connect(pollThread, SIGNAL(newCappiInfo(float, float, float, float, float, float, float ,float ,float, float)),
             this, SLOT(updateCappiInfo(float, float, float, float, float, float, float ,float ,float, float)),Qt::DirectConnection);
@@ -0,0 +1,319 @@
+/*
+ * DriverBenchmark.cpp
+ * VORTRAC
+ *
+ * Copyright 2026 University Corporation for Atmospheric Research.
+ * All rights reserved.
+ *
+ */
+
+#include "DriverBenchmark.h"
+#include <QDir>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <iostream>
+#include <cstdlib>
+#include <sys/resource.h>
+#include "Threads/workThread.h"
+#include "DataObjects/GriddedData.h"
+#include "DataObjects/Coefficient.h"
+
+DriverBenchmark::DriverBenchmark(const QString &benchmarkFile, QObject *parent)
+    : QObject(parent)
+{
+    this->setObjectName("Benchmark Driver");
+    xmlfile = benchmarkFile;
+    logFile = NULL;
+    caseVolumes = 0;
+    caseVortex = NULL;
+
+    benchmarkConfig = new Configuration;
+    connect(benchmarkConfig, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)),
+            Qt::DirectConnection);
+}
+
+DriverBenchmark::~DriverBenchmark()
+{
+    delete benchmarkConfig;
+    delete logFile;
+    delete caseVortex;
+}
+
+bool DriverBenchmark::initialize()
+{
+    qRegisterMetaType<Message>("Message");
+    qRegisterMetaType<GriddedDataPtr>("GriddedDataPtr");
+    qRegisterMetaType<VortexList>("VortexList");
+    qRegisterMetaType<VolumeMetrics>("VolumeMetrics");
+
+    if (!benchmarkConfig->read(xmlfile)) {
+        std::cerr << "Couldn't load benchmark file " << xmlfile.toStdString() << std::endl;
+        return false;
+    }
+
+    // Relative paths are taken from where the benchmark file is
+    QDir benchmarkDir = QFileInfo(xmlfile).absoluteDir();
+    QDomElement benchmark = benchmarkConfig->getConfig("benchmark");
+    mainConfigFile = benchmarkDir.absoluteFilePath(benchmarkConfig->getParam(benchmark, "config"));
+    analyticConfigFile = benchmarkDir.absoluteFilePath(benchmarkConfig->getParam(benchmark, "analytic"));
+    outputDir = benchmarkDir.absoluteFilePath(benchmarkConfig->getParam(benchmark, "dir"));
+
+    if (!QDir().mkpath(outputDir)) {
+        std::cerr << "Failed to find or create benchmark directory: "
+                  << outputDir.toStdString() << std::endl;
+        return false;
+    }
+
+    logFile = new QFile(QDir(outputDir).filePath("benchmark.log"));
+    if (!logFile->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::cerr << "Can't open log file " << logFile->fileName().toStdString() << std::endl;
+        delete logFile;
+        logFile = NULL;
+    }
+    catchLog(Message("VORTRAC benchmark "+xmlfile+" started "
+                     +QDateTime::currentDateTime().toUTC().toString()+ " UTC"));
+    return true;
+}
+
+int DriverBenchmark::run()
+{
+    int failed = 0;
+    int caseNumber = 0;
+    QDomElement benchmarkCase = benchmarkConfig->getRoot().firstChildElement("case");
+    for (; !benchmarkCase.isNull(); benchmarkCase = benchmarkCase.nextSiblingElement("case")) {
+        caseNumber++;
+        if (!runCase(benchmarkCase, caseNumber))
+            failed++;
+    }
+
+    if (logFile != NULL)
+        logFile->flush();
+    if (failed > 0) {
+        std::cerr << failed << " benchmark cases could not be run" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+bool DriverBenchmark::runCase(const QDomElement& benchmarkCase, int caseNumber)
+{
+    QString name = benchmarkCase.attribute("name");
+    if (name.isEmpty())
+        name = "case" + QString().setNum(caseNumber);
+    QString caseDir = QDir(outputDir).filePath(name);
+    if (!QDir().mkpath(caseDir)) {
+        std::cerr << "Failed to create case directory " << caseDir.toStdString() << std::endl;
+        return false;
+    }
+
+    Configuration mainConfig;
+    Configuration analyticConfig;
+    if (!setupCase(benchmarkCase, caseDir, mainConfig, analyticConfig))
+        return false;
+
+    caseMetrics.clear();
+    caseMetrics.setVolume(name);
+    caseVolumes = 0;
+    delete caseVortex;
+    caseVortex = NULL;
+
+    catchLog(Message("Benchmark case " + name));
+
+    // Same as a headless run, on this thread without an event loop
+    workThread *pollThread = new workThread;
+    connect(pollThread, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)),
+            Qt::DirectConnection);
+    connect(pollThread, SIGNAL(volumeMetrics(const VolumeMetrics&)),
+            this, SLOT(catchMetrics(const VolumeMetrics&)), Qt::DirectConnection);
+    connect(pollThread, SIGNAL(vortexListUpdate(VortexList*)),
+            this, SLOT(catchVortexList(VortexList*)), Qt::DirectConnection);
+
+    QElapsedTimer wallClock;
+    wallClock.start();
+    pollThread->setConfig(&mainConfig);
+    pollThread->setContinuePreviousRun(false);
+    pollThread->setOnlyRunOnce(true);
+    pollThread->run();
+    qint64 wallMsecs = wallClock.elapsed();
+    delete pollThread;
+
+    QString record = caseRecord(name, mainConfig, analyticConfig, wallMsecs);
+    std::cout << record.toStdString() << std::endl;
+    QFile results(QDir(outputDir).filePath("benchmark.json"));
+    if (!results.open(QIODevice::Append | QIODevice::Text)) {
+        std::cerr << "Can't write " << results.fileName().toStdString() << std::endl;
+        return false;
+    }
+    results.write((record + "\n").toUtf8());
+    return (caseVolumes > 0);
+}
+
+bool DriverBenchmark::setupCase(const QDomElement& benchmarkCase, const QString& caseDir,
+                                Configuration& mainConfig, Configuration& analyticConfig)
+{
+    if (!mainConfig.read(mainConfigFile)) {
+        std::cerr << "Couldn't load configuration file " << mainConfigFile.toStdString() << std::endl;
+        return false;
+    }
+    if (!analyticConfig.read(analyticConfigFile)) {
+        std::cerr << "Couldn't load analytic storm file " << analyticConfigFile.toStdString() << std::endl;
+        return false;
+    }
+
+    // Case overrides, analysis groups first
+    QDomElement overrides = benchmarkCase.firstChildElement();
+    for (; !overrides.isNull(); overrides = overrides.nextSiblingElement()) {
+        QDomElement group = mainConfig.getRoot().firstChildElement(overrides.tagName());
+        if (!group.isNull()) {
+            overrideParams(mainConfig, group, overrides);
+            continue;
+        }
+        group = analyticConfig.getRoot().firstChildElement(overrides.tagName());
+        if (!group.isNull()) {
+            overrideParams(analyticConfig, group, overrides);
+            continue;
+        }
+        catchLog(Message("Benchmark: no configuration group named " + overrides.tagName()));
+    }
+
+    // A synthetic volume goes through the whole analysis, without data
+    // feeds or saved centers
+    QDomElement vortex = mainConfig.getConfig("vortex");
+    if (mainConfig.getParam(vortex, "mode") == "operational")
+        mainConfig.setParam(vortex, "mode", "manual");
+    if (!mainConfig.getElement(vortex, "centers").isNull())
+        mainConfig.setParam(vortex, "centers", "");
+    QDomElement radar = mainConfig.getConfig("radar");
+    if (!mainConfig.getElement(radar, "pre_gridded").isNull())
+        mainConfig.setParam(radar, "pre_gridded", "false");
+
+    // Everything is written into the case directory, the radar reads the
+    // case's analytic storm
+    QString analyticFile = QDir(caseDir).filePath("analytic.xml");
+    QDomElement group = mainConfig.getRoot().firstChildElement();
+    for (; !group.isNull(); group = group.nextSiblingElement()) {
+        if ((group.tagName() == "radar") || (group.tagName() == "pressure"))
+            continue;
+        if (!mainConfig.getElement(group, "dir").isNull())
+            mainConfig.setParam(group, "dir", caseDir);
+    }
+    mainConfig.setParam(radar, "format", "MODEL");
+    mainConfig.setParam(radar, "dir", analyticFile);
+
+    return analyticConfig.write(analyticFile)
+        && mainConfig.write(QDir(caseDir).filePath("vortrac.xml"));
+}
+
+void DriverBenchmark::overrideParams(Configuration& config, const QDomElement& group,
+                                     const QDomElement& overrides)
+{
+    QDomElement param = overrides.firstChildElement();
+    for (; !param.isNull(); param = param.nextSiblingElement()) {
+        if (config.getElement(group, param.tagName()).isNull())
+            config.addDom(group, param.tagName(), param.text());
+        else
+            config.setParam(group, param.tagName(), param.text());
+    }
+}
+
+QString DriverBenchmark::caseRecord(const QString& name, Configuration& mainConfig,
+                                    Configuration& analyticConfig, qint64 wallMsecs)
+{
+    QDomElement cappi = mainConfig.getConfig("cappi");
+    QDomElement vortex = mainConfig.getConfig("vortex");
+    QDomElement radar = analyticConfig.getConfig("analytic_radar");
+    QDomElement winds = analyticConfig.getConfig("wind_field");
+
+    QString record = "{\"case\":" + VolumeMetrics::jsonString(name);
+    record += ",\"grid\":[" + mainConfig.getParam(cappi, "xdim") + ","
+        + mainConfig.getParam(cappi, "ydim") + "," + mainConfig.getParam(cappi, "zdim") + "]";
+    record += ",\"sweeps\":" + analyticConfig.getParam(radar, "numsweeps");
+    record += ",\"gates\":" + analyticConfig.getParam(radar, "numgates");
+    QString seed = analyticConfig.getParam(radar, "seed");
+    record += ",\"seed\":" + (seed.isEmpty() ? QString("null") : seed);
+    record += ",\"volumes\":" + QString().setNum(caseVolumes);
+
+    record += ",\"stage_ms\":" + caseMetrics.stageJson();
+    record += ",\"counts\":" + caseMetrics.countJson();
+    record += ",\"wall_ms\":" + QString().setNum(wallMsecs);
+    record += ",\"peak_rss_kb\":" + QString().setNum(peakRss());
+
+    // Errors against the analytic storm, which is centered on the
+    // configured vortex position
+    if (caseVortex != NULL) {
+        int level = caseVortex->getBestLevel();
+        float truthLat = mainConfig.getParam(vortex, "lat").toFloat();
+        float truthLon = mainConfig.getParam(vortex, "lon").toFloat();
+        float truthRmw = analyticConfig.getParam(winds, "rmw").toFloat();
+        float truthVt = analyticConfig.getParam(winds, "vt0").toFloat();
+
+        float maxVt = -999;
+        for (int r = 0; r < caseVortex->getNumRadii(); r++) {
+            float vt = caseVortex->getCoefficient(level, r, Coefficient::VTC0).getValue();
+            if ((vt != -999) && (vt > maxVt))
+                maxVt = vt;
+        }
+
+        QString value;
+        record += ",\"center_error_km\":" + value.setNum(GriddedData::getCartesianDistance(
+            truthLat, truthLon, caseVortex->getLat(level), caseVortex->getLon(level)));
+        record += ",\"rmw_error_km\":" + value.setNum(caseVortex->getRMW(level) - truthRmw);
+        if (maxVt != -999)
+            record += ",\"vt_error\":" + value.setNum(maxVt - truthVt);
+        else
+            record += ",\"vt_error\":null";
+        record += ",\"pressure\":" + value.setNum(caseVortex->getPressure());
+        record += ",\"pressure_uncertainty\":" + value.setNum(caseVortex->getPressureUncertainty());
+    } else {
+        record += ",\"center_error_km\":null,\"rmw_error_km\":null,\"vt_error\":null"
+            ",\"pressure\":null,\"pressure_uncertainty\":null";
+    }
+    record += "}";
+    return record;
+}
+
+long DriverBenchmark::peakRss()
+{
+    // High water mark of the whole process so far, in kB on Linux. Run the
+    // cases from small to large for it to mean something per case.
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+void DriverBenchmark::catchMetrics(const VolumeMetrics& metrics)
+{
+    caseVolumes++;
+    caseMetrics.add(metrics);
+}
+
+void DriverBenchmark::catchVortexList(VortexList* list)
+{
+    if ((list == NULL) || list->isEmpty())
+        return;
+    if (caseVortex == NULL)
+        caseVortex = new VortexData(list->last());
+    else
+        *caseVortex = list->last();
+}
+
+void DriverBenchmark::catchLog(const Message& message)
+{
+    // The analysis messages only go to the log file, the case results
+    // are what ends up on stdout
+    Message entry(message);
+    QString text = entry.getLogMessage();
+    if (text.isEmpty())
+        return;
+
+    QMutexLocker locker(&logMutex);
+    if (logFile != NULL) {
+        logFile->write((text + "\n").toLatin1());
+    }
+}
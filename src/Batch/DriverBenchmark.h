@@ -0,0 +1,90 @@
+/*
+ * DriverBenchmark.h
+ * VORTRAC
+ *
+ * Copyright 2026 University Corporation for Atmospheric Research.
+ * All rights reserved.
+ *
+ */
+
+#ifndef DRIVERBENCHMARK_H
+#define DRIVERBENCHMARK_H
+
+#include <QObject>
+#include <QString>
+#include <QDomElement>
+#include <QFile>
+#include <QMutex>
+
+#include "Config/Configuration.h"
+#include "IO/Message.h"
+#include "IO/VolumeMetrics.h"
+#include "DataObjects/VortexList.h"
+
+// Runs the analysis on a family of synthetic storms so performance changes
+// can be judged without real radar data. The benchmark file is a vortrac
+// XML file:
+//
+//   <vortrac>
+//     <benchmark>
+//       <config>base analysis configuration, its radar format is ignored</config>
+//       <analytic>base analytic storm configuration</analytic>
+//       <dir>output directory</dir>
+//     </benchmark>
+//     <case name="small">
+//       <cappi><xdim>100</xdim><ydim>100</ydim></cappi>
+//       <analytic_radar><numsweeps>5</numsweeps><seed>1</seed></analytic_radar>
+//       <wind_field><vt1>0.2</vt1></wind_field>
+//     </case>
+//     ...
+//   </vortrac>
+//
+// Every group in a case overrides parameters of the group with the same
+// name in the analysis configuration or, failing that, in the analytic
+// storm configuration. The analysis always runs as a manual run on the
+// analytic radar, whatever the base configuration says. Cases run in the order given, each in its own
+// directory under dir, and one JSON line per case is appended to
+// dir/benchmark.json with the stage times, work counts, peak RSS and the errors
+// against the analytic truth.
+
+class DriverBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    DriverBenchmark(const QString &benchmarkFile, QObject *parent = 0);
+    ~DriverBenchmark();
+    bool initialize();
+    int run();
+
+public slots:
+    void catchLog(const Message& message);
+    void catchMetrics(const VolumeMetrics& metrics);
+    void catchVortexList(VortexList* list);
+
+private:
+    bool runCase(const QDomElement& benchmarkCase, int caseNumber);
+    bool setupCase(const QDomElement& benchmarkCase, const QString& caseDir,
+                   Configuration& mainConfig, Configuration& analyticConfig);
+    static void overrideParams(Configuration& config, const QDomElement& group,
+                               const QDomElement& overrides);
+    QString caseRecord(const QString& name, Configuration& mainConfig,
+                       Configuration& analyticConfig, qint64 wallMsecs);
+    static long peakRss();
+
+    QString xmlfile;
+    Configuration *benchmarkConfig;
+    QString mainConfigFile;
+    QString analyticConfigFile;
+    QString outputDir;
+    QFile *logFile;
+    QMutex logMutex;
+
+    // Results of the case being run
+    VolumeMetrics caseMetrics;
+    int caseVolumes;
+    // Last vortex of the case, too large for the stack
+    VortexData *caseVortex;
+};
+
+#endif // DRIVERBENCHMARK_H
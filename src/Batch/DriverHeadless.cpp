@@ -0,0 +1,114 @@
+/*
+ * DriverHeadless.cpp
+ * VORTRAC
+ *
+ * Copyright 2026 University Corporation for Atmospheric Research.
+ * All rights reserved.
+ *
+ */
+
+#include "DriverHeadless.h"
+#include <QDir>
+#include <QDateTime>
+#include <QMutexLocker>
+#include <iostream>
+#include <cstdlib>
+#include "Threads/workThread.h"
+#include "DataObjects/GriddedData.h"
+#include "DataObjects/VortexList.h"
+
+DriverHeadless::DriverHeadless(const QString &configFile, const QStringList &inputFiles,
+                               QObject *parent)
+    : QObject(parent)
+{
+    this->setObjectName("Headless Driver");
+    xmlfile = configFile;
+    files = inputFiles;
+    logFile = NULL;
+
+    // Log messages come in from the worker threads, so every connection
+    // is direct and catchLog does its own locking
+    configData = new Configuration;
+    connect(configData, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)),
+            Qt::DirectConnection);
+}
+
+DriverHeadless::~DriverHeadless()
+{
+    delete configData;
+    delete logFile;
+}
+
+bool DriverHeadless::initialize()
+{
+    qRegisterMetaType<Message>("Message");
+    qRegisterMetaType<GriddedDataPtr>("GriddedDataPtr");
+    qRegisterMetaType<VortexList>("VortexList");
+
+    if (!configData->read(xmlfile)) {
+        std::cerr << "Couldn't load configuration file " << xmlfile.toStdString() << std::endl;
+        return false;
+    }
+
+    QString mode = configData->getParam(configData->getConfig("vortex"), "mode");
+    if (mode == "operational") {
+        std::cerr << "Operational mode needs the batch window for its data feeds" << std::endl;
+        return false;
+    }
+
+    // Working directory, as in DriverBatch::loadFile
+    QString directoryString(configData->getParam(configData->getConfig("vortex"), "dir"));
+    QDir workingDirectory(directoryString);
+    if (!workingDirectory.isAbsolute())
+        workingDirectory.makeAbsolute();
+    if (!workingDirectory.exists() && !workingDirectory.mkpath(directoryString)) {
+        std::cerr << "Failed to find or create working directory path: "
+                  << directoryString.toStdString() << std::endl;
+        return false;
+    }
+
+    QString logFileName = "VORTRAC_status_"
+        + QDateTime::currentDateTime().toUTC().toString("yyMMddhhmmss") + ".log";
+    logFile = new QFile(workingDirectory.filePath(logFileName));
+    if (!logFile->open(QIODevice::Append)) {
+        std::cerr << "Can't open log file " << logFile->fileName().toStdString() << std::endl;
+        delete logFile;
+        logFile = NULL;
+    }
+    catchLog(Message("VORTRAC Status Log for "+QDateTime::currentDateTime().toUTC().toString()+ " UTC"));
+
+    return true;
+}
+
+int DriverHeadless::run()
+{
+    // No event loop is running, so nothing may be queued to this thread
+    workThread *pollThread = new workThread;
+    connect(pollThread, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)),
+            Qt::DirectConnection);
+
+    pollThread->setConfig(configData);
+    pollThread->setContinuePreviousRun(false);
+    pollThread->setInputFiles(files);
+    pollThread->setOnlyRunOnce(true);
+    pollThread->run();
+
+    delete pollThread;
+    if (logFile != NULL)
+        logFile->flush();
+    return EXIT_SUCCESS;
+}
+
+void DriverHeadless::catchLog(const Message& message)
+{
+    Message entry(message);
+    QString text = entry.getLogMessage();
+    if (text.isEmpty())
+        return;
+
+    QMutexLocker locker(&logMutex);
+    std::cout << text.toStdString() << std::endl;
+    if (logFile != NULL) {
+        logFile->write((text + "\n").toLatin1());
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * DriverHeadless.h
+ * VORTRAC
+ *
+ * Copyright 2026 University Corporation for Atmospheric Research.
+ * All rights reserved.
+ *
+ */
+
+#ifndef DRIVERHEADLESS_H
+#define DRIVERHEADLESS_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QFile>
+#include <QMutex>
+
+#include "Config/Configuration.h"
+#include "IO/Message.h"
+
+// Runs the analysis without a QApplication, widgets or display sinks, so
+// batch jobs start quickly on machines without an X server. The work
+// thread runs on the calling thread and returns when the data is used up.
+
+class DriverHeadless : public QObject
+{
+    Q_OBJECT
+
+public:
+    DriverHeadless(const QString &configFile, const QStringList &inputFiles,
+                   QObject *parent = 0);
+    ~DriverHeadless();
+    bool initialize();
+    int run();
+
+public slots:
+    void catchLog(const Message& message);
+
+private:
+    QString xmlfile;
+    QStringList files;
+    Configuration *configData;
+    QFile *logFile;
+    QMutex logMutex;
+};
+
+#endif // DRIVERHEADLESS_H
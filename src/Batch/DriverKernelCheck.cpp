@@ -0,0 +1,451 @@
+/*
+ * DriverKernelCheck.cpp
+ * VORTRAC
+ *
+ * Copyright 2026 University Corporation for Atmospheric Research.
+ * All rights reserved.
+ *
+ */
+
+#include "DriverKernelCheck.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QVector>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include "Math/Matrix.h"
+#include "Math/LeastSquares.h"
+#include "VTD/VTD.h"
+#include "Radar/LdmLevelII.h"
+#include "Radar/AnalyticRadar.h"
+#include "NRL/RadarQC.h"
+#include "Radar/Ray.h"
+#include "IO/VolumeMetrics.h"
+
+DriverKernelCheck::DriverKernelCheck(const QString &kernel, const QStringList &arguments,
+                                     QObject *parent)
+    : QObject(parent)
+{
+    this->setObjectName("Kernel Check");
+    kernelName = kernel;
+    args = arguments;
+}
+
+int DriverKernelCheck::run()
+{
+    if (kernelName == "solver")
+        return checkSolver();
+    if (kernelName == "level2")
+        return checkLevelII();
+    if (kernelName == "qc")
+        return checkQC();
+
+    std::cerr << "Unknown kernel " << kernelName.toStdString()
+              << ", expected solver, level2 or qc" << std::endl;
+    return EXIT_FAILURE;
+}
+
+int DriverKernelCheck::checkSolver()
+{
+    // Rings of a few sizes, with as many coefficients as the VTD fits use
+    const int ringSizes[] = { 64, 360 };
+    const int numFits = 500;
+    srand(1);
+
+    bool agree = true;
+    for (int s = 0; s < 2; s++) {
+        for (int numCoeff = 3; numCoeff <= 11; numCoeff++) {
+            if (!compareSolver(numCoeff, ringSizes[s], numFits))
+                agree = false;
+        }
+    }
+    return agree ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+bool DriverKernelCheck::compareSolver(int numCoeff, int numData, int numFits)
+{
+    // numFits independent rings: a mean and the harmonics of azimuth with
+    // random amplitudes, plus noise. Every fit gets its own data so the
+    // timings aren't just cache hits.
+    QVector<float> xData(numFits * numCoeff * numData);
+    QVector<float> yData(numFits * numData);
+    QVector<float*> rows(numFits * numCoeff);
+    for (int f = 0; f < numFits; f++) {
+        float* y = yData.data() + f * numData;
+        float* x = xData.data() + f * numCoeff * numData;
+        for (int c = 0; c < numCoeff; c++)
+            rows[f * numCoeff + c] = x + c * numData;
+
+        float amplitude[11];
+        for (int c = 0; c < numCoeff; c++)
+            amplitude[c] = 40.0 * rand() / RAND_MAX - 20.0;
+        float offset = 2.0 * M_PI * rand() / RAND_MAX;
+        for (int i = 0; i < numData; i++) {
+            float azimuth = offset + 2.0 * M_PI * i / numData;
+            float value = 2.0 * rand() / RAND_MAX - 1.0;
+            for (int c = 0; c < numCoeff; c++) {
+                int wave = (c + 1) / 2;
+                float term;
+                if (c == 0)
+                    term = 1.0;
+                else if (c % 2 == 1)
+                    term = cos(wave * azimuth);
+                else
+                    term = sin(wave * azimuth);
+                x[c * numData + i] = term;
+                value += amplitude[c] * term;
+            }
+            y[i] = value;
+        }
+    }
+
+    QVector<float> oldCoeff(numFits * numCoeff), newCoeff(numFits * numCoeff);
+    QVector<float> oldError(numFits * numCoeff), newError(numFits * numCoeff);
+    QVector<float> oldDev(numFits), newDev(numFits);
+    QVector<bool> oldFit(numFits), newFit(numFits);
+
+    QElapsedTimer clock;
+    clock.start();
+    for (int f = 0; f < numFits; f++) {
+        float** x = rows.data() + f * numCoeff;
+        float* y = yData.data() + f * numData;
+        float* coeff = oldCoeff.data() + f * numCoeff;
+        float* stError = oldError.data() + f * numCoeff;
+        oldFit[f] = Matrix::lls(numCoeff, numData, x, y, oldDev[f], coeff, stError);
+    }
+    qint64 oldNsecs = clock.nsecsElapsed();
+
+    clock.restart();
+    for (int f = 0; f < numFits; f++) {
+        float** x = rows.data() + f * numCoeff;
+        float* y = yData.data() + f * numData;
+        float* coeff = newCoeff.data() + f * numCoeff;
+        float* stError = newError.data() + f * numCoeff;
+        newFit[f] = LeastSquares<VTD::MaxCoefficients>::lls(numCoeff, numData, x, y, newDev[f],
+                                                             coeff, stError);
+    }
+    qint64 newNsecs = clock.nsecsElapsed();
+
+    int mismatched = 0;
+    float maxCoeffDiff = 0, maxErrorDiff = 0, maxDevDiff = 0;
+    for (int f = 0; f < numFits; f++) {
+        if (oldFit[f] != newFit[f]) {
+            mismatched++;
+            continue;
+        }
+        if (!oldFit[f])
+            continue;
+        maxDevDiff = qMax(maxDevDiff, (float)fabs(oldDev[f] - newDev[f]));
+        for (int c = 0; c < numCoeff; c++) {
+            int n = f * numCoeff + c;
+            maxCoeffDiff = qMax(maxCoeffDiff, (float)fabs(oldCoeff[n] - newCoeff[n]));
+            maxErrorDiff = qMax(maxErrorDiff, (float)fabs(oldError[n] - newError[n]));
+        }
+    }
+
+    QString value;
+    QString record = "{\"kernel\":\"solver\"";
+    record += ",\"coeffs\":" + value.setNum(numCoeff);
+    record += ",\"points\":" + value.setNum(numData);
+    record += ",\"fits\":" + value.setNum(numFits);
+    record += ",\"lls_us\":" + value.setNum(oldNsecs / 1000.0 / numFits);
+    record += ",\"cholesky_us\":" + value.setNum(newNsecs / 1000.0 / numFits);
+    record += ",\"max_coeff_diff\":" + value.setNum(maxCoeffDiff);
+    record += ",\"max_stderror_diff\":" + value.setNum(maxErrorDiff);
+    record += ",\"max_stdev_diff\":" + value.setNum(maxDevDiff);
+    record += ",\"mismatched_fits\":" + value.setNum(mismatched);
+    record += "}";
+    std::cout << record.toStdString() << std::endl;
+    return (mismatched == 0);
+}
+
+int DriverKernelCheck::checkLevelII()
+{
+    if (args.size() != 1) {
+        std::cerr << "The level2 kernel needs a directory of LDM level II files" << std::endl;
+        return EXIT_FAILURE;
+    }
+    QDir dataDir(args[0]);
+    if (!dataDir.exists()) {
+        std::cerr << "Can't find " << args[0].toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int numFiles = 0, numFailed = 0;
+    qint64 totalBytes = 0, serialNsecs = 0, pipelinedNsecs = 0;
+    QStringList files = dataDir.entryList(QDir::Files | QDir::Readable, QDir::Name);
+    for (int f = 0; f < files.size(); f++) {
+        QString fileName = dataDir.filePath(files[f]);
+
+        // Read the file once up front so neither reader pays for the disk,
+        // and so the reader never has to report a short volume
+        QFile volumeFile(fileName);
+        if (!volumeFile.open(QIODevice::ReadOnly))
+            continue;
+        qint64 volumeBytes = volumeFile.readAll().size();
+        volumeFile.close();
+        if (volumeBytes < (qint64)sizeof(nexrad_vol_scan_title))
+            continue;
+
+        LdmLevelII serialVolume("KCHK", 0, 0, fileName);
+        serialVolume.setSerialDecompress(true);
+        QElapsedTimer clock;
+        clock.start();
+        bool serialRead = serialVolume.readVolume();
+        qint64 serialTime = clock.nsecsElapsed();
+
+        LdmLevelII pipelinedVolume("KCHK", 0, 0, fileName);
+        clock.restart();
+        bool pipelinedRead = pipelinedVolume.readVolume();
+        qint64 pipelinedTime = clock.nsecsElapsed();
+
+        if (!serialRead && !pipelinedRead) {
+            // Not a level II volume, or a corrupt one
+            continue;
+        }
+
+        int mismatched = -1;
+        if (serialRead == pipelinedRead)
+            mismatched = compareVolumes(&serialVolume, &pipelinedVolume);
+        if (mismatched != 0)
+            numFailed++;
+        numFiles++;
+        totalBytes += volumeBytes;
+        serialNsecs += serialTime;
+        pipelinedNsecs += pipelinedTime;
+
+        QString value;
+        QString record = "{\"kernel\":\"level2\"";
+        record += ",\"file\":" + VolumeMetrics::jsonString(files[f]);
+        record += ",\"bytes\":" + value.setNum(volumeBytes);
+        record += ",\"sweeps\":" + value.setNum(pipelinedVolume.getNumSweeps());
+        record += ",\"rays\":" + value.setNum(pipelinedVolume.getNumRays());
+        record += ",\"serial_ms\":" + value.setNum(serialTime / 1.0e6);
+        record += ",\"pipelined_ms\":" + value.setNum(pipelinedTime / 1.0e6);
+        record += ",\"mismatched_rays\":" + value.setNum(mismatched);
+        record += "}";
+        std::cout << record.toStdString() << std::endl;
+    }
+
+    QString value;
+    QString record = "{\"kernel\":\"level2\",\"total\":true";
+    record += ",\"files\":" + value.setNum(numFiles);
+    record += ",\"bytes\":" + value.setNum(totalBytes);
+    record += ",\"serial_ms\":" + value.setNum(serialNsecs / 1.0e6);
+    record += ",\"pipelined_ms\":" + value.setNum(pipelinedNsecs / 1.0e6);
+    if (pipelinedNsecs > 0)
+        record += ",\"speedup\":" + value.setNum((double)serialNsecs / pipelinedNsecs);
+    record += ",\"failed_files\":" + value.setNum(numFailed);
+    record += "}";
+    std::cout << record.toStdString() << std::endl;
+    return (numFailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int DriverKernelCheck::compareVolumes(RadarData* first, RadarData* second)
+{
+    // Number of rays that differ in geometry or in any moment, bit for bit.
+    // A different sweep or ray count counts every ray of the larger volume.
+    if ((first->getNumSweeps() != second->getNumSweeps())
+        || (first->getNumRays() != second->getNumRays()))
+        return qMax(qMax(first->getNumRays(), second->getNumRays()), 1);
+
+    int mismatched = 0;
+    for (int r = 0; r < first->getNumRays(); r++) {
+        Ray* a = first->getRay(r);
+        Ray* b = second->getRay(r);
+        int refGates = a->getRef_numgates();
+        int velGates = a->getVel_numgates();
+        bool same = (a->getSweepIndex() == b->getSweepIndex())
+            && (a->getAzimuth() == b->getAzimuth())
+            && (a->getElevation() == b->getElevation())
+            && (refGates == b->getRef_numgates())
+            && (velGates == b->getVel_numgates());
+        float* fields[3][2] = { { a->getRefData(), b->getRefData() },
+                                { a->getVelData(), b->getVelData() },
+                                { a->getSwData(), b->getSwData() } };
+        int gates[3] = { refGates, velGates, velGates };
+        for (int m = 0; same && (m < 3); m++) {
+            if ((fields[m][0] == NULL) || (fields[m][1] == NULL))
+                same = (fields[m][0] == fields[m][1]);
+            else
+                same = (memcmp(fields[m][0], fields[m][1], gates[m] * sizeof(float)) == 0);
+        }
+        if (!same)
+            mismatched++;
+    }
+    return mismatched;
+}
+
+int DriverKernelCheck::checkQC()
+{
+#ifndef VORTRAC_KERNEL_CHECK
+    std::cerr << "The qc kernel needs the serial quality control stages, "
+              << "build with qmake CONFIG+=kernelcheck" << std::endl;
+    return EXIT_FAILURE;
+#else
+    if (args.size() != 2) {
+        std::cerr << "The qc kernel needs a configuration file and an analytic storm file"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    Configuration mainConfig;
+    Configuration analyticConfig;
+    if (!mainConfig.read(args[0])) {
+        std::cerr << "Couldn't load configuration file " << args[0].toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (!analyticConfig.read(args[1])) {
+        std::cerr << "Couldn't load analytic storm file " << args[1].toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // The storm is sampled and sent through quality control, from a fixed
+    // seed so both volumes get the same noise
+    QDomElement analytic = analyticConfig.getRoot().firstChildElement("analytic_radar");
+    setParam(analyticConfig, analytic, "sample", "true");
+    setParam(analyticConfig, analytic, "dealiasdata", "true");
+    QString seed = analyticConfig.getParam(analytic, "seed");
+    if (seed.isEmpty()) {
+        seed = "1";
+        setParam(analyticConfig, analytic, "seed", seed);
+    }
+
+    // Anything the sampling writes goes into a scratch directory
+    QDir workDir(QDir::temp().filePath("vortrac_kernel_qc"));
+    if (!workDir.mkpath(".")) {
+        std::cerr << "Couldn't create " << workDir.path().toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }
+    QDomElement group = mainConfig.getRoot().firstChildElement();
+    for (; !group.isNull(); group = group.nextSiblingElement()) {
+        if ((group.tagName() == "radar") || (group.tagName() == "pressure"))
+            continue;
+        if (!mainConfig.getElement(group, "dir").isNull())
+            mainConfig.setParam(group, "dir", workDir.path());
+    }
+    QString analyticFile = workDir.filePath("analytic.xml");
+    if (!analyticConfig.write(analyticFile)) {
+        std::cerr << "Couldn't write " << analyticFile.toStdString() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    QDomElement radar = mainConfig.getConfig("radar");
+    float radarLat = mainConfig.getParam(radar, "lat").toFloat();
+    float radarLon = mainConfig.getParam(radar, "lon").toFloat();
+    AnalyticRadar serialVolume("KCHK", radarLat, radarLon, analyticFile);
+    AnalyticRadar sweepVolume("KCHK", radarLat, radarLon, analyticFile);
+    serialVolume.setConfigElement(&mainConfig);
+    sweepVolume.setConfigElement(&mainConfig);
+    if (!serialVolume.readVolume() || !sweepVolume.readVolume()
+        || (serialVolume.getNumSweeps() <= 0)) {
+        std::cerr << "Couldn't sample the analytic storm" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (compareVolumes(&serialVolume, &sweepVolume) != 0) {
+        std::cerr << "Seed " << seed.toStdString()
+                  << " doesn't sample the same volume twice" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // The serial Bargen-Brown stage never finishes on a NaN velocity
+    long nanGates = 0;
+    for (int r = 0; r < serialVolume.getNumRays(); r++) {
+        Ray* ray = serialVolume.getRay(r);
+        float* vGates = ray->getVelData();
+        if (vGates == NULL)
+            continue;
+        for (int j = 0; j < ray->getVel_numgates(); j++)
+            if (std::isnan(vGates[j]))
+                nanGates++;
+    }
+    if (nanGates > 0) {
+        std::cerr << "The sampled volume has " << nanGates
+                  << " NaN velocity gates, the serial stages can't run on it" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    serialVolume.buildBeamGeometry();
+    sweepVolume.buildBeamGeometry();
+
+    RadarQC serialQC(&serialVolume);
+    RadarQC sweepQC(&sweepVolume);
+    connect(&serialQC, SIGNAL(log(const Message&)), this, SLOT(catchLog(const Message&)),
+            Qt::DirectConnection);
+    connect(&sweepQC, SIGNAL(log(const Message&)), this, SLOT(catchLog(const Message&)),
+            Qt::DirectConnection);
+    serialQC.getConfig(mainConfig.getConfig("qc"));
+    sweepQC.getConfig(mainConfig.getConfig("qc"));
+
+    QElapsedTimer clock;
+    clock.start();
+    bool serialDealiased = serialQC.dealiasReference();
+    qint64 serialNsecs = clock.nsecsElapsed();
+    clock.restart();
+    bool sweepDealiased = sweepQC.dealias();
+    qint64 sweepNsecs = clock.nsecsElapsed();
+
+    // Velocity gates that differ at all, and the largest difference where
+    // both still have data
+    long numGates = 0, mismatched = 0, nullMismatched = 0;
+    float maxDiff = 0;
+    const float velNull = -999.;
+    for (int r = 0; r < serialVolume.getNumRays(); r++) {
+        Ray* a = serialVolume.getRay(r);
+        Ray* b = sweepVolume.getRay(r);
+        float* aGates = a->getVelData();
+        float* bGates = b->getVelData();
+        if ((aGates == NULL) || (bGates == NULL))
+            continue;
+        int gates = qMin(a->getVel_numgates(), b->getVel_numgates());
+        for (int j = 0; j < gates; j++) {
+            numGates++;
+            if (memcmp(&aGates[j], &bGates[j], sizeof(float)) == 0)
+                continue;
+            mismatched++;
+            if ((aGates[j] == velNull) || (bGates[j] == velNull))
+                nullMismatched++;
+            else
+                maxDiff = qMax(maxDiff, (float)fabs(aGates[j] - bGates[j]));
+        }
+    }
+
+    QString value;
+    QString record = "{\"kernel\":\"qc\"";
+    record += ",\"seed\":" + seed;
+    record += ",\"sweeps\":" + value.setNum(sweepVolume.getNumSweeps());
+    record += ",\"rays\":" + value.setNum(sweepVolume.getNumRays());
+    record += ",\"gates\":" + value.setNum(numGates);
+    record += ",\"serial_ms\":" + value.setNum(serialNsecs / 1.0e6);
+    record += ",\"sweep_ms\":" + value.setNum(sweepNsecs / 1.0e6);
+    record += ",\"serial_dealiased\":" + QString(serialDealiased ? "true" : "false");
+    record += ",\"sweep_dealiased\":" + QString(sweepDealiased ? "true" : "false");
+    record += ",\"mismatched_gates\":" + value.setNum(mismatched);
+    record += ",\"null_mismatched_gates\":" + value.setNum(nullMismatched);
+    record += ",\"max_vel_diff\":" + value.setNum(maxDiff);
+    record += "}";
+    std::cout << record.toStdString() << std::endl;
+    return ((mismatched == 0) && (serialDealiased == sweepDealiased))
+        ? EXIT_SUCCESS : EXIT_FAILURE;
+#endif
+}
+
+void DriverKernelCheck::setParam(Configuration& config, const QDomElement& group,
+                                 const QString& name, const QString& value)
+{
+    if (config.getElement(group, name).isNull())
+        config.addDom(group, name, value);
+    else
+        config.setParam(group, name, value);
+}
+
+void DriverKernelCheck::catchLog(const Message& message)
+{
+    // stdout is kept for the results
+    Message entry(message);
+    QString text = entry.getLogMessage();
+    if (!text.isEmpty())
+        std::cerr << text.toStdString() << std::endl;
+}
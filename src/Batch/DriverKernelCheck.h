@@ -0,0 +1,63 @@
+/*
+ * DriverKernelCheck.h
+ * VORTRAC
+ *
+ * Copyright 2026 University Corporation for Atmospheric Research.
+ * All rights reserved.
+ *
+ */
+
+#ifndef DRIVERKERNELCHECK_H
+#define DRIVERKERNELCHECK_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include "Config/Configuration.h"
+#include "IO/Message.h"
+
+class RadarData;
+
+// Runs a rewritten numerical kernel next to the code it replaced, on the
+// same input, and reports how long each took and how far their results
+// are apart. The kernels are:
+//
+//   solver         LeastSquares against Matrix::lls on ring sized fits
+//   level2 <dir>   pipelined against serial LdmLevelII decompression for
+//                  every file in the directory
+//   qc <config.xml> <analytic.xml>
+//                  the sweep pass quality control against the serial
+//                  stages, on two analytic volumes sampled from one seed;
+//                  needs a build with qmake CONFIG+=kernelcheck
+//
+// Each comparison prints one JSON line on stdout. run() fails if the two
+// disagree on which fits succeed, read different volumes or leave any
+// velocity gate different.
+
+class DriverKernelCheck : public QObject
+{
+    Q_OBJECT
+
+public:
+    DriverKernelCheck(const QString &kernel, const QStringList &arguments,
+                      QObject *parent = 0);
+    int run();
+
+public slots:
+    void catchLog(const Message& message);
+
+private:
+    int checkSolver();
+    bool compareSolver(int numCoeff, int numData, int numFits);
+    int checkLevelII();
+    int compareVolumes(RadarData* first, RadarData* second);
+    int checkQC();
+    void setParam(Configuration& config, const QDomElement& group,
+                  const QString& name, const QString& value);
+
+    QString kernelName;
+    QStringList args;
+};
+
+#endif // DRIVERKERNELCHECK_H
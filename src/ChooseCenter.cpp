@@ -11,6 +11,7 @@
 
 #include "ChooseCenter.h"
 #include "Math/Matrix.h"
+#include "Math/LeastSquares.h"
 #include <math.h>
 #include <QDomElement>
 #include <QHash>
@@ -18,14 +19,17 @@
 #include <cstdlib>
 #include <ctime>
 
+// Coefficients supported by _polyFit, enough for MAX_ORDER and _polyTest
+static const int maxPolyFitCoeffs = 11;
+
 ChooseCenter::ChooseCenter(Configuration* newConfig, const SimplexList* newList, VortexData* vortexPtr):
     MAX_ORDER(10),velNull(-999.0f)
 {
     _config = newConfig;
     _simplexResults = newList;
     _vortexData = vortexPtr;
-    _pppScore = NULL;
-    _ppBestRadius = NULL;
+    for(int i = 0; i < 3; i++)
+        _scoredWeights[i] = velNull;
     _ppBestFitVariance = NULL;
     _ppBestFitDegree = NULL;
     _pppBestFitCoeff = NULL;
@@ -37,29 +41,12 @@ ChooseCenter::ChooseCenter(Configuration* newConfig, const SimplexList* newList,
 
 ChooseCenter::~ChooseCenter()
 {
-    if(_pppScore!=NULL) {
-        for(int i = 0; i < _simplexResults->count(); i++) {
-            for(int j = 0; j < _simplexResults->at(i).getNumRadii(); j++) {
-                delete [] _pppScore[i][j];
-            }
-            delete [] _pppScore[i];
-        }
-        delete [] _pppScore;
-    }
-    else
-        delete _pppScore;
+    _dropScores(0);
 
     // We might not be able to delete these depending on weither they
     // are passed out for further use or not after the ChooseCenter object is
     // destroyed
 
-    if(_ppBestRadius!=NULL) {
-        for(int i = 0; i < _simplexResults->count(); i++)
-            delete[] _ppBestRadius[i];
-        delete[] _ppBestRadius;   }
-    else
-        delete _ppBestRadius;
-
     if(_ppNewBestRadius!=NULL) {
         for(int i = 0; i < _simplexResults->count(); i++)
             delete[] _ppNewBestRadius[i];
@@ -242,25 +229,39 @@ void ChooseCenter::_initialize()
         _fCriteria[29] = 4.1709;
     }
 
-    _ppBestRadius= new int*[_simplexResults->count()];
-    _pppScore    = new float**[_simplexResults->count()];
-
-    for(int i = 0; i < _simplexResults->count(); i++) {
-        _pppScore[i] = new float*[_simplexResults->at(i).getNumRadii()];
-        _ppBestRadius[i] = new int[_simplexResults->at(i).getNumLevels()];
+    // Scores from an earlier call are kept as long as the volume they were
+    // computed from is still at the same place in the list, and the
+    // weights have not been changed.
+    if((_paramWindWeight != _scoredWeights[0]) || (_paramStdWeight != _scoredWeights[1])
+       || (_paramPtsWeight != _scoredWeights[2])) {
+        _dropScores(0);
+        _scoredWeights[0] = _paramWindWeight;
+        _scoredWeights[1] = _paramStdWeight;
+        _scoredWeights[2] = _paramPtsWeight;
+    }
+    int first = 0;
+    while((first < _scoredTimes.size()) && (first < _simplexResults->count())
+          && (_scoredTimes[first] == _simplexResults->at(first).getTime())
+          && (_scoredRadii[first] == _simplexResults->at(first).getNumRadii())
+          && (_scoredLevels[first] == _simplexResults->at(first).getNumLevels()))
+        first++;
+    _dropScores(first);
+}
 
-#if 0
-	std::cout << "At " << i << ", levels: " << _simplexResults->at(i).getNumLevels()
-		  << ", radii: " << _simplexResults->at(i).getNumRadii() << std::endl;
-#endif
-	
-        for(int rad = 0; rad < _simplexResults->at(i).getNumRadii(); rad++) {
-            _pppScore[i][rad] = new float[_simplexResults->at(i).getNumLevels()];
-            for(int level = 0; level < _simplexResults->at(i).getNumLevels(); level++){
-                _pppScore[i][rad][level] = 0.0;
-                _ppBestRadius[i][level] = -1;
-            }
-        }
+void ChooseCenter::_dropScores(const int& first)
+{
+    for(int i = _pppScore.size() - 1; i >= first; i--) {
+        for(int rad = 0; rad < _scoredRadii[i]; rad++)
+            delete [] _pppScore[i][rad];
+        delete [] _pppScore[i];
+        delete [] _ppBestRadius[i];
+    }
+    if(first < _pppScore.size()) {
+        _pppScore.resize(first);
+        _ppBestRadius.resize(first);
+        _scoredTimes.resize(first);
+        _scoredRadii.resize(first);
+        _scoredLevels.resize(first);
     }
 }
 
@@ -279,134 +280,155 @@ bool ChooseCenter::_calMeanCenters()
     if(_simplexResults->isEmpty())
         return false;
 
-    for(int vidx = 0; vidx < _simplexResults->size(); vidx++) {
-        float meanRadius = 0;
-        float meanCenX = 0;
-        float meanCenY = 0;
-        const int NLEVEL = _simplexResults->at(vidx).getNumLevels();
-        const int NRADII = _simplexResults->at(vidx).getNumRadii();
-        for(int hidx = 0; hidx < NLEVEL; hidx++) {
-
-            float *winds= new float[NRADII];
-            float *stds = new float[NRADII];
-            float *pts  = new float[NRADII];
-            float bestWind = 0.0;
-            float bestStd = 50.;
-            float bestPts = 0.;
-            float ptRatio = (float)_simplexResults->at(vidx).getNumPointsUsed() / 2.718281828;
-
-            //get array of maxwind,centerSD,convegedPoints on this level, and calculate best value of these param
-            for(int ridx = 0; ridx < NRADII; ridx++) {
-                // Examine each radius based on index j, for the one containing the highest tangential winds
-
-                winds[ridx] = _simplexResults->at(vidx).getMaxVT(hidx, ridx);
-                stds[ridx]  = _simplexResults->at(vidx).getCenterStdDev(hidx, ridx);
-                pts[ridx]   = _simplexResults->at(vidx).getNumConvergingCenters(hidx, ridx);
-
-                if((winds[ridx] != SimplexData::_fillv) && (winds[ridx] > bestWind))
-                    bestWind = winds[ridx];
-
-                if((stds[ridx] != SimplexData::_fillv) && (stds[ridx] < bestStd))
-                    bestStd = stds[ridx];
-
-                if((pts[ridx] != SimplexData::_fillv) && (pts[ridx] > bestPts))
-                    bestPts = pts[ridx];
-            }
+    // Only the volumes added since the last call need scores
+    for(int vidx = _pppScore.size(); vidx < _simplexResults->size(); vidx++)
+        _scoreVolume(vidx);
+    return true;
+}
+
+void ChooseCenter::_scoreVolume(const int& vidx)
+{
+    const int NLEVEL = _simplexResults->at(vidx).getNumLevels();
+    const int NRADII = _simplexResults->at(vidx).getNumRadii();
+
+    float** score = new float*[NRADII];
+    int* bestRadius = new int[NLEVEL];
+    for(int rad = 0; rad < NRADII; rad++) {
+        score[rad] = new float[NLEVEL];
+        for(int level = 0; level < NLEVEL; level++)
+            score[rad][level] = 0.0;
+    }
+    for(int level = 0; level < NLEVEL; level++)
+        bestRadius[level] = -1;
+    _pppScore.append(score);
+    _ppBestRadius.append(bestRadius);
+    _scoredTimes.append(_simplexResults->at(vidx).getTime());
+    _scoredRadii.append(NRADII);
+    _scoredLevels.append(NLEVEL);
+
+    float meanRadius = 0;
+    float meanCenX = 0;
+    float meanCenY = 0;
+    for(int hidx = 0; hidx < NLEVEL; hidx++) {
+
+        float *winds= new float[NRADII];
+        float *stds = new float[NRADII];
+        float *pts  = new float[NRADII];
+        float bestWind = 0.0;
+        float bestStd = 50.;
+        float bestPts = 0.;
+        float ptRatio = (float)_simplexResults->at(vidx).getNumPointsUsed() / 2.718281828;
+
+        //get array of maxwind,centerSD,convegedPoints on this level, and calculate best value of these param
+        for(int ridx = 0; ridx < NRADII; ridx++) {
+            // Examine each radius based on index j, for the one containing the highest tangential winds
+
+            winds[ridx] = _simplexResults->at(vidx).getMaxVT(hidx, ridx);
+            stds[ridx]  = _simplexResults->at(vidx).getCenterStdDev(hidx, ridx);
+            pts[ridx]   = _simplexResults->at(vidx).getNumConvergingCenters(hidx, ridx);
+
+            if((winds[ridx] != SimplexData::_fillv) && (winds[ridx] > bestWind))
+                bestWind = winds[ridx];
+
+            if((stds[ridx] != SimplexData::_fillv) && (stds[ridx] < bestStd))
+                bestStd = stds[ridx];
+
+            if((pts[ridx] != SimplexData::_fillv) && (pts[ridx] > bestPts))
+                bestPts = pts[ridx];
+        }
 
-            // Formely known as fix winds which was a sub routine in the perl version of this algorithm
-            // zeros all wind entrys that are not a local maxima, or adjacent to a local maxima
+        // Formely known as fix winds which was a sub routine in the perl version of this algorithm
+        // zeros all wind entrys that are not a local maxima, or adjacent to a local maxima
 	    
-            int count = 0;
-            float *peakWinds = new float[NRADII];
-            bool  *isPeaks   = new bool[NRADII];
+        int count = 0;
+        float *peakWinds = new float[NRADII];
+        bool  *isPeaks   = new bool[NRADII];
 	    
-            for(int z = 0; z < NRADII; z++) {
-                peakWinds[z] = 0.f;
-                isPeaks[z] = 0;
-            }
+        for(int z = 0; z < NRADII; z++) {
+            peakWinds[z] = 0.f;
+            isPeaks[z] = 0;
+        }
 	    
-            for(int a = 1; a < NRADII - 1; a++) {
-                if((winds[a] >= winds[a-1]) && (winds[a] >= winds[a + 1])) {
-                    peakWinds[count] = winds[a];
-                    isPeaks[a] = 1;
-                    count++;
-                }
-            }
-            float peakWindMean = 0.f, peakWindStd = 0.f;
-            for(int a = 0; a < count; a++) {
-                peakWindMean += peakWinds[a];
+        for(int a = 1; a < NRADII - 1; a++) {
+            if((winds[a] >= winds[a-1]) && (winds[a] >= winds[a + 1])) {
+                peakWinds[count] = winds[a];
+                isPeaks[a] = 1;
+                count++;
             }
-            if(count > 0) {
-                peakWindMean = peakWindMean/((float)count);
-                for(int z = 0; z < count; z++)
-                    peakWindStd += (peakWinds[z] - peakWindMean) * (peakWinds[z] - peakWindMean);
-                peakWindStd /= count;
-            }
-            delete[] peakWinds;
+        }
+        float peakWindMean = 0.f, peakWindStd = 0.f;
+        for(int a = 0; a < count; a++) {
+            peakWindMean += peakWinds[a];
+        }
+        if(count > 0) {
+            peakWindMean = peakWindMean/((float)count);
+            for(int z = 0; z < count; z++)
+                peakWindStd += (peakWinds[z] - peakWindMean) * (peakWinds[z] - peakWindMean);
+            peakWindStd /= count;
+        }
+        delete[] peakWinds;
 
-            //put point and points adjacent to peakwind into winds[]
-            for(int jj = 0; jj < NRADII; jj++) {
-                if(((jj > 0) && (jj < NRADII-1))
+        //put point and points adjacent to peakwind into winds[]
+        for(int jj = 0; jj < NRADII; jj++) {
+            if(((jj > 0) && (jj < NRADII-1))
 		   &&((isPeaks[jj] == 1) || (isPeaks[jj + 1] == 1) || (isPeaks[jj - 1] == 1))) {
-                    winds[jj] = _simplexResults->at(vidx).getMaxVT(hidx, jj);
-                    // Keep an eye out for the maxima
-                    if(winds[jj] > bestWind) {
-                        bestWind = winds[jj];
-                    }
-                }
-                else {
-                    winds[jj] = velNull;
+                winds[jj] = _simplexResults->at(vidx).getMaxVT(hidx, jj);
+                // Keep an eye out for the maxima
+                if(winds[jj] > bestWind) {
+                    bestWind = winds[jj];
                 }
             }
+            else {
+                winds[jj] = velNull;
+            }
+        }
 
-            //calculate a weight for each ring, and find a best on this level
-            float tempBest = 0.f, windScore, stdScore, ptsScore;
-            int   bestFlag = 0;
-            for(int rr = 0; rr < NRADII; rr++){
-                windScore = stdScore = ptsScore = 0.f;
-                _pppScore[vidx][rr][hidx] = velNull;
-                if((bestWind != 0.0) && (winds[rr] != velNull))
-                    windScore = exp(winds[rr] - bestWind) * _paramWindWeight;
-                if((stds[rr] != velNull) && (stds[rr] != 0.0))
-                    stdScore = bestStd / stds[rr] * _paramStdWeight;
-                if((bestPts !=0 ) && (pts[rr] != velNull) && (ptRatio != 0.0)) {
-                    ptsScore = log((float)pts[rr] / ptRatio) * _paramPtsWeight;
-                }
-                if(winds[rr] != velNull) {
-                    _pppScore[vidx][rr][hidx] = windScore + stdScore + ptsScore;
-                    if((_pppScore[vidx][rr][hidx] > tempBest) && (hidx >= 0) &&
+        //calculate a weight for each ring, and find a best on this level
+        float tempBest = 0.f, windScore, stdScore, ptsScore;
+        int   bestFlag = 0;
+        for(int rr = 0; rr < NRADII; rr++){
+            windScore = stdScore = ptsScore = 0.f;
+            _pppScore[vidx][rr][hidx] = velNull;
+            if((bestWind != 0.0) && (winds[rr] != velNull))
+                windScore = exp(winds[rr] - bestWind) * _paramWindWeight;
+            if((stds[rr] != velNull) && (stds[rr] != 0.0))
+                stdScore = bestStd / stds[rr] * _paramStdWeight;
+            if((bestPts !=0 ) && (pts[rr] != velNull) && (ptRatio != 0.0)) {
+                ptsScore = log((float)pts[rr] / ptRatio) * _paramPtsWeight;
+            }
+            if(winds[rr] != velNull) {
+                _pppScore[vidx][rr][hidx] = windScore + stdScore + ptsScore;
+                if((_pppScore[vidx][rr][hidx] > tempBest) && (hidx >= 0) &&
 		       (hidx <= _simplexResults->at(vidx).getNumLevels())) {
-                        tempBest = _pppScore[vidx][rr][hidx];
-                        bestFlag = rr;
-                    }
+                    tempBest = _pppScore[vidx][rr][hidx];
+                    bestFlag = rr;
                 }
-            }//end of radii
-            meanRadius += _simplexResults->at(vidx).getRadius(bestFlag);
-            meanCenX   += _simplexResults->at(vidx).getMeanX(hidx, bestFlag);
-            meanCenY   += _simplexResults->at(vidx).getMeanY(hidx, bestFlag);
-            _ppBestRadius[vidx][hidx] = bestFlag;
-
-            delete [] winds;
-            delete [] stds;
-            delete [] pts;
-            delete [] isPeaks;
-        }//end of levels
-
-        // calculate the mean radius and center scores over all levels
-        meanRadius = meanRadius/NLEVEL;
-        meanCenX   = meanCenX/NLEVEL;
-        meanCenY   = meanCenY/NLEVEL;
-        if(vidx == (_simplexResults->size() -1)){
-            // const float radarLat = _config->getParam(_config->getConfig("radar"), QString("lat")).toFloat();
-            // const float radarLon = _config->getParam(_config->getConfig("radar"), QString("lon")).toFloat();
-            // const float radarLatRadians = radarLat * acos(-1.0) / 180.0;
-            // const float fac_lat = 111.13209 - 0.56605 * cos(2.0 * radarLatRadians) + 0.00012 * cos(4.0 * radarLatRadians) - 0.000002 * cos(6.0 * radarLatRadians);
-            // const float fac_lon = 111.41513 * cos(radarLatRadians) - 0.09455 * cos(3.0 * radarLatRadians) + 0.00012 * cos(5.0 * radarLatRadians);
-
-            //std::cout<<"ChooseCenter found new mean center: "<<radarLat+meanCenY/fac_lat<<","<<radarLon+meanCenX/fac_lon<<","<<meanRadius<<std::endl;
-        }
+            }
+        }//end of radii
+        meanRadius += _simplexResults->at(vidx).getRadius(bestFlag);
+        meanCenX   += _simplexResults->at(vidx).getMeanX(hidx, bestFlag);
+        meanCenY   += _simplexResults->at(vidx).getMeanY(hidx, bestFlag);
+        _ppBestRadius[vidx][hidx] = bestFlag;
+
+        delete [] winds;
+        delete [] stds;
+        delete [] pts;
+        delete [] isPeaks;
+    }//end of levels
+
+    // calculate the mean radius and center scores over all levels
+    meanRadius = meanRadius/NLEVEL;
+    meanCenX   = meanCenX/NLEVEL;
+    meanCenY   = meanCenY/NLEVEL;
+    if(vidx == (_simplexResults->size() -1)){
+        // const float radarLat = _config->getParam(_config->getConfig("radar"), QString("lat")).toFloat();
+        // const float radarLon = _config->getParam(_config->getConfig("radar"), QString("lon")).toFloat();
+        // const float radarLatRadians = radarLat * acos(-1.0) / 180.0;
+        // const float fac_lat = 111.13209 - 0.56605 * cos(2.0 * radarLatRadians) + 0.00012 * cos(4.0 * radarLatRadians) - 0.000002 * cos(6.0 * radarLatRadians);
+        // const float fac_lon = 111.41513 * cos(radarLatRadians) - 0.09455 * cos(3.0 * radarLatRadians) + 0.00012 * cos(5.0 * radarLatRadians);
+
+        //std::cout<<"ChooseCenter found new mean center: "<<radarLat+meanCenY/fac_lat<<","<<radarLon+meanCenX/fac_lon<<","<<meanRadius<<std::endl;
     }
-    return true;
 }
 
 bool ChooseCenter::_calPolyTest(const QList<int>& volIdx,const int& levelIdx)
@@ -1081,29 +1103,28 @@ void ChooseCenter::findHeights()
 
 bool ChooseCenter::_polyFit(const int nCoeff, const int nData, const float* xData, const float* yData, float* aData, float& rss )
 {
-    float** A=new float*[nCoeff+1];
-    for(int i=0;i<=nCoeff;i++)
-        A[i]=new float[nData];
-    for(int i=0;i<=nCoeff;i++)
-        for(int j=0;j<nData;j++)
-            A[i][j]=pow(xData[j],float(i));
-    float* b=new float[nData];
-    for(int i=0;i<nData;i++)
-        b[i]=yData[i];
-    float* stError=new float[nData];
+    const int numCoeff = nCoeff+1;
+    if(numCoeff > maxPolyFitCoeffs)
+        return false;
+
+    // Fold each (x^0 .. x^nCoeff, y) row straight into the normal equations
+    LeastSquares<maxPolyFitCoeffs> fit(numCoeff);
+    float A[maxPolyFitCoeffs];
+    for(int j=0;j<nData;j++) {
+        for(int i=0;i<numCoeff;i++)
+            A[i]=pow(xData[j],float(i));
+        fit.addRow(A,yData[j]);
+    }
+    float stError[maxPolyFitCoeffs];
     float dummyStd;
-    Matrix::lls(nCoeff+1,nData,A,b,dummyStd,aData,stError);
-    for(int i=0;i<nData;i++)
-        _polyCal(nCoeff,aData,xData[i],b[i]);
+    fit.solve(dummyStd,aData,stError);
     rss =0.0f;
-    for(int i=0;i<nData;i++)
-        rss +=(b[i]-yData[i])*(b[i]-yData[i]);
-
-    delete[] stError;
-    delete[] b;
-    for(int i=0;i<=nCoeff;i++)
-        delete[] A[i];
-    delete[] A;
+    for(int i=0;i<nData;i++) {
+        float b;
+        _polyCal(nCoeff,aData,xData[i],b);
+        rss +=(b-yData[i])*(b-yData[i]);
+    }
+
 	return true;
 }
 
@@ -16,6 +16,7 @@
 #include "DataObjects/SimplexList.h"
 #include "DataObjects/VortexData.h"
 #include <QDateTime>
+#include <QVector>
 
 class ChooseCenter
 {
@@ -23,6 +24,10 @@ public:
      ChooseCenter(Configuration* newConfig,const SimplexList* newList,VortexData* vortexPtr);
     ~ChooseCenter();
 
+    // The object can be kept for a whole run. Volumes that were scored by
+    // an earlier call are not scored again, so each call only does the work
+    // for the volumes appended to the list since the last one.
+    void setVortexData(VortexData* vortexPtr) { _vortexData = vortexPtr; }
     bool findCenter(int level);
 
 private:
@@ -72,15 +77,24 @@ private:
      *
      */
 
-    float*** _pppScore;
-    int**    _ppBestRadius;
+    QVector<float**> _pppScore;
+    QVector<int*>    _ppBestRadius;
     /*
      * bestRadius contains the index of the best radius for each level of
      *   each volume used. Here the best radius is decided from examining the
      *   means of all converging centers used in the simplex run.
      *   bestRadius[# of volumes used][# of levels in each volume]
      *
+     * Both only depend on the volume itself and the weights, so they are
+     *   kept between calls. scoredTimes, scoredRadii and scoredLevels
+     *   identify the simplex result each entry was computed from,
+     *   scoredWeights the weights that were used.
+     *
      */
+    QVector<QDateTime> _scoredTimes;
+    QVector<int>       _scoredRadii;
+    QVector<int>       _scoredLevels;
+    float _scoredWeights[3];
 
     float **_ppBestFitVariance;
     int   **_ppBestFitDegree;
@@ -148,6 +162,8 @@ private:
 
     void  _initialize();
     bool  _calMeanCenters();
+    void  _scoreVolume(const int& vidx);
+    void  _dropScores(const int& first);
     bool  _calPolyCenters();
     bool  _calPolyTest(const QList<int>& volIdx,const int& levelIdx);
 
@@ -14,6 +14,7 @@
 #include <QTextStream>
 #include <QFile>
 #include <QDir>
+#include <QtConcurrentMap>
 
 CappiGrid::CappiGrid() : GriddedData()
 {
@@ -116,7 +117,7 @@ void CappiGrid::gridRadarData(RadarData *radarData, QDomElement cappiConfig,floa
     else if (kGridsp>3)
     {
         Message::toScreen("Z spacing bounds too high. Set to maximum of 3 km.");
-        kGridsp=3.0
+        kGridsp=3.0;
     }
         
 
@@ -166,6 +167,13 @@ void CappiGrid::gridRadarData(RadarData *radarData, QDomElement cappiConfig,floa
 
     delete[] relDist;
 
+    // Size the grid storage to the configured dimensions
+    if (!allocateGrid()) {
+        Message::toScreen("CappiGrid: unable to allocate a "+QString().setNum(iDim)+"x"
+                          +QString().setNum(jDim)+"x"+QString().setNum(kDim)+" grid");
+        return;
+    }
+
     // Interpolate the data depending on method chosen
     QString interpolation = cappiConfig.firstChildElement("interpolation").text();
     if (interpolation == "cressman") {
@@ -200,19 +208,6 @@ void CappiGrid::CressmanInterpolation(RadarData *radarData)
     float maxIplus = RSquare/iGridsp;// .09-18
     float maxJplus = RSquare/jGridsp; //.09-18
     float maxKplus = RSquare/kGridsp; //.09-18
-    // Initialize weights
-    // might need +1 for typecasting 
-    for (int k = 0; k < int(kDim); k++) {
-        for (int j = 0; j < int(jDim); j++) {
-            for (int i = 0; i < int(iDim); i++) {  
-                refValues[i][j][k].sumRef = 0;
-                refValues[i][j][k].weight = 0;
-                velValues[i][j][k].sumVel = 0;
-                velValues[i][j][k].height = 0;
-                velValues[i][j][k].weight = 0;
-            }
-        }
-    }
 
     // Find the maximum unambiguous range for the volume
     float maxUnambig_range = 0;
@@ -230,53 +225,46 @@ void CappiGrid::CressmanInterpolation(RadarData *radarData)
 
     // Find good values
     //START GRID VAR DEP-BS
+    // Each gate inside the grid is located once, with the trig hoisted out
+    // to the ray and the beam heights taken from the volume's geometry tables.
+    QVector<CressmanGate> refGates;
+    QVector<CressmanGate> velGates;
     for (int n = 0; n < radarData->getNumRays(); n++) {
         Ray* currentRay = radarData->getRay(n);
         float theta = deg2rad * fmodf((450. - currentRay->getAzimuth()),360.);
         float phi = deg2rad * (90. - (currentRay->getElevation()));
+        float sinPhi = sin(phi);
+        float cosTheta = cos(theta);
+        float sinTheta = sin(theta);
 
         if ((currentRay->getRef_numgates() > 0) and (gridReflectivity)) {
 
             float* refData = currentRay->getRefData();
+            const BeamGeometry::Gates* geometry = radarData->getRefGeometry(currentRay);
+            const float* gateRange = geometry->range.constData();
+            const float* beamHeight = geometry->height.constData();
             for (int g = 0; g <= (currentRay->getRef_numgates()-1); g++) {
                 if (refData[g] == -999.) { continue; }
-                float range = float(currentRay->getFirst_ref_gate() +
-                                    (g * currentRay->getRef_gatesp()))/1000.;
+                float range = gateRange[g];
 
-                float x = range*sin(phi)*cos(theta);
+                float x = range*sinPhi*cosTheta;
                 if ((x < (xmin - iGridsp)) or x > (xmax + iGridsp)) { continue; }
-                float y = range*sin(phi)*sin(theta);
+                float y = range*sinPhi*sinTheta;
                 if ((y < (ymin - jGridsp)) or y > (ymax + jGridsp)) { continue; }
-                float z = radarData->radarBeamHeight(range,
-                                                     currentRay->getElevation() );
+                float z = beamHeight[g];
                 if ((z < (zmin - kGridsp)) or z > (zmax + kGridsp)) { continue; }
 
                 // Looks like a good point, find its closest Cartesian index
-                float i = (x - xmin)/iGridsp;
-                float j = (y - ymin)/jGridsp;
-                float k = (z - zmin)/kGridsp;
-                float RSquareLinear = RSquare*range*range / 30276.0;
-                for (int kplus = -maxKplus; kplus <= maxKplus; kplus++) {
-                    for (int jplus = -maxJplus; jplus <= maxJplus; jplus++) {
-                        for (int iplus = -maxIplus; iplus <= maxIplus; iplus++) {
-                            int iIndex = (int)(i+iplus);
-                            int jIndex = (int)(j+jplus);
-                            int kIndex = (int)(k+kplus);
-                            if ((iIndex < 0) or (iIndex > (int)iDim)) { continue; }
-                            if ((jIndex < 0) or (jIndex > (int)jDim)) { continue; }
-                            if ((kIndex < 0) or (kIndex > (int)kDim)) { continue; }
-
-                            float dx = (i - (int)(i+iplus))*iGridsp;
-                            float dy = (j - (int)(j+jplus))*jGridsp;
-                            float dz = (k - (int)(k+kplus))*kGridsp;
-                            float rSquare = (dx*dx) + (dy*dy) + (dz*dz);
-                            if (rSquare > RSquareLinear) { continue; }     
-                            float weight = (RSquareLinear - rSquare) / (RSquareLinear + rSquare);
-                            refValues[iIndex][jIndex][kIndex].weight += weight;
-                            refValues[iIndex][jIndex][kIndex].sumRef += weight*refData[g];
-                        }
-                    }
-                }
+                CressmanGate gate;
+                gate.i = (x - xmin)/iGridsp;
+                gate.j = (y - ymin)/jGridsp;
+                gate.k = (z - zmin)/kGridsp;
+                gate.height = z;
+                gate.radiusSq = RSquare*range*range / 30276.0;
+                gate.weightScale = 1;
+                gate.nyquist = 0;
+                gate.data = refData + g;
+                refGates.append(gate);
             }
 
         }
@@ -285,181 +273,139 @@ void CappiGrid::CressmanInterpolation(RadarData *radarData)
                 //and (currentRay->getElevation() < 0.75)) {
                 //and (fabs(currentRay->getNyquist_vel() - maxNyquist) < 0.1)) {
             float* velData = currentRay->getVelData();
-            // float* swData = currentRay->getSwData();
             float nyquist = currentRay->getNyquist_vel();
+            const BeamGeometry::Gates* geometry = radarData->getVelGeometry(currentRay);
+            const float* gateRange = geometry->range.constData();
+            const float* beamHeight = geometry->height.constData();
             for (int g = 0; g <= (currentRay->getVel_numgates()-1); g++) {
                 if (velData[g] == -999.) { continue; }
 
-                float range = float(currentRay->getFirst_vel_gate() +
-                                    (g * currentRay->getVel_gatesp()))/1000.;
-                float x = range*sin(phi)*cos(theta);
+                float range = gateRange[g];
+                float x = range*sinPhi*cosTheta;
 
                 //TODO 
                 //Does the grid spacing affect the rsults of this? --BS
                 if ((x < (xmin - iGridsp)) or x > (xmax + iGridsp)) { continue; }
-                float y = range*sin(phi)*sin(theta);
+                float y = range*sinPhi*sinTheta;
                 if ((y < (ymin - jGridsp)) or y > (ymax + jGridsp)) { continue; }
-                float z = radarData->radarBeamHeight(range,
-                                                     currentRay->getElevation() );
+                float z = beamHeight[g];
                 if ((z < (zmin - kGridsp)) or z > (zmax + kGridsp)) { continue; }
 
                 // Looks like a good point, find its closest Cartesian index
-                float i = (x - xmin)/iGridsp;
-                float j = (y - ymin)/jGridsp;
-                float k = (z - zmin)/kGridsp;
-                float RSquareLinear = RSquare; //* range*range / 30276.0;
-                for (int kplus = -maxKplus; kplus <= maxKplus; kplus++) {
-                for (int jplus = -maxJplus; jplus <= maxJplus; jplus++) {
-                    for (int iplus = -maxIplus; iplus <= maxIplus; iplus++) {
-                        int iIndex = (int)(i+iplus);
-                        int jIndex = (int)(j+jplus);
-                        int kIndex = (int)(k+kplus);
-                        if ((iIndex < 0) or (iIndex >= (int)iDim)) { continue; }
-                        if ((jIndex < 0) or (jIndex >= (int)jDim)) { continue; }
-                        if ((kIndex < 0) or (kIndex >= (int)kDim)) { continue; }
-
-                        float dx = (i - (int)(i+iplus))*iGridsp;
-                        float dy = (j - (int)(j+jplus))*jGridsp;
-                        float dz = (k - (int)(k+kplus))*kGridsp;
-                        float rSquare = (dx*dx) + (dy*dy) + (dz*dz);
-                        if (rSquare > RSquareLinear) { continue; }
-                        float weight = (100*nyquist) *(RSquareLinear - rSquare) / (RSquareLinear + rSquare);
-                        velValues[iIndex][jIndex][kIndex].weight += weight;
-                        velValues[iIndex][jIndex][kIndex].sumVel += weight*velData[g];
-                        velValues[iIndex][jIndex][kIndex].height += weight*z;
-                    }
-                }
-                }
+                CressmanGate gate;
+                gate.i = (x - xmin)/iGridsp;
+                gate.j = (y - ymin)/jGridsp;
+                gate.k = (z - zmin)/kGridsp;
+                gate.height = z;
+                gate.radiusSq = RSquare; //* range*range / 30276.0;
+                gate.weightScale = 100*nyquist;
+                gate.nyquist = nyquist;
+                gate.data = velData + g;
+                velGates.append(gate);
             }
-
-            velData = NULL;
-            // swData = NULL;
-            //delete velData;
-            //delete swData;
         }
-        currentRay = NULL;
-        //delete currentRay;
     }
-   
 
-    //Message::toScreen("# of Reflectivity gates used in CAPPI = "+QString().setNum(r));
-    //Message::toScreen("# of Velocity gates used in CAPPI = "+QString().setNum(v));
+    gatesGridded = refGates.size() + velGates.size();
 
-    for (int k = 0; k < int(kDim); k++) {
-        for (int j = 0; j < int(jDim); j++) {
-            for (int i = 0; i < int(iDim); i++) {
+    // Bin the gates and let every row of the grid gather its own cells
+    GateBins refBins;
+    GateBins velBins;
+    binGates(refGates, maxIplus, maxJplus, maxKplus, refBins);
+    binGates(velGates, maxIplus, maxJplus, maxKplus, velBins);
+    refGates.clear();
 
-                dataGrid[0][i][j][k] = -999;
-                dataGrid[1][i][j][k] = -999;
-                dataGrid[2][i][j][k] = -999;
+    QVector<int> rows((int)iDim);
+    for (int i = 0; i < rows.size(); i++)
+        rows[i] = i;
+    QtConcurrent::blockingMap(rows, GatherRow(this, &refBins, &velBins));
+    refBins.gates.clear();
+    velBins.gates.clear();
 
-                if (refValues[i][j][k].weight > 0) {
-                    dataGrid[0][i][j][k] = refValues[i][j][k].sumRef/refValues[i][j][k].weight;
-                }
-                if (velValues[i][j][k].weight > 0) {
-                    dataGrid[1][i][j][k] = velValues[i][j][k].sumVel/velValues[i][j][k].weight;
-                    dataGrid[2][i][j][k] = velValues[i][j][k].height/velValues[i][j][k].weight;
-                }
-                velValues[i][j][k].sumVel = 0;
-                velValues[i][j][k].height = 0;
-                velValues[i][j][k].weight = 0;
-            }
-        }
+    //Message::toScreen("# of Reflectivity gates used in CAPPI = "+QString().setNum(r));
+    //Message::toScreen("# of Velocity gates used in CAPPI = "+QString().setNum(v));
+
+    // The unfolding pass changes each gate in place cell by cell, so it
+    // keeps the scatter form. The local mean around a cell is the same for
+    // every gate, so it is summed once up front, and only the offsets that
+    // can fall inside the radius of influence are visited.
+    long numCells = long(iDim)*long(jDim)*long(kDim);
+    goodVel* velValues = new goodVel[numCells];
+    for (long n = 0; n < numCells; n++) {
+        velValues[n].sumVel = 0;
+        velValues[n].height = 0;
+        velValues[n].weight = 0;
     }
+    float* localSum = new float[numCells];
+    float* localCount = new float[numCells];
+
+    int iPlus = int(maxIplus);
+    int jPlus = int(maxJplus);
+    int kPlus = int(maxKplus);
+    float reach = sqrt(RSquare);
+    int iFirst = -iPlus, iLast = iPlus;
+    int jFirst = -jPlus, jLast = jPlus;
+    int kFirst = -kPlus, kLast = kPlus;
+    if (int(reach/iGridsp) + 2 < iPlus) { iFirst = -(int(reach/iGridsp) + 2); iLast = -iFirst; }
+    if (int(reach/jGridsp) + 2 < jPlus) { jFirst = -(int(reach/jGridsp) + 2); jLast = -jFirst; }
+    if (int(reach/kGridsp) + 2 < kPlus) { kFirst = -(int(reach/kGridsp) + 2); kLast = -kFirst; }
 
     int maxfoldpasses = 1;
     int localArea = 10;
     for (int foldpass = 0; foldpass < maxfoldpasses; foldpass++) {
+        QtConcurrent::blockingMap(rows, LocalSumRow(this, localArea, localSum, localCount));
+
         // Find good values
-        for (int n = 0; n < radarData->getNumRays(); n++) {
-            Ray* currentRay = radarData->getRay(n);
-            float theta = deg2rad * fmodf((450. - currentRay->getAzimuth()),360.);
-            float phi = deg2rad * (90. - (currentRay->getElevation()));
-
-            if ((currentRay->getVel_numgates() > 0)) {
-                    // Just grab the lowest elevation sweeps & try to adjust bad folds
-                    //and (currentRay->getElevation() < 0.75)) {
-                float* velData = currentRay->getVelData();
-                // float* swData = currentRay->getSwData();
-                float nyquist = currentRay->getNyquist_vel();
-                for (int g = 0; g <= (currentRay->getVel_numgates()-1); g++) {
-                    if (velData[g] == -999.) { continue; }
-
-                    float range = float(currentRay->getFirst_vel_gate() +
-                                        (g * currentRay->getVel_gatesp()))/1000.;
-                    float x = range*sin(phi)*cos(theta);
-                    if ((x < (xmin - iGridsp)) or x > (xmax + iGridsp)) { continue; }
-                    float y = range*sin(phi)*sin(theta);
-                    if ((y < (ymin - jGridsp)) or y > (ymax + jGridsp)) { continue; }
-                    float z = radarData->radarBeamHeight(range,
-                                                         currentRay->getElevation() );
-                    if ((z < (zmin - kGridsp)) or z > (zmax + kGridsp)) { continue; }
-
-                    // Looks like a good point, find its closest Cartesian index
-                    float i = (x - xmin)/iGridsp;
-                    float j = (y - ymin)/jGridsp;
-                    float k = (z - zmin)/kGridsp;
-                    float RSquareLinear = RSquare; //* range*range / 30276.0;
-                    for (int kplus = -maxKplus; kplus <= maxKplus; kplus++) {
-                    for (int jplus = -maxJplus; jplus <= maxJplus; jplus++) {
-                        for (int iplus = -maxIplus; iplus <= maxIplus; iplus++) {
-                            int iIndex = (int)(i+iplus);
-                            int jIndex = (int)(j+jplus);
-                            int kIndex = (int)(k+kplus);
-                            if ((iIndex < 0) or (iIndex >= (int)iDim)) { continue; }
-                            if ((jIndex < 0) or (jIndex >= (int)jDim)) { continue; }
-                            if ((kIndex < 0) or (kIndex >= (int)kDim)) { continue; }
-
-                            float dx = (i - (int)(i+iplus))*iGridsp;
-                            float dy = (j - (int)(j+jplus))*jGridsp;
-                            float dz = (k - (int)(k+kplus))*kGridsp;
-                            float rSquare = (dx*dx) + (dy*dy) + (dz*dz);
-                            if (rSquare > RSquareLinear) { continue; }
-                            float avgCappi = 0;
-                            float quadcount = 0;
-                            for (int quadi = iIndex-localArea; quadi <= iIndex+localArea; quadi++) {
-                                for (int quadj = jIndex-localArea; quadj <= jIndex+localArea; quadj++) {
-                                    if ((quadi < 0) or (quadi >= (int)iDim)) { continue; }
-                                    if ((quadj < 0) or (quadj >= (int)jDim)) { continue; }
-                                    if (dataGrid[1][quadi][quadj][kIndex] != -999) {
-                                        avgCappi += dataGrid[1][quadi][quadj][kIndex];
-                                        quadcount++;
-                                    }
-                                }
-                            }
-                            int minfold = 0;
-                            if (quadcount != 0) { // Need at least one seed from the higher nyquist, otherwise use original
-                                avgCappi /= quadcount;
-                                float velDiff = velData[g] - avgCappi;
-                                if (fabs(velDiff) > nyquist) {
-                                    // Potential folding problem
-                                    float mindiff = 999999;
-                                    for (int fold=-2; fold <=2; fold++) {
-                                        velDiff = velData[g]+2*fold*nyquist - avgCappi;
-                                        if (fabs(velDiff) < mindiff) {
-                                            mindiff = fabs(velDiff);
-                                            minfold = fold;
-                                        }
-                                    }
+        for (int n = 0; n < velGates.size(); n++) {
+            const CressmanGate& gate = velGates[n];
+            float* velData = gate.data;
+            float nyquist = gate.nyquist;
+            float i = gate.i;
+            float j = gate.j;
+            float k = gate.k;
+            float RSquareLinear = RSquare; //* range*range / 30276.0;
+            for (int kplus = kFirst; kplus <= kLast; kplus++) {
+            for (int jplus = jFirst; jplus <= jLast; jplus++) {
+                for (int iplus = iFirst; iplus <= iLast; iplus++) {
+                    int iIndex = (int)(i+iplus);
+                    int jIndex = (int)(j+jplus);
+                    int kIndex = (int)(k+kplus);
+                    if ((iIndex < 0) or (iIndex >= (int)iDim)) { continue; }
+                    if ((jIndex < 0) or (jIndex >= (int)jDim)) { continue; }
+                    if ((kIndex < 0) or (kIndex >= (int)kDim)) { continue; }
+
+                    float dx = (i - (int)(i+iplus))*iGridsp;
+                    float dy = (j - (int)(j+jplus))*jGridsp;
+                    float dz = (k - (int)(k+kplus))*kGridsp;
+                    float rSquare = (dx*dx) + (dy*dy) + (dz*dz);
+                    if (rSquare > RSquareLinear) { continue; }
+                    long cell = cellIndex(iIndex,jIndex,kIndex);
+                    float avgCappi = localSum[cell];
+                    float quadcount = localCount[cell];
+                    int minfold = 0;
+                    if (quadcount != 0) { // Need at least one seed from the higher nyquist, otherwise use original
+                        avgCappi /= quadcount;
+                        float velDiff = velData[0] - avgCappi;
+                        if (fabs(velDiff) > nyquist) {
+                            // Potential folding problem
+                            float mindiff = 999999;
+                            for (int fold=-2; fold <=2; fold++) {
+                                velDiff = velData[0]+2*fold*nyquist - avgCappi;
+                                if (fabs(velDiff) < mindiff) {
+                                    mindiff = fabs(velDiff);
+                                    minfold = fold;
                                 }
                             }
-                            velData[g] += 2*minfold*nyquist;
-                            float newVel = velData[g];
-                            float weight = (100*nyquist) * (RSquareLinear - rSquare) / (RSquareLinear + rSquare);
-                            velValues[iIndex][jIndex][kIndex].weight += weight;
-                            velValues[iIndex][jIndex][kIndex].sumVel += weight*newVel;
                         }
                     }
-                    }
+                    velData[0] += 2*minfold*nyquist;
+                    float newVel = velData[0];
+                    float weight = (100*nyquist) * (RSquareLinear - rSquare) / (RSquareLinear + rSquare);
+                    velValues[cell].weight += weight;
+                    velValues[cell].sumVel += weight*newVel;
                 }
-
-                velData = NULL;
-                // swData = NULL;
-                //delete velData;
-                //delete swData;
             }
-            currentRay = NULL;
-            //delete currentRay;
+            }
         }
 
 
@@ -467,12 +413,12 @@ void CappiGrid::CressmanInterpolation(RadarData *radarData)
         for (int k = 0; k < int(kDim); k++) {
             for (int j = 0; j < int(jDim); j++) {
                 for (int i = 0; i < int(iDim); i++) {
-                    dataGrid[1][i][j][k] = -999;
-                    if (velValues[i][j][k].weight > 0) {
-                        dataGrid[1][i][j][k] = velValues[i][j][k].sumVel/velValues[i][j][k].weight;
+                    gridValue(1,i,j,k) = -999;
+                    if (velValues[cellIndex(i,j,k)].weight > 0) {
+                        gridValue(1,i,j,k) = velValues[cellIndex(i,j,k)].sumVel/velValues[cellIndex(i,j,k)].weight;
                     }
-                    velValues[i][j][k].sumVel = 0;
-                    velValues[i][j][k].weight = 0;
+                    velValues[cellIndex(i,j,k)].sumVel = 0;
+                    velValues[cellIndex(i,j,k)].weight = 0;
                 }
             }
         }
@@ -490,8 +436,8 @@ void CappiGrid::CressmanInterpolation(RadarData *radarData)
                     for (int quadj = j-localArea; quadj <= j+localArea; quadj++) {
                         if ((quadi < 0) or (quadi >= (int)iDim)) { continue; }
                         if ((quadj < 0) or (quadj >= (int)jDim)) { continue; }
-                        if (dataGrid[1][quadi][quadj][k] != -999) {
-                            avgCappi += dataGrid[1][quadi][quadj][k];
+                        if (gridValue(1,quadi,quadj,k) != -999) {
+                            avgCappi += gridValue(1,quadi,quadj,k);
                             quadcount++;
                         }
                     }
@@ -503,22 +449,26 @@ void CappiGrid::CressmanInterpolation(RadarData *radarData)
                         for (int quadj = j-localArea; quadj <= j+localArea; quadj++) {
                             if ((quadi < 0) or (quadi >= (int)iDim)) { continue; }
                             if ((quadj < 0) or (quadj >= (int)jDim)) { continue; }
-                            if (dataGrid[1][quadi][quadj][k] != -999) {
-                                stdVel += (dataGrid[1][quadi][quadj][k]-avgCappi)*
-                                        (dataGrid[1][quadi][quadj][k]-avgCappi);
+                            if (gridValue(1,quadi,quadj,k) != -999) {
+                                stdVel += (gridValue(1,quadi,quadj,k)-avgCappi)*
+                                        (gridValue(1,quadi,quadj,k)-avgCappi);
                             }
                         }
                     }
                     stdVel = sqrt(stdVel/quadcount);
-                    float diffCappi = fabs(dataGrid[1][i][j][k] - avgCappi);
-                    if ((diffCappi > stdVel*2) and (dataGrid[1][i][j][k] != -999)) {
-                        dataGrid[1][i][j][k] =avgCappi;
+                    float diffCappi = fabs(gridValue(1,i,j,k) - avgCappi);
+                    if ((diffCappi > stdVel*2) and (gridValue(1,i,j,k) != -999)) {
+                        gridValue(1,i,j,k) =avgCappi;
                     }
                 }
             }
         }
     }
 
+    delete[] velValues;
+    delete[] localSum;
+    delete[] localCount;
+
     /* Remove global outliers
  for (int k = 0; k < int(kDim); k++) {
   // float sumtexture = 0;
@@ -534,13 +484,13 @@ void CappiGrid::CressmanInterpolation(RadarData *radarData)
     return;
    }
    for (int i = 1; i < int(iDim)-1; i++) {
-    if (dataGrid[1][i][j][k] != -999) {
-     if (dataGrid[1][i][j][k] > 0) {
-      posCappi += dataGrid[1][i][j][k];
+    if (gridValue(1,i,j,k) != -999) {
+     if (gridValue(1,i,j,k) > 0) {
+      posCappi += gridValue(1,i,j,k);
       QString pos;
       poscount++;
      } else {
-      negCappi += dataGrid[1][i][j][k];
+      negCappi += gridValue(1,i,j,k);
       negcount++;
      }
     }
@@ -556,9 +506,9 @@ void CappiGrid::CressmanInterpolation(RadarData *radarData)
      return;
     }
     for (int i = 1; i < int(iDim)-1; i++) {
-     if ((dataGrid[1][i][j][k] != -999) and (dataGrid[1][i][j][k] > 0)) {
-      stdVel += (dataGrid[1][i][j][k]-posCappi)*
-      (dataGrid[1][i][j][k]-posCappi);
+     if ((gridValue(1,i,j,k) != -999) and (gridValue(1,i,j,k) > 0)) {
+      stdVel += (gridValue(1,i,j,k)-posCappi)*
+      (gridValue(1,i,j,k)-posCappi);
      }
     }
    }
@@ -570,10 +520,10 @@ void CappiGrid::CressmanInterpolation(RadarData *radarData)
      return;
     }
     for (int i = 1; i < int(iDim)-1; i++) {
-     float diffCappi = fabs(dataGrid[1][i][j][k] - posCappi);
-     if ((diffCappi > stdVel*2) and (dataGrid[1][i][j][k] != -999)
-      and (dataGrid[1][i][j][k] > 0)) {
-      dataGrid[1][i][j][k] = -999;
+     float diffCappi = fabs(gridValue(1,i,j,k) - posCappi);
+     if ((diffCappi > stdVel*2) and (gridValue(1,i,j,k) != -999)
+      and (gridValue(1,i,j,k) > 0)) {
+      gridValue(1,i,j,k) = -999;
      }
     }
    }
@@ -588,9 +538,9 @@ void CappiGrid::CressmanInterpolation(RadarData *radarData)
      return;
     }
     for (int i = 1; i < int(iDim)-1; i++) {
-     if ((dataGrid[1][i][j][k] != -999) and (dataGrid[1][i][j][k] < 0)) {
-      stdVel += (dataGrid[1][i][j][k]-negCappi)*
-      (dataGrid[1][i][j][k]-negCappi);
+     if ((gridValue(1,i,j,k) != -999) and (gridValue(1,i,j,k) < 0)) {
+      stdVel += (gridValue(1,i,j,k)-negCappi)*
+      (gridValue(1,i,j,k)-negCappi);
      }
     }
    }
@@ -602,10 +552,10 @@ void CappiGrid::CressmanInterpolation(RadarData *radarData)
      return;
     }
     for (int i = 1; i < int(iDim)-1; i++) {
-     float diffCappi = fabs(dataGrid[1][i][j][k] - negCappi);
-     if ((diffCappi > stdVel*2) and (dataGrid[1][i][j][k] != -999)
-      and (dataGrid[1][i][j][k] < 0)) {
-      dataGrid[1][i][j][k] = -999;
+     float diffCappi = fabs(gridValue(1,i,j,k) - negCappi);
+     if ((diffCappi > stdVel*2) and (gridValue(1,i,j,k) != -999)
+      and (gridValue(1,i,j,k) < 0)) {
+      gridValue(1,i,j,k) = -999;
      }
     }
    }
@@ -615,6 +565,152 @@ void CappiGrid::CressmanInterpolation(RadarData *radarData)
 
 }
 
+void CappiGrid::binGates(const QVector<CressmanGate>& gates, const float& maxIplus,
+                         const float& maxJplus, const float& maxKplus, GateBins& bins) const
+{
+    // Gates sit between index -1 and Dim+1, bin n holds floor(index) == n-1
+    bins.iBins = int(iDim) + 3;
+    bins.jBins = int(jDim) + 3;
+    bins.kBins = int(kDim) + 3;
+
+    // The scatter form visits int(maxPlus) offsets each way, and a cell
+    // further than the largest radius of influence gets no weight anyway
+    bins.iPlus = int(maxIplus);
+    bins.jPlus = int(maxJplus);
+    bins.kPlus = int(maxKplus);
+    float maxRadiusSq = 0;
+    for (int n = 0; n < gates.size(); n++) {
+        if (gates[n].radiusSq > maxRadiusSq)
+            maxRadiusSq = gates[n].radiusSq;
+    }
+    float reach = sqrt(maxRadiusSq);
+    bins.iReach = qMin(bins.iPlus, int(ceil(reach/iGridsp)) + 1);
+    bins.jReach = qMin(bins.jPlus, int(ceil(reach/jGridsp)) + 1);
+    bins.kReach = qMin(bins.kPlus, int(ceil(reach/kGridsp)) + 1);
+
+    // Counting sort, keeping the gates of a bin in ray order
+    int numBins = bins.iBins*bins.jBins*bins.kBins;
+    QVector<int> gateBin(gates.size());
+    bins.binStart.fill(0, numBins + 1);
+    for (int n = 0; n < gates.size(); n++) {
+        int bi = qBound(0, int(floor(gates[n].i)) + 1, bins.iBins - 1);
+        int bj = qBound(0, int(floor(gates[n].j)) + 1, bins.jBins - 1);
+        int bk = qBound(0, int(floor(gates[n].k)) + 1, bins.kBins - 1);
+        gateBin[n] = (bk*bins.jBins + bj)*bins.iBins + bi;
+        bins.binStart[gateBin[n] + 1]++;
+    }
+    for (int b = 0; b < numBins; b++)
+        bins.binStart[b + 1] += bins.binStart[b];
+
+    QVector<int> next(bins.binStart);
+    bins.gates.resize(gates.size());
+    for (int n = 0; n < gates.size(); n++)
+        bins.gates[next[gateBin[n]]++] = gates[n];
+}
+
+// Number of offsets in [-maxPlus, maxPlus] for which the scatter form of
+// the analysis puts a gate at fractional index g onto cell. Usually 0 or 1,
+// but truncation toward zero lets cell 0 be hit twice.
+static inline int cressmanHits(const float& g, const int& cell, const int& maxPlus)
+{
+    int hits = 0;
+    int first = int(floor(cell - 1 - g));
+    for (int plus = first; plus <= first + 3; plus++) {
+        if ((plus < -maxPlus) or (plus > maxPlus)) { continue; }
+        if ((int)(g+plus) == cell) hits++;
+    }
+    return hits;
+}
+
+void CappiGrid::gatherCell(const GateBins& bins, const int& i, const int& j, const int& k,
+                           float& sumValue, float& sumHeight, float& sumWeight) const
+{
+    sumValue = sumHeight = sumWeight = 0;
+    if (bins.gates.isEmpty())
+        return;
+
+    int iLow = qMax(0, i - bins.iReach), iHigh = qMin(bins.iBins - 1, i + bins.iReach + 1);
+    int jLow = qMax(0, j - bins.jReach), jHigh = qMin(bins.jBins - 1, j + bins.jReach + 1);
+    int kLow = qMax(0, k - bins.kReach), kHigh = qMin(bins.kBins - 1, k + bins.kReach + 1);
+
+    const CressmanGate* gates = bins.gates.constData();
+    const int* binStart = bins.binStart.constData();
+    for (int bk = kLow; bk <= kHigh; bk++) {
+        for (int bj = jLow; bj <= jHigh; bj++) {
+            // Bins along i are adjacent, so their gates are too
+            int row = (bk*bins.jBins + bj)*bins.iBins;
+            int first = binStart[row + iLow];
+            int last = binStart[row + iHigh + 1];
+            for (int n = first; n < last; n++) {
+                const CressmanGate& gate = gates[n];
+                int hits = cressmanHits(gate.k, k, bins.kPlus);
+                if (hits == 0) { continue; }
+                hits *= cressmanHits(gate.j, j, bins.jPlus);
+                if (hits == 0) { continue; }
+                hits *= cressmanHits(gate.i, i, bins.iPlus);
+                if (hits == 0) { continue; }
+
+                float dx = (gate.i - i)*iGridsp;
+                float dy = (gate.j - j)*jGridsp;
+                float dz = (gate.k - k)*kGridsp;
+                float rSquare = (dx*dx) + (dy*dy) + (dz*dz);
+                if (rSquare > gate.radiusSq) { continue; }
+                float weight = gate.weightScale * (gate.radiusSq - rSquare) / (gate.radiusSq + rSquare);
+                weight *= hits;
+                sumWeight += weight;
+                sumValue += weight*gate.data[0];
+                sumHeight += weight*gate.height;
+            }
+        }
+    }
+}
+
+void CappiGrid::gatherRow(const int& i, const GateBins& refBins, const GateBins& velBins)
+{
+    for (int j = 0; j < int(jDim); j++) {
+        for (int k = 0; k < int(kDim); k++) {
+            float sumValue, sumHeight, sumWeight;
+
+            gridValue(0,i,j,k) = -999;
+            gridValue(1,i,j,k) = -999;
+            gridValue(2,i,j,k) = -999;
+
+            gatherCell(refBins, i, j, k, sumValue, sumHeight, sumWeight);
+            if (sumWeight > 0) {
+                gridValue(0,i,j,k) = sumValue/sumWeight;
+            }
+            gatherCell(velBins, i, j, k, sumValue, sumHeight, sumWeight);
+            if (sumWeight > 0) {
+                gridValue(1,i,j,k) = sumValue/sumWeight;
+                gridValue(2,i,j,k) = sumHeight/sumWeight;
+            }
+        }
+    }
+}
+
+void CappiGrid::localVelocitySum(const int& i, const int& localArea, float* localSum, float* localCount) const
+{
+    // Sum of the good velocities in the (2*localArea+1)^2 box around each cell
+    for (int j = 0; j < int(jDim); j++) {
+        for (int k = 0; k < int(kDim); k++) {
+            float avgCappi = 0;
+            float quadcount = 0;
+            for (int quadi = i-localArea; quadi <= i+localArea; quadi++) {
+                for (int quadj = j-localArea; quadj <= j+localArea; quadj++) {
+                    if ((quadi < 0) or (quadi >= (int)iDim)) { continue; }
+                    if ((quadj < 0) or (quadj >= (int)jDim)) { continue; }
+                    if (gridValue(1,quadi,quadj,k) != -999) {
+                        avgCappi += gridValue(1,quadi,quadj,k);
+                        quadcount++;
+                    }
+                }
+            }
+            localSum[cellIndex(i,j,k)] = avgCappi;
+            localCount[cellIndex(i,j,k)] = quadcount;
+        }
+    }
+}
+
 // TODO
 // I think all the NetCDF stuff should be kept in the NetCDF.cpp file.
 // Put it here for now. But I can see adding the ability to read different file formats
@@ -743,6 +839,11 @@ void CappiGrid::loadPreGridded(RadarData *radarData, QDomElement cappiConfig)
     std::cerr << "Can't get z0 array from file" << std::endl;
 
   setDisplayIndex(cappiConfig, kGridsp);
+
+  if (! allocateGrid() ) {
+    std::cerr << "Error: CappiGrid::loadPreGridded couldn't allocate the grid" << std::endl;
+    return;
+  }
   
   // TODO: Some debug stuff
   // std::cout << "x0: " << iDim << ", y0: " << jDim << ", z0: " << kDim << std::endl;
@@ -852,24 +953,25 @@ void CappiGrid::loadPreGridded(RadarData *radarData, QDomElement cappiConfig)
     //	  "ref: " << ref << ", vel: " << vel << std::endl;
     float v;
 
-    // Looks like x and y are swapped in the NetCDF file.
+    // The NetCDF slab is stored y-major (x varies fastest), so the
+    // indices are swapped relative to the grid.
       
-    for(int i = 0; i < xDim; i++) {
-      for(int j = 0; j < yDim; j++) {
-	v = *(ref + i * yDim + j);		// reflectivity (REF)
+    for(int j = 0; j < yDim; j++) {
+      for(int i = 0; i < xDim; i++) {
+	v = *(ref + j * xDim + i);		// reflectivity (REF)
 	if (v <= ref_fill)
 	  v = -999;
-	dataGrid[0][j][i][k] = v;	
+	gridValue(0,i,j,k) = v;	
 
-	v = *(vel + i * yDim + j);		// dopler velocity magnitude (VU)
+	v = *(vel + j * xDim + i);		// dopler velocity magnitude (VU)
 	if (v <= vel_fill)
 	  v = -999;
-	dataGrid[1][j][i][k] = v;
+	gridValue(1,i,j,k) = v;
 
-	v = *(spec + i * yDim + j);		// spectral grid width (SW)
+	v = *(spec + j * xDim + i);		// spectral grid width (SW)
 	if (v <= spec_fill)
 	  v = -999;
-	dataGrid[2][j][i][k] = v;
+	gridValue(2,i,j,k) = v;
       }
     }
   }
@@ -903,9 +1005,9 @@ void CappiGrid::ClosestPointInterpolation()
    }
    for (int i = 0; i < int(iDim); i++) {
 
-    dataGrid[0][i][j][k] = -999.;
-    dataGrid[1][i][j][k] = -999.;
-    dataGrid[2][i][j][k] = -999.;
+    gridValue(0,i,j,k) = -999.;
+    gridValue(1,i,j,k) = -999.;
+    gridValue(2,i,j,k) = -999.;
 
     float minR = sqrt(iDim*iGridsp*iDim*iGridsp + jDim*jGridsp*jDim*jGridsp);
 
@@ -917,7 +1019,7 @@ void CappiGrid::ClosestPointInterpolation()
      if (r > gridsp) { continue; }
      if (r < minR) {
       minR = r;
-      dataGrid[0][i][j][k] = refValues[n].refValue;
+      gridValue(0,i,j,k) = refValues[n].refValue;
      }
      if (minR < gridsp/10) {
       // Close enough
@@ -934,8 +1036,8 @@ void CappiGrid::ClosestPointInterpolation()
      if (r > gridsp) { continue; }
      if (r < minR) {
       minR = r;
-      dataGrid[1][i][j][k] = velValues[n].velValue;
-      dataGrid[2][i][j][k] = velValues[n].swValue;
+      gridValue(1,i,j,k) = velValues[n].velValue;
+      gridValue(2,i,j,k) = velValues[n].swValue;
      }
      if (minR < gridsp/3) {
       // Close enough
@@ -965,9 +1067,9 @@ void CappiGrid::BilinearInterpolation(RadarData *radarData)
    }
    for (int i = 0; i < int(iDim); i++) {
 
-    dataGrid[0][i][j][k] = -999.;
-    dataGrid[1][i][j][k] = -999.;
-    dataGrid[2][i][j][k] = -999.;
+    gridValue(0,i,j,k) = -999.;
+    gridValue(1,i,j,k) = -999.;
+    gridValue(2,i,j,k) = -999.;
 
     float x = xmin + i*iGridsp;
     float y = ymin + j*jGridsp;
@@ -1021,9 +1123,9 @@ void CappiGrid::BarnesInterpolation()
     for (int j = 0; j < int(jDim); j++) {
       for (int i = 0; i < int(iDim); i++) {
 
- dataGrid[0][i][j][k] = -999.;
- dataGrid[1][i][j][k] = -999.;
- dataGrid[2][i][j][k] = -999.;
+ gridValue(0,i,j,k) = -999.;
+ gridValue(1,i,j,k) = -999.;
+ gridValue(2,i,j,k) = -999.;
 
  float sumRef = 0;
  float sumVel = 0;
@@ -1072,11 +1174,11 @@ void CappiGrid::BarnesInterpolation()
  }
 
  if (refWeight > 0) {
-   dataGrid[0][i][j][k] = sumRef/refWeight;
+   gridValue(0,i,j,k) = sumRef/refWeight;
  }
  if (velWeight > 0) {
-   dataGrid[1][i][j][k] = sumVel/velWeight;
-   dataGrid[2][i][j][k] = sumSw/velWeight;
+   gridValue(1,i,j,k) = sumVel/velWeight;
+   gridValue(2,i,j,k) = sumSw/velWeight;
  }
       }
     }
@@ -1138,11 +1240,11 @@ void CappiGrid::BarnesInterpolation()
  }
 
  if (refWeight > 0) {
-   dataGrid[0][i][j][k] += sumRef/refWeight;
+   gridValue(0,i,j,k) += sumRef/refWeight;
  }
  if (velWeight > 0) {
-   dataGrid[1][i][j][k] += sumVel/velWeight;
-   dataGrid[2][i][j][k] += sumSw/velWeight;
+   gridValue(1,i,j,k) += sumVel/velWeight;
+   gridValue(2,i,j,k) += sumSw/velWeight;
  }
       }
     }
@@ -1202,29 +1304,29 @@ float CappiGrid::trilinear(const float &x, const float &y,
   }
 
   float interpValue = 0;
-  if (dataGrid[param][x0][y0][z0] != -999) {
-    interpValue += omdx*omdy*omdz*dataGrid[param][x0][y0][z0];
+  if (gridValue(param,x0,y0,z0) != -999) {
+    interpValue += omdx*omdy*omdz*gridValue(param,x0,y0,z0);
   }
-  if (dataGrid[param][x0][y1][z0] != -999) {
-    interpValue += omdx*dy*omdz*dataGrid[param][x0][y1][z0];
+  if (gridValue(param,x0,y1,z0) != -999) {
+    interpValue += omdx*dy*omdz*gridValue(param,x0,y1,z0);
   }
-  if (dataGrid[param][x1][y0][z0] != -999) {
-    interpValue += dx*omdy*omdz*dataGrid[param][x1][y0][z0];
+  if (gridValue(param,x1,y0,z0) != -999) {
+    interpValue += dx*omdy*omdz*gridValue(param,x1,y0,z0);
   }
-  if (dataGrid[param][x1][y1][z0] != -999) {
-    interpValue += dx*dy*omdz*dataGrid[param][x1][y1][z0];
+  if (gridValue(param,x1,y1,z0) != -999) {
+    interpValue += dx*dy*omdz*gridValue(param,x1,y1,z0);
   }
-  if (dataGrid[param][x0][y0][z1] != -999) {
-    interpValue += omdx*omdy*dz*dataGrid[param][x0][y0][z1];
+  if (gridValue(param,x0,y0,z1) != -999) {
+    interpValue += omdx*omdy*dz*gridValue(param,x0,y0,z1);
   }
-  if (dataGrid[param][x0][y1][z1] != -999) {
-    interpValue += omdx*dy*dz*dataGrid[param][x0][y1][z1];
+  if (gridValue(param,x0,y1,z1) != -999) {
+    interpValue += omdx*dy*dz*gridValue(param,x0,y1,z1);
   }
-  if (dataGrid[param][x1][y0][z1] != -999) {
-    interpValue += dx*omdy*dz*dataGrid[param][x1][y0][z1];
+  if (gridValue(param,x1,y0,z1) != -999) {
+    interpValue += dx*omdy*dz*gridValue(param,x1,y0,z1);
   }
-  if (dataGrid[param][x1][y1][z1] != -999) {
-    interpValue += dx*dy*dz*dataGrid[param][x1][y1][z1];
+  if (gridValue(param,x1,y1,z1) != -999) {
+    interpValue += dx*dy*dz*gridValue(param,x1,y1,z1);
   }
 
   return interpValue;
@@ -1236,6 +1338,11 @@ void CappiGrid::writeAsi()
 
     // Write out the CAPPI to an asi file
 
+    if (dataGrid == NULL) {
+        Message::toScreen("CappiGrid: no grid data to write");
+        return;
+    }
+
     // Initialize header
     int id[511];
     for (int n = 1; n <= 510; n++) {
@@ -1334,9 +1441,10 @@ void CappiGrid::writeAsi()
 
             for(int n = 0; n < fieldNames.size(); n++) {
                 out << reset << left << fieldNames.at(n) << endl;
+                const float* row = getFieldData(n) + j*jStride + k;
                 int line = 0;
                 for (int i = 0; i < int(iDim);  i++){
-                    out << reset << qSetRealNumberPrecision(3) << scientific << qSetFieldWidth(10) << dataGrid[n][i][j][k];
+                    out << reset << qSetRealNumberPrecision(3) << scientific << qSetFieldWidth(10) << row[i*iStride];
                     line++;
                     if (line == 8) {
                         out << endl;
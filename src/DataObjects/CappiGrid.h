@@ -13,6 +13,7 @@
 
 #include <QDomElement>
 #include <QFile>
+#include <QVector>
 
 #include <Ncxx/Nc3xFile.hh>
 #include "Radar/RadarData.h"
@@ -47,11 +48,61 @@ private:
     QString outFileName;
     float* relDist;
 
-    class goodRef {
+    // A gate inside the grid, located by fractional grid index
+    class CressmanGate {
     public:
-        float sumRef;
-        float weight;
+        float i, j, k;
+        float height;
+        float radiusSq;
+        float weightScale;
+        float nyquist;
+        float* data;
     };
+
+    // Gates sorted into unit cells of the grid (offset by one so the
+    // gates just outside the grid have a bin too). A cell only looks at
+    // the bins within reach of its radius of influence.
+    class GateBins {
+    public:
+        QVector<CressmanGate> gates;
+        QVector<int> binStart;
+        int iBins, jBins, kBins;
+        int iPlus, jPlus, kPlus;
+        int iReach, jReach, kReach;
+    };
+
+    class GatherRow {
+    public:
+        GatherRow(CappiGrid* grid, const GateBins* refBins, const GateBins* velBins)
+            : grid(grid), refBins(refBins), velBins(velBins) {}
+        typedef void result_type;
+        void operator()(const int& i) const { grid->gatherRow(i, *refBins, *velBins); }
+    private:
+        CappiGrid* grid;
+        const GateBins* refBins;
+        const GateBins* velBins;
+    };
+
+    class LocalSumRow {
+    public:
+        LocalSumRow(const CappiGrid* grid, int localArea, float* localSum, float* localCount)
+            : grid(grid), localArea(localArea), localSum(localSum), localCount(localCount) {}
+        typedef void result_type;
+        void operator()(const int& i) const { grid->localVelocitySum(i, localArea, localSum, localCount); }
+    private:
+        const CappiGrid* grid;
+        int localArea;
+        float* localSum;
+        float* localCount;
+    };
+
+    void binGates(const QVector<CressmanGate>& gates, const float& maxIplus, const float& maxJplus,
+                  const float& maxKplus, GateBins& bins) const;
+    void gatherCell(const GateBins& bins, const int& i, const int& j, const int& k,
+                    float& sumValue, float& sumHeight, float& sumWeight) const;
+    void gatherRow(const int& i, const GateBins& refBins, const GateBins& velBins);
+    void localVelocitySum(const int& i, const int& localArea, float* localSum, float* localCount) const;
+
     class goodVel {
     public:
         float sumVel;
@@ -62,8 +113,6 @@ private:
     bool gridReflectivity;
     long maxRefIndex;
     long maxVelIndex;
-    goodRef refValues[maxIDim][maxJDim][maxKDim];
-    goodVel velValues[maxIDim][maxJDim][maxKDim];
 
 };
 
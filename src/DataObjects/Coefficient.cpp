@@ -15,24 +15,17 @@ Coefficient::Coefficient()
     level = -999;
     radius = -999;
     value = -999;
-    parameter = QString("NULL");
+    parameter = NoParameter;
 }
 
-Coefficient::Coefficient(float newLevel, float newRadius, float newValue,QString name)
+Coefficient::Coefficient(float newLevel, float newRadius, float newValue,
+                         Parameter newParameter)
 {
     level = newLevel;
     radius = newRadius;
     value = newValue;
-    parameter = name;
-
-}
+    parameter = newParameter;
 
-Coefficient::Coefficient(const Coefficient &other)
-{
-    this->level = other.level;
-    this->radius = other.radius;
-    this->value = other.value;
-    this->parameter = other.parameter;
 }
 
 bool Coefficient::isValid() const {
@@ -56,11 +49,59 @@ void Coefficient::setValue(const float &newValue)
     value = newValue;
 }
 
-void Coefficient::setParameter(const QString &newParameter)
+void Coefficient::setParameter(const Parameter &newParameter)
 {
     parameter = newParameter;
 }
 
+Coefficient::Parameter Coefficient::VTC(int n)
+{
+    if(n == 0)
+        return VTC0;
+    int param = VTC1 + 2 * (n - 1);
+    if((n < 0) || (param >= NumParameters))
+        return NoParameter;
+    return Parameter(param);
+}
+
+Coefficient::Parameter Coefficient::VTS(int n)
+{
+    int param = VTS1 + 2 * (n - 1);
+    if((n < 1) || (param >= NumParameters))
+        return NoParameter;
+    return Parameter(param);
+}
+
+QString Coefficient::parameterName(const Parameter &param)
+{
+    switch(param) {
+    case VTC0:
+        return QString("VTC0");
+    case VRC0:
+        return QString("VRC0");
+    case VMC0:
+        return QString("VMC0");
+    case NoParameter:
+    case NumParameters:
+        return QString("NULL");
+    default:
+        break;
+    }
+    // VTC1, VTS1, VTC2, ... alternate from VTC1 on
+    int offset = param - VTC1;
+    QString prefix = (offset % 2 == 0) ? QString("VTC") : QString("VTS");
+    return prefix + QString().setNum(offset / 2 + 1);
+}
+
+Coefficient::Parameter Coefficient::parameterFromName(const QString &name)
+{
+    for(int param = 0; param < NumParameters; param++) {
+        if(parameterName(Parameter(param)) == name)
+            return Parameter(param);
+    }
+    return NoParameter;
+}
+
 bool Coefficient::operator == (const Coefficient &other)
 {
     if(level == other.getLevel())
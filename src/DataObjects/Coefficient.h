@@ -17,9 +17,18 @@ class Coefficient
 {
 
 public:
+    // The wind components the VTD analyses produce. The names are only used
+    // when coefficients are written out; everything else compares these.
+    enum Parameter {
+        NoParameter = -1,
+        VTC0, VRC0, VMC0,
+        VTC1, VTS1, VTC2, VTS2, VTC3, VTS3, VTC4, VTS4,
+        VTC5, VTS5, VTC6, VTS6, VTC7, VTS7,
+        NumParameters
+    };
+
     Coefficient();
-    Coefficient(float newLevel, float newRadius, float newValue, QString name);
-    Coefficient(const Coefficient &other);
+    Coefficient(float newLevel, float newRadius, float newValue, Parameter newParameter);
 
     bool isValid() const;
     
@@ -32,8 +41,16 @@ public:
     float getValue() const { return value; }
     void setValue(const float &newValue);
 
-    QString getParameter() const { return parameter; }
-    void setParameter(const QString &newParameter);
+    Parameter getParameter() const { return parameter; }
+    void setParameter(const Parameter &newParameter);
+    QString getParameterName() const { return parameterName(parameter); }
+
+    // Cosine and sine tangential wind terms of wave number n
+    static Parameter VTC(int n);
+    static Parameter VTS(int n);
+
+    static QString parameterName(const Parameter &param);
+    static Parameter parameterFromName(const QString &name);
 
     bool operator == (const Coefficient &other);
 
@@ -44,7 +61,7 @@ private:
     float level;
     float radius;
     float value;
-    QString parameter;
+    Parameter parameter;
 
 };
 
@@ -15,7 +15,10 @@
 
 #include "GriddedData.h"
 #include "Message.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 
 GriddedData::GriddedData()
 { 
@@ -44,11 +47,121 @@ GriddedData::GriddedData()
 
     // TODO:
     kDisplayIndex = 0;
+    gatesGridded = 0;
+
+    ringIndexIGridsp = 0;
+    ringIndexJGridsp = 0;
+    ringIndexRadiusSpacing = 0;
+
+    // No storage until the subclass knows its dimensions
+    dataGrid = NULL;
+    gridSize = 0;
+    fieldStride = iStride = jStride = 0;
+}
+
+GriddedData::GriddedData(const GriddedData& other)
+{
+    dataGrid = NULL;
+    gridSize = 0;
+    *this = other;
+}
+
+GriddedData& GriddedData::operator=(const GriddedData& other)
+{
+    if (this == &other)
+        return *this;
+
+    iDim = other.iDim;
+    jDim = other.jDim;
+    kDim = other.kDim;
+    iGridsp = other.iGridsp;
+    jGridsp = other.jGridsp;
+    kGridsp = other.kGridsp;
+    Pi = other.Pi;
+    deg2rad = other.deg2rad;
+    rad2deg = other.rad2deg;
+    numFields = other.numFields;
+    fieldNames = other.fieldNames;
+    sphericalRangeSpacing = other.sphericalRangeSpacing;
+    sphericalAzimuthSpacing = other.sphericalAzimuthSpacing;
+    sphericalElevationSpacing = other.sphericalElevationSpacing;
+    cylindricalRadiusSpacing = other.cylindricalRadiusSpacing;
+    cylindricalAzimuthSpacing = other.cylindricalAzimuthSpacing;
+    cylindricalHeightSpacing = other.cylindricalHeightSpacing;
+    refPointI = other.refPointI;
+    refPointJ = other.refPointJ;
+    refPointK = other.refPointK;
+    originLat = other.originLat;
+    originLon = other.originLon;
+    xmin = other.xmin;
+    xmax = other.xmax;
+    ymin = other.ymin;
+    ymax = other.ymax;
+    zmin = other.zmin;
+    zmax = other.zmax;
+    kDisplayIndex = other.kDisplayIndex;
+    gatesGridded = other.gatesGridded;
+    ringIndexCache = other.ringIndexCache;
+    ringIndexIGridsp = other.ringIndexIGridsp;
+    ringIndexJGridsp = other.ringIndexJGridsp;
+    ringIndexRadiusSpacing = other.ringIndexRadiusSpacing;
+    sphericalIndex = other.sphericalIndex;
+
+    // Only copy the part of the grid that is actually in use
+    if (other.dataGrid == NULL) {
+        freeGrid();
+    } else if (allocateGrid()) {
+        long copySize = (gridSize < other.gridSize) ? gridSize : other.gridSize;
+        memcpy(dataGrid, other.dataGrid, copySize*sizeof(float));
+    }
+    return *this;
 }
 
 GriddedData::~GriddedData()
 {
+    freeGrid();
+}
+
+bool GriddedData::allocateGrid()
+{
+    long ni = long(iDim);
+    long nj = long(jDim);
+    long nk = long(kDim);
+    if ((ni <= 0) or (nj <= 0) or (nk <= 0)) {
+        Message::toScreen("GriddedData: allocateGrid: invalid grid dimensions "
+                          +QString().setNum(ni)+"x"+QString().setNum(nj)+"x"+QString().setNum(nk));
+        freeGrid();
+        return false;
+    }
 
+    long newSize = maxFields*ni*nj*nk;
+    if ((dataGrid == NULL) or (newSize != gridSize)) {
+        freeGrid();
+        // Align to a cache line so the k columns vectorize cleanly
+        void* buffer = NULL;
+        if (posix_memalign(&buffer, 64, newSize*sizeof(float)) != 0) {
+            Message::toScreen("GriddedData: allocateGrid: unable to allocate "
+                              +QString().setNum(newSize*sizeof(float))+" bytes");
+            return false;
+        }
+        dataGrid = (float*)buffer;
+        gridSize = newSize;
+    }
+    jStride = nk;
+    iStride = nj*nk;
+    fieldStride = ni*nj*nk;
+
+    for (long n = 0; n < gridSize; n++)
+        dataGrid[n] = -999;
+    return true;
+}
+
+void GriddedData::freeGrid()
+{
+    free(dataGrid);
+    dataGrid = NULL;
+    gridSize = 0;
+    fieldStride = iStride = jStride = 0;
 }
 
 void GriddedData::writeAsi()
@@ -77,7 +190,7 @@ void GriddedData::setLatLonOrigin(float *knownLat, float *knownLon, float *relX,
     // testing Message::toScreen("Set Zero: ZeroLat = "+QString().setNum(zeroLat)+" ZeroLon = "+QString().setNum(zeroLon));
 }
 
-float GriddedData::fixAngle(float angle) {
+float GriddedData::fixAngle(float angle) const {
     // Takes and angle in radians and puts it in the 0-2Pi range
 
     float fixangle = angle;
@@ -96,9 +209,11 @@ void GriddedData::setReferencePoint(int ii, int jj, int kk)
 
     //Message::toScreen("GriddedData: Using the Index Based Reference Assignment");
 
-    if((ii > iDim)||(ii < 0)||(jj > jDim)||(jj < 0)||(kk > kDim)||(kk < 0))
+    // An index outside the grid leaves the reference point where it was
+    if((ii >= iDim)||(ii < 0)||(jj >= jDim)||(jj < 0)||(kk >= kDim)||(kk < 0))
         //Message::toScreen("GriddedData: trying to examine point outside cappi for setReferencePoint: i = "+QString().setNum(ii)+" j = "+QString().setNum(jj)+" k = "+QString().setNum(kk));
-        refPointI = ii;
+        return;
+    refPointI = ii;
     refPointJ = jj;
     refPointK = kk;
 }
@@ -125,6 +240,17 @@ void GriddedData::setCartesianReferencePoint(float ii, float jj, float kk)
    */
 }
 
+float GriddedData::getReferenceIndexI(const float& ii) const
+{
+    // Same rounding as setCartesianReferencePoint, without storing the result
+    return int(floor((ii- xmin)/iGridsp+.5));
+}
+
+float GriddedData::getReferenceIndexJ(const float& jj) const
+{
+    return int(floor((jj -ymin)/jGridsp+.5));
+}
+
 // TODO What if Lat and/or Lon is -999. refPoint* will be non-sensical
 
 void GriddedData::setAbsoluteReferencePoint(float Lat, float Lon, float Height) 
@@ -367,10 +493,10 @@ float GriddedData::getIndexValue(QString& fieldName, float& ii, float& jj, float
     // a point on the defined cartesian grid in km.
     // It is a simple accessor function.
 
-    if((ii > iDim)||(ii < 0)||(jj > jDim)||(jj < 0)||(kk > kDim)||(kk < 0))
+    if((ii >= iDim)||(ii < 0)||(jj >= jDim)||(jj < 0)||(kk >= kDim)||(kk < 0))
         return -999.;
     int field = getFieldIndex(fieldName);
-    return dataGrid[field][(int)ii][(int)jj][(int)kk];
+    return gridValue(field,(int)ii,(int)jj,(int)kk);
 
 }
 
@@ -401,10 +527,10 @@ float* GriddedData::getCartesianXslice(const QString& fieldName,
 
     for(int i = 0; i < iDim; i++) {
         float ave = 0;
-        ave += (1-jjMaxDiff)*(1-kkMinDiff)*dataGrid[field][i][jjMax][kkMin];
-        ave += (1-jjMinDiff)*(1-kkMinDiff)*dataGrid[field][i][jjMin][kkMin];
-        ave += (1-jjMaxDiff)*(1-kkMaxDiff)*dataGrid[field][i][jjMax][kkMax];
-        ave += (1-jjMinDiff)*(1-kkMaxDiff)*dataGrid[field][i][jjMin][kkMax];
+        ave += (1-jjMaxDiff)*(1-kkMinDiff)*gridValue(field,i,jjMax,kkMin);
+        ave += (1-jjMinDiff)*(1-kkMinDiff)*gridValue(field,i,jjMin,kkMin);
+        ave += (1-jjMaxDiff)*(1-kkMaxDiff)*gridValue(field,i,jjMax,kkMax);
+        ave += (1-jjMinDiff)*(1-kkMaxDiff)*gridValue(field,i,jjMin,kkMax);
         values[i] = ave;
     }
     return values;
@@ -438,10 +564,10 @@ float* GriddedData::getCartesianYslice(const QString& fieldName,
 
     for(int j = 0; j < jDim; j++) {
         float ave = 0;
-        ave += (1-iiMinDiff)*(1-kkMaxDiff)*dataGrid[field][iiMin][j][kkMax];
-        ave += (1-iiMaxDiff)*(1-kkMaxDiff)*dataGrid[field][iiMax][j][kkMax];
-        ave += (1-iiMinDiff)*(1-kkMinDiff)*dataGrid[field][iiMin][j][kkMin];
-        ave += (1-iiMaxDiff)*(1-kkMinDiff)*dataGrid[field][iiMax][j][kkMin];
+        ave += (1-iiMinDiff)*(1-kkMaxDiff)*gridValue(field,iiMin,j,kkMax);
+        ave += (1-iiMaxDiff)*(1-kkMaxDiff)*gridValue(field,iiMax,j,kkMax);
+        ave += (1-iiMinDiff)*(1-kkMinDiff)*gridValue(field,iiMin,j,kkMin);
+        ave += (1-iiMaxDiff)*(1-kkMinDiff)*gridValue(field,iiMax,j,kkMin);
         values[j] = ave;
     }
     return values;
@@ -474,10 +600,10 @@ float* GriddedData::getCartesianZslice(const QString& fieldName,
 
     for(int k = 0; k < kDim; k++) {
         float ave = 0;
-        ave += (1-jjMinDiff)*(1-iiMaxDiff)*dataGrid[field][iiMax][jjMin][k];
-        ave += (1-jjMaxDiff)*(1-iiMaxDiff)*dataGrid[field][iiMax][jjMax][k];
-        ave += (1-jjMinDiff)*(1-iiMinDiff)*dataGrid[field][iiMin][jjMin][k];
-        ave += (1-jjMaxDiff)*(1-iiMinDiff)*dataGrid[field][iiMin][jjMax][k];
+        ave += (1-jjMinDiff)*(1-iiMaxDiff)*gridValue(field,iiMax,jjMin,k);
+        ave += (1-jjMaxDiff)*(1-iiMaxDiff)*gridValue(field,iiMax,jjMax,k);
+        ave += (1-jjMinDiff)*(1-iiMinDiff)*gridValue(field,iiMin,jjMin,k);
+        ave += (1-jjMaxDiff)*(1-iiMinDiff)*gridValue(field,iiMin,jjMax,k);
         values[k] = ave;
     }
     return values;
@@ -513,42 +639,135 @@ float GriddedData::getCartesianValue(const QString& fieldName, const float& x,
     float iiMaxDiff = iiMax - iiIndex;
 
     float ave = 0;
-    ave += (1-jjMinDiff)*(1-iiMaxDiff)*(1-kkMinDiff)*dataGrid[field][iiMax][jjMin][kkMin];
-    ave += (1-jjMaxDiff)*(1-iiMaxDiff)*(1-kkMinDiff)*dataGrid[field][iiMax][jjMax][kkMin];
-    ave += (1-jjMinDiff)*(1-iiMinDiff)*(1-kkMinDiff)*dataGrid[field][iiMin][jjMin][kkMin];
-    ave += (1-jjMaxDiff)*(1-iiMinDiff)*(1-kkMinDiff)*dataGrid[field][iiMin][jjMax][kkMin];
-    ave += (1-jjMinDiff)*(1-iiMaxDiff)*(1-kkMaxDiff)*dataGrid[field][iiMax][jjMin][kkMax];
-    ave += (1-jjMaxDiff)*(1-iiMaxDiff)*(1-kkMaxDiff)*dataGrid[field][iiMax][jjMax][kkMax];
-    ave += (1-jjMinDiff)*(1-iiMinDiff)*(1-kkMaxDiff)*dataGrid[field][iiMin][jjMin][kkMax];
-    ave += (1-jjMaxDiff)*(1-iiMinDiff)*(1-kkMaxDiff)*dataGrid[field][iiMin][jjMax][kkMax];
+    ave += (1-jjMinDiff)*(1-iiMaxDiff)*(1-kkMinDiff)*gridValue(field,iiMax,jjMin,kkMin);
+    ave += (1-jjMaxDiff)*(1-iiMaxDiff)*(1-kkMinDiff)*gridValue(field,iiMax,jjMax,kkMin);
+    ave += (1-jjMinDiff)*(1-iiMinDiff)*(1-kkMinDiff)*gridValue(field,iiMin,jjMin,kkMin);
+    ave += (1-jjMaxDiff)*(1-iiMinDiff)*(1-kkMinDiff)*gridValue(field,iiMin,jjMax,kkMin);
+    ave += (1-jjMinDiff)*(1-iiMaxDiff)*(1-kkMaxDiff)*gridValue(field,iiMax,jjMin,kkMax);
+    ave += (1-jjMaxDiff)*(1-iiMaxDiff)*(1-kkMaxDiff)*gridValue(field,iiMax,jjMax,kkMax);
+    ave += (1-jjMinDiff)*(1-iiMinDiff)*(1-kkMaxDiff)*gridValue(field,iiMin,jjMin,kkMax);
+    ave += (1-jjMaxDiff)*(1-iiMinDiff)*(1-kkMaxDiff)*gridValue(field,iiMin,jjMax,kkMax);
     return ave;
 
 }
 
-int GriddedData::getSphericalRangeLength(float azimuth, float elevation)
+void GriddedData::updateSphericalIndex()
 {
-    int count = 0;
+    SphericalIndex& index = sphericalIndex;
+    if ((index.refI == refPointI) && (index.refJ == refPointJ)
+            && (index.iGridsp == iGridsp) && (index.jGridsp == jGridsp)
+            && (index.iDim == int(iDim)) && (index.jDim == int(jDim))) {
+        // Columns still good, the last ray also depends on k
+        if ((index.refK != refPointK) || (index.kGridsp != kGridsp)
+                || (index.kDim != int(kDim)))
+            index.hasRay = false;
+        index.refK = refPointK;
+        index.kGridsp = kGridsp;
+        index.kDim = int(kDim);
+        return;
+    }
 
+    index.refI = refPointI;
+    index.refJ = refPointJ;
+    index.refK = refPointK;
+    index.iGridsp = iGridsp;
+    index.jGridsp = jGridsp;
+    index.kGridsp = kGridsp;
+    index.iDim = int(iDim);
+    index.jDim = int(jDim);
+    index.kDim = int(kDim);
+    index.hasRay = false;
+
+    // Same azimuth and horizontal distance as the grid scan, once per column
+    int numColumns = index.iDim*index.jDim;
+    QVector<QPair<float, int> > byAzimuth(numColumns);
+    QVector<float> columnRp(numColumns);
     for(int i = 0; i < iDim; i ++) {
         for(int j = 0; j < jDim; j ++) {
-            for (int k = 0; k < kDim; k++) {
-                float rp = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ));
-                float pAzimuth = fixAngle(atan2((j-refPointJ),(i-refPointI)))*rad2deg;
-                float pElevation = fixAngle(atan2((k-refPointK),rp))*rad2deg;
-                if((pAzimuth <= (azimuth+sphericalAzimuthSpacing/2.))
-                        && (pAzimuth > (azimuth-sphericalAzimuthSpacing/2.))) {
+            int column = i*index.jDim + j;
+            columnRp[column] = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ));
+            byAzimuth[column] = qMakePair(float(fixAngle(atan2((j-refPointJ),(i-refPointI)))*rad2deg), column);
+        }
+    }
+    std::sort(byAzimuth.begin(), byAzimuth.end());
+
+    index.azimuth.resize(numColumns);
+    index.column.resize(numColumns);
+    index.rp.resize(numColumns);
+    for (int c = 0; c < numColumns; c++) {
+        index.azimuth[c] = byAzimuth.at(c).first;
+        index.column[c] = byAzimuth.at(c).second;
+        index.rp[c] = columnRp.at(byAzimuth.at(c).second);
+    }
+}
 
-                    // QString test("pElevation " +QString().setNum( pElevation )+ " elevation " +QString().setNum( elevation )+ "sphericalElevationSpacing " +QString().setNum( sphericalElevationSpacing )+ "\n");
-                    //Message::toScreen(test);
-                    if((pElevation <=(elevation+sphericalElevationSpacing/2.))
-                            && (pElevation > (elevation-sphericalElevationSpacing/2.))) {
-                        count++;
-                    }
-                }
+void GriddedData::getSphericalAzimuthColumns(float azimuth, QVector<int>& columns)
+{
+    updateSphericalIndex();
+    const SphericalIndex& index = sphericalIndex;
+
+    // The azimuth test of the grid scan picks a contiguous run of the
+    // sorted columns
+    double low = azimuth-sphericalAzimuthSpacing/2.;
+    double high = azimuth+sphericalAzimuthSpacing/2.;
+    QVector<float>::const_iterator first =
+        std::upper_bound(index.azimuth.constBegin(), index.azimuth.constEnd(), low);
+    QVector<float>::const_iterator last =
+        std::upper_bound(first, index.azimuth.constEnd(), high);
+
+    // Back into scan order
+    QVector<QPair<int, int> > byColumn;
+    for (QVector<float>::const_iterator c = first; c != last; ++c) {
+        int pos = c - index.azimuth.constBegin();
+        byColumn.append(qMakePair(index.column.at(pos), pos));
+    }
+    std::sort(byColumn.begin(), byColumn.end());
+    columns.resize(byColumn.size());
+    for (int c = 0; c < byColumn.size(); c++)
+        columns[c] = byColumn.at(c).second;
+}
+
+void GriddedData::findSphericalRangeCells(float azimuth, float elevation)
+{
+    updateSphericalIndex();
+    SphericalIndex& index = sphericalIndex;
+    if (index.hasRay && (index.rayAzimuth == azimuth) && (index.rayElevation == elevation)
+            && (index.rayAzimuthSpacing == sphericalAzimuthSpacing)
+            && (index.rayElevationSpacing == sphericalElevationSpacing))
+        return;
+
+    QVector<int> columns;
+    getSphericalAzimuthColumns(azimuth, columns);
+
+    index.rayI.clear();
+    index.rayJ.clear();
+    index.rayK.clear();
+    for (int c = 0; c < columns.size(); c++) {
+        int pos = columns.at(c);
+        int i = index.column.at(pos) / index.jDim;
+        int j = index.column.at(pos) % index.jDim;
+        float rp = index.rp.at(pos);
+        for (int k = 0; k < kDim; k++) {
+            float pElevation = fixAngle(atan2((k-refPointK),rp))*rad2deg;
+            if((pElevation <=(elevation+sphericalElevationSpacing/2.))
+                    && (pElevation > (elevation-sphericalElevationSpacing/2.))) {
+                index.rayI.append(i);
+                index.rayJ.append(j);
+                index.rayK.append(k);
             }
         }
     }
-    return count;
+    index.rayAzimuth = azimuth;
+    index.rayElevation = elevation;
+    index.rayAzimuthSpacing = sphericalAzimuthSpacing;
+    index.rayElevationSpacing = sphericalElevationSpacing;
+    index.hasRay = true;
+}
+
+int GriddedData::getSphericalRangeLength(float azimuth, float elevation)
+{
+    findSphericalRangeCells(azimuth, elevation);
+    return sphericalIndex.rayI.size();
 }
 
 float* GriddedData::getSphericalRangeData(QString& fieldName, float azimuth, 
@@ -564,24 +783,11 @@ float* GriddedData::getSphericalRangeData(QString& fieldName, float azimuth,
     int field = getFieldIndex(fieldName);
     float *values = new float[numPoints];
 
-    int count = 0;
-    for(int i = 0; i < iDim; i ++) {
-        for(int j = 0; j < jDim; j++) {
-            for (int k = 0; k < kDim; k++) {
-                float rp = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ));
-                float pAzimuth = fixAngle(atan2((j-refPointJ),(i-refPointI)))*rad2deg;
-                float pElevation = fixAngle(atan2((k-refPointK),rp))*rad2deg;
-                if((pAzimuth <= (azimuth+sphericalAzimuthSpacing/2.))
-                        && (pAzimuth > (azimuth-sphericalAzimuthSpacing/2.))) {
-                    if((pElevation <=(elevation+sphericalElevationSpacing/2.))
-                            && (pElevation > (elevation-sphericalElevationSpacing/2.))) {
-                        values[count] = dataGrid[field][i][j][k];
-                        count++;
-                    }
-                }
-            }
-        }
-    }
+    findSphericalRangeCells(azimuth, elevation);
+    const SphericalIndex& index = sphericalIndex;
+    int count = qMin(numPoints, index.rayI.size());
+    for (int p = 0; p < count; p++)
+        values[p] = gridValue(field,index.rayI.at(p),index.rayJ.at(p),index.rayK.at(p));
     return values;
 }
 
@@ -596,23 +802,14 @@ float* GriddedData::getSphericalRangePosition(float azimuth, float elevation,
 {
     float *positions = new float[numPoints];
 
-    int count = 0;
-    for(int i = 0; i < iDim; i ++) {
-        for(int j = 0; j < jDim; j++) {
-            for (int k = 0; k < kDim; k++) {
-                float rp = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ));
-                float pAzimuth = fixAngle(atan2((j-refPointJ),(i-refPointI)))*rad2deg;
-                float pElevation = fixAngle(atan2((k-refPointK),rp))*rad2deg;
-                if((pAzimuth <= (azimuth+sphericalAzimuthSpacing/2.))
-                        && (pAzimuth > (azimuth-sphericalAzimuthSpacing/2.))) {
-                    if((pElevation <=(elevation+sphericalElevationSpacing/2.))
-                            && (pElevation > (elevation-sphericalElevationSpacing/2.))) {
-                        positions[count] = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ)+kGridsp*kGridsp*(k-refPointK)*(k-refPointK));
-                        count++;
-                    }
-                }
-            }
-        }
+    findSphericalRangeCells(azimuth, elevation);
+    const SphericalIndex& index = sphericalIndex;
+    int count = qMin(numPoints, index.rayI.size());
+    for (int p = 0; p < count; p++) {
+        int i = index.rayI.at(p);
+        int j = index.rayJ.at(p);
+        int k = index.rayK.at(p);
+        positions[p] = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ)+kGridsp*kGridsp*(k-refPointK)*(k-refPointK));
     }
     return positions;
 }
@@ -659,7 +856,7 @@ float* GriddedData::getSphericalAzimuthData(QString& fieldName,
                         && (r > (range-sphericalRangeSpacing/2.))) {
                     if((pElevation <=(elevation+sphericalElevationSpacing/2.))
                             && (pElevation > (elevation-sphericalElevationSpacing/2.))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = gridValue(field,i,j,k);
                         count++;
                     }
                 }
@@ -698,20 +895,19 @@ float* GriddedData::getSphericalAzimuthPosition(float range, float elevation)
 
 int GriddedData::getSphericalElevationLength(float range, float azimuth)
 {
-    int count = 0;
+    QVector<int> columns;
+    getSphericalAzimuthColumns(azimuth, columns);
+    const SphericalIndex& index = sphericalIndex;
 
-    for(int i = 0; i < iDim; i ++) {
-        for(int j = 0; j < jDim; j ++) {
-            for (int k = 0; k < kDim; k++) {
-                float r = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ)+kGridsp*kGridsp*(k-refPointK)*(k-refPointK));
-                float pAzimuth = fixAngle(atan2((j-refPointJ),(i-refPointI)))*rad2deg;
-                if((pAzimuth <= (azimuth+sphericalAzimuthSpacing/2.))
-                        && (pAzimuth > (azimuth-sphericalAzimuthSpacing/2.))) {
-                    if((r <= (range+sphericalRangeSpacing/2.))
-                            && (r > (range-sphericalRangeSpacing/2.))) {
-                        count++;
-                    }
-                }
+    int count = 0;
+    for (int c = 0; c < columns.size(); c++) {
+        int i = index.column.at(columns.at(c)) / index.jDim;
+        int j = index.column.at(columns.at(c)) % index.jDim;
+        for (int k = 0; k < kDim; k++) {
+            float r = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ)+kGridsp*kGridsp*(k-refPointK)*(k-refPointK));
+            if((r <= (range+sphericalRangeSpacing/2.))
+                    && (r > (range-sphericalRangeSpacing/2.))) {
+                count++;
             }
         }
     }
@@ -726,20 +922,20 @@ float* GriddedData::getSphericalElevationData(QString& fieldName, float range,
     int field = getFieldIndex(fieldName);
     float *values = new float[numPoints];
 
+    QVector<int> columns;
+    getSphericalAzimuthColumns(azimuth, columns);
+    const SphericalIndex& index = sphericalIndex;
+
     int count = 0;
-    for(int i = 0; i < iDim; i ++) {
-        for(int j = 0; j < jDim; j ++) {
-            for (int k = 0; k < kDim; k++) {
-                float r = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ)+kGridsp*kGridsp*(k-refPointK)*(k-refPointK));
-                float pAzimuth = fixAngle(atan2((j-refPointJ),(i-refPointI)))*rad2deg;
-                if((pAzimuth <= (azimuth+sphericalAzimuthSpacing/2.))
-                        && (pAzimuth > (azimuth-sphericalAzimuthSpacing/2.))) {
-                    if((r <= (range+sphericalRangeSpacing/2.))
-                            && (r > (range-sphericalRangeSpacing/2.))) {
-                        values[count] = dataGrid[field][i][j][k];
-                        count++;
-                    }
-                }
+    for (int c = 0; c < columns.size(); c++) {
+        int i = index.column.at(columns.at(c)) / index.jDim;
+        int j = index.column.at(columns.at(c)) % index.jDim;
+        for (int k = 0; k < kDim; k++) {
+            float r = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ)+kGridsp*kGridsp*(k-refPointK)*(k-refPointK));
+            if((r <= (range+sphericalRangeSpacing/2.))
+                    && (r > (range-sphericalRangeSpacing/2.))) {
+                values[count] = gridValue(field,i,j,k);
+                count++;
             }
         }
     }
@@ -751,21 +947,21 @@ float* GriddedData::getSphericalElevationPosition(float range, float azimuth)
     int numPoints = getSphericalElevationLength(range, azimuth);
     float *positions = new float[numPoints];
 
+    QVector<int> columns;
+    getSphericalAzimuthColumns(azimuth, columns);
+    const SphericalIndex& index = sphericalIndex;
+
     int count = 0;
-    for(int i = 0; i < iDim; i ++) {
-        for(int j = 0; j < jDim; j ++) {
-            for (int k = 0; k < kDim; k++) {
-                float rp = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ));
-                float r = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ)+kGridsp*kGridsp*(k-refPointK)*(k-refPointK));
-                float pAzimuth = fixAngle(atan2((j-refPointJ),(i-refPointI)))*rad2deg;
-                if((pAzimuth <= (azimuth+sphericalAzimuthSpacing/2.))
-                        && (pAzimuth > (azimuth-sphericalAzimuthSpacing/2.))) {
-                    if((r <= (range+sphericalRangeSpacing/2.))
-                            && (r > (range-sphericalRangeSpacing/2.))) {
-                        positions[count] = fixAngle(atan2((k-refPointK),rp))*rad2deg;
-                        count++;
-                    }
-                }
+    for (int c = 0; c < columns.size(); c++) {
+        int i = index.column.at(columns.at(c)) / index.jDim;
+        int j = index.column.at(columns.at(c)) % index.jDim;
+        float rp = index.rp.at(columns.at(c));
+        for (int k = 0; k < kDim; k++) {
+            float r = sqrt(iGridsp*iGridsp*(i-refPointI)*(i-refPointI)+jGridsp*jGridsp*(j-refPointJ)*(j-refPointJ)+kGridsp*kGridsp*(k-refPointK)*(k-refPointK));
+            if((r <= (range+sphericalRangeSpacing/2.))
+                    && (r > (range-sphericalRangeSpacing/2.))) {
+                positions[count] = fixAngle(atan2((k-refPointK),rp))*rad2deg;
+                count++;
             }
         }
     }
@@ -810,7 +1006,7 @@ float* GriddedData::getCylindricalRadiusData(QString& fieldName, float azimuth,
                         && (pAzimuth > (azimuth-cylindricalAzimuthSpacing/2.))) {
                     if((k*kGridsp <= ((height/kGridsp)-zmin+cylindricalHeightSpacing/2.))
                             && (k*kGridsp > ((height/kGridsp)-zmin-cylindricalHeightSpacing/2.))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = gridValue(field,i,j,k);
                         count++;
                     }
                 }
@@ -872,6 +1068,25 @@ int GriddedData::getCylindricalAzimuthLength(float radius, float height)
 
 int GriddedData::getCylindricalAzimuthLength(float radius, float height)
 {
+    if (hasIntegralReferencePoint()) {
+        // Same cells as the scan below, taken from the ring index
+        int kLow, kHigh;
+        if (!getRingHeightWindow(height, kLow, kHigh))
+            return 0;
+        const RingIndex& ring = getRingIndex(radius);
+        int refI = int(refPointI);
+        int refJ = int(refPointJ);
+        int count = 0;
+        for (int n = 0; n < ring.iOffset.size(); n++) {
+            int i = refI + ring.iOffset[n];
+            int j = refJ + ring.jOffset[n];
+            if ((i < 0) or (i >= iDim) or (j < 0) or (j >= jDim))
+                continue;
+            count += kHigh - kLow;
+        }
+        return count;
+    }
+
     int count = 0;
     float r = 0;
     // 2 is for a little extra :)
@@ -906,6 +1121,172 @@ int GriddedData::getCylindricalAzimuthLength(float radius, float height)
 
 }
 
+bool GriddedData::hasIntegralReferencePoint() const
+{
+    // The ring index is built from whole cell offsets, which matches the
+    // scan exactly as long as the reference point sits on a grid point.
+    // The set*ReferencePoint functions always round to one.
+    return (refPointI == floor(refPointI)) && (refPointJ == floor(refPointJ));
+}
+
+bool GriddedData::getRingHeightWindow(float height, int& kLow, int& kHigh) const
+{
+    // Levels [kLow, kHigh) that pass the same height test as the grid scan
+    kLow = -1;
+    kHigh = -1;
+    for(int k = 0; k < kDim; k ++) {
+        if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
+                && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
+            if (kLow < 0)
+                kLow = k;
+            kHigh = k + 1;
+        }
+    }
+    return (kLow >= 0);
+}
+
+const GriddedData::RingIndex& GriddedData::getRingIndex(float radius)
+{
+    // Throw everything out if the geometry changed under us
+    if ((ringIndexIGridsp != iGridsp) || (ringIndexJGridsp != jGridsp)
+            || (ringIndexRadiusSpacing != cylindricalRadiusSpacing)) {
+        ringIndexCache.clear();
+        ringIndexIGridsp = iGridsp;
+        ringIndexJGridsp = jGridsp;
+        ringIndexRadiusSpacing = cylindricalRadiusSpacing;
+    }
+
+    QMap<float, RingIndex>::const_iterator cached = ringIndexCache.constFind(radius);
+    if (cached != ringIndexCache.constEnd())
+        return cached.value();
+
+    RingIndex ring;
+    buildRingIndex(radius, ring);
+    return ringIndexCache.insert(radius, ring).value();
+}
+
+const GriddedData::RingIndex* GriddedData::findRingIndex(float radius) const
+{
+    // Read-only lookup, safe to use from several threads at once
+    if ((ringIndexIGridsp != iGridsp) || (ringIndexJGridsp != jGridsp)
+            || (ringIndexRadiusSpacing != cylindricalRadiusSpacing))
+        return NULL;
+    QMap<float, RingIndex>::const_iterator cached = ringIndexCache.constFind(radius);
+    if (cached == ringIndexCache.constEnd())
+        return NULL;
+    return &cached.value();
+}
+
+void GriddedData::buildRingIndex(float radius, RingIndex& ring) const
+{
+    // Same bounding box, annulus test and azimuth as the grid scan, done once
+    // relative to a reference point at the origin
+    float originI = 0;
+    float originJ = 0;
+    int iHalf = int((radius+cylindricalRadiusSpacing)/iGridsp)+2;
+    int jHalf = int((radius+cylindricalRadiusSpacing)/jGridsp)+2;
+    for(int i = -iHalf; i < iHalf; i ++) {
+        for(int j = -jHalf; j < jHalf; j ++) {
+            float r = sqrt(iGridsp*iGridsp*(i-originI)*(i-originI)
+                           + jGridsp*jGridsp*(j-originJ)*(j-originJ));
+            if((r <= (radius+cylindricalRadiusSpacing/2.))
+                    && (r > (radius-cylindricalRadiusSpacing/2.))) {
+                ring.iOffset.append(i);
+                ring.jOffset.append(j);
+                ring.azimuth.append(fixAngle(atan2((j-originJ),(i-originI)))*rad2deg);
+            }
+        }
+    }
+}
+
+void GriddedData::prepareCylindricalRing(float radius)
+{
+    getRingIndex(radius);
+}
+
+int GriddedData::getCylindricalAzimuthMaxLength(float radius, float height)
+{
+    int kLow, kHigh;
+    if (!getRingHeightWindow(height, kLow, kHigh))
+        return 0;
+    if (!hasIntegralReferencePoint())
+        return getCylindricalAzimuthLength(radius, height);
+    return getRingIndex(radius).iOffset.size()*(kHigh - kLow);
+}
+
+int GriddedData::getCylindricalAzimuthMaxLength(float radius, float height) const
+{
+    int kLow, kHigh;
+    if (!getRingHeightWindow(height, kLow, kHigh))
+        return 0;
+    const RingIndex* ring = findRingIndex(radius);
+    if (ring != NULL)
+        return ring->iOffset.size()*(kHigh - kLow);
+    RingIndex local;
+    buildRingIndex(radius, local);
+    return local.iOffset.size()*(kHigh - kLow);
+}
+
+int GriddedData::getCylindricalAzimuthRing(QString& fieldName, float radius, float height,
+                                           int maxPoints, float* values, float* azimuths)
+{
+    if (!hasIntegralReferencePoint()) {
+        // Off-grid reference point, fall back to scanning the grid
+        int numPoints = getCylindricalAzimuthLength(radius, height);
+        if (numPoints > maxPoints) {
+            Message::toScreen("GriddedData: getCylindricalAzimuthRing: ring does not fit in the buffer");
+            numPoints = maxPoints;
+        }
+        getCylindricalAzimuthData(fieldName, numPoints, radius, height, values);
+        getCylindricalAzimuthPosition(numPoints, radius, height, azimuths);
+        return numPoints;
+    }
+
+    getRingIndex(radius);
+    return getCylindricalAzimuthRing(fieldName, refPointI, refPointJ, radius, height,
+                                     maxPoints, values, azimuths);
+}
+
+int GriddedData::getCylindricalAzimuthRing(const QString& fieldName, float refI, float refJ,
+                                           float radius, float height, int maxPoints,
+                                           float* values, float* azimuths) const
+{
+    // Reentrant form: the reference point is an argument and the grid is not
+    // touched, so several threads can sample the same grid. refI and refJ are
+    // grid indices, see getReferenceIndexI/J.
+    int kLow, kHigh;
+    if (!getRingHeightWindow(height, kLow, kHigh))
+        return 0;
+    const RingIndex* ring = findRingIndex(radius);
+    RingIndex local;
+    if (ring == NULL) {
+        buildRingIndex(radius, local);
+        ring = &local;
+    }
+    const float* field = getFieldData(getFieldIndex(fieldName));
+    int refII = int(refI);
+    int refJJ = int(refJ);
+
+    int count = 0;
+    for (int n = 0; n < ring->iOffset.size(); n++) {
+        int i = refII + ring->iOffset[n];
+        int j = refJJ + ring->jOffset[n];
+        if ((i < 0) or (i >= iDim) or (j < 0) or (j >= jDim))
+            continue;
+        const float* column = field + i*iStride + j*jStride;
+        for (int k = kLow; k < kHigh; k++) {
+            if (count >= maxPoints) {
+                Message::toScreen("GriddedData: getCylindricalAzimuthRing: ring does not fit in the buffer");
+                return count;
+            }
+            values[count] = column[k];
+            azimuths[count] = ring->azimuth[n];
+            count++;
+        }
+    }
+    return count;
+}
+
 int GriddedData::getCylindricalAzimuthLengthTest2(float radius, float height)
 {
     int count = 0;
@@ -930,6 +1311,16 @@ int GriddedData::getCylindricalAzimuthLengthTest2(float radius, float height)
         iInLow = int(refPointI);
         iInHigh = int(refPointI);
     }
+    // The reference point can be off the grid, so the inner box is kept
+    // inside [iLow, iHigh) as well
+    if(iInLow > iHigh)
+        iInLow = iHigh;
+    if(iInHigh < iLow)
+        iInHigh = iLow;
+    if(iInLow < iLow)
+        iInLow = iLow;
+    if(iInHigh > iHigh)
+        iInHigh = iHigh;
     int jLow = int(refPointJ)-int((radius+cylindricalRadiusSpacing)/jGridsp)-2;
     int jHigh = int(refPointJ)+int((radius+cylindricalRadiusSpacing)/jGridsp)+2;
     int jInLow = int(refPointJ) - int((radius-cylindricalRadiusSpacing)/(sqrt2*jGridsp))+2;
@@ -948,6 +1339,16 @@ int GriddedData::getCylindricalAzimuthLengthTest2(float radius, float height)
         jInLow = int(refPointJ);
         jInHigh = int(refPointJ);
     }
+    // The reference point can be off the grid, so the inner box is kept
+    // inside [jLow, jHigh) as well
+    if(jInLow > jHigh)
+        jInLow = jHigh;
+    if(jInHigh < jLow)
+        jInHigh = jLow;
+    if(jInLow < jLow)
+        jInLow = jLow;
+    if(jInHigh > jHigh)
+        jInHigh = jHigh;
 
     // Do k too!
 
@@ -1029,7 +1430,7 @@ void GriddedData::getCylindricalAzimuthData(QString& fieldName, int numPoints,
     && (r > (radius-cylindricalRadiusSpacing/2.))) {
    if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
       && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-     values[count] = dataGrid[field][i][j][k];
+     values[count] = gridValue(field,i,j,k);
      count++;
      if(count > numPoints) {
        // Memory overflow ... bail out
@@ -1049,6 +1450,13 @@ void GriddedData::getCylindricalAzimuthData(QString& fieldName,
                                             float height, float* values)
 {
     //  int numPoints = getCylindricalAzimuthLength(radius, height);
+    if (hasIntegralReferencePoint()) {
+        float* azimuths = new float[numPoints];
+        getCylindricalAzimuthRing(fieldName, radius, height, numPoints, values, azimuths);
+        delete[] azimuths;
+        return;
+    }
+
     int field = getFieldIndex(fieldName);
 
     //  float *values = new float[numPoints];
@@ -1078,7 +1486,7 @@ void GriddedData::getCylindricalAzimuthData(QString& fieldName,
                         && (r > (radius-cylindricalRadiusSpacing/2.))) {
                     if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
                             && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = gridValue(field,i,j,k);
 			// TODO debug
 			// std::cout << "val[" << count << "] = " << values[count] << std::endl;
                         count++;
@@ -1126,6 +1534,16 @@ void GriddedData::getCylindricalAzimuthDataTest2(QString& fieldName,
         iInLow = int(refPointI);
         iInHigh = int(refPointI);
     }
+    // The reference point can be off the grid, so the inner box is kept
+    // inside [iLow, iHigh) as well
+    if(iInLow > iHigh)
+        iInLow = iHigh;
+    if(iInHigh < iLow)
+        iInHigh = iLow;
+    if(iInLow < iLow)
+        iInLow = iLow;
+    if(iInHigh > iHigh)
+        iInHigh = iHigh;
     int jLow = int(refPointJ)-int((radius+cylindricalRadiusSpacing)/jGridsp)-2;
     int jHigh = int(refPointJ)+int((radius+cylindricalRadiusSpacing)/jGridsp)+2;
     int jInLow = int(refPointJ) - int((radius-cylindricalRadiusSpacing)/(sqrt2*jGridsp))+2;
@@ -1144,6 +1562,16 @@ void GriddedData::getCylindricalAzimuthDataTest2(QString& fieldName,
         jInLow = int(refPointJ);
         jInHigh = int(refPointJ);
     }
+    // The reference point can be off the grid, so the inner box is kept
+    // inside [jLow, jHigh) as well
+    if(jInLow > jHigh)
+        jInLow = jHigh;
+    if(jInHigh < jLow)
+        jInHigh = jLow;
+    if(jInLow < jLow)
+        jInLow = jLow;
+    if(jInHigh > jHigh)
+        jInHigh = jHigh;
 
     // Do k too!
 
@@ -1155,7 +1583,7 @@ void GriddedData::getCylindricalAzimuthDataTest2(QString& fieldName,
                         && (r > (radius-cylindricalRadiusSpacing/2.))) {
                     if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
                             && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = gridValue(field,i,j,k);
                         count++;
                         if(count > numPoints) {
                             // Memory overflow ... bail out
@@ -1174,7 +1602,7 @@ void GriddedData::getCylindricalAzimuthDataTest2(QString& fieldName,
                         && (r > (radius-cylindricalRadiusSpacing/2.))) {
                     if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
                             && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = gridValue(field,i,j,k);
                         count++;
                         if(count > numPoints) {
                             // Memory overflow ... bail out
@@ -1191,7 +1619,7 @@ void GriddedData::getCylindricalAzimuthDataTest2(QString& fieldName,
                         && (r > (radius-cylindricalRadiusSpacing/2.))) {
                     if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
                             && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = gridValue(field,i,j,k);
                         count++;
                         if(count > numPoints) {
                             // Memory overflow ... bail out
@@ -1210,7 +1638,7 @@ void GriddedData::getCylindricalAzimuthDataTest2(QString& fieldName,
                         && (r > (radius-cylindricalRadiusSpacing/2.))) {
                     if((k <= (((height-zmin)/kGridsp)+cylindricalHeightSpacing/2))
                             && (k > (((height-zmin)/kGridsp)-cylindricalHeightSpacing/2))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = gridValue(field,i,j,k);
                         count++;
                         if(count > numPoints) {
                             // Memory overflow ... bail out
@@ -1265,6 +1693,28 @@ void GriddedData::getCylindricalAzimuthPosition(int numPoints, float radius, flo
 
     //  float *positions = new float[numPoints];
 
+    if (hasIntegralReferencePoint()) {
+        int kLow, kHigh;
+        if (!getRingHeightWindow(height, kLow, kHigh))
+            return;
+        const RingIndex& ring = getRingIndex(radius);
+        int refI = int(refPointI);
+        int refJ = int(refPointJ);
+        int count = 0;
+        for (int n = 0; n < ring.iOffset.size(); n++) {
+            int i = refI + ring.iOffset[n];
+            int j = refJ + ring.jOffset[n];
+            if ((i < 0) or (i >= iDim) or (j < 0) or (j >= jDim))
+                continue;
+            for (int k = kLow; k < kHigh; k++) {
+                if (count >= numPoints)
+                    return;
+                positions[count++] = ring.azimuth[n];
+            }
+        }
+        return;
+    }
+
     int count = 0;
     float r = 0;
 
@@ -1336,6 +1786,16 @@ void GriddedData::getCylindricalAzimuthPositionTest2(int numPoints, float radius
         iInLow = int(refPointI);
         iInHigh = int(refPointI);
     }
+    // The reference point can be off the grid, so the inner box is kept
+    // inside [iLow, iHigh) as well
+    if(iInLow > iHigh)
+        iInLow = iHigh;
+    if(iInHigh < iLow)
+        iInHigh = iLow;
+    if(iInLow < iLow)
+        iInLow = iLow;
+    if(iInHigh > iHigh)
+        iInHigh = iHigh;
     int jLow = int(refPointJ)-int((radius+cylindricalRadiusSpacing)/jGridsp)-2;
     int jHigh = int(refPointJ)+int((radius+cylindricalRadiusSpacing)/jGridsp)+2;
     int jInLow = int(refPointJ) - int((radius-cylindricalRadiusSpacing)/(sqrt2*jGridsp))+2;
@@ -1354,6 +1814,16 @@ void GriddedData::getCylindricalAzimuthPositionTest2(int numPoints, float radius
         jInLow = int(refPointJ);
         jInHigh = int(refPointJ);
     }
+    // The reference point can be off the grid, so the inner box is kept
+    // inside [jLow, jHigh) as well
+    if(jInLow > jHigh)
+        jInLow = jHigh;
+    if(jInHigh < jLow)
+        jInHigh = jLow;
+    if(jInLow < jLow)
+        jInLow = jLow;
+    if(jInHigh > jHigh)
+        jInHigh = jHigh;
 
     // Do k too!
 
@@ -1485,7 +1955,7 @@ float* GriddedData::getCylindricalHeightData(QString& fieldName, float radius,
                 if((pAzimuth <= azimuth+cylindricalAzimuthSpacing/2.)
                         && (pAzimuth > azimuth-cylindricalAzimuthSpacing/2.)) {
                     for(int k = 0; k < kDim; k++){
-                        data[count] = dataGrid[field][i][j][k];
+                        data[count] = gridValue(field,i,j,k);
                         count++;
                     }
                 }
@@ -1534,11 +2004,12 @@ bool GriddedData::test()
     iGridsp = 2;
     jGridsp = 2;
     kGridsp = 1;
+    allocateGrid();
     for(int i = 0; i < iDim; i++) {
         for(int j = 0; j < jDim; j++) {
             for(int k = 0; k < kDim; k++) {
                 for(int dataField = 0; dataField < 3; dataField++) {
-                    dataGrid[dataField][i][j][k] = dataField*j;
+                    gridValue(dataField,i,j,k) = dataField*j;
                 }
             }
         }
@@ -1555,8 +2026,8 @@ bool GriddedData::test()
                     QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(xValues[i])+" from getCartesianValue");
                     Message::toScreen(message);
                 }
-                if(xValues[i]!=(dataGrid[0][i][j][k]+dataGrid[0][i][j+1][k])) {
-                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(xValues[i])+" actual: "+QString().setNum(dataGrid[0][i][j][k]));
+                if(xValues[i]!=(gridValue(0,i,j,k)+gridValue(0,i,j+1,k))) {
+                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(xValues[i])+" actual: "+QString().setNum(gridValue(0,i,j,k)));
                     Message::toScreen(message);
                 }
             }
@@ -1565,8 +2036,8 @@ bool GriddedData::test()
             xValues = getCartesianXslice(fieldName,(j+ymin)*jGridsp,
                                          (k+zmin)*kGridsp);
             for(int i = 0; i < iDim; i++) {
-                if(xValues[i]!=dataGrid[1][i][j][k]) {
-                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(j)+" value:"+QString().setNum(xValues[i])+" actual: "+QString().setNum(dataGrid[1][i][j][k]));
+                if(xValues[i]!=gridValue(1,i,j,k)) {
+                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(j)+" value:"+QString().setNum(xValues[i])+" actual: "+QString().setNum(gridValue(1,i,j,k)));
                     Message::toScreen(message);
                 }
             }
@@ -1575,8 +2046,8 @@ bool GriddedData::test()
             xValues = getCartesianXslice(fieldName,(j+ymin)*jGridsp,
                                          (k+zmin)*kGridsp);
             for(int i = 0; i < iDim; i++) {
-                if(xValues[i]!=dataGrid[2][i][j][k]) {
-                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(xValues[i])+" actual: "+QString().setNum(dataGrid[2][i][j][k]));
+                if(xValues[i]!=gridValue(2,i,j,k)) {
+                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(xValues[i])+" actual: "+QString().setNum(gridValue(2,i,j,k)));
                     Message::toScreen(message);
                 }
             }
@@ -1591,8 +2062,8 @@ bool GriddedData::test()
             yValues = getCartesianYslice(fieldName,(i+xmin)*iGridsp,
                                          (k+zmin)*kGridsp);
             for(int j = 0; j < jDim; j++) {
-                if(yValues[j]!=dataGrid[0][i][j][k]) {
-                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(yValues[j])+" actual: "+QString().setNum(dataGrid[0][i][j][k]));
+                if(yValues[j]!=gridValue(0,i,j,k)) {
+                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(yValues[j])+" actual: "+QString().setNum(gridValue(0,i,j,k)));
                     Message::toScreen(message);
                 }
             }
@@ -1600,8 +2071,8 @@ bool GriddedData::test()
             yValues = getCartesianYslice(fieldName,(i+xmin)*iGridsp,
                                          (k+zmin)*kGridsp);
             for(int j = 0; j < jDim; j++) {
-                if(yValues[j]!=dataGrid[1][i][j][k]) {
-                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(yValues[j])+" actual "+QString().setNum(dataGrid[1][i][j][k]));
+                if(yValues[j]!=gridValue(1,i,j,k)) {
+                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(yValues[j])+" actual "+QString().setNum(gridValue(1,i,j,k)));
                     Message::toScreen(message);
                 }
             }
@@ -1609,8 +2080,8 @@ bool GriddedData::test()
             yValues = getCartesianYslice(fieldName,(i+xmin)*iGridsp,
                                          (k+zmin)*kGridsp);
             for(int j = 0; j < jDim; j++) {
-                if(yValues[j]!=dataGrid[2][i][j][k]) {
-                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(yValues[j])+" actual "+QString().setNum(dataGrid[2][i][j][k]));
+                if(yValues[j]!=gridValue(2,i,j,k)) {
+                    QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(yValues[j])+" actual "+QString().setNum(gridValue(2,i,j,k)));
                     Message::toScreen(message);
                 }
             }
@@ -1624,7 +2095,7 @@ bool GriddedData::test()
             float *zValues = new float[int(floor(kDim))];
             zValues= getCartesianZslice(fieldName,(i+xmin)*iGridsp,(j+ymin)*jGridsp);
             for(int k = 0; k < kDim; k++) {
-                if(zValues[k]!=dataGrid[0][i][j][k]) {
+                if(zValues[k]!=gridValue(0,i,j,k)) {
                     QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(zValues[k]));
                     Message::toScreen(message);
                 }
@@ -1633,7 +2104,7 @@ bool GriddedData::test()
             zValues = getCartesianZslice(fieldName,(i+xmin)*iGridsp,
                                          (j+ymin)*jGridsp);
             for(int k = 0; k < kDim; k++) {
-                if(zValues[k]!=dataGrid[1][i][j][k]) {
+                if(zValues[k]!=gridValue(1,i,j,k)) {
                     QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(zValues[k]));
                     Message::toScreen(message);
                 }
@@ -1642,7 +2113,7 @@ bool GriddedData::test()
             zValues = getCartesianZslice(fieldName,(i+xmin)*iGridsp,
                                          (j+ymin)*jGridsp);
             for(int k = 0; k < kDim; k++) {
-                if(zValues[k]!=dataGrid[2][i][j][k]) {
+                if(zValues[k]!=gridValue(2,i,j,k)) {
                     QString message("TEST: Value not what is expected "+fieldName+" x:"+QString().setNum(i)+" y:"+QString().setNum(j)+" z:"+QString().setNum(k)+" value:"+QString().setNum(zValues[k]));
                     Message::toScreen(message);
                 }
@@ -1737,7 +2208,7 @@ float* GriddedData::getSphericalRangeDataTest(QString& fieldName,
                         && (pAzimuth > (azimuth-sphericalAzimuthSpacing/2.))) {
                     if((pElevation <=(elevation+sphericalElevationSpacing/2.))
                             && (pElevation > (elevation-sphericalElevationSpacing/2.))) {
-                        values[count] = dataGrid[field][i][j][k];
+                        values[count] = gridValue(field,i,j,k);
                         count++;
                     }
                 }
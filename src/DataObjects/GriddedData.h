@@ -15,6 +15,10 @@
 #include "IO/Message.h"
 #include <QDomElement>
 #include <QStringList>
+#include <QVector>
+#include <QMap>
+#include <QMetaType>
+#include <QSharedPointer>
 
 class GriddedData 
 {
@@ -22,6 +26,8 @@ class GriddedData
  public:
     
   GriddedData();
+  GriddedData(const GriddedData& other);
+  GriddedData& operator=(const GriddedData& other);
   virtual ~GriddedData();
 
   // These 2 currently do nothing
@@ -40,11 +46,11 @@ class GriddedData
   //void setIGridsp(const float& iSpacing);
   //void setJGridsp(const float& jSpacing);
   //void setKGridsp(const float& kSpacing);
-  float fixAngle(float angle);
+  float fixAngle(float angle) const;
   
   void setLatLonOrigin(float *knownLat, float *knownLon, float *relX,float *relY);
-  float getOriginLat()	{ return originLat; }
-  float getOriginLon()	{ return originLon; }
+  float getOriginLat() const	{ return originLat; }
+  float getOriginLon() const	{ return originLon; }
   
   void setReferencePoint(int ii, int jj, int kk);
   void setCartesianReferencePoint(float ii, float jj, float kk); 
@@ -58,6 +64,11 @@ class GriddedData
   float getRefPointJ();
   float getRefPointK();
 
+  // Reference point indices for a Cartesian position (km), for callers
+  // that pass the reference point around instead of setting it
+  float getReferenceIndexI(const float& ii) const;
+  float getReferenceIndexJ(const float& jj) const;
+
   float getCartesianRefPointI();
   float getCartesianRefPointJ();
   float getCartesianRefPointK();
@@ -126,6 +137,22 @@ class GriddedData
   float* getCylindricalHeightData(QString& fieldName, float radius,float height);
   float* getCylindricalHeightPosition(float radius, float height);
 
+  // Sample one ring around the reference point in a single pass.
+  // MaxLength is an upper bound for sizing the buffers, the return value of
+  // getCylindricalAzimuthRing is the number of values and azimuths filled in.
+  int    getCylindricalAzimuthMaxLength(float radius, float height);
+  int    getCylindricalAzimuthRing(QString& fieldName, float radius, float height,
+                                   int maxPoints, float* values, float* azimuths);
+
+  // Const, reentrant versions that take the reference point (grid indices)
+  // as arguments. Call prepareCylindricalRing for each radius before sharing
+  // the grid between threads, otherwise every call rebuilds the ring offsets.
+  void   prepareCylindricalRing(float radius);
+  int    getCylindricalAzimuthMaxLength(float radius, float height) const;
+  int    getCylindricalAzimuthRing(const QString& fieldName, float refI, float refJ,
+                                   float radius, float height, int maxPoints,
+                                   float* values, float* azimuths) const;
+
   // Cylindrical Coordinates !!!! Testing Only !!!!
 
   int getCylindricalAzimuthLengthTest2(float radius, float height);
@@ -135,7 +162,20 @@ class GriddedData
   /* All of these functions go through all points in the grid to check for
      points within the requested radius. Somewhat inefficient. -LM
   */
-  
+
+  // Direct access to the grid storage. The grid is one contiguous block,
+  // field-major with k innermost:
+  //   dataGrid[field*fieldStride + i*iStride + j*jStride + k]
+  // so a k column is contiguous and a whole field can be walked linearly.
+  const float* getFieldData(const int& field) const { return dataGrid + field*fieldStride; }
+  long  getFieldStride() const { return fieldStride; }
+  long  getIStride() const { return iStride; }
+  long  getJStride() const { return jStride; }
+  float getGridValue(const int& field, const int& i, const int& j, const int& k) const
+    { return dataGrid[field*fieldStride + i*iStride + j*jStride + k]; }
+
+  // Upper bounds on the grid dimensions accepted from the configuration.
+  // Storage is sized to the actual iDim/jDim/kDim, these are only sanity limits.
   static int getMaxFields() { return maxFields; }
   static int getMaxIDim() { return maxIDim; }
   static int getMaxJDim() { return maxJDim; }
@@ -147,6 +187,9 @@ class GriddedData
   // TODO: This is really a graphic attribute.
   //       But I find no other way to cleanly pass a value to CappiDisplay::constructImage()
   int getDisplayKIndex() const { return kDisplayIndex; }
+
+  // Radar gates that went into the grid, 0 unless it was interpolated
+  long getGatesGridded() const { return gatesGridded; }
     
  protected:
   float iDim;
@@ -160,16 +203,84 @@ class GriddedData
   float rad2deg;
   float numFields;
   QStringList fieldNames;
+  long gatesGridded;
 
   static const int maxFields = 3;
   static const int maxIDim = 1024; // 256;
   static const int maxJDim = 1024; // 256;
   static const int maxKDim = 40;   // 20;
 
-  float dataGrid[maxFields][maxIDim][maxJDim][maxKDim];
-  //dataGrid[0] = reflectivity
-  //dataGrid[1] = doppler velocity magnitude
-  //dataGrid[2] = spectral width
+  // (Re)allocate dataGrid for the current iDim, jDim and kDim and fill it
+  // with -999. Subclasses call this once the dimensions are known.
+  bool allocateGrid();
+  void freeGrid();
+
+  float& gridValue(const int& field, const int& i, const int& j, const int& k)
+    { return dataGrid[field*fieldStride + i*iStride + j*jStride + k]; }
+  float  gridValue(const int& field, const int& i, const int& j, const int& k) const
+    { return dataGrid[field*fieldStride + i*iStride + j*jStride + k]; }
+  float* fieldData(const int& field) { return dataGrid + field*fieldStride; }
+  long   cellIndex(const int& i, const int& j, const int& k) const
+    { return i*iStride + j*jStride + k; }
+
+  // Cells that make up one ring, stored as offsets from the reference point
+  // in the order a full grid scan visits them (i, then j). Only depends on
+  // the grid spacing and ring width, so it is built once per radius.
+  class RingIndex {
+  public:
+    QVector<int> iOffset;
+    QVector<int> jOffset;
+    QVector<float> azimuth;
+  };
+  const RingIndex& getRingIndex(float radius);
+  const RingIndex* findRingIndex(float radius) const;
+  void buildRingIndex(float radius, RingIndex& ring) const;
+  bool getRingHeightWindow(float height, int& kLow, int& kHigh) const;
+  bool hasIntegralReferencePoint() const;
+
+  QMap<float, RingIndex> ringIndexCache;
+  float ringIndexIGridsp;
+  float ringIndexJGridsp;
+  float ringIndexRadiusSpacing;
+
+  // Grid columns sorted by their azimuth from the reference point, so a
+  // spherical query walks out along the beam through the columns inside
+  // its azimuth window instead of scanning the whole grid. The cells picked
+  // for the last range query are kept too, a ray asks for its length, data
+  // and positions in turn.
+  class SphericalIndex {
+  public:
+    SphericalIndex() : refI(0), refJ(0), refK(0), iGridsp(0), jGridsp(0), kGridsp(0),
+                       iDim(-1), jDim(-1), kDim(-1), hasRay(false) {}
+    float refI, refJ, refK;
+    float iGridsp, jGridsp, kGridsp;
+    int iDim, jDim, kDim;
+    QVector<float> azimuth;   // ascending
+    QVector<int> column;      // i*jDim + j
+    QVector<float> rp;        // horizontal distance from the reference point
+    // Last range query
+    bool hasRay;
+    float rayAzimuth, rayElevation;
+    float rayAzimuthSpacing, rayElevationSpacing;
+    QVector<int> rayI, rayJ, rayK;
+  };
+  void updateSphericalIndex();
+  // Columns inside the azimuth window, in grid scan order (i, then j).
+  // Entries are positions in sphericalIndex.
+  void getSphericalAzimuthColumns(float azimuth, QVector<int>& columns);
+  // Cells on the beam, in grid scan order (i, j, then k)
+  void findSphericalRangeCells(float azimuth, float elevation);
+
+  SphericalIndex sphericalIndex;
+
+  float* dataGrid;
+  //field 0 = reflectivity
+  //field 1 = doppler velocity magnitude
+  //field 2 = spectral width
+  long gridSize;
+  long fieldStride;
+  long iStride;
+  long jStride;
 
   float sphericalRangeSpacing;
   float sphericalAzimuthSpacing;
@@ -200,4 +311,10 @@ class GriddedData
   
 };
 
+// A finished grid handed from the analysis to the display and other
+// consumers. It is shared rather than copied, and freed when the last
+// holder lets go of it.
+typedef QSharedPointer<const GriddedData> GriddedDataPtr;
+Q_DECLARE_METATYPE(GriddedDataPtr)
+
 #endif
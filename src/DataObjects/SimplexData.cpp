@@ -10,6 +10,7 @@
 
 #include "SimplexData.h"
 #include "Message.h"
+#include <QDataStream>
 #include <QTextStream>
 
 constexpr float SimplexData::_fillv;
@@ -453,3 +454,64 @@ void SimplexData::setInitialY( int& level,  int& rad,
 {
     initialY[level][rad][center] = value;
 }
+
+// Only the levels, radii and centers in use are written
+
+QDataStream& operator<<(QDataStream& out, const SimplexData& data)
+{
+    out << qint32(data.numLevels) << qint32(data.numRadii) << qint32(data.numCenters)
+        << qint32(data.numPointsUsed) << data.time;
+    for(int i = 0; i < data.numLevels; i++)
+        out << data.height[i];
+    for(int j = 0; j < data.numRadii; j++)
+        out << data.radius[j];
+    for(int i = 0; i < data.numLevels; i++)
+        for(int j = 0; j < data.numRadii; j++) {
+            out << data.meanX[i][j] << data.meanY[i][j] << data.centerStdDeviation[i][j]
+                << data.meanVT[i][j] << data.meanVTUncertainty[i][j]
+                << qint32(data.numConvergingCenters[i][j]);
+            for(int k = 0; k < data.numCenters; k++) {
+                const Center& center = data.centers[i][j][k];
+                out << data.initialX[i][j][k] << data.initialY[i][j][k]
+                    << center.getStartX() << center.getStartY() << center.getX()
+                    << center.getY() << center.getMaxVT() << center.getLevel()
+                    << center.getRadius();
+            }
+        }
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, SimplexData& data)
+{
+    qint32 numLevels, numRadii, numCenters, numPointsUsed;
+    in >> numLevels >> numRadii >> numCenters >> numPointsUsed >> data.time;
+    if ((numLevels < 0) || (numLevels > SimplexData::MAXLEVELS) ||
+        (numRadii < 0) || (numRadii > SimplexData::MAXRADII) ||
+        (numCenters < 0) || (numCenters > SimplexData::MAXCENTERS)) {
+        in.setStatus(QDataStream::ReadCorruptData);
+        return in;
+    }
+    data.numLevels = numLevels;
+    data.numRadii = numRadii;
+    data.numCenters = numCenters;
+    data.numPointsUsed = numPointsUsed;
+
+    for(int i = 0; i < data.numLevels; i++)
+        in >> data.height[i];
+    for(int j = 0; j < data.numRadii; j++)
+        in >> data.radius[j];
+    qint32 numConverging;
+    float startX, startY, endX, endY, maxVT, level, radius;
+    for(int i = 0; i < data.numLevels; i++)
+        for(int j = 0; j < data.numRadii; j++) {
+            in >> data.meanX[i][j] >> data.meanY[i][j] >> data.centerStdDeviation[i][j]
+               >> data.meanVT[i][j] >> data.meanVTUncertainty[i][j] >> numConverging;
+            data.numConvergingCenters[i][j] = numConverging;
+            for(int k = 0; k < data.numCenters; k++) {
+                in >> data.initialX[i][j][k] >> data.initialY[i][j][k]
+                   >> startX >> startY >> endX >> endY >> maxVT >> level >> radius;
+                data.centers[i][j][k] = Center(startX, startY, endX, endY, maxVT, level, radius);
+            }
+        }
+    return in;
+}
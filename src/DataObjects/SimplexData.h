@@ -14,8 +14,13 @@
 #include "Center.h"
 #include <QDateTime>
 
+class QDataStream;
+
 class SimplexData
 {
+    // Binary form used by SimplexList to keep the history on disk
+    friend QDataStream& operator<<(QDataStream& out, const SimplexData& data);
+    friend QDataStream& operator>>(QDataStream& in, SimplexData& data);
 
 public:
     SimplexData();
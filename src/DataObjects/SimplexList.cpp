@@ -17,6 +17,8 @@
 SimplexList::SimplexList(QString filePath) : QList<SimplexData>()
 {
     _filePath = filePath;
+    _numSaved = 0;
+    _savedReordered = false;
 }
 
 SimplexList::~SimplexList()
@@ -73,17 +75,45 @@ bool SimplexList::saveXML()
 }
 
 
+bool SimplexList::save()
+{
+    if(_savedReordered || (_numSaved > count()))
+        return rewrite();
+    _numSaved += _store.append(*this, _numSaved);
+    return _numSaved == count();
+}
+
+bool SimplexList::rewrite()
+{
+    if(!_store.rewrite(*this))
+        return false;
+    _numSaved = count();
+    _savedReordered = false;
+    return true;
+}
+
 bool SimplexList::restore()
 {
-    return false;
+    clear();
+    bool complete = _store.read(*this);
+    _numSaved = count();
+    _savedReordered = false;
+    // Drop whatever follows a record that could not be read
+    if(!complete && !isEmpty())
+        rewrite();
+    return !isEmpty();
 }
 
 void SimplexList::timeSort()
 {
     for(int i = 0; i < this->count(); i++)
         for(int j = i+1; j < this->count(); j++)
-            if(this->at(i).getTime() > this->at(j).getTime())
+            if(this->at(i).getTime() > this->at(j).getTime()) {
                 this->swap(j,i);
+                // Only the entries past _numSaved can be appended
+                if(i < _numSaved)
+                    _savedReordered = true;
+            }
 }
 
 void SimplexList::dump() const
@@ -15,6 +15,7 @@
 #include "SimplexData.h"
 #include <QList>
 #include "Configuration.h"
+#include "IO/RecordFile.h"
 #include <QString>
 
 class SimplexList : public QList<SimplexData>
@@ -24,14 +25,25 @@ public:
     SimplexList(QString filePath = QString());
     virtual ~SimplexList();
     void setFilePath(QString filePath) {_filePath=filePath;}
+    void setRecordPath(QString recordPath) { _store.setFilePath(recordPath); }
     void timeSort();
+
+    // Same record file scheme as VortexList
+    bool save();
+    bool rewrite();
     bool restore();
+
+    // Write the whole list as XML, for export
     bool saveXML();
 
     void dump() const;
     
 private:
     QString _filePath;
+    RecordFile _store;
+    int _numSaved;
+    // timeSort() moved saved entries, the file has to be rewritten
+    bool _savedReordered;
 };
 
 #endif
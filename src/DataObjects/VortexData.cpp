@@ -11,9 +11,11 @@
 #include <fstream>
 
 #include "VortexData.h"
+#include <QDataStream>
 #include <QTextStream>
 #include "Message.h"
 #include <math.h>
+#include <algorithm>
 
 constexpr float VortexData::_fillv;
 
@@ -44,6 +46,7 @@ VortexData::VortexData()
     _aveRMW = -999.0;
     _aveRMWUncertainty = -999.0;
     _maxValidRadius = -999;
+    _clearCoefficients();
 }
 
 VortexData::VortexData(int availLevels, int availRadii, int availWaveNum)
@@ -73,45 +76,19 @@ VortexData::VortexData(int availLevels, int availRadii, int availWaveNum)
     _aveRMW = -999.0;
     _aveRMWUncertainty = -999.0;
     _maxValidRadius = -999;
+    _clearCoefficients();
 }
 
-VortexData::VortexData(const VortexData &other)
+VortexData::~VortexData()
 {
-    this->_numLevels = other._numLevels;
-    this->_numRadii  = other._numRadii;
-    this->_numWaveNum = other._numWaveNum;
-    this->_bestLevel = other._bestLevel;
-    
-    for(int i = 0; i < _numLevels; i++)
-    {
-        this->_centerLat[i] = other._centerLat[i];
-        this->_centerLon[i] = other._centerLon[i];
-        this->_centerAlt[i] = other._centerAlt[i];
-        this->_maxVT[i] = other._maxVT[i];
-        this->_RMW[i] = other._RMW[i];
-        this->_RMWUncertainty[i] = other._RMWUncertainty[i];
-        this->_centerSD[i] = other._centerSD[i];
-        for(int j = 0; j < _numRadii; j++) {
-            for(int k = 0; k < _numWaveNum; k++) {
-                this->coefficients[i][j][k] = coefficients[i][j][k];
-            }
-        }
-    }
-
-    this->_time = other._time;
-
-    this->centralPressure = other.centralPressure;
-    this->centralPressureUncertainty = other.centralPressureUncertainty;
-    this->pressureDeficit = other.pressureDeficit;
-    this->pressureDeficitUncertainty = other.pressureDeficitUncertainty;
-	this->maxSfcWind = other.maxSfcWind;
-    this->_aveRMW = other._aveRMW;
-    this->_aveRMWUncertainty = other._aveRMWUncertainty;
-    this->_maxValidRadius = other._maxValidRadius;
 }
 
-VortexData::~VortexData()
+void VortexData::_clearCoefficients()
 {
+    const int size = MAXLEVELS * MAXRADII * Coefficient::NumParameters;
+    std::fill(&_coeffLevel[0][0][0], &_coeffLevel[0][0][0] + size, _fillv);
+    std::fill(&_coeffRadius[0][0][0], &_coeffRadius[0][0][0] + size, _fillv);
+    std::fill(&_coeffValue[0][0][0], &_coeffValue[0][0][0] + size, _fillv);
 }
 
 // TODO
@@ -143,24 +120,17 @@ int VortexData::getHeightIndex(const float& height) const
     return closestIndex;
 }
 
-Coefficient VortexData::getCoefficient(const int& lev, const int& rad, 
-                                       const int& waveNum) const
-{
-    return coefficients[lev][rad][waveNum];
-}
-
 Coefficient VortexData::getCoefficient(const int& lev, const int& rad,
-                                       const QString& parameter) const
+                                       const Coefficient::Parameter& parameter) const
 {
-    for(int i = 0; i < _numWaveNum; i++) {
-        if(coefficients[lev][rad][i].getParameter() == parameter)
-            return coefficients[lev][rad][i];
-    }
-    return Coefficient();
+    if((parameter < 0) || (parameter >= Coefficient::NumParameters))
+        return Coefficient();
+    return Coefficient(_coeffLevel[lev][rad][parameter], _coeffRadius[lev][rad][parameter],
+                       _coeffValue[lev][rad][parameter], parameter);
 }
 
 Coefficient VortexData::getCoefficient(const float& height, const int& rad,
-                                       const QString& parameter) const
+                                       const Coefficient::Parameter& parameter) const
 {
     int level = getHeightIndex(height);
     if((level == -1) || (rad == -1)) {
@@ -171,7 +141,7 @@ Coefficient VortexData::getCoefficient(const float& height, const int& rad,
 }
 
 Coefficient VortexData::getCoefficient(const float& height, const float& rad,
-                                       const QString& parameter) const
+                                       const Coefficient::Parameter& parameter) const
 {
     int level = getHeightIndex(height);
     if (level < 0) return Coefficient();
@@ -186,10 +156,15 @@ Coefficient VortexData::getCoefficient(const float& height, const float& rad,
     return getCoefficient(level, radIndex, parameter);
 }
 
-void VortexData::setCoefficient(const int& lev, const int& rad, 
-                                const int& coeffNum, const Coefficient &coefficient)
+void VortexData::setCoefficient(const int& lev, const int& rad,
+                                const Coefficient &coefficient)
 {
-    coefficients[lev][rad][coeffNum] = coefficient;
+    const Coefficient::Parameter param = coefficient.getParameter();
+    if((param < 0) || (param >= Coefficient::NumParameters))
+        return;
+    _coeffLevel[lev][rad][param] = coefficient.getLevel();
+    _coeffRadius[lev][rad][param] = coefficient.getRadius();
+    _coeffValue[lev][rad][param] = coefficient.getValue();
 }
 
 bool VortexData::operator ==(const VortexData &other)
@@ -223,15 +198,66 @@ void VortexData::saveCoefficients(QString &fname)
 
     for(int lev = 0; lev < _numLevels; lev++)
       for(int rad = 0; rad < _numRadii; rad++)
-	for(int wave = 0; wave < _numWaveNum; wave++) {
-	  Coefficient current = getCoefficient(lev, rad, wave);
+	for(int param = 0; param < Coefficient::NumParameters; param++) {
+	  Coefficient current = getCoefficient(lev, rad, Coefficient::Parameter(param));
 	  if(current.getValue() <= _fillv)
 	    continue;
 	  outfile  << current.getLevel()
 		   << "," << current.getRadius()
-		   << "," << current.getParameter().toLatin1().data()
+		   << "," << current.getParameterName().toLatin1().data()
 		   << "," << current.getValue()
 		   << std::endl;
 	}
     // file closed by the destructor.
 }
+
+// Only the levels and radii in use are written
+
+QDataStream& operator<<(QDataStream& out, const VortexData& data)
+{
+    out << qint32(data._numLevels) << qint32(data._numRadii) << qint32(data._numWaveNum)
+        << qint32(data._bestLevel) << data._time;
+    for(int lev = 0; lev < data._numLevels; lev++) {
+        out << data._centerLat[lev] << data._centerLon[lev] << data._centerAlt[lev]
+            << data._maxVT[lev] << data._RMW[lev] << data._RMWUncertainty[lev]
+            << data._centerSD[lev];
+        for(int rad = 0; rad < data._numRadii; rad++)
+            for(int param = 0; param < Coefficient::NumParameters; param++)
+                out << data._coeffLevel[lev][rad][param] << data._coeffRadius[lev][rad][param]
+                    << data._coeffValue[lev][rad][param];
+    }
+    out << data._maxValidRadius << data._aveRMW << data._aveRMWUncertainty
+        << data.centralPressure << data.centralPressureUncertainty
+        << data.pressureDeficit << data.pressureDeficitUncertainty << data.maxSfcWind;
+    return out;
+}
+
+QDataStream& operator>>(QDataStream& in, VortexData& data)
+{
+    qint32 numLevels, numRadii, numWaveNum, bestLevel;
+    in >> numLevels >> numRadii >> numWaveNum >> bestLevel >> data._time;
+    if ((numLevels < 0) || (numLevels > VortexData::MAXLEVELS) ||
+        (numRadii < 0) || (numRadii > VortexData::MAXRADII) ||
+        (numWaveNum < 0) || (numWaveNum > VortexData::MAXWAVENUM)) {
+        in.setStatus(QDataStream::ReadCorruptData);
+        return in;
+    }
+    data._numLevels = numLevels;
+    data._numRadii = numRadii;
+    data._numWaveNum = numWaveNum;
+    data._bestLevel = bestLevel;
+
+    for(int lev = 0; lev < data._numLevels; lev++) {
+        in >> data._centerLat[lev] >> data._centerLon[lev] >> data._centerAlt[lev]
+           >> data._maxVT[lev] >> data._RMW[lev] >> data._RMWUncertainty[lev]
+           >> data._centerSD[lev];
+        for(int rad = 0; rad < data._numRadii; rad++)
+            for(int param = 0; param < Coefficient::NumParameters; param++)
+                in >> data._coeffLevel[lev][rad][param] >> data._coeffRadius[lev][rad][param]
+                   >> data._coeffValue[lev][rad][param];
+    }
+    in >> data._maxValidRadius >> data._aveRMW >> data._aveRMWUncertainty
+       >> data.centralPressure >> data.centralPressureUncertainty
+       >> data.pressureDeficit >> data.pressureDeficitUncertainty >> data.maxSfcWind;
+    return in;
+}
@@ -14,13 +14,17 @@
 #include "Coefficient.h"
 #include <QDateTime>
 
+class QDataStream;
+
 class VortexData
 {
+    // Binary form used by VortexList to keep the history on disk
+    friend QDataStream& operator<<(QDataStream& out, const VortexData& data);
+    friend QDataStream& operator>>(QDataStream& in, VortexData& data);
 
 public:
     VortexData();
     VortexData(int availLevels, int availRadii, int availWaveNum);
-    VortexData(const VortexData &other);
     ~VortexData();
 
     static constexpr float _fillv  =-999.0f;
@@ -83,11 +87,11 @@ public:
     inline void  setCenterStdDev(int index,float value) { if(index<_numLevels) _centerSD[index]=value; }
     inline void  setCenterStdDev(float a[],int howMany) { for(int i=0;i<howMany;i++) setCenterStdDev(i,a[i]); }
 
-    Coefficient getCoefficient(const int& lev, const int& rad,const int& waveNum) const;
-    Coefficient getCoefficient(const int& lev, const int& rad,const QString& parameter) const;
-    Coefficient getCoefficient(const float& height, const int& rad,const QString& parameter) const;
-    Coefficient getCoefficient(const float& height, const float& rad,const QString& parameter) const;
-    void	setCoefficient(const int& lev, const int& rad,const int& coeffNum, const Coefficient &coefficient);
+    Coefficient getCoefficient(const int& lev, const int& rad,const Coefficient::Parameter& parameter) const;
+    Coefficient getCoefficient(const float& height, const int& rad,const Coefficient::Parameter& parameter) const;
+    Coefficient getCoefficient(const float& height, const float& rad,const Coefficient::Parameter& parameter) const;
+    // Stored under coefficient.getParameter(); coefficients without one are ignored
+    void	setCoefficient(const int& lev, const int& rad, const Coefficient &coefficient);
     void	saveCoefficients(QString &fname);
 
     // void operator = (const VortexData &other);
@@ -128,7 +132,13 @@ private:
     float _RMW[MAXLEVELS];
     float _RMWUncertainty[MAXLEVELS];
     float _centerSD[MAXLEVELS];
-    Coefficient coefficients[MAXLEVELS][MAXRADII][MAXWAVENUM*2+3];
+
+    // Coefficients are kept by parameter in one plain array per field, so
+    // a lookup is an index and the whole object copies as a block
+    float _coeffLevel[MAXLEVELS][MAXRADII][Coefficient::NumParameters];
+    float _coeffRadius[MAXLEVELS][MAXRADII][Coefficient::NumParameters];
+    float _coeffValue[MAXLEVELS][MAXRADII][Coefficient::NumParameters];
+    void _clearCoefficients();
 
     QDateTime _time;
     float _maxValidRadius;
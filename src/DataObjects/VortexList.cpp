@@ -22,6 +22,8 @@
 VortexList::VortexList(QString filePath) : QList<VortexData>()
 {
     _filePath = filePath;
+    _numSaved = 0;
+    _savedReordered = false;
 }
 
 VortexList::~VortexList()
@@ -67,9 +69,38 @@ bool VortexList::saveXML()
     return true;
 }
 
+bool VortexList::save()
+{
+    if(_savedReordered || (_numSaved > count()))
+        return rewrite();
+    _numSaved += _store.append(*this, _numSaved);
+    return _numSaved == count();
+}
+
+bool VortexList::rewrite()
+{
+    if(!_store.rewrite(*this))
+        return false;
+    _numSaved = count();
+    _savedReordered = false;
+    return true;
+}
+
 bool VortexList::restore()
 {
-    return false;
+    clear();
+    bool complete = _store.read(*this);
+    _numSaved = count();
+    _savedReordered = false;
+    // Drop whatever follows a record that could not be read
+    if(!complete && !isEmpty())
+        rewrite();
+    return !isEmpty();
+}
+
+void VortexList::setRecordPath(QString recordPath)
+{
+    _store.setFilePath(recordPath);
 }
 
 void VortexList::setFilePath(QString newFileName)
@@ -82,6 +113,10 @@ void VortexList::timeSort()
 {
     for(int i = 0; i < this->count(); i++)
         for(int j = i+1; j < this->count(); j++)
-            if(this->at(i).getTime()>this->at(j).getTime())
+            if(this->at(i).getTime()>this->at(j).getTime()) {
                 this->swap(j,i);
+                // Only the entries past _numSaved can be appended
+                if(i < _numSaved)
+                    _savedReordered = true;
+            }
 }
@@ -14,6 +14,7 @@
 
 #include <QList>
 #include "DataObjects/VortexData.h"
+#include "IO/RecordFile.h"
 
 class QString;
 
@@ -24,13 +25,26 @@ public:
      VortexList(QString filePath = QString());
      virtual ~VortexList();
      
-     bool saveXML();
+     // The list is kept on disk in an append-only record file. save()
+     // only writes the entries added since the last save or restore,
+     // rewrite() replaces the file after entries were removed. save()
+     // rewrites too if timeSort() moved entries that were already saved.
+     bool save();
+     bool rewrite();
      bool restore();
+     void setRecordPath(QString recordPath);
+
+     // Write the whole list as XML, for export
+     bool saveXML();
      void setFilePath(QString filePath);
      void timeSort();
 
 private:
      QString _filePath;
+     RecordFile _store;
+     int _numSaved;
+     // timeSort() moved saved entries, the file has to be rewritten
+     bool _savedReordered;
 };
 
 #endif
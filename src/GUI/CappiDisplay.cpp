@@ -150,21 +150,22 @@ void CappiDisplay::clearImage()
 
 void CappiDisplay::mousePressEvent(QMouseEvent *event)
 {
-    if (event->button() == Qt::LeftButton) {
+    GriddedDataPtr cappi = getCurrentCappi();
+    if ((event->button() == Qt::LeftButton) && !cappi.isNull()) {
         lastPoint = event->pos();
 
 	// Display origin is at the top left. Cappi origin is at the radar.
 
 	// Map the point to the grid:
-	float click_x = lastPoint.x() * currentCappi.getIdim() / 500;
-	float click_y = (500 - lastPoint.y()) * currentCappi.getJdim() / 500;
+	float click_x = lastPoint.x() * cappi->getIdim() / 500;
+	float click_y = (500 - lastPoint.y()) * cappi->getJdim() / 500;
 	
-	int x = currentCappi.getCartesianPointFromIndexI(click_x);
-	// int y = currentCappi.getCartesianPointFromIndexJ(currentCappi.getJdim() - lastPoint.y());
-	int y = currentCappi.getCartesianPointFromIndexJ(click_y);
+	int x = cappi->getCartesianPointFromIndexI(click_x);
+	// int y = cappi->getCartesianPointFromIndexJ(cappi->getJdim() - lastPoint.y());
+	int y = cappi->getCartesianPointFromIndexJ(click_y);
 
-	float *coords = currentCappi.getAdjustedLatLon(currentCappi.getOriginLat(),
-						       currentCappi.getOriginLon(),
+	float *coords = GriddedData::getAdjustedLatLon(cappi->getOriginLat(),
+						       cappi->getOriginLon(),
 						       x, y);
 	// coords[0] -> Lon
 	// coords[1] -> Lat
@@ -185,17 +186,21 @@ void CappiDisplay::mouseMoveEvent(QMouseEvent *event)
 {
   lastPoint = event->pos();
 
+  GriddedDataPtr cappi = getCurrentCappi();
+  if (cappi.isNull())
+    return;
+
   // Map the point to the grid:
   // Display origin is at the top left. Cappi origin is at the radar.
 
-  float click_x = lastPoint.x() * currentCappi.getIdim() / 500;
-  float click_y = (500 - lastPoint.y()) * currentCappi.getJdim() / 500;
+  float click_x = lastPoint.x() * cappi->getIdim() / 500;
+  float click_y = (500 - lastPoint.y()) * cappi->getJdim() / 500;
 	
-  int x = currentCappi.getCartesianPointFromIndexI(click_x);
-  int y = currentCappi.getCartesianPointFromIndexJ(click_y);
+  int x = cappi->getCartesianPointFromIndexI(click_x);
+  int y = cappi->getCartesianPointFromIndexJ(click_y);
   
-  float *coords = currentCappi.getAdjustedLatLon(currentCappi.getOriginLat(),
-						 currentCappi.getOriginLon(),
+  float *coords = GriddedData::getAdjustedLatLon(cappi->getOriginLat(),
+						 cappi->getOriginLon(),
 						 x, y);
 
   QToolTip::showText(event->globalPos(),
@@ -247,7 +252,7 @@ void CappiDisplay::paintEvent(QPaintEvent * /* event */)
 
     painter.save();
     
-    if(hasGBVTDInfo) {
+    if(hasGBVTDInfo && hasCappi) {
         // Given the relevant GBVTD and config parameters
         // Draw an X (small hurricane symbol?) at (x, y) to mark
         // GBVTD center
@@ -262,8 +267,8 @@ void CappiDisplay::paintEvent(QPaintEvent * /* event */)
 	// Draw a small X at the radar
 	float zero = 0.0;
 
-	int radX = (int) currentCappi.getIndexFromCartesianPointI(zero);
-	int radY = (int) currentCappi.getIndexFromCartesianPointJ(zero);
+	int radX = (int) currentCappi->getIndexFromCartesianPointI(zero);
+	int radY = (int) currentCappi->getIndexFromCartesianPointJ(zero);
 	
 	// Display origin is top left corner. Cappi origin is bottom left. Adjust radY accordingly
 	// radY = currentCappi.getJdim() - radY;
@@ -345,16 +350,22 @@ void CappiDisplay::resizeImage(QImage *image, const QSize &newSize)
     imageHolder.unlock();
 }
 
-void CappiDisplay::constructImage(const GriddedData& cappi)
+void CappiDisplay::constructImage(GriddedDataPtr cappi)
 {
     // Fill the pixmap with data from the cappi
+    if (cappi.isNull() || (cappi->getFieldData(0) == NULL)) {
+        Message::toScreen("CappiDisplay: received a cappi without grid data");
+        return;
+    }
+    imageHolder.lock();
+    // Keep a reference to the grid, not a copy, for the mouse handlers
+    // and for redrawing at another level
     currentCappi = cappi;
     hasCappi = true;
-    imageHolder.lock();
     //hasGBVTDInfo = false;
     image.fill(qRgb(255, 255, 255));
-    iDim = (int)cappi.getIdim();
-    jDim = (int)cappi.getJdim();
+    iDim = (int)cappi->getIdim();
+    jDim = (int)cappi->getJdim();
     QSize cappiSize((int)iDim,(int)jDim);
     image = image.scaled(cappiSize);
 
@@ -367,14 +378,19 @@ void CappiDisplay::constructImage(const GriddedData& cappi)
     QString velfield("ve");
     QString dbzfield("dz");
     QString heightfield("ht");
+
+    // Read the display level straight out of the grid buffer
+    long iStride = cappi->getIStride();
+    long jStride = cappi->getJStride();
+    const float* velLevel = cappi->getFieldData(cappi->getFieldIndex(velfield)) + (int)k;
     float minI, maxI, minJ, maxJ;
     if(hasGBVTDInfo) {
         float xIndex = xPercent*iDim;
         float yIndex = yPercent*jDim;
-        minI = xIndex-(simplexMax*iDim*cappi.getIGridsp());
-        maxI = xIndex+(simplexMax*iDim*cappi.getIGridsp());
-        minJ = yIndex-(simplexMax*iDim*cappi.getJGridsp());
-        maxJ = yIndex+(simplexMax*iDim*cappi.getJGridsp());
+        minI = xIndex-(simplexMax*iDim*cappi->getIGridsp());
+        maxI = xIndex+(simplexMax*iDim*cappi->getIGridsp());
+        minJ = yIndex-(simplexMax*iDim*cappi->getJGridsp());
+        maxJ = yIndex+(simplexMax*iDim*cappi->getJGridsp());
         if (minI < 0) minI = 0;
         if (maxI > iDim) maxI = iDim;
         if (minJ < 0) minJ = 0;
@@ -391,7 +407,7 @@ void CappiDisplay::constructImage(const GriddedData& cappi)
     float maxRecYindex = -999.0;
     for (float i = minI; i < maxI; i++) {
         for (float j = minJ; j < maxJ; j++) {
-            float vel = cappi.getIndexValue(velfield,i,j,k);
+            float vel = velLevel[(long)i*iStride + (long)j*jStride];
             if (vel != -999) {
 	        vel *= 1.9438445;
                 if (vel > maxVel) {
@@ -430,9 +446,9 @@ void CappiDisplay::constructImage(const GriddedData& cappi)
         }
         
         if ((maxAppXindex != -999.0) and (maxAppYindex != -999.0)) {
-            heightMaxApp = cappi.getIndexValue(heightfield,maxAppXindex,maxAppYindex,k);
-            float cartI = cappi.getCartesianPointFromIndexI(maxAppXindex);
-            float cartJ = cappi.getCartesianPointFromIndexJ(maxAppYindex);
+            heightMaxApp = cappi->getIndexValue(heightfield,maxAppXindex,maxAppYindex,k);
+            float cartI = cappi->getCartesianPointFromIndexI(maxAppXindex);
+            float cartJ = cappi->getCartesianPointFromIndexJ(maxAppYindex);
             distMaxApp = sqrt(cartI*cartI + cartJ*cartJ);
             dirMaxApp = atan2(cartJ,cartI)*57.2957795130823;
             dirMaxApp = 450.0 - dirMaxApp;
@@ -443,9 +459,9 @@ void CappiDisplay::constructImage(const GriddedData& cappi)
             heightMaxApp = distMaxApp = dirMaxApp = -999.0;
         }
         if ((maxRecXindex != -999.0) and (maxRecYindex != -999.0)) {
-            heightMaxRec = cappi.getIndexValue(heightfield,maxRecXindex,maxRecYindex,k);
-            float cartI = cappi.getCartesianPointFromIndexI(maxRecXindex);
-            float cartJ = cappi.getCartesianPointFromIndexJ(maxRecYindex);
+            heightMaxRec = cappi->getIndexValue(heightfield,maxRecXindex,maxRecYindex,k);
+            float cartI = cappi->getCartesianPointFromIndexI(maxRecXindex);
+            float cartJ = cappi->getCartesianPointFromIndexJ(maxRecYindex);
             distMaxRec = sqrt(cartI*cartI + cartJ*cartJ);
             dirMaxRec = atan2(cartJ,cartI)*57.2957795130823;
             dirMaxRec = 450.0 - dirMaxRec;
@@ -469,9 +485,10 @@ void CappiDisplay::constructImage(const GriddedData& cappi)
         minValue = -11.5;
     }
     // Set each pixel color scaled to the max and min ranges
+    const float* fieldLevel = cappi->getFieldData(cappi->getFieldIndex(field)) + (int)k;
     for (float i = 0; i < iDim; i++) {
         for (float j = 0; j < jDim; j++) {
-            float value = cappi.getIndexValue(field,i,j,k);
+            float value = fieldLevel[(long)i*iStride + (long)j*jStride];
             int color = 1;
             if (value == -999) {
                 color = 0;
@@ -506,6 +523,16 @@ void CappiDisplay::constructImage(const GriddedData& cappi)
     update();
 }
 
+// The grid currently on display, safe to call from any thread
+
+GriddedDataPtr CappiDisplay::getCurrentCappi()
+{
+  imageHolder.lock();
+  GriddedDataPtr cappi = currentCappi;
+  imageHolder.unlock();
+  return cappi;
+}
+
 // If level was overwritten from the GUI, return that.
 // Otherwise, ask the cappi what level to use
 
@@ -513,14 +540,14 @@ int CappiDisplay::getDisplayLevel()
 {
   if (displayLevel >= 0)
     return displayLevel;
-  return currentCappi.getDisplayKIndex();
+  return currentCappi->getDisplayKIndex();
 }
 
 void CappiDisplay::levelChanged(int level)
 {
   displayLevel = level;
   if (hasCappi)
-    constructImage(currentCappi);
+    constructImage(getCurrentCappi());
   update();
 }
 
@@ -547,6 +574,6 @@ void CappiDisplay::toggleRadarDisplay()
     } else {
         displayType = velocity;
     }
-    if (hasCappi) constructImage(currentCappi);
+    if (hasCappi) constructImage(getCurrentCappi());
     update();
 }
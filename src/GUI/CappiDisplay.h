@@ -42,7 +42,7 @@ public:
     
 public slots:
     void clearImage();
-    void constructImage(const GriddedData& cappi);
+    void constructImage(GriddedDataPtr cappi);
     void setGBVTDResults(float x, float y,float rmwEstimate, float sMin, float sMax, float vMax,
                          float userlat, float userlon,float lat, float lon);
     void toggleRadarDisplay();
@@ -60,6 +60,7 @@ protected:
 private:
     void resizeImage(QImage *image, const QSize &newSize);
     int getDisplayLevel();
+    GriddedDataPtr getCurrentCappi();
     QString cappiLabel;
     QImage image;
     QMutex imageHolder;
@@ -87,7 +88,7 @@ private:
         spectrumWidth
     };
     int displayType;
-    GriddedData currentCappi;
+    GriddedDataPtr currentCappi;
     float heightMaxApp, heightMaxRec;
     float distMaxApp, distMaxRec;
     float dirMaxApp, dirMaxRec;
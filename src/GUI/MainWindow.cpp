@@ -41,7 +41,7 @@ MainWindow::MainWindow()
 
     readSettings();
     qRegisterMetaType<Message>("Message");
-    qRegisterMetaType<GriddedData>("GriddedData");
+    qRegisterMetaType<GriddedDataPtr>("GriddedDataPtr");
     qRegisterMetaType<VortexList>("VortexList");
     setWindowTitle(tr("VORTRAC"));
 }
@@ -0,0 +1,154 @@
+/*
+ *  RecordFile.cpp
+ *  VORTRAC
+ *
+ *  Copyright 2026 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include "RecordFile.h"
+#include "Message.h"
+#include <QFile>
+#include <cstdio>
+
+RecordFile::RecordFile(const QString& filePath)
+{
+    _filePath = filePath;
+}
+
+void RecordFile::frame(const QByteArray& payload, QByteArray& buffer)
+{
+    QDataStream out(&buffer, QIODevice::WriteOnly | QIODevice::Append);
+    out.setVersion(streamVersion);
+    out << recordMagic << quint32(payload.size())
+        << quint16(qChecksum(payload.constData(), payload.size()));
+    out.writeRawData(payload.constData(), payload.size());
+}
+
+bool RecordFile::compatible(const QByteArray& head)
+{
+    if (head.size() < headerSize)
+        return false;
+    QDataStream in(head);
+    in.setVersion(streamVersion);
+    quint32 magic, version;
+    in >> magic >> version;
+    return (magic == fileMagic) && (version == formatVersion);
+}
+
+bool RecordFile::setAside()
+{
+    // Records in another layout would read back as garbage, so keep the
+    // file for inspection and start a new one
+    QString oldPath = _filePath + ".old";
+    Message::toScreen("RecordFile: " + _filePath + " is not in record format "
+                      + QString().setNum(formatVersion) + ", moving it to " + oldPath);
+    if (std::rename(_filePath.toLocal8Bit().constData(), oldPath.toLocal8Bit().constData()) != 0) {
+        Message::toScreen("RecordFile: Cannot move " + _filePath);
+        return false;
+    }
+    return true;
+}
+
+bool RecordFile::writeRecords(const QList<QByteArray>& payloads, const QString& fileName,
+                              bool truncate)
+{
+    // A truncated file is a new one and gets the header first
+    QByteArray buffer;
+    if (truncate) {
+        QDataStream out(&buffer, QIODevice::WriteOnly);
+        out.setVersion(streamVersion);
+        out << fileMagic << formatVersion;
+    }
+    for (int i = 0; i < payloads.count(); i++)
+        frame(payloads.at(i), buffer);
+
+    QFile file(fileName);
+    QIODevice::OpenMode mode = QIODevice::WriteOnly;
+    mode |= truncate ? QIODevice::Truncate : QIODevice::Append;
+    if (!file.open(mode)) {
+        Message::toScreen("RecordFile: Cannot open " + fileName + " for writing");
+        return false;
+    }
+    bool ok = (file.write(buffer) == buffer.size());
+    ok = file.flush() && ok;
+    file.close();
+    if (!ok)
+        Message::toScreen("RecordFile: Failed to write records to " + fileName);
+    return ok;
+}
+
+bool RecordFile::appendRecords(const QList<QByteArray>& payloads)
+{
+    // Only add to a file in the current format, anything else starts over
+    bool fresh = true;
+    QFile file(_filePath);
+    if (file.open(QIODevice::ReadOnly)) {
+        QByteArray head = file.read(headerSize);
+        file.close();
+        if (compatible(head))
+            fresh = false;
+        else if (!head.isEmpty() && !setAside())
+            return false;
+    }
+    return writeRecords(payloads, _filePath, fresh);
+}
+
+bool RecordFile::rewriteRecords(const QList<QByteArray>& payloads)
+{
+    // Write the new file next to the old one and rename it over the old
+    // one, which replaces it in one step, so a crash part way through
+    // leaves the previous history intact
+    QString tmpPath = _filePath + ".tmp";
+    if (!writeRecords(payloads, tmpPath, true))
+        return false;
+    if (std::rename(tmpPath.toLocal8Bit().constData(), _filePath.toLocal8Bit().constData()) != 0) {
+        Message::toScreen("RecordFile: Cannot replace " + _filePath);
+        return false;
+    }
+    return true;
+}
+
+bool RecordFile::readRecords(QList<QByteArray>& payloads)
+{
+    QFile file(_filePath);
+    if (!file.open(QIODevice::ReadWrite))
+        return false;
+    QByteArray contents = file.readAll();
+    if (contents.isEmpty()) {
+        file.close();
+        return true;
+    }
+    if (!compatible(contents)) {
+        file.close();
+        setAside();
+        return false;
+    }
+
+    QDataStream in(contents);
+    in.setVersion(streamVersion);
+    in.skipRawData(headerSize);
+    qint64 good = headerSize;
+    while (contents.size() - good >= frameSize) {
+        quint32 magic, length;
+        quint16 checksum;
+        in >> magic >> length >> checksum;
+        if ((magic != recordMagic) || (length > quint64(contents.size() - good - frameSize)))
+            break;
+        const char* payload = contents.constData() + good + frameSize;
+        if (qChecksum(payload, length) != checksum)
+            break;
+        payloads.append(QByteArray(payload, length));
+        in.skipRawData(length);
+        good += frameSize + length;
+    }
+
+    if (good < contents.size()) {
+        Message::toScreen("RecordFile: Dropping " + QString().setNum(contents.size() - good)
+                          + " bytes of incomplete records at the end of " + _filePath);
+        file.resize(good);
+    }
+    file.close();
+    return true;
+}
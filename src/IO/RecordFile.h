@@ -0,0 +1,128 @@
+/*
+ *  RecordFile.h
+ *  VORTRAC
+ *
+ *  Copyright 2026 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef RECORDFILE_H
+#define RECORDFILE_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QList>
+#include <QString>
+
+// Append-only file of framed binary records, used to keep the analysis
+// history on disk. The file starts with
+//   file magic (quint32), format version (quint32)
+// and each record is stored as
+//   magic (quint32), payload length (quint32), checksum (quint16), payload
+// and is never rewritten once it is on disk, so saving after a volume only
+// costs the size of that volume's record. A record cut short by a crash
+// fails its frame check on reading; it is dropped and the file truncated
+// back to the last complete record. A file in another format, including
+// the unversioned files that start with a record, is moved aside to
+// <file>.old rather than read or appended to.
+//
+// The templates serialize any type with QDataStream operators, one list
+// element per record.
+
+class RecordFile
+{
+
+public:
+    RecordFile(const QString& filePath = QString());
+
+    void setFilePath(const QString& filePath) { _filePath = filePath; }
+    QString getFilePath() const { return _filePath; }
+
+    // Append list[first] .. list.last(), returns the number of records written
+    template <class T> int append(const QList<T>& list, int first);
+    // Replace the whole file with the contents of list
+    template <class T> bool rewrite(const QList<T>& list);
+    // Append every complete record in the file to list
+    template <class T> bool read(QList<T>& list);
+
+    bool appendRecords(const QList<QByteArray>& payloads);
+    bool rewriteRecords(const QList<QByteArray>& payloads);
+    bool readRecords(QList<QByteArray>& payloads);
+
+    // Fixed so the files do not change with the Qt version
+    static const int streamVersion = QDataStream::Qt_5_0;
+
+private:
+    static const quint32 fileMagic = 0x56545246;    // "VTRF"
+    static const quint32 recordMagic = 0x56545243;  // "VTRC"
+    static const int headerSize = 8;
+    static const int frameSize = 10;
+    // Bump whenever the stream layout of a stored type changes
+    static const quint32 formatVersion = 1;
+
+    static void frame(const QByteArray& payload, QByteArray& buffer);
+    static bool compatible(const QByteArray& head);
+    bool setAside();
+    bool writeRecords(const QList<QByteArray>& payloads, const QString& fileName,
+                      bool truncate);
+
+    QString _filePath;
+};
+
+template <class T>
+int RecordFile::append(const QList<T>& list, int first)
+{
+    QList<QByteArray> payloads;
+    for (int i = first; i < list.count(); i++) {
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out.setVersion(streamVersion);
+        out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+        out << list.at(i);
+        payloads.append(payload);
+    }
+    if (payloads.isEmpty() || !appendRecords(payloads))
+        return 0;
+    return payloads.count();
+}
+
+template <class T>
+bool RecordFile::rewrite(const QList<T>& list)
+{
+    QList<QByteArray> payloads;
+    for (int i = 0; i < list.count(); i++) {
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out.setVersion(streamVersion);
+        out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+        out << list.at(i);
+        payloads.append(payload);
+    }
+    return rewriteRecords(payloads);
+}
+
+template <class T>
+bool RecordFile::read(QList<T>& list)
+{
+    QList<QByteArray> payloads;
+    if (!readRecords(payloads))
+        return false;
+    for (int i = 0; i < payloads.count(); i++) {
+        QDataStream in(payloads.at(i));
+        in.setVersion(streamVersion);
+        in.setFloatingPointPrecision(QDataStream::SinglePrecision);
+        // Some records are too large for the stack
+        T* record = new T();
+        in >> *record;
+        bool ok = (in.status() == QDataStream::Ok);
+        if (ok)
+            list.append(*record);
+        delete record;
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ *  VolumeMetrics.cpp
+ *  VORTRAC
+ *
+ *  Copyright 2026 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include "VolumeMetrics.h"
+
+VolumeMetrics::VolumeMetrics()
+{
+}
+
+void VolumeMetrics::clear()
+{
+    volume.clear();
+    stages.clear();
+    msecs.clear();
+    counters.clear();
+    counts.clear();
+}
+
+void VolumeMetrics::addTime(const QString& stage, qint64 elapsed)
+{
+    int index = stages.indexOf(stage);
+    if (index < 0) {
+        stages.append(stage);
+        msecs.append(elapsed);
+    } else {
+        msecs[index] += elapsed;
+    }
+}
+
+qint64 VolumeMetrics::getTime(const QString& stage) const
+{
+    int index = stages.indexOf(stage);
+    if (index < 0)
+        return -1;
+    return msecs.at(index);
+}
+
+qint64 VolumeMetrics::getTotalTime() const
+{
+    qint64 total = 0;
+    for (int i = 0; i < msecs.count(); i++)
+        total += msecs.at(i);
+    return total;
+}
+
+void VolumeMetrics::addCount(const QString& counter, qint64 count)
+{
+    int index = counters.indexOf(counter);
+    if (index < 0) {
+        counters.append(counter);
+        counts.append(count);
+    } else {
+        counts[index] += count;
+    }
+}
+
+qint64 VolumeMetrics::getCount(const QString& counter) const
+{
+    int index = counters.indexOf(counter);
+    if (index < 0)
+        return 0;
+    return counts.at(index);
+}
+
+void VolumeMetrics::add(const VolumeMetrics& other)
+{
+    for (int i = 0; i < other.stages.count(); i++)
+        addTime(other.stages.at(i), other.msecs.at(i));
+    for (int i = 0; i < other.counters.count(); i++)
+        addCount(other.counters.at(i), other.counts.at(i));
+}
+
+QString VolumeMetrics::summary() const
+{
+    QString text;
+    for (int i = 0; i < stages.count(); i++) {
+        if (i > 0)
+            text += ", ";
+        text += stages.at(i) + " " + QString().setNum(msecs.at(i)) + " ms";
+    }
+    text += "; total " + QString().setNum(getTotalTime()) + " ms";
+    for (int i = 0; i < counters.count(); i++)
+        text += ", " + counters.at(i) + " " + QString().setNum(counts.at(i));
+    return text;
+}
+
+QString VolumeMetrics::stageJson() const
+{
+    QString json = "{";
+    for (int i = 0; i < stages.count(); i++) {
+        if (i > 0)
+            json += ",";
+        json += jsonString(stages.at(i)) + ":" + QString().setNum(msecs.at(i));
+    }
+    return json + "}";
+}
+
+QString VolumeMetrics::countJson() const
+{
+    QString json = "{";
+    for (int i = 0; i < counters.count(); i++) {
+        if (i > 0)
+            json += ",";
+        json += jsonString(counters.at(i)) + ":" + QString().setNum(counts.at(i));
+    }
+    return json + "}";
+}
+
+QString VolumeMetrics::toJson() const
+{
+    return "{\"volume\":" + jsonString(volume)
+        + ",\"stage_ms\":" + stageJson()
+        + ",\"total_ms\":" + QString().setNum(getTotalTime())
+        + ",\"counts\":" + countJson() + "}";
+}
+
+QString VolumeMetrics::toPrometheus(const QString& prefix, bool cumulative) const
+{
+    QString type = cumulative ? "counter" : "gauge";
+    QString suffix = cumulative ? "_total" : "";
+    QString text;
+
+    QString name = prefix + "_stage_seconds" + suffix;
+    text += "# HELP " + name + " Wall time of each analysis stage\n";
+    text += "# TYPE " + name + " " + type + "\n";
+    for (int i = 0; i < stages.count(); i++)
+        text += name + "{stage=" + jsonString(stages.at(i)) + "} "
+            + QString::number(msecs.at(i) / 1000.0, 'f', 3) + "\n";
+
+    name = prefix + "_count" + suffix;
+    text += "# HELP " + name + " Work done by the analysis\n";
+    text += "# TYPE " + name + " " + type + "\n";
+    for (int i = 0; i < counters.count(); i++)
+        text += name + "{counter=" + jsonString(counters.at(i)) + "} "
+            + QString().setNum(counts.at(i)) + "\n";
+    return text;
+}
+
+QString VolumeMetrics::jsonString(const QString& text)
+{
+    // Also good for Prometheus label values
+    QString escaped = text;
+    escaped.replace("\\", "\\\\");
+    escaped.replace("\"", "\\\"");
+    escaped.replace("\n", "\\n");
+    return "\"" + escaped + "\"";
+}
+
+VolumeMetrics::Timer::Timer(VolumeMetrics* volumeMetrics, const QString& stageName)
+    : metrics(volumeMetrics), stage(stageName)
+{
+    clock.start();
+}
+
+VolumeMetrics::Timer::~Timer()
+{
+    if (metrics != NULL)
+        metrics->addTime(stage, clock.elapsed());
+}
@@ -0,0 +1,88 @@
+/*
+ *  VolumeMetrics.h
+ *  VORTRAC
+ *
+ *  Copyright 2026 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef VOLUMEMETRICS_H
+#define VOLUMEMETRICS_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMetaType>
+#include <QString>
+#include <QStringList>
+
+// Wall time spent in each stage of the analysis of one radar volume, and
+// counts of the work done (bytes read, gates gridded, rings analyzed...).
+// Stages and counters are kept in the order they first showed up; timing a
+// stage or counting again adds to it. A volume is only worked on by one
+// thread at a time (read and QC on the prefetch thread, the rest on the
+// analysis thread), so there is no locking. Parallel loops count into
+// their own tasks and add the sum once they are done.
+
+class VolumeMetrics
+{
+
+public:
+    VolumeMetrics();
+
+    void clear();
+
+    void setVolume(const QString& name) { volume = name; }
+    QString getVolume() const { return volume; }
+
+    void addTime(const QString& stage, qint64 msecs);
+    // -1 if the stage never ran
+    qint64 getTime(const QString& stage) const;
+    qint64 getTotalTime() const;
+    QStringList getStages() const { return stages; }
+
+    void addCount(const QString& counter, qint64 count);
+    // 0 if nothing was counted
+    qint64 getCount(const QString& counter) const;
+    QStringList getCounters() const { return counters; }
+
+    // Adds all the times and counts of another volume, for run totals
+    void add(const VolumeMetrics& other);
+
+    // "read 120 ms, qc 80 ms, ...; bytes_read 1024, ..." for the log
+    QString summary() const;
+    // {"stage":msecs,...} and {"counter":count,...}
+    QString stageJson() const;
+    QString countJson() const;
+    // The whole volume as one line of JSON
+    QString toJson() const;
+    // Prometheus text exposition, as gauges named prefix_stage_seconds and
+    // prefix_count, or as counters with a _total suffix for run totals
+    QString toPrometheus(const QString& prefix, bool cumulative) const;
+
+    static QString jsonString(const QString& text);
+
+    // Adds the time until it goes out of scope to a stage. A NULL metrics
+    // pointer times nothing, so callers don't need to check.
+    class Timer {
+    public:
+        Timer(VolumeMetrics* metrics, const QString& stage);
+        ~Timer();
+    private:
+        VolumeMetrics* metrics;
+        QString stage;
+        QElapsedTimer clock;
+    };
+
+private:
+    QString volume;
+    QStringList stages;
+    QList<qint64> msecs;
+    QStringList counters;
+    QList<qint64> counts;
+
+};
+
+Q_DECLARE_METATYPE(VolumeMetrics)
+
+#endif
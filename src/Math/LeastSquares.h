@@ -0,0 +1,187 @@
+/*
+ *  LeastSquares.h
+ *  VORTRAC
+ *
+ *  Copyright 2026 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef LEASTSQUARES_H
+#define LEASTSQUARES_H
+
+#include <math.h>
+#include "Matrix.h"
+
+// Least squares fit for small systems of at most MaxCoeffs coefficients.
+// Observations are folded into the normal equations one row at a time, so
+// the design matrix never has to be stored, and the system is solved by
+// Cholesky factorization. solve() returns the same coefficients, standard
+// deviation and standard errors as Matrix::lls.
+//
+// All storage has a fixed size and a fixed row stride so the accumulation
+// loops vectorize. Only the upper triangle of x'x is accumulated.
+
+template <int MaxCoeffs>
+class LeastSquares
+{
+
+public:
+
+  LeastSquares(const int& numCoeff = MaxCoeffs) { reset(numCoeff); }
+
+  // Start a new fit with numCoeff (<= MaxCoeffs) coefficients
+  void reset(const int& numCoeff);
+
+  // Add one observation; x holds numCoeff values
+  inline void addRow(const float* x, const float& y);
+
+  bool solve(float& stDeviation, float* coeff, float* stError) const;
+
+  // Drop-in replacement for Matrix::lls on a numCoeff x numData design
+  // matrix. Falls back to Matrix::lls if numCoeff is too large.
+  static bool lls(const int& numCoeff, const long& numData, float** x, float* y,
+                  float& stDeviation, float* coeff, float* stError);
+
+  int  getNumCoeff() const { return _numCoeff; }
+  long getNumData() const { return _numData; }
+
+private:
+
+  int _numCoeff;
+  long _numData;
+  double _xtx[MaxCoeffs][MaxCoeffs];
+  double _xty[MaxCoeffs];
+  double _yty;
+
+};
+
+template <int MaxCoeffs>
+void LeastSquares<MaxCoeffs>::reset(const int& numCoeff)
+{
+  _numCoeff = numCoeff < MaxCoeffs ? numCoeff : MaxCoeffs;
+  _numData = 0;
+  _yty = 0;
+  for (int row = 0; row < MaxCoeffs; row++) {
+    for (int col = 0; col < MaxCoeffs; col++)
+      _xtx[row][col] = 0;
+    _xty[row] = 0;
+  }
+}
+
+template <int MaxCoeffs>
+inline void LeastSquares<MaxCoeffs>::addRow(const float* x, const float& y)
+{
+  double xd[MaxCoeffs];
+  const int n = _numCoeff;
+  for (int col = 0; col < n; col++)
+    xd[col] = x[col];
+  const double yd = y;
+
+  for (int row = 0; row < n; row++) {
+    const double xr = xd[row];
+    double* xtxRow = _xtx[row];
+    for (int col = row; col < n; col++)
+      xtxRow[col] += xr * xd[col];
+    _xty[row] += xr * yd;
+  }
+  _yty += yd * yd;
+  _numData++;
+}
+
+template <int MaxCoeffs>
+bool LeastSquares<MaxCoeffs>::solve(float& stDeviation, float* coeff, float* stError) const
+{
+  const int n = _numCoeff;
+  for (int i = 0; i < n; i++)
+    coeff[i] = 0;
+
+  // We need at least as many data points as coefficients
+  if ((n == 0) || (_numData < n))
+    return false;
+
+  // Cholesky factorization x'x = L L'
+  double L[MaxCoeffs][MaxCoeffs];
+  for (int j = 0; j < n; j++) {
+    double sum = _xtx[j][j];
+    for (int k = 0; k < j; k++)
+      sum -= L[j][k] * L[j][k];
+    if (!(sum > 0))
+      return false;
+    L[j][j] = sqrt(sum);
+    for (int i = j + 1; i < n; i++) {
+      double off = _xtx[j][i];
+      for (int k = 0; k < j; k++)
+        off -= L[i][k] * L[j][k];
+      L[i][j] = off / L[j][j];
+    }
+  }
+
+  // Forward and back substitution
+  double z[MaxCoeffs];
+  for (int i = 0; i < n; i++) {
+    double sum = _xty[i];
+    for (int k = 0; k < i; k++)
+      sum -= L[i][k] * z[k];
+    z[i] = sum / L[i][i];
+  }
+  double c[MaxCoeffs];
+  for (int i = n - 1; i >= 0; i--) {
+    double sum = z[i];
+    for (int k = i + 1; k < n; k++)
+      sum -= L[k][i] * c[k];
+    c[i] = sum / L[i][i];
+  }
+
+  // Residual sum of squares, y'y - c'x'y at the solution
+  double rss = _yty;
+  for (int i = 0; i < n; i++) {
+    rss -= c[i] * _xty[i];
+    coeff[i] = float(c[i]);
+  }
+  if (rss < 0) rss = 0;
+
+  if (_numData != n)
+    stDeviation = float(sqrt(rss / double(_numData - n)));
+  else
+    stDeviation = float(sqrt(rss));
+
+  // The diagonal of the inverse of x'x is the column sums of squares of L^-1
+  double Linv[MaxCoeffs][MaxCoeffs];
+  for (int col = 0; col < n; col++) {
+    Linv[col][col] = 1.0 / L[col][col];
+    for (int row = col + 1; row < n; row++) {
+      double sum = 0;
+      for (int k = col; k < row; k++)
+        sum -= L[row][k] * Linv[k][col];
+      Linv[row][col] = sum / L[row][row];
+    }
+  }
+  for (int i = 0; i < n; i++) {
+    double diag = 0;
+    for (int row = i; row < n; row++)
+      diag += Linv[row][i] * Linv[row][i];
+    stError[i] = stDeviation * float(sqrt(fabs(diag)));
+  }
+
+  return true;
+}
+
+template <int MaxCoeffs>
+bool LeastSquares<MaxCoeffs>::lls(const int& numCoeff, const long& numData, float** x, float* y,
+                                  float& stDeviation, float* coeff, float* stError)
+{
+  if (numCoeff > MaxCoeffs)
+    return Matrix::lls(numCoeff, int(numData), x, y, stDeviation, coeff, stError);
+
+  LeastSquares<MaxCoeffs> fit(numCoeff);
+  float row[MaxCoeffs];
+  for (long i = 0; i < numData; i++) {
+    for (int r = 0; r < numCoeff; r++)
+      row[r] = x[r][i];
+    fit.addRow(row, y[i]);
+  }
+  return fit.solve(stDeviation, coeff, stError);
+}
+
+#endif
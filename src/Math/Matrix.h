@@ -24,6 +24,13 @@ public:
   // Preforms a least squares regression on the velocity values
   // on the selected VAD ring to deduce the environmental wind
 
+  static bool lls(const int &numCoeff, const int &numData, float** &x, float* &y,
+		  float &stDeviation, float* &coeff, float* &stError,
+		  float** normal, float** rhs);
+  // Same as above, but builds the normal equations in caller supplied
+  // storage (normal is numCoeff x numCoeff, rhs is numCoeff x 1) instead
+  // of allocating it
+
   static bool oldlls(const int &numCoeff, const long &numData, 
 		  float** &x, float* &y, 
 		  float &stDeviation, float* &coeff, float* &stError, 
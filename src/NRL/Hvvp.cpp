@@ -13,9 +13,11 @@
 #include "Sweep.h"
 #include <math.h>
 #include "Math/Matrix.h"
+#include "Math/LeastSquares.h"
 #include <QFile>
 #include <QDir>
 #include <QTextStream>
+#include <QtConcurrentMap>
 
 /*
 * The HVVP subroutine used here was created and written by Paul Harasti for 
@@ -38,7 +40,6 @@ Hvvp::Hvvp()
 	xlsDimension = 16;
 	// New HVVP number of predictor variables
 	//  xlsDimension = 10;
-	maxpoints = 500000;               // **
   
 	z = new float[levels];
 	u = new float[levels];
@@ -62,15 +63,6 @@ Hvvp::Hvvp()
 		xr[i] = velNull;
 	}
 
-	xls = new float*[xlsDimension];
-	wgt = new float[maxpoints];
-	yls = new float[maxpoints];
-	for(int k = 0; k < xlsDimension; k++) {
-		xls[k] = new float[maxpoints];
-		for(long kk = 0; kk < maxpoints; kk++)
-			xls[k][kk] = velNull;
-	}
-
 	printOutput = true;
 	hgtStart = .600;                // km   // Most Recently Used
 	//hgtStart = 1.0;
@@ -91,13 +83,6 @@ Hvvp::~Hvvp()
 	delete [] vt;
 	delete [] xr;
 	delete [] vr;
-  
-	for(int i = 0; i < xlsDimension; i++) {
-		delete [] xls[i];
-	}
-	delete [] yls;
-	delete [] xls;
-	delete [] wgt;
 }
 
 void Hvvp::setRadarData(RadarData *newVolume, float range, float angle, float vortexRmw)
@@ -137,176 +122,171 @@ float Hvvp::rotateAzimuth(const float &angle)
 	return newAngle;
 }
 
-long Hvvp::hvvpPrep(int m) {
+void Hvvp::Layer::setHeight(float height, float inc, int numCoeff)
+{
+	h0 = height;
+	hLow = h0-inc;
+	hHigh = h0+inc;
+	fit.reset(numCoeff);
+	goodFit.reset(numCoeff);
+	fitted = false;
+	outlier = false;
+	cgood = 0;
+	sse = 0;
+}
+
+void Hvvp::Layer::solve()
+{
+	fitted = fit.solve(sse, cc, stand_err);
+}
+
+void Hvvp::Layer::refit()
+{
+	// The HVVP parameters are taken from this fit whether it succeeds or not
+	goodFit.solve(sse, cc, stand_err);
+}
+
+void Hvvp::scanLayers(QVector<Layer>& layers, bool screen)
+{
 
 	float cumin = 5.0/rt;                 // What are the units here?
 	float cuspec = 0.6;                   // Unitless
 	float curmw = (rt - rmw)/rt;          // Unitless
 	float cuthr;                          // Unitless
-	float ae = 4.0*6371.0/3.0;                // km
-	Sweep* currentSweep = NULL;
-	Ray* currentRay = NULL;
-	float* vel = NULL; 
 
 	if(cuspec < curmw)
 		cuthr = cuspec; 
 	else 
 		cuthr = curmw;
 
-	/*
-	// For Printing the results to file for Fortran Comparisons
- 
-	Message::toScreen("hgtStart = "+QString().setNum(hgtStart)+" hInc = "+QString().setNum(hInc));
-  
-	QString fileName("PointsSelected_BigLevel"+QString().setNum(m)+".csv");
-	QFile* outputFile = new QFile(fileName);
-	outputFile->open(QIODevice::WriteOnly);
-	QTextStream out(outputFile);
-	out << "Printing Data Points in Level " << m << endl;
-	Message::toScreen("Writing to "+outputFile->fileName()+" .... ");
-  
-	if(m == 0) {
-	out << "CUTHR, "<< cuthr << endl;
-	out << "CUMIN, "<< cumin << endl;
-	out << " alt(km), cu, Vd(m/s), elvn(adjusted for range in rad), ray index, az(after rotation in rad)" << endl;
-	}
-	*/ // End Comments
-  
 	rot = cca*deg2rad;               // ** 
 	// float rot = (cca-4.22)*deg2rad; **
 	// ** Special case scenerio for KBRO Data of Bret (1999)
-  
-	for(int k = 0; k < xlsDimension; k++) {
-		for(long l = 0; l < maxpoints; l++) {
-			xls[k][l] = 0;
-			yls[l] = 0;
-		}
-	}
 
-	long count = 0;
-	float h0 = hgtStart+hInc*float(m);
-	z[m] = h0;
-	float hLow = h0-hInc;
-	float hHigh = h0+hInc;
-
-	//  out << " num sweeps = " << volume->getNumSweeps();
+	const int numLayers = layers.size();
+	float x[maxXlsDimension];
 
 	for(int s = 0; s < volume->getNumSweeps(); s++) {
-		currentSweep = volume->getSweep(s);
-		//float elevation = currentSweep->getElevation();     // deg
-		// if(elevation <= 5.0) {
+		Sweep* currentSweep = volume->getSweep(s);
 		int startRay = currentSweep->getFirstRay();
 		int stopRay = currentSweep->getLastRay();
 		for(int r = startRay; r <= stopRay; r++) {
-			currentRay = volume->getRay(r);
+			Ray* currentRay = volume->getRay(r);
 			float elevation = currentRay->getElevation();
 			// Current HVVP set elevation max to 5.0
 			// New HVVP set elevation max to 25.0
-			if(elevation <= 5.0) {                           // deg
-				vel = currentRay->getVelData();          // still in km/s
-				//	float vGateSpace = currentRay->getVel_gatesp(); // in m
-				//	vGateSpace /= 1000.0;   // now in km
-				float numGates = currentRay->getVel_numgates();
-				int first = 0;
-				// int first = currentRay->getFirst_vel_gate();   
-				// What does getFirst_vel_gate actually return?
-				// Index or distance?
-				// Are the limits on this ray right or should i go
-				// to first+numGates is ? -LM
-				float aa = currentRay->getAzimuth();
-				aa = rotateAzimuth(aa)*deg2rad;
-				float sinaa = sin(aa);
-				float cosaa = cos(aa);
-				for(int v = first; v < numGates; v++) {
-					if(vel[v]!=velNull) {
-						// PH 10/2007.  need accurate range - previously missing first gate distance 
-						// which  has usually been -0.375 m (due to radar T/R time delay) but is now
-						// 0.125 m for VCP 211.
-						float srange =  float(currentRay->getFirst_vel_gate()+(v*currentRay->getVel_gatesp()))/1000.;
-
-						//	    float srange = (rangeStart+float(v)*vGateSpace);
-						float cu = srange/rt * cos(elevation*deg2rad);    // unitless
-						//float alt = volume->absoluteRadarBeamHeight(srange, elevation);  // km
-						float alt = volume->radarBeamHeight(srange, elevation);  // km
-						if((cu > cumin)&&(cu < cuthr)&&(alt >= hLow)&&(alt < hHigh)) {
-							float ee = elevation*deg2rad;
-							ee+=asin(srange*cos(elevation*deg2rad)/(ae+alt));
-							float cosee = cos(ee);
-							float xx = srange*cosee*sinaa;
-							float yy = srange*cosee*cosaa;
-							float rr = srange*srange*cosee*cosee*cosee;
-							float zz = alt-h0;
-
-							//Used for checking the first ten entries
-							/*
-							//if(((count<=30)||(s == 6))&&(m==0)){
-							out << count << "= v: " << vel[v] << " gate " << v << " ray " <<r-startRay << " orig az = " << currentRay->getAzimuth() << endl;
-							out << " elev# " << s << " = " << elevation << endl;
-							out << count << "= srange: " << srange << " cu " << cu << " alt " << alt << " zz " << zz << endl;
-							}
-							// Comments End For Paul's Test      
-							if(m == 0) {
-							// What Paul would like to receive for comparisons
-							out << alt << ", " << cu << ", " << vel[v] << ", " << ee << ", "<< r << ", " << aa << endl;
-							}
-							// Comments Begin For Paul's Test
-	      
-							//What I was using for test comparisons
-							out << vel[v] << ", " << v << ", " << r-startRay <<", " << currentRay->getAzimuth() << ", " << s << ",  " << elevation << ", " << srange << ", " << cu << ", " << alt << ", " << zz << endl;
-		
-
-							}
-							*/
-	      
-							yls[count] = vel[v];
-							wgt[count] = 1; 
-							// why are we weighting it if they are all the same? -LM
-							xls[0][count] = sinaa*cosee;
-							xls[1][count] = cosee*sinaa*xx;
-							xls[2][count] = cosee*sinaa*zz;
-							xls[3][count] = cosaa*cosee;
-							xls[4][count] = cosee*cosaa*yy;
-							xls[5][count] = cosee*cosaa*zz;
-							xls[6][count] = cosee*sinaa*yy;
-							// For new HVVP comment out to xls[15][count]
-							xls[7][count] = rr*sinaa*sinaa*sinaa;
-							xls[8][count] = rr*sinaa*cosaa*cosaa;
-							xls[9][count] = rr*cosaa*cosaa*cosaa;
-							xls[10][count] = rr*cosaa*sinaa*sinaa;
-							xls[11][count] = cosee*sinaa*xx*zz;
-							xls[12][count] = cosee*cosaa*yy*zz;
-							xls[13][count] = cosee*sinaa*zz*zz;
-							xls[14][count] = cosee*cosaa*zz*zz;
-							xls[15][count] = cosee*sinaa*yy*zz;
-							// For new HVVP, uncomment to xls[9][count] 
-							//              xls[7][count] = rr*sinaa;
-							//              xls[8][count] = rr*cosaa;
-							//              xls[9][count] = (1.0 + sinaa*cosaa)*zz*srange*cosee*cosee;
-							if (count < maxpoints) {
-								count++;
-							} else {
-								// emit log(Message(QString("Truncating HVVP at 500k rows"), 0,this->objectName()));
-								break;
-							}
-						}
+			if(elevation > 5.0)                           // deg
+				continue;
+			float* vel = currentRay->getVelData();          // still in km/s
+			float numGates = currentRay->getVel_numgates();
+			float aa = currentRay->getAzimuth();
+			aa = rotateAzimuth(aa)*deg2rad;
+			float sinaa = sin(aa);
+			float cosaa = cos(aa);
+			// Range, height and effective elevation of each gate come
+			// from the volume's geometry tables
+			const BeamGeometry::Gates* geometry = volume->getVelGeometry(currentRay);
+			float cosElevation = geometry->cosElevation;
+			for(int v = 0; v < numGates; v++) {
+				if(vel[v]==velNull)
+					continue;
+				// PH 10/2007.  need accurate range - previously missing first gate distance 
+				// which  has usually been -0.375 m (due to radar T/R time delay) but is now
+				// 0.125 m for VCP 211.
+				float srange = geometry->range[v];
+				float cu = srange/rt * cosElevation;    // unitless
+				if((cu <= cumin)||(cu >= cuthr))
+					continue;
+				float alt = geometry->height[v];  // km
+				float cosee = geometry->cosEffectiveElevation[v];
+				float xx = srange*cosee*sinaa;
+				float yy = srange*cosee*cosaa;
+				float rr = srange*srange*cosee*cosee*cosee;
+
+				// The layers overlap, so a gate is in one or two of them
+				for(int m = 0; m < numLayers; m++) {
+					Layer& layer = layers[m];
+					if((alt < layer.hLow)||(alt >= layer.hHigh))
+						continue;
+					if(screen && !layer.fitted)
+						continue;
+					float zz = alt-layer.h0;
+					x[0] = sinaa*cosee;
+					x[1] = cosee*sinaa*xx;
+					x[2] = cosee*sinaa*zz;
+					x[3] = cosaa*cosee;
+					x[4] = cosee*cosaa*yy;
+					x[5] = cosee*cosaa*zz;
+					x[6] = cosee*sinaa*yy;
+					// For new HVVP comment out to x[15]
+					x[7] = rr*sinaa*sinaa*sinaa;
+					x[8] = rr*sinaa*cosaa*cosaa;
+					x[9] = rr*cosaa*cosaa*cosaa;
+					x[10] = rr*cosaa*sinaa*sinaa;
+					x[11] = cosee*sinaa*xx*zz;
+					x[12] = cosee*cosaa*yy*zz;
+					x[13] = cosee*sinaa*zz*zz;
+					x[14] = cosee*cosaa*zz*zz;
+					x[15] = cosee*sinaa*yy*zz;
+					// For new HVVP, uncomment to x[9]
+					//              x[7] = rr*sinaa;
+					//              x[8] = rr*cosaa;
+					//              x[9] = (1.0 + sinaa*cosaa)*zz*srange*cosee*cosee;
+					if(!screen) {
+						layer.fit.addRow(x, vel[v]);
+						continue;
+					}
+
+					/*
+					* Check for outliers that deviate more than two standard 
+					*   deviations from the least squares fit.
+					*
+					*/
+					float vr_est = 0;
+					for(int p = 0; p < xlsDimension; p++) {
+						vr_est = vr_est+layer.cc[p]*x[p];
+					}
+					if(fabs(vr_est-vel[v])>2.0*layer.sse) {
+						layer.outlier = true;
+					}
+					else {
+						layer.cgood++;
+						layer.goodFit.addRow(x, vel[v]);
 					}
 				}
-				vel = NULL;
 			}
-			currentRay = NULL;
 		}
-		currentSweep = NULL;
 	}
-	delete currentSweep;
-	delete currentRay;
-	delete vel;
-
-	//out << "Level " << m << " count = " << count << endl;
-	//Message::toScreen("Level "+QString().setNum(m)+" count = "+QString().setNum(count));
+}
 
-	//outputFile->close();
+void Hvvp::fitLayers(QVector<Layer>& layers, bool both)
+{
+	scanLayers(layers, false);
 
-	return count;
+	QVector<int> solvable;
+	for(int m = 0; m < layers.size(); m++) {
+		if(layers[m].fit.getNumData() >= minLayerPoints)
+			solvable.append(m);
+	}
+	QtConcurrent::blockingMap(solvable, SolveLayer(&layers, false));
+	if(!both)
+		return;
+
+	// Re-calculate the least squares solution if outliers are found.
+	bool anyFitted = false;
+	for(int i = 0; i < solvable.size(); i++)
+		anyFitted = anyFitted || layers[solvable[i]].fitted;
+	if(!anyFitted)
+		return;
+	scanLayers(layers, true);
+
+	QVector<int> refits;
+	for(int i = 0; i < solvable.size(); i++) {
+		const Layer& layer = layers[solvable[i]];
+		if(layer.fitted && layer.outlier && (layer.cgood >= minLayerPoints))
+			refits.append(solvable[i]);
+	}
+	QtConcurrent::blockingMap(refits, SolveLayer(&layers, true));
 }
 
 bool Hvvp::findHVVPWinds(bool both)
@@ -336,6 +316,15 @@ bool Hvvp::findHVVPWinds(bool both)
 	long count = 0; 
 	int last = 0;
 
+	// One scan of the volume fills all the layers, which are then solved
+	// together
+	QVector<Layer> layers(levels);
+	for(int m = 0; m < levels; m++) {
+		layers[m].setHeight(hgtStart+hInc*float(m), hInc, xlsDimension);
+		z[m] = layers[m].h0;
+	}
+	fitLayers(layers, both);
+
 	// For updating the percentage bar we have 7% to give away in this routine
 	float increment = float(levels)/7.0;
 
@@ -348,7 +337,8 @@ bool Hvvp::findHVVPWinds(bool both)
 
 		xt[m] = velNull; 
 
-		count = hvvpPrep(m);
+		const Layer& layer = layers[m];
+		count = layer.fit.getNumData();
 
 		/* 
 		* Empirically determined limit to the minimum number of points
@@ -357,111 +347,12 @@ bool Hvvp::findHVVPWinds(bool both)
 		*/
 
 
-		if(count >= 6500.0) {
-
-			float sse;
-			float *stand_err = new float[xlsDimension];
-			float *cc = new float[xlsDimension];
-			bool flag, outlier;
-      
-			// Only for comparisons in Mathematica
-			/* // Comment start here
-			QString fileName("/scr/science40/mauger/Working/trunk/hvvp1824CharBigRepeat"+QString().setNum(m)+".dat");
-			writeToFile(fileName,xlsDimension,count,count,1,xls,yls);
-			QString midFileName = fileName+QString(".printA");
-			flag = Matrix::oldlls(xlsDimension, count, xls, yls, sse, cc, stand_err, midFileName);
-			Message::toScreen(QString(" count = ")+QString().setNum(count));
-			QFile* outputFile = new QFile(fileName+QString(".cpplls"));
-			outputFile->open(QIODevice::WriteOnly);
-			QTextStream out(outputFile);
-			out << "Volume Used" << volume->getDateTimeString() << endl;
-			out << "Range: " << rt << endl;
-			out << "CCA: " << cca << endl;
-			out << "RMW: " << rmw << endl;
-			out << endl;
-			out << "OLD C++ ROUTINE" << endl << endl;
-			out << "SSE: "<<sse<<endl;
-			out << "stand_dev@" << m << ": " << sse << endl;
-			for(int zz = 0; zz < xlsDimension; zz++) {
-			out << cc[zz] << " " << stand_err[zz] << endl;
-			}
-      
-			flag = Matrix::lls(xlsDimension, count, xls, yls, sse, cc, stand_err);
-      
-			out << "NEW C++ ROUTINE" << endl << endl;
-			out << "SSE: "<< sse << endl;
-			out << "stand_dev@" << m << ": " << sse << endl;
-			for(int zz = 0; zz < xlsDimension; zz++) {
-			out << cc[zz] << " " << stand_err[zz] << endl;
-			}
-      
-			outputFile->close();
-			*/ // comments end here
-      
-			flag = Matrix::lls(xlsDimension, count, xls, yls, sse, cc, stand_err);
-
-			//Message::toScreen("SSE = "+QString().setNum(sse));
-
-			//Message::toScreen("Finished Printing in HVVP");
-
-			/*
-			* Check for outliers that deviate more than two standard 
-			*   deviations from the least squares fit.
-			*
-			*/
-
-			if(flag) {
-				outlier = false;
-				long cgood = 0;
-				for (long n = 0; n < count; n++) {
-					float vr_est = 0;
-					for(int p = 0; p < xlsDimension; p++) {
-						vr_est = vr_est+cc[p]*xls[p][n];
-					}
-					if(fabs(vr_est-yls[n])>2.0*sse) {
-						yls[n] = velNull;
-						outlier = true;
-					}
-					else {
-						cgood++;
-					}
-				}
+		if(count >= minLayerPoints) {
 
-				// Re-calculate the least squares solution if outliers are found.
-
-
-
-				if(both) {
-					if(outlier && (cgood >=long(6500))) {
-						long qc_count = 0;
-						float** qcxls = new float*[xlsDimension];
-						float* qcyls = new float[count];
-						for(int d = 0; d < xlsDimension; d++) {
-							qcxls[d] = new float[count];
-						} 
-						for (long n = 0; n < count; n++) {
-							qcyls[n] = 0;
-							for(int p = 0; p < xlsDimension; p++) {
-								qcxls[p][n] = 0;
-							}
-
-							if(yls[n] != velNull) {
-								qcyls[qc_count] = yls[n];
-								for(int p = 0; p < xlsDimension; p++) {
-									qcxls[p][qc_count] = xls[p][n];
-								}
-								qc_count++;
-							}
-						}
-						// Message::toScreen("qc_count = "+QString().setNum(qc_count));
-						flag=Matrix::lls(xlsDimension,qc_count,qcxls,qcyls,sse,cc,stand_err);
-						for(int ii = 0; ii < xlsDimension; ii++) {
-							delete [] qcxls[ii];
-						}
-						delete [] qcxls;
-						delete [] qcyls;
-					}
-				}
+			const float* stand_err = layer.stand_err;
+			const float* cc = layer.cc;
+
+			if(layer.fitted) {
 
 				// Calculate the HVVP wind parameters:
 
@@ -561,8 +452,6 @@ bool Hvvp::findHVVPWinds(bool both)
 				v[m] = velNull;
 				vm_sin[m] = velNull;
 			}
-			delete [] stand_err;
-			delete [] cc;
 		} else {
 			//z[m] = h0;
 			u[m] = velNull;
@@ -777,78 +666,19 @@ bool Hvvp::computeCrossBeamWind(float height, float& cc0, float& cc6, float& sse
 		return false;
 	}
 
-	hgtStart = height;
-	int count = hvvpPrep(0);
-
-	if(count >= 6500) {
-
-		float *stand_err = new float[xlsDimension];
-		float *cc = new float[xlsDimension];
-		bool flag, outlier;
-
-		flag = Matrix::lls(xlsDimension, count, xls, yls, sse, cc, stand_err);
-
-		if(flag) {
-			outlier = false;
-			long cgood = 0;
-			for (long n = 0; n < count; n++) {
-				float vr_est = 0;
-				for(int p = 0; p < xlsDimension; p++) {
-					vr_est = vr_est+cc[p]*xls[p][n];
-				}
-				if(fabs(vr_est-yls[n])>2.0*sse) {
-					yls[n] = velNull;
-					outlier = true;
-				}
-				else {
-					cgood++;
-				}
-			}
-
-			// Re-calculate the least squares solution if outliers are found.
-			if(1) {
-				if(outlier && (cgood >=long(6500))) {
-					long qc_count = 0;
-					float** qcxls = new float*[xlsDimension];
-					float* qcyls = new float[count];
-					for(int d = 0; d < xlsDimension; d++) {
-						qcxls[d] = new float[count];
-					} 
-					for (long n = 0; n < count; n++) {
-						qcyls[n] = 0;
-						for(int p = 0; p < xlsDimension; p++) {
-							qcxls[p][n] = 0;
-						}
-
-						if(yls[n] != velNull) {
-							qcyls[qc_count] = yls[n];
-							for(int p = 0; p < xlsDimension; p++) {
-								qcxls[p][qc_count] = xls[p][n];
-							}
-							qc_count++;
-						}
-					}
-					// Message::toScreen("qc_count = "+QString().setNum(qc_count));
-					flag=Matrix::lls(xlsDimension,qc_count,qcxls,qcyls,sse,cc,stand_err);
-					for(int ii = 0; ii < xlsDimension; ii++) {
-						delete [] qcxls[ii];
-					}
-					delete [] qcxls;
-					delete [] qcyls;
-				}
-			}
-
-			// Across-beam component of the environmental wind
-			cc0 = cc[0];
-			cc6 = cc[6];
-			delete[] stand_err;
-			delete[] cc;
-			return true;
-		} 
-		else{
-			delete[] stand_err;
-			delete[] cc;
-		}
+	// A single layer centered on height; the analysis heights of
+	// findHVVPWinds are left alone so both can be asked of one object
+	QVector<Layer> layers(1);
+	layers[0].setHeight(height, hInc, xlsDimension);
+	fitLayers(layers, true);
+
+	const Layer& layer = layers[0];
+	if((layer.fit.getNumData() >= minLayerPoints) && layer.fitted) {
+		// Across-beam component of the environmental wind
+		cc0 = layer.cc[0];
+		cc6 = layer.cc[6];
+		sse = layer.sse;
+		return true;
 	}
 	return false;
 }
@@ -11,9 +11,11 @@
 #ifndef HVVP_H
 #define HVVP_H
 
+#include <QVector>
 #include "RadarData.h"
 #include "Message.h"
 #include "Configuration.h"
+#include "Math/LeastSquares.h"
 
 
 class Hvvp : public QObject
@@ -75,11 +77,41 @@ private:
 
     float deg2rad, rad2deg;
 
-    float** xls;
     int xlsDimension;
-    long maxpoints;
-    float* yls;
-    float* wgt;
+    // Capacity of the fixed-size least squares fit, at least xlsDimension
+    static const int maxXlsDimension = 16;
+    // Empirically determined minimum number of points in a layer
+    static const long minLayerPoints = 6500;
+
+    // One analysis layer, h0 - hInc <= height < h0 + hInc. Each gate's
+    // row is folded into the layer's normal equations as the volume is
+    // scanned, so no design matrix is kept and one scan fills every layer.
+    class Layer {
+    public:
+        void setHeight(float height, float inc, int numCoeff);
+        void solve();
+        void refit();
+        float h0, hLow, hHigh;
+        LeastSquares<maxXlsDimension> fit;
+        // Rows within two standard deviations of the first fit
+        LeastSquares<maxXlsDimension> goodFit;
+        bool fitted, outlier;
+        long cgood;
+        float sse;
+        float cc[maxXlsDimension];
+        float stand_err[maxXlsDimension];
+    };
+
+    class SolveLayer {
+    public:
+        SolveLayer(QVector<Layer>* layers, bool refit) : layers(layers), refit(refit) {}
+        typedef void result_type;
+        void operator()(const int& m) const
+            { if (refit) (*layers)[m].refit(); else (*layers)[m].solve(); }
+    private:
+        QVector<Layer>* layers;
+        bool refit;
+    };
 
     float *z, *u, *v, *vm_sin, *var, av_VmSin, stdErr_VmSin;
     /*
@@ -133,7 +165,12 @@ private:
 
     float rotateAzimuth(const float &angle);
 
-    long hvvpPrep(int m);
+    // Accumulate every qualifying gate into the layers it falls in. With
+    // screen set, compare each row to the first fit of its layer instead
+    // and collect the ones that are not outliers.
+    void scanLayers(QVector<Layer>& layers, bool screen);
+    // Fit all layers, and with both set fit again without the outliers
+    void fitLayers(QVector<Layer>& layers, bool both);
 
 
     //Moved to static functions in Math/Matrix
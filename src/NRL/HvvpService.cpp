@@ -0,0 +1,169 @@
+/*
+ *  HvvpService.cpp
+ *  VORTRAC
+ *
+ *  Copyright 2026 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include "HvvpService.h"
+#include <QElapsedTimer>
+
+HvvpService::HvvpService(QObject *parent) : QObject(parent)
+{
+    setObjectName("HVVP");
+    volume = NULL;
+    configData = NULL;
+    rt = cca = rmw = -999;
+    requests = 0;
+    volumeFits = 0;
+    fitMsecs = 0;
+}
+
+HvvpService::~HvvpService()
+{
+    clear();
+}
+
+void HvvpService::setConfig(Configuration* newConfig)
+{
+    if (newConfig != configData)
+        clear();
+    configData = newConfig;
+}
+
+void HvvpService::setRadarData(RadarData *newVolume)
+{
+    if (newVolume != volume)
+        clear();
+    volume = newVolume;
+}
+
+void HvvpService::setCenter(float range, float angle, float vortexRmw)
+{
+    rt = range;
+    cca = angle;
+    rmw = vortexRmw;
+}
+
+void HvvpService::clear()
+{
+    for (int i = 0; i < centers.count(); i++) {
+        delete centers[i]->hvvp;
+        delete centers[i];
+    }
+    centers.clear();
+}
+
+HvvpService::Center* HvvpService::findCenter() const
+{
+    for (int i = 0; i < centers.count(); i++) {
+        Center* center = centers[i];
+        if ((center->rt == rt) && (center->cca == cca) && (center->rmw == rmw))
+            return center;
+    }
+    return NULL;
+}
+
+HvvpService::Center* HvvpService::currentCenter()
+{
+    Center* found = findCenter();
+    if (found != NULL)
+        return found;
+
+    Center* center = new Center;
+    center->rt = rt;
+    center->cca = cca;
+    center->rmw = rmw;
+    center->hvvp = new Hvvp;
+    if (configData != NULL)
+        center->hvvp->setConfig(configData);
+    center->hvvp->setRadarData(volume, rt, cca, rmw);
+    connect(center->hvvp, SIGNAL(log(const Message&)), this, SLOT(catchLog(const Message&)),
+            Qt::DirectConnection);
+    center->windsDone = false;
+    center->printed = false;
+    center->hasHVVP = false;
+    centers.append(center);
+    return center;
+}
+
+bool HvvpService::findHVVPWinds(bool printOutput)
+{
+    requests++;
+    Center* center = currentCenter();
+    if (center->windsDone && (center->printed || !printOutput))
+        return center->hasHVVP;
+
+    QElapsedTimer timer;
+    timer.start();
+    center->hvvp->setPrintOutput(printOutput);
+    //center->hvvp->findHVVPWinds(false); for first fit only
+    center->hasHVVP = center->hvvp->findHVVPWinds(true);
+    center->windsDone = true;
+    center->printed = printOutput;
+    volumeFits++;
+    fitMsecs += timer.elapsed();
+    return center->hasHVVP;
+}
+
+float HvvpService::getAvAcrossBeamWinds() const
+{
+    const Center* center = findCenter();
+    if ((center == NULL) || !center->windsDone)
+        return -999;
+    return center->hvvp->getAvAcrossBeamWinds();
+}
+
+float HvvpService::getAvAcrossBeamWindsStdError() const
+{
+    const Center* center = findCenter();
+    if ((center == NULL) || !center->windsDone)
+        return -999;
+    return center->hvvp->getAvAcrossBeamWindsStdError();
+}
+
+bool HvvpService::computeCrossBeamWind(float height, float& cc0, float& cc6, float& sse)
+{
+    requests++;
+    Center* center = currentCenter();
+    for (int i = 0; i < center->crossBeam.count(); i++) {
+        const CrossBeamWind& wind = center->crossBeam.at(i);
+        if (wind.height == height)
+            return copyCrossBeamWind(wind, cc0, cc6, sse);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    CrossBeamWind wind;
+    wind.height = height;
+    wind.cc0 = wind.cc6 = -999;
+    wind.found = center->hvvp->computeCrossBeamWind(height, wind.cc0, wind.cc6, wind.sse);
+    center->crossBeam.append(wind);
+    volumeFits++;
+    fitMsecs += timer.elapsed();
+    return copyCrossBeamWind(wind, cc0, cc6, sse);
+}
+
+bool HvvpService::copyCrossBeamWind(const CrossBeamWind& wind, float& cc0, float& cc6, float& sse)
+{
+    // Like Hvvp, the coefficients are only set if the fit worked
+    sse = wind.sse;
+    if (wind.found) {
+        cc0 = wind.cc0;
+        cc6 = wind.cc6;
+    }
+    return wind.found;
+}
+
+QString HvvpService::counterSummary() const
+{
+    return QString("HVVP requests: %1, volume fits: %2, fit time: %3 ms")
+        .arg(requests).arg(volumeFits).arg(fitMsecs);
+}
+
+void HvvpService::catchLog(const Message& message)
+{
+    emit log(message);
+}
@@ -0,0 +1,97 @@
+/*
+ *  HvvpService.h
+ *  VORTRAC
+ *
+ *  Copyright 2026 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef HVVPSERVICE_H
+#define HVVPSERVICE_H
+
+#include <QList>
+#include <QObject>
+#include "Hvvp.h"
+
+// HVVP results for one radar volume, shared by everything in the VTD
+// stage. Both the environmental wind and the cross beam wind only depend on
+// the distance and direction to the vortex and its RMW, so each is worked
+// out once per center and handed back to every later caller. The counters
+// record how many requests came in and how many of them had to scan the
+// volume.
+
+class HvvpService : public QObject
+{
+
+    Q_OBJECT
+
+public:
+
+    HvvpService(QObject *parent = 0);
+    ~HvvpService();
+
+    void setConfig(Configuration* newConfig);
+    // Forgets every result if the volume changes
+    void setRadarData(RadarData *newVolume);
+    // rt: range to the vortex (km), cca: direction to it (deg from north)
+    void setCenter(float range, float angle, float vortexRmw);
+
+    // Hvvp::findHVVPWinds(true) for the current center. A result worked
+    // out without printing is worked out again if printing is asked for.
+    bool findHVVPWinds(bool printOutput);
+    float getAvAcrossBeamWinds() const;
+    float getAvAcrossBeamWindsStdError() const;
+
+    // Hvvp::computeCrossBeamWind for the current center
+    bool computeCrossBeamWind(float height, float& cc0, float& cc6, float& sse);
+
+    void clear();
+
+    int getRequests() const { return requests; }
+    int getVolumeFits() const { return volumeFits; }
+    qint64 getFitMsecs() const { return fitMsecs; }
+    QString counterSummary() const;
+
+public slots:
+    void catchLog(const Message& message);
+
+signals:
+    void log(const Message& message);
+
+private:
+
+    class CrossBeamWind {
+    public:
+        float height;
+        bool found;
+        float cc0, cc6, sse;
+    };
+
+    class Center {
+    public:
+        float rt, cca, rmw;
+        Hvvp* hvvp;
+        bool windsDone;
+        bool printed;
+        bool hasHVVP;
+        QList<CrossBeamWind> crossBeam;
+    };
+
+    static bool copyCrossBeamWind(const CrossBeamWind& wind, float& cc0, float& cc6, float& sse);
+    Center* findCenter() const;
+    // The entry for the current center, made if it isn't there yet
+    Center* currentCenter();
+
+    RadarData *volume;
+    Configuration *configData;
+    float rt, cca, rmw;
+    QList<Center*> centers;
+
+    int requests;
+    int volumeFits;
+    qint64 fitMsecs;
+
+};
+
+#endif
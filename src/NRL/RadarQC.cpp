@@ -10,8 +10,10 @@
 
 #include <stdlib.h>
 #include <cmath>
+#include <algorithm>
 #include <QInputDialog>
 #include <QString>
+#include <QtConcurrentMap>
 
 #include "RadarQC.h"
 #include "RadarData.h"
@@ -263,20 +265,24 @@ RadarQC::RadarQC(RadarData *radarPtr, QObject *parent)
         int first = radarData->getSweep(n)->getFirstRay();
         int last = radarData->getSweep(n)->getLastRay();
         aveVADHeight[n] = new float[sweepNumVelGates];
-        for(int v = 0; v < sweepNumVelGates; v++) {
+        QVector<int> count(sweepNumVelGates, 0);
+        for(int v = 0; v < sweepNumVelGates; v++)
             aveVADHeight[n][v] = 0;
-            int count = 0;
-            for(int r = first; r <= last; r++) {
-                Ray *currentRay = radarData->getRay(r);
-                if(v < currentRay->getVel_numgates()) {
-                    count++;
-                    aveVADHeight[n][v] += findHeight(currentRay,v);
-                }
-                currentRay = NULL;
-                delete currentRay;
+        // Ray by ray so each ray's geometry is looked up once, the sums
+        // still go in ray order
+        for(int r = first; r <= last; r++) {
+            Ray *currentRay = radarData->getRay(r);
+            int numGates = qMin(currentRay->getVel_numgates(), sweepNumVelGates);
+            if(numGates <= 0)
+                continue;
+            const BeamGeometry::Gates* geometry = radarData->getVelGeometry(currentRay);
+            for(int v = 0; v < numGates; v++) {
+                count[v]++;
+                aveVADHeight[n][v] += findHeight(geometry,v);
             }
-            aveVADHeight[n][v] /= float(count);
         }
+        for(int v = 0; v < sweepNumVelGates; v++)
+            aveVADHeight[n][v] /= float(count[v]);
     }
 }
 
@@ -407,6 +413,8 @@ bool RadarQC::dealias()
     // reflectivity which could cause a large enough terminal velocity correction
     // to push clutter velocity beyond the assume +-1.5 m/s clutter threshold.
 
+    groupRaysBySweep();
+
     thresholdData();
     emit log(Message(QString(),1,this->objectName()));
 
@@ -437,6 +445,34 @@ bool RadarQC::dealias()
 
 
 
+void RadarQC::groupRaysBySweep()
+{
+    // The rays of a sweep, in ray order, by the sweep index they carry.
+    // Rays outside every sweep are left out, as the passes skipped them.
+    int numSweeps = radarData->getNumSweeps();
+    sweepRays.clear();
+    sweepRays.resize(numSweeps);
+    int numRays = radarData->getNumRays();
+    for(int i = 0; i < numRays; i++) {
+        Ray* currentRay = radarData->getRay(i);
+        if (currentRay == NULL) {
+            std::cout << "No ray at index " << i << std::endl;
+            continue;
+        }
+        int sweepIndex = currentRay->getSweepIndex();
+        if ((sweepIndex >= 0) && (sweepIndex < numSweeps))
+            sweepRays[sweepIndex].append(i);
+    }
+}
+
+void RadarQC::runSweepPass(SweepPass::Pass pass)
+{
+    QVector<int> sweeps(radarData->getNumSweeps());
+    for (int n = 0; n < sweeps.size(); n++)
+        sweeps[n] = n;
+    QtConcurrent::blockingMap(sweeps, SweepPass(this, pass));
+}
+
 void RadarQC::thresholdData()
 {
     /*
@@ -446,89 +482,72 @@ void RadarQC::thresholdData()
    *  improve the preformance of the following quality control routines.
    *  This method also calculates the number of valid gates, which is used
    *  in the VAD and GVAD methods.
+   *
+   *  Each sweep only counts into its own row of validBinCount, so the
+   *  sweeps are done in parallel.
    */
 
-    int numSweeps = radarData->getNumSweeps();
-    for (int i = 0; i < numSweeps; i++) {
-        Sweep *currentSweep = radarData->getSweep(i);
-        int numBins = currentSweep->getVel_numgates();
-        for (int j=0; j < numBins; j++)
-            validBinCount[i][j]=0.;
+    runSweepPass(&RadarQC::thresholdSweep);
+    emit log(Message(QString(),1,this->objectName()));
+}
+
+// Null the velocity of gates outside the thresholds and count the gates
+// left. Written without branches so it vectorizes.
+
+static void thresholdGates(float* vGates, const float* swGates, const int numVGates,
+                           const float specWidthLimit, const float velMin,
+                           const float velMax, const float velNull, float* binCount)
+{
+    for (int j = 0; j < numVGates; j++) {
+        const float v = vGates[j];
+        const float speed = fabs(v);
+        // This was extended to threshold against min and max
+        // reflectivity as well but we are not currently using
+        // these thresholds - LM
+        const bool bad = (swGates[j] > specWidthLimit) | (speed < velMin) | (speed > velMax);
+        const float kept = bad ? velNull : v;
+        vGates[j] = kept;
+        binCount[j] += (kept != velNull) ? 1.0f : 0.0f;
     }
+}
 
-    int numRays = radarData->getNumRays();
-    Ray* currentRay;
-    int numVGates = 0;
+static void countGates(const float* vGates, const int numVGates, const float velNull,
+                       float* binCount)
+{
+    for (int j = 0; j < numVGates; j++)
+        binCount[j] += (vGates[j] != velNull) ? 1.0f : 0.0f;
+}
 
-    for(int i = 0; i < numRays; i++)
+void RadarQC::thresholdSweep(const int& sweepIndex)
+{
+    Sweep *currentSweep = radarData->getSweep(sweepIndex);
+    int numSweepGates = currentSweep->getVel_numgates();
+    float* binCount = validBinCount[sweepIndex];
+    for (int j=0; j < numSweepGates; j++)
+        binCount[j]=0.;
+
+    const QVector<int>& rays = sweepRays.at(sweepIndex);
+    for(int r = 0; r < rays.size(); r++)
     {
-        if(i == (int) numRays/2.0)
-            emit log(Message(QString(),1,this->objectName()));
-        currentRay = radarData->getRay(i);
-	if (currentRay == NULL) {
-	  std::cout << "No ray at index " << i << std::endl;
-	  continue;
-	}
-        int sweepIndex = currentRay->getSweepIndex();
-	if (sweepIndex < 0)
-	  continue;
-	
-        Sweep *currentSweep = radarData->getSweep(sweepIndex);
-	if(currentSweep == NULL)
-	  continue;
+        Ray* currentRay = radarData->getRay(rays[r]);
+        int numVGates = currentRay->getVel_numgates();
+        if (numSweepGates < numVGates)
+            numVGates = numSweepGates;
+        if (numVGates <= 0)
+            continue;
 
-        int numSweepGates = currentSweep->getVel_numgates();
-	int numRayGates = currentRay->getVel_numgates();
-	if (numRayGates < numSweepGates) {
-	  numVGates = numRayGates;
-	} else {
-	  numVGates = numSweepGates;
-	}
-        //      float velGateSp = currentRay->getVel_gatesp();
-        //      float refGateSp = currentRay->getRef_gatesp();
         float *vGates = currentRay->getVelData();
         float *swGates = currentRay->getSwData();
-	// float *refGates = currentRay->getRefData();
+        if (vGates == NULL)
+            continue;
         if (swGates != NULL) {
-            for (int j = 0; j < numVGates; j++)
-            {
-                //         if(j<20) {
-                //         vGates[j]=velNull;
-                //       }
-                //	  int jref = int((float)j * velGateSp / refGateSp);
-                //	  if(jref >= currentRay->getRef_numgates())
-                //	    jref = int(velNull);
-                if((swGates[j] > specWidthLimit)||
-                   (fabs(vGates[j]) < velMin) ||
-                   (fabs(vGates[j]) > velMax))
-                    //||(jref==velNull)||(refGates[jref] < refMin)
-                    //  ||(refGates[jref] > refMax))
-                {
-                    // This was extended to threshold against min and max
-                    // reflectivity as well but we are not currently using
-                    // these thresholds - LM
-                    vGates[j] = velNull;
-                }
-                
-                if(vGates[j]!=velNull) {
-                    validBinCount[sweepIndex][j]++;
-                }
-            }
+            thresholdGates(vGates, swGates, numVGates, specWidthLimit, velMin, velMax,
+                           velNull, binCount);
         } else {
             // No spectrum width data, so just go with it for now
-	  if(vGates != NULL)
-            for (int j = 0; j < numVGates; j++) {
-                if(vGates[j]!=velNull) {
-                    validBinCount[sweepIndex][j]++;
-                }
-            }
+            countGates(vGates, numVGates, velNull, binCount);
         }
-        vGates = NULL;
-        swGates = NULL;
-        // refGates = NULL;
     }
-    currentRay = NULL;
-    delete currentRay;
 }
 
 
@@ -540,22 +559,21 @@ bool RadarQC::terminalVelocity()
    *  from each valid doppler velocity reading in the radar volume.
    */
 
+    runSweepPass(&RadarQC::terminalVelocitySweep);
+    return true;
+}
+
+void RadarQC::terminalVelocitySweep(const int& sweepIndex)
+{
     float ae = 6371.*4./3.; // Adjustment factor for 4/3 Earth Radius (in km)
-    int numRays = radarData->getNumRays();
-    int numVGates;
-    Ray* currentRay;
+    const float* sweepHeights = aveVADHeight[sweepIndex];
 
-    for(int i = 0; i < numRays; i++)
+    const QVector<int>& rays = sweepRays.at(sweepIndex);
+    for(int r = 0; r < rays.size(); r++)
     {
-        currentRay = radarData->getRay(i);
-	
-	if (currentRay->getSweepIndex() == -999)
-	  continue;
-
-	
-        numVGates = currentRay->getVel_numgates();
+        Ray* currentRay = radarData->getRay(rays[r]);
+        int numVGates = currentRay->getVel_numgates();
         float *vGates = currentRay->getVelData();
-        float *rGates = currentRay->getRefData();
 
 	// Some rays might not have VEL data
 	if ( vGates == NULL )
@@ -563,6 +581,13 @@ bool RadarQC::terminalVelocity()
 
         if((currentRay->getRef_gatesp()!=0)&&(currentRay->getVel_gatesp()!=0)&&(currentRay->getRef_numgates()!=0))
         {
+            const float *rGates = currentRay->getRefData();
+            const float elevAngle = currentRay->getElevation();
+            const int firstVelGate = currentRay->getFirst_vel_gate();
+            const float velGateSp = currentRay->getVel_gatesp();
+            const int firstRefGate = currentRay->getFirst_ref_gate();
+            const float refGateSp = currentRay->getRef_gatesp();
+            const int refNumGates = currentRay->getRef_numgates();
             for(int j = 0; j < numVGates; j++)
             {
                 if(vGates[j]!=velNull)
@@ -570,57 +595,35 @@ bool RadarQC::terminalVelocity()
                     // PH 10/2007.  need accurate range - previously missing first gate distance
                     // which  has usually been -0.375 m (due to radar T/R time delay) but is now
                     // 0.125 m for VCP 211.
-                    //		  float range = j*currentRay->getVel_gatesp()/1000.0;
-                    float range = float(currentRay->getFirst_vel_gate()+(j*currentRay->getVel_gatesp()))/1000.;
+                    float range = float(firstVelGate+(j*velGateSp))/1000.;
                     if (range<0.) range=0.;
-                    float elevAngle = currentRay->getElevation();
 
-		    int sweepIndex = currentRay->getSweepIndex();
-		    if (sweepIndex < 0)
-		      continue;
-
-                    float height = aveVADHeight[sweepIndex][j];
+                    float height = sweepHeights[j];
                     // height is in km from sea level here
 
                     float rho = 1.1904*exp(-1*height/9.58);
                     float theta = elevAngle*deg2rad+asin(range*cos(deg2rad*elevAngle)/(ae+height-radarHeight));
                     int zgate = 0;
-                    /* I think this next step makes assumptions about
-           * the reflectivity of the gate spacing
-           */
 
-                    // PH 10/2007.  Previous logic not accurate enough.
-                    // The objective is to use the Z datum that is within +- 0.5 km of the
+                    // PH 10/2007.  The objective is to use the Z datum that is within +- 0.5 km of the
                     // current radial velocity datum's range - previous accuracy was only 1 km.
-                    //                 int zgate = int(floor(range/rgatesp)+1);
-
-                    // Paul Harasti 3/2009: Add logic for Super Resolution Z gate spacing
-                    //					float rgatesp = currentRay->getRef_gatesp()/1000.0;
-                    //                  int zgate = int(floor(0.5+range/rgatesp));
+                    // Paul Harasti 3/2009: Add logic for Super Resolution Z gate spacing.
                     // Ref_gatesp = 1 km at all times when not super resolution
                     // and division by rgatesp does not work for super resolution case
                     // since range is offset by first gate distance rendering range
                     // unevenly divisible by rgatesp.
 
-                    if(currentRay->getRef_gatesp()!=currentRay->getVel_gatesp()) {
-						zgate = (int)(floor(0.5+(range*1000.0 - currentRay->getFirst_ref_gate())/currentRay->getRef_gatesp()));
-                        /*zgate = int(floor(0.5+(currentRay->getFirst_vel_gate()-currentRay->getFirst_ref_gate())+
-                                          +j*currentRay->getRef_gatesp()/currentRay->getVel_gatesp())); */
-                        //if(zgate<1) zgate = 1;
-                        // Why don't we use the first gate? -LM
-                        // PH 10/2007.  Because it is at range = 0 km for current 88D VCPs.
+                    if(refGateSp!=velGateSp) {
+                        zgate = (int)(floor(0.5+(range*1000.0 - firstRefGate)/refGateSp));
                     }
                     else {
                         // Ref_gatesp = Vel_gatesp at all times when  super resolution
                         zgate = j;
                     }
-                    if(zgate >= currentRay->getRef_numgates())
-                        zgate = currentRay->getRef_numgates()-1;
-					if (zgate < 1) zgate = 1;
+                    if(zgate >= refNumGates)
+                        zgate = refNumGates-1;
+                    if (zgate < 1) zgate = 1;
                     float zData = rGates[zgate];
-                    //                  int zwhere=currentRay->getSweepIndex();
-                    //                  if ((zwhere < 22)&&(zData > 0.)&&(zData < 100.))
-                    //  Message::toScreen("SweepNo = "+QString().setNum(zwhere));
                     float terminalV = 0;
                     zData = pow(10.0,(zData/10.0));
                     // New logic from Marks and Houze (1987)
@@ -649,11 +652,6 @@ bool RadarQC::terminalVelocity()
                     if(!std::isnan(terminalV)) {
                         vGates[j] -= terminalV;
                     }
-                    else {
-                        QString trap = "Ray = "+QString().setNum(i)+" j = "+QString().setNum(j)+" terminal vel "+QString().setNum(terminalV)+" ISNAN";
-                        //Message::toScreen(trap);
-                        //emit log(Message(trap));
-                    }
                 }
             }
         }
@@ -662,22 +660,17 @@ bool RadarQC::terminalVelocity()
                 vGates[j] = velNull;
             }
         }
-        vGates = NULL;
-        rGates = NULL;
     }
-    currentRay = NULL;
-    return true;
 }
 
-
-float RadarQC::findHeight(Ray *currentRay, int gateIndex)
+float RadarQC::findHeight(const BeamGeometry::Gates* geometry, int gateIndex)
 {
 
     /*
    *  The method calculates the height of gate in a ray,
    *  relative to the absolute height of the radar in km.
    */
-    if(currentRay->getVel_gatesp()==0){
+    if(geometry->gateSpacing==0){
         Message::toScreen("Find height of ray w/o gate data");
         return -999;
     }
@@ -685,13 +678,12 @@ float RadarQC::findHeight(Ray *currentRay, int gateIndex)
     // PH 10/2007.  need accurate range - previously missing first gate distance
     // which  has usually been -0.375 m (due to radar T/R time delay) but is now
     // 0.125 m for VCP 211.
-
-    float range = float(currentRay->getFirst_vel_gate()+(gateIndex*currentRay->getVel_gatesp()))/1000.;
-    if (range<0.) range=0.;
-    //  float range = gateIndex*currentRay->getVel_gatesp()/1000.0;
-    float elevAngle = currentRay->getElevation();
+    // The beam height at zero range is zero, so gates before the radar are
+    // at the height of the radar.
+    if (geometry->range[gateIndex] < 0.)
+        return radarHeight;
     // This height is in km from sea level
-    float height = radarData->absoluteRadarBeamHeight(range, elevAngle);
+    float height = geometry->height[gateIndex] + radarHeight;
     return height;
 
 }
@@ -1620,17 +1612,73 @@ float RadarQC::getStart(Ray *currentRay)
     return startVelocity;
 }
 
+// The velocity a gate would have with n folds removed
+
+static inline float foldedVelocity(const float& velocity, const int& n, const float& nyquist)
+{
+    return velocity+(2.0*n*nyquist);
+}
+
+bool RadarQC::unfold(const float& velocity, const float& reference,
+                     const float& nyquist, int& n) const
+{
+    /*
+   *  Finds the number of folds that brings velocity within one Nyquist
+   *  velocity of the reference. This is the fold the old search stepping
+   *  out one fold at a time from zero settled on, computed directly: the
+   *  first fold, going toward the reference, that is no longer on the far
+   *  side of it. Fails if that takes maxFold or more folds.
+   */
+
+    const float upper = reference+nyquist;
+    const float lower = reference-nyquist;
+    float tryVelocity = foldedVelocity(velocity, 0, nyquist);
+    n = 0;
+    if((upper >= tryVelocity)&&(tryVelocity >= lower))
+        return true;
+
+    if(tryVelocity > upper) {
+        // The largest fold below zero that is not above the window
+        n = (int)floor((upper - velocity)/(2.0*nyquist));
+        if(n > -1) n = -1;
+        while((n < -1)&&(foldedVelocity(velocity, n+1, nyquist) <= upper))
+            n++;
+        while((n > -maxFold)&&(foldedVelocity(velocity, n, nyquist) > upper))
+            n--;
+    }
+    else if(tryVelocity < lower) {
+        // The smallest fold above zero that is not below the window
+        n = (int)ceil((lower - velocity)/(2.0*nyquist));
+        if(n < 1) n = 1;
+        while((n > 1)&&(foldedVelocity(velocity, n-1, nyquist) >= lower))
+            n--;
+        while((n < maxFold)&&(foldedVelocity(velocity, n, nyquist) < lower))
+            n++;
+    }
+    else {
+        // Not a number
+        return false;
+    }
+    return (abs(n) < maxFold);
+}
+
 bool RadarQC::BB()
 {
-    //emit log(Message("In BB"));
-    Ray* currentRay = NULL;
-    float numRays = radarData->getNumRays();
-    for(int i = 0; i < numRays; i++)
+    // Rays only depend on the environmental wind, so sweeps run in parallel
+    runSweepPass(&RadarQC::bbSweep);
+    return true;
+}
+
+void RadarQC::bbSweep(const int& sweepIndex)
+{
+    const QVector<int>& rays = sweepRays.at(sweepIndex);
+    float segVelocity[numVGatesAveraged];
+    float sortVelocity[numVGatesAveraged];
+    const int mIndex = float(numVGatesAveraged)/2;
+
+    for(int r = 0; r < rays.size(); r++)
     {
-        currentRay = radarData->getRay(i);
-	if (currentRay->getSweepIndex() == -999)
-	  continue;
-	
+        Ray* currentRay = radarData->getRay(rays[r]);
         float *vGates = currentRay->getVelData();
 
 	// Some rays might not have VEL data
@@ -1643,228 +1691,150 @@ bool RadarQC::BB()
         int numVelocityGates = currentRay->getVel_numgates();
         if((numVelocityGates!=0)&&(startVelocity!=velNull))
         {
-            float sum = float(numVGatesAveraged)*startVelocity;
-	    float median, mean;
-	    mean = median = startVelocity;
-	    // float nyquistSum = float(numVGatesAveraged)*nyquistVelocity;
-            int n = 0;
-            int overMaxFold = 0;
-            bool dealiased;
-            float segVelocity[numVGatesAveraged];
+            float median = startVelocity;
             for(int k = 0; k < numVGatesAveraged; k++)
             {
                 segVelocity[k] = startVelocity;
             }
             for(int j = 0; j < numVelocityGates; j++)
             {
-                //Message::toScreen("Gate "+QString().setNum(j));
                 if(vGates[j]!=velNull)
                 {
-                    //Message::toScreen("has data");
-                    n = 0;
-                    dealiased = false;
-                    while(dealiased!=true)
-                    {
-                        float tryVelocity = vGates[j]+(2.0*n*nyquistVelocity);
-                        if((median+nyquistVelocity >= tryVelocity)&&
-                                (tryVelocity >= median-nyquistVelocity))
-                        {
-                            dealiased=true;
-                        }
-                        else
-                        {
-                            if(tryVelocity > median+nyquistVelocity){
-                                n--;
-                                //Message::toScreen("n--");
-                            }
-                            if(tryVelocity < median-nyquistVelocity){
-                                n++;
-                                //Message::toScreen("n++");
-                            }
-                            if(abs(n) >= maxFold) {
-                                //emit log(Message(QString("Ray #")+QString().setNum(i)+QString(" Gate# ")+QString().setNum(j)+QString(" exceeded maxfolds")));
-                                overMaxFold++;
-                                dealiased=true;
-                                vGates[j]=velNull;
-                            }
-                        }
-                        //Message::toScreen("Ray = "+QString().setNum(i)+" j = "+QString().setNum(j)+" with "+QString().setNum(n)+" folds");
+                    int n;
+                    if(!unfold(vGates[j], median, nyquistVelocity, n)) {
+                        vGates[j]=velNull;
+                        continue;
                     }
-                    if(vGates[j]!=velNull)
+                    vGates[j]+= 2.0*n*(nyquistVelocity);
+
+                    // The median is taken over the older part of the
+                    // window and the new gate
+                    for(int m = 0; m < numVGatesAveraged-1; m++)
                     {
-                        vGates[j]+= 2.0*n*(nyquistVelocity);
-                        sum -= segVelocity[0];
-                        sum += vGates[j];
-						mean = sum / numVGatesAveraged;
-						float threshold_mean = 0.0;
-						int meancount = 0;
-						QList<float> sortVelocity;
-                        for(int m = 0; m < numVGatesAveraged-1; m++)
-                        {
-							sortVelocity << segVelocity[m];
-                            segVelocity[m] = segVelocity[m+1];
-							if (fabs(segVelocity[m] - mean) < nyquistVelocity)
-							{
-								threshold_mean += segVelocity[m];
-								meancount++;
-							}							
-                        }
-						sortVelocity << vGates[j];
-						segVelocity[numVGatesAveraged-1] = vGates[j];
-						threshold_mean += vGates[j];
-						meancount++;
-						//if (meancount < numVGatesAveraged) Message::toScreen(QString("Threshold reduced to ") + QString().setNum(meancount));
-						qSort(sortVelocity);
-						int mIndex = float(numVGatesAveraged)/2;
-						median = (sortVelocity.at(mIndex));// + (threshold_mean / (float)meancount)) / 2;
+                        sortVelocity[m] = segVelocity[m];
+                        segVelocity[m] = segVelocity[m+1];
                     }
+                    sortVelocity[numVGatesAveraged-1] = vGates[j];
+                    segVelocity[numVGatesAveraged-1] = vGates[j];
+                    std::nth_element(sortVelocity, sortVelocity + mIndex,
+                                     sortVelocity + numVGatesAveraged);
+                    median = sortVelocity[mIndex];
                 }
             }
         }
-        vGates = NULL;
-        currentRay = NULL;
     }
-	
-    //Message::toScreen("Getting out of dealias");
-    return true;
 }
 
 bool RadarQC::derivativeDealias()
 {
-	
-	// Minimize 2nd derivative in azimuth after BB routine
-	for (int n = 0; n < radarData->getNumSweeps(); n++) {
-        Sweep* currentSweep = radarData->getSweep(n);
-		int rays = currentSweep->getNumRays();
-		int gates = currentSweep->getVel_numgates();
-        if (gates == 0) continue;
-
-		float nyquistVelocity = currentSweep->getNyquist_vel();
-		// Allocate memory for the gradient fields
-		float** a1 = new float*[rays];
-		float** veldata = new float*[rays];
-		for (int i=0; i < rays; i++) {
-			a1[i] = new float[gates];
-			veldata[i] = new float[gates];
-            for (int j=0; j < gates; j++) {
-                a1[i][j] = veldata[i][j] = velNull;
-            }
+	// Minimize 2nd derivative in azimuth after BB routine. Each sweep
+	// only touches its own rays.
+	runSweepPass(&RadarQC::derivativeDealiasSweep);
+	return true;
+}
+
+void RadarQC::derivativeDealiasSweep(const int& n)
+{
+	Sweep* currentSweep = radarData->getSweep(n);
+	const int rays = currentSweep->getNumRays();
+	const int gates = currentSweep->getVel_numgates();
+	if ((gates <= 0) || (rays <= 0)) return;
+	const int firstRay = currentSweep->getFirstRay();
+
+	float nyquistVelocity = currentSweep->getNyquist_vel();
+
+	// Gate major copies of the sweep, so each gate's ring of rays is
+	// contiguous: veldata[j * rays + i] is gate j of ray i
+	QVector<float> veldataStore(rays * gates, velNull);
+	QVector<float> a1Store(rays * gates, velNull);
+	float* veldata = veldataStore.data();
+	float* a1 = a1Store.data();
+	for (int i=0; i < rays; i++) {
+		Ray* currentRay = radarData->getRay(firstRay + i);
+		const float* raydata = currentRay->getVelData();
+		if (raydata == NULL) continue;
+		const int rayGates = qMin(gates, currentRay->getVel_numgates());
+		for (int j=0; j < rayGates; j++)
+			veldata[j * rays + i] = raydata[j];
+	}
+
+	// Find the gradient
+	const double gradWeights[5] = { 1./12., -2./3., 0, 2./3., -1./12. };
+	for (int j=0; j < gates; j++) {
+		const float* vel = veldata + j * rays;
+		float* grad = a1 + j * rays;
+		for (int i=0; i < rays; i++)  {
+			float sum = 0;
+			for (int m = i-2; m < i+3; m++) {
+				int ri = (m >= rays) ? (m-rays) : m;
+				ri = (ri < 0) ? (ri+rays) : ri;
+				if (vel[ri] != velNull) {
+					sum += gradWeights[m-i+2]*vel[ri];
+				} else {
+					sum = velNull;
+					break;
+				}
+			}
+			if (sum != velNull)
+				grad[i] = fabs(sum);
 		}
-		
-		// Find the gradient
-		float sum;
-		int ray_index;
+	}
+
+	const double weights[3] = {1.0, -2.0, 1.0};
+	for (int j=0; j < gates; j++) {
+		float* vel = veldata + j * rays;
+		const float* grad = a1 + j * rays;
+		float mingrad = 1e34;
+		int startindex = 0;
 		for (int i=0; i < rays; i++)  {
-			for (int j=0; j < gates; j++) {
-				sum = 0.0;
-				double weights[5] = { 1./12., -2./3., 0, 2./3., -1./12. }; 
-				//double weights[2] = {-1.0, 1.0};
-				sum = 0;
-				for (int m = i-2; m < i+3; m++) {
-					//for (int m = i; m < i+2; m++) {
-					ray_index = m + currentSweep->getFirstRay();
-					if (ray_index < currentSweep->getFirstRay()) ray_index += rays;
-					if (ray_index > currentSweep->getLastRay()) ray_index -= rays;
-					Ray* currentRay = radarData->getRay(ray_index);
-					float* raydata = currentRay->getVelData();
-					int ri = (m >= rays) ? (m-rays) : m;
-					ri = (ri < 0) ? (ri+rays) : ri;
-					if ((raydata != NULL) and (j < currentRay->getVel_numgates())) {
-					   veldata[ri][j] = raydata[j];
-				    }
-					if (veldata[ri][j] != velNull) {
-						sum += weights[m-i+2]*veldata[ri][j];
-						//sum += weights[m-i]*veldata[i][j];
+			if ((grad[i] != velNull) and (grad[i] < mingrad)) {
+				mingrad = grad[i];
+				startindex = i;
+			}
+		}
+		// Use a much smaller azimuthal average because of radial shear across eyewall
+		float startVelocity = vel[startindex];
+		if(startVelocity==velNull)
+			continue;
+		for (int ri=startindex; ri < rays+startindex; ri++)
+		{
+			int i = (ri >= rays) ? (ri-rays) : ri;
+			if(vel[i]==velNull)
+				continue;
+
+			// Pick the fold of this gate, -1, 0 or +1, that gives the
+			// smallest second derivative with its neighbours
+			int minfold = 0;
+			mingrad = 1e34;
+			for (int fold = -1; fold < 2; fold++)
+			{
+				float sum = 0;
+				for (int m = i-1; m < i+2; m++) {
+					int mi = (m >= rays) ? (m-rays) : m;
+					mi = (mi < 0) ? (mi+rays) : mi;
+					if (vel[mi] != velNull) {
+						float tryVelocity = vel[mi];
+						if (mi == i) tryVelocity += (2.0*fold*nyquistVelocity);
+						sum += weights[m-i+1]*tryVelocity;
 					} else {
 						sum = velNull;
 						break;
 					}
 				}
-				if (sum != velNull) 
-					a1[i][j] = fabs(sum);
-			}
-		}
-		for (int j=0; j < gates; j++) {
-			float mingrad = 1e34;
-			int startindex = 0;
-			for (int i=0; i < rays; i++)  {
-				if ((a1[i][j] != velNull) and (a1[i][j] < mingrad)) {
-					mingrad = a1[i][j];
-					startindex = i;
+				if ((sum != velNull) and (fabs(sum) < mingrad)) {
+					mingrad = sum;
+					minfold = fold;
 				}
 			}
-			// Use a much smaller azimuthal average because of radial shear across eyewall
-			int azavg = 1; //numVGatesAveraged / 6;
-			float startVelocity = veldata[startindex][j];
-			if(startVelocity!=velNull)
-			{
-				float sum = float(azavg)*startVelocity;
-				float median, mean;
-				mean = median = startVelocity;
-				float segVelocity[azavg];
-				for(int k = 0; k < azavg; k++)
-				{
-					segVelocity[k] = startVelocity;
-				}
-				for (int ri=startindex; ri < rays+startindex; ri++)
-				{
-					
-					int i = (ri >= rays) ? (ri-rays) : ri;
-					
-					//Message::toScreen("Gate "+QString().setNum(j));
-					if(veldata[i][j]!=velNull)
-					{
-						int minfold = 0;
-						mingrad = 1e34;
-						for (int fold = -1; fold < 2; fold++)
-						{
-							//double weights[5] = { -1./12., 4./3., -5./2., 4./3., -1./12. }; 
-							double weights[3] = {1.0, -2.0, 1.0};
-							sum = 0;
-							//for (int m = i-2; m < i+3; m++) {
-							for (int m = i-1; m < i+2; m++) {
-								int ri = (m >= rays) ? (m-rays) : m;
-								ri = (ri < 0) ? (ri+rays) : ri;
-								if (veldata[ri][j] != velNull) {
-									float tryVelocity = veldata[ri][j];
-									if (ri == i) tryVelocity += (2.0*fold*nyquistVelocity);
-									sum += weights[m-i+1]*tryVelocity;
-									//sum += weights[m-i]*veldata[i][j];
-								} else {
-									sum = velNull;
-									break;
-								}
-							}
-							if ((sum != velNull) and (fabs(sum) < mingrad)) {
-								mingrad = sum;
-								minfold = fold;
-							}
-						}
-						if(veldata[i][j]!=velNull)
-						{
-							veldata[i][j]+= 2.0*minfold*(nyquistVelocity);
-							ray_index = i + currentSweep->getFirstRay();
-							Ray* currentRay = radarData->getRay(ray_index);
-							float* raydata = currentRay->getVelData();
-							if ((raydata != NULL) and (j < currentRay->getVel_numgates())) {
-							   raydata[j] = veldata[i][j];
-						    }
-						}
-					}
-				}
-			}			
-		}
-		for (int i=0; i < rays; i++)  {
-			delete[] veldata[i];
-			delete[] a1[i];
+			vel[i]+= 2.0*minfold*(nyquistVelocity);
+			Ray* currentRay = radarData->getRay(firstRay + i);
+			float* raydata = currentRay->getVelData();
+			if ((raydata != NULL) and (j < currentRay->getVel_numgates())) {
+				raydata[j] = vel[i];
+			}
 		}
-		delete[] veldata;
-		delete[] a1;
-		
 	}
-    //Message::toScreen("Getting out of dealias");
-    return true;
-}	
+}
 
 bool RadarQC::multiprfDealias()
 {
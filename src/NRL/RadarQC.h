@@ -16,6 +16,7 @@
 #include <QWidget>
 #include <QDomElement>
 #include <QObject>
+#include <QVector>
 #include "Math/Matrix.h"
 
 class RadarQC : public QObject
@@ -39,6 +40,14 @@ public:
    * various methods to find environmental wind, and BB dealiasing
    */
 
+#ifdef VORTRAC_KERNEL_CHECK
+    bool dealiasReference();
+    /* The same stages as dealias, as they ran before they were split into
+   * sweep passes, one ray at a time on the calling thread. Only built
+   * with CONFIG+=kernelcheck, to check the sweep passes (vortrac -k qc).
+   */
+#endif
+
     void debugDump(RadarData *radarPtr, int sweepNum);
     void dumpRay(RadarData *radarPtr, int rayNum);
     
@@ -135,6 +144,26 @@ private:
     float radarHeight;       // Absolute height of radar in km from sea leve
 
 
+    QVector<QVector<int> > sweepRays;
+    void groupRaysBySweep();
+    /*
+   * sweepRays[n] lists the rays whose sweep index is n. The stages below
+   *   work on one sweep at a time and run the sweeps on the thread pool.
+   *
+   */
+
+    class SweepPass {
+    public:
+        typedef void (RadarQC::*Pass)(const int& sweep);
+        SweepPass(RadarQC* qc, Pass pass) : qc(qc), pass(pass) {}
+        typedef void result_type;
+        void operator()(const int& sweep) const { (qc->*pass)(sweep); }
+    private:
+        RadarQC* qc;
+        Pass pass;
+    };
+    void runSweepPass(SweepPass::Pass pass);
+
     void thresholdData();
     /*
    * Primary Quality Control Method
@@ -143,6 +172,8 @@ private:
    *
    */
 
+    void thresholdSweep(const int& sweepIndex);
+
     bool terminalVelocity();
     /*
    * Uses reflectivity data to approximate the terminal velocity component
@@ -151,6 +182,8 @@ private:
    *
    */
 
+    void terminalVelocitySweep(const int& sweepIndex);
+
     bool findEnvironmentalWind();
     /*
    * Provides environmental wind according to user specified methods
@@ -188,6 +221,9 @@ private:
    */
 
     bool BB();
+    void bbSweep(const int& sweepIndex);
+    bool unfold(const float& velocity, const float& reference,
+                const float& nyquist, int& n) const;
     /*
    * This method is modeled after velocity dealiasing algorithm B,
    *   published by Bargain and Brown (1980).
@@ -195,13 +231,22 @@ private:
    */
 
 	bool derivativeDealias();
+	void derivativeDealiasSweep(const int& sweepIndex);
 	/* This method tries to minimize 2nd derivatives in the radial velocity
 	 by through velocity unfolding */
 	
+#ifdef VORTRAC_KERNEL_CHECK
+	void thresholdDataReference();
+	bool terminalVelocityReference();
+	bool BBReference();
+	bool derivativeDealiasReference();
+	/* The serial stages behind dealiasReference, in RadarQCReference.cpp */
+#endif
+
 	bool multiprfDealias();
 	/* This method compares rays at different Nyquist velocities for dealiasing */
 	
-    float findHeight(Ray* currentRay, int gateIndex);
+    float findHeight(const BeamGeometry::Gates* geometry, int gateIndex);
     /*
    * Uses the 4/3 earth radius model to return the height of a specific gate
    *   in km, relative to sea level.
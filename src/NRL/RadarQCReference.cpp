@@ -0,0 +1,527 @@
+/*
+ *  RadarQCReference.cpp
+ *  VORTRAC
+ *
+ *  Copyright 2026 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include <stdlib.h>
+#include <cmath>
+#include <QString>
+#include <QList>
+#include <QtAlgorithms>
+
+#include "RadarQC.h"
+#include "RadarData.h"
+#include "Message.h"
+
+// The quality control stages as they ran before they were split into
+// sweep passes: one ray after another on the calling thread. They are
+// copied unchanged, to check the sweep passes against (vortrac -k qc),
+// and only built with CONFIG+=kernelcheck. Like the original, BBReference
+// never finishes on a NaN velocity, so the check refuses such volumes.
+
+bool RadarQC::dealiasReference()
+{
+    thresholdDataReference();
+    emit log(Message(QString(),1,this->objectName()));
+
+    if(!terminalVelocityReference())
+        return false;
+    emit log(Message(QString(),1,this->objectName()));
+
+    if(!findEnvironmentalWind()) {
+        Message::toScreen("Failed finding environmental wind");
+    }
+    emit log(Message(QString(),1,this->objectName()));
+
+    if(!BBReference()) {
+        Message::toScreen("Failed in Bargen-Brown dealising");
+        return false;
+    }
+
+    if(!derivativeDealiasReference())
+        return false;
+
+    return true;
+}
+
+void RadarQC::thresholdDataReference()
+{
+    /*
+   *  This method iterates through each Ray of the RadarData volume,
+   *  and removes velocity data that exceeds spectral width, reflectivity
+   *  and velocity thresholds. This improves data quality in order to
+   *  improve the preformance of the following quality control routines.
+   *  This method also calculates the number of valid gates, which is used
+   *  in the VAD and GVAD methods.
+   */
+
+    int numSweeps = radarData->getNumSweeps();
+    for (int i = 0; i < numSweeps; i++) {
+        Sweep *currentSweep = radarData->getSweep(i);
+        int numBins = currentSweep->getVel_numgates();
+        for (int j=0; j < numBins; j++)
+            validBinCount[i][j]=0.;
+    }
+
+    int numRays = radarData->getNumRays();
+    Ray* currentRay;
+    int numVGates = 0;
+
+    for(int i = 0; i < numRays; i++)
+    {
+        if(i == (int) numRays/2.0)
+            emit log(Message(QString(),1,this->objectName()));
+        currentRay = radarData->getRay(i);
+	if (currentRay == NULL) {
+	  std::cout << "No ray at index " << i << std::endl;
+	  continue;
+	}
+        int sweepIndex = currentRay->getSweepIndex();
+	if (sweepIndex < 0)
+	  continue;
+	
+        Sweep *currentSweep = radarData->getSweep(sweepIndex);
+	if(currentSweep == NULL)
+	  continue;
+
+        int numSweepGates = currentSweep->getVel_numgates();
+	int numRayGates = currentRay->getVel_numgates();
+	if (numRayGates < numSweepGates) {
+	  numVGates = numRayGates;
+	} else {
+	  numVGates = numSweepGates;
+	}
+        //      float velGateSp = currentRay->getVel_gatesp();
+        //      float refGateSp = currentRay->getRef_gatesp();
+        float *vGates = currentRay->getVelData();
+        float *swGates = currentRay->getSwData();
+	// float *refGates = currentRay->getRefData();
+        if (swGates != NULL) {
+            for (int j = 0; j < numVGates; j++)
+            {
+                //         if(j<20) {
+                //         vGates[j]=velNull;
+                //       }
+                //	  int jref = int((float)j * velGateSp / refGateSp);
+                //	  if(jref >= currentRay->getRef_numgates())
+                //	    jref = int(velNull);
+                if((swGates[j] > specWidthLimit)||
+                   (fabs(vGates[j]) < velMin) ||
+                   (fabs(vGates[j]) > velMax))
+                    //||(jref==velNull)||(refGates[jref] < refMin)
+                    //  ||(refGates[jref] > refMax))
+                {
+                    // This was extended to threshold against min and max
+                    // reflectivity as well but we are not currently using
+                    // these thresholds - LM
+                    vGates[j] = velNull;
+                }
+                
+                if(vGates[j]!=velNull) {
+                    validBinCount[sweepIndex][j]++;
+                }
+            }
+        } else {
+            // No spectrum width data, so just go with it for now
+	  if(vGates != NULL)
+            for (int j = 0; j < numVGates; j++) {
+                if(vGates[j]!=velNull) {
+                    validBinCount[sweepIndex][j]++;
+                }
+            }
+        }
+        vGates = NULL;
+        swGates = NULL;
+        // refGates = NULL;
+    }
+    currentRay = NULL;
+    delete currentRay;
+}
+
+
+bool RadarQC::terminalVelocityReference()
+{
+
+    /*
+   *  This algorithm is used to remove the terminal velocity component
+   *  from each valid doppler velocity reading in the radar volume.
+   */
+
+    float ae = 6371.*4./3.; // Adjustment factor for 4/3 Earth Radius (in km)
+    int numRays = radarData->getNumRays();
+    int numVGates;
+    Ray* currentRay;
+
+    for(int i = 0; i < numRays; i++)
+    {
+        currentRay = radarData->getRay(i);
+	
+	if (currentRay->getSweepIndex() == -999)
+	  continue;
+
+	
+        numVGates = currentRay->getVel_numgates();
+        float *vGates = currentRay->getVelData();
+        float *rGates = currentRay->getRefData();
+
+	// Some rays might not have VEL data
+	if ( vGates == NULL )
+	  continue;
+
+        if((currentRay->getRef_gatesp()!=0)&&(currentRay->getVel_gatesp()!=0)&&(currentRay->getRef_numgates()!=0))
+        {
+            for(int j = 0; j < numVGates; j++)
+            {
+                if(vGates[j]!=velNull)
+                {
+                    // PH 10/2007.  need accurate range - previously missing first gate distance
+                    // which  has usually been -0.375 m (due to radar T/R time delay) but is now
+                    // 0.125 m for VCP 211.
+                    //		  float range = j*currentRay->getVel_gatesp()/1000.0;
+                    float range = float(currentRay->getFirst_vel_gate()+(j*currentRay->getVel_gatesp()))/1000.;
+                    if (range<0.) range=0.;
+                    float elevAngle = currentRay->getElevation();
+
+		    int sweepIndex = currentRay->getSweepIndex();
+		    if (sweepIndex < 0)
+		      continue;
+
+                    float height = aveVADHeight[sweepIndex][j];
+                    // height is in km from sea level here
+
+                    float rho = 1.1904*exp(-1*height/9.58);
+                    float theta = elevAngle*deg2rad+asin(range*cos(deg2rad*elevAngle)/(ae+height-radarHeight));
+                    int zgate = 0;
+                    /* I think this next step makes assumptions about
+           * the reflectivity of the gate spacing
+           */
+
+                    // PH 10/2007.  Previous logic not accurate enough.
+                    // The objective is to use the Z datum that is within +- 0.5 km of the
+                    // current radial velocity datum's range - previous accuracy was only 1 km.
+                    //                 int zgate = int(floor(range/rgatesp)+1);
+
+                    // Paul Harasti 3/2009: Add logic for Super Resolution Z gate spacing
+                    //					float rgatesp = currentRay->getRef_gatesp()/1000.0;
+                    //                  int zgate = int(floor(0.5+range/rgatesp));
+                    // Ref_gatesp = 1 km at all times when not super resolution
+                    // and division by rgatesp does not work for super resolution case
+                    // since range is offset by first gate distance rendering range
+                    // unevenly divisible by rgatesp.
+
+                    if(currentRay->getRef_gatesp()!=currentRay->getVel_gatesp()) {
+						zgate = (int)(floor(0.5+(range*1000.0 - currentRay->getFirst_ref_gate())/currentRay->getRef_gatesp()));
+                        /*zgate = int(floor(0.5+(currentRay->getFirst_vel_gate()-currentRay->getFirst_ref_gate())+
+                                          +j*currentRay->getRef_gatesp()/currentRay->getVel_gatesp())); */
+                        //if(zgate<1) zgate = 1;
+                        // Why don't we use the first gate? -LM
+                        // PH 10/2007.  Because it is at range = 0 km for current 88D VCPs.
+                    }
+                    else {
+                        // Ref_gatesp = Vel_gatesp at all times when  super resolution
+                        zgate = j;
+                    }
+                    if(zgate >= currentRay->getRef_numgates())
+                        zgate = currentRay->getRef_numgates()-1;
+					if (zgate < 1) zgate = 1;
+                    float zData = rGates[zgate];
+                    //                  int zwhere=currentRay->getSweepIndex();
+                    //                  if ((zwhere < 22)&&(zData > 0.)&&(zData < 100.))
+                    //  Message::toScreen("SweepNo = "+QString().setNum(zwhere));
+                    float terminalV = 0;
+                    zData = pow(10.0,(zData/10.0));
+                    // New logic from Marks and Houze (1987)
+                    if(height  < 5.1){
+                        terminalV = -2.6*sin(theta)*(pow(zData,0.107))*(pow((1.1904/rho),0.45));
+                    }
+                    else {
+                        if(height > 7.5) {
+                            terminalV = (-0.817*sin(theta)*pow(zData,0.063)*pow((1.1904/rho),0.45));
+                        }
+                        else {
+                            float a,b,c,den, v1, v2;
+                            c = height;
+                            den = 7.5-5.1;
+                            a = (7.5-c)/den;
+                            b = (c - 5.1)/den;
+                            rho = 1.1904*exp(-1*5.1/9.58);
+                            theta = deg2rad*elevAngle+asin(range*cos(deg2rad*elevAngle)/(ae+5.1-radarHeight));
+                            v1 = (-2.6*sin(theta)*pow(zData, 0.107)*pow((1.1904/rho),0.45));
+                            rho = 1.1904*exp(-1*7.5/9.58);
+                            theta = deg2rad*elevAngle+asin(range*cos(deg2rad*elevAngle)/(ae+7.5-radarHeight));
+                            v2 = (-0.817*sin(theta)*pow(zData, 0.063)*pow((1.1904/rho),0.45));
+                            terminalV = a*v1+b*v2;
+                        }
+                    }
+                    if(!std::isnan(terminalV)) {
+                        vGates[j] -= terminalV;
+                    }
+                    else {
+                        QString trap = "Ray = "+QString().setNum(i)+" j = "+QString().setNum(j)+" terminal vel "+QString().setNum(terminalV)+" ISNAN";
+                        //Message::toScreen(trap);
+                        //emit log(Message(trap));
+                    }
+                }
+            }
+        }
+        else {
+            for(int j = 0; j < numVGates; j++) {
+                vGates[j] = velNull;
+            }
+        }
+        vGates = NULL;
+        rGates = NULL;
+    }
+    currentRay = NULL;
+    return true;
+}
+
+bool RadarQC::BBReference()
+{
+    //emit log(Message("In BB"));
+    Ray* currentRay = NULL;
+    float numRays = radarData->getNumRays();
+    for(int i = 0; i < numRays; i++)
+    {
+        currentRay = radarData->getRay(i);
+	if (currentRay->getSweepIndex() == -999)
+	  continue;
+	
+        float *vGates = currentRay->getVelData();
+
+	// Some rays might not have VEL data
+	
+	if(vGates == NULL)
+	  continue;
+	
+        float startVelocity = getStart(currentRay);
+        float nyquistVelocity = currentRay->getNyquist_vel();
+        int numVelocityGates = currentRay->getVel_numgates();
+        if((numVelocityGates!=0)&&(startVelocity!=velNull))
+        {
+            float sum = float(numVGatesAveraged)*startVelocity;
+	    float median, mean;
+	    mean = median = startVelocity;
+	    // float nyquistSum = float(numVGatesAveraged)*nyquistVelocity;
+            int n = 0;
+            int overMaxFold = 0;
+            bool dealiased;
+            float segVelocity[numVGatesAveraged];
+            for(int k = 0; k < numVGatesAveraged; k++)
+            {
+                segVelocity[k] = startVelocity;
+            }
+            for(int j = 0; j < numVelocityGates; j++)
+            {
+                //Message::toScreen("Gate "+QString().setNum(j));
+                if(vGates[j]!=velNull)
+                {
+                    //Message::toScreen("has data");
+                    n = 0;
+                    dealiased = false;
+                    while(dealiased!=true)
+                    {
+                        float tryVelocity = vGates[j]+(2.0*n*nyquistVelocity);
+                        if((median+nyquistVelocity >= tryVelocity)&&
+                                (tryVelocity >= median-nyquistVelocity))
+                        {
+                            dealiased=true;
+                        }
+                        else
+                        {
+                            if(tryVelocity > median+nyquistVelocity){
+                                n--;
+                                //Message::toScreen("n--");
+                            }
+                            if(tryVelocity < median-nyquistVelocity){
+                                n++;
+                                //Message::toScreen("n++");
+                            }
+                            if(abs(n) >= maxFold) {
+                                //emit log(Message(QString("Ray #")+QString().setNum(i)+QString(" Gate# ")+QString().setNum(j)+QString(" exceeded maxfolds")));
+                                overMaxFold++;
+                                dealiased=true;
+                                vGates[j]=velNull;
+                            }
+                        }
+                        //Message::toScreen("Ray = "+QString().setNum(i)+" j = "+QString().setNum(j)+" with "+QString().setNum(n)+" folds");
+                    }
+                    if(vGates[j]!=velNull)
+                    {
+                        vGates[j]+= 2.0*n*(nyquistVelocity);
+                        sum -= segVelocity[0];
+                        sum += vGates[j];
+						mean = sum / numVGatesAveraged;
+						float threshold_mean = 0.0;
+						int meancount = 0;
+						QList<float> sortVelocity;
+                        for(int m = 0; m < numVGatesAveraged-1; m++)
+                        {
+							sortVelocity << segVelocity[m];
+                            segVelocity[m] = segVelocity[m+1];
+							if (fabs(segVelocity[m] - mean) < nyquistVelocity)
+							{
+								threshold_mean += segVelocity[m];
+								meancount++;
+							}							
+                        }
+						sortVelocity << vGates[j];
+						segVelocity[numVGatesAveraged-1] = vGates[j];
+						threshold_mean += vGates[j];
+						meancount++;
+						//if (meancount < numVGatesAveraged) Message::toScreen(QString("Threshold reduced to ") + QString().setNum(meancount));
+						qSort(sortVelocity);
+						int mIndex = float(numVGatesAveraged)/2;
+						median = (sortVelocity.at(mIndex));// + (threshold_mean / (float)meancount)) / 2;
+                    }
+                }
+            }
+        }
+        vGates = NULL;
+        currentRay = NULL;
+    }
+	
+    //Message::toScreen("Getting out of dealias");
+    return true;
+}
+
+bool RadarQC::derivativeDealiasReference()
+{
+	
+	// Minimize 2nd derivative in azimuth after BB routine
+	for (int n = 0; n < radarData->getNumSweeps(); n++) {
+        Sweep* currentSweep = radarData->getSweep(n);
+		int rays = currentSweep->getNumRays();
+		int gates = currentSweep->getVel_numgates();
+        if (gates == 0) continue;
+
+		float nyquistVelocity = currentSweep->getNyquist_vel();
+		// Allocate memory for the gradient fields
+		float** a1 = new float*[rays];
+		float** veldata = new float*[rays];
+		for (int i=0; i < rays; i++) {
+			a1[i] = new float[gates];
+			veldata[i] = new float[gates];
+            for (int j=0; j < gates; j++) {
+                a1[i][j] = veldata[i][j] = velNull;
+            }
+		}
+		
+		// Find the gradient
+		float sum;
+		int ray_index;
+		for (int i=0; i < rays; i++)  {
+			for (int j=0; j < gates; j++) {
+				sum = 0.0;
+				double weights[5] = { 1./12., -2./3., 0, 2./3., -1./12. }; 
+				//double weights[2] = {-1.0, 1.0};
+				sum = 0;
+				for (int m = i-2; m < i+3; m++) {
+					//for (int m = i; m < i+2; m++) {
+					ray_index = m + currentSweep->getFirstRay();
+					if (ray_index < currentSweep->getFirstRay()) ray_index += rays;
+					if (ray_index > currentSweep->getLastRay()) ray_index -= rays;
+					Ray* currentRay = radarData->getRay(ray_index);
+					float* raydata = currentRay->getVelData();
+					int ri = (m >= rays) ? (m-rays) : m;
+					ri = (ri < 0) ? (ri+rays) : ri;
+					if ((raydata != NULL) and (j < currentRay->getVel_numgates())) {
+					   veldata[ri][j] = raydata[j];
+				    }
+					if (veldata[ri][j] != velNull) {
+						sum += weights[m-i+2]*veldata[ri][j];
+						//sum += weights[m-i]*veldata[i][j];
+					} else {
+						sum = velNull;
+						break;
+					}
+				}
+				if (sum != velNull) 
+					a1[i][j] = fabs(sum);
+			}
+		}
+		for (int j=0; j < gates; j++) {
+			float mingrad = 1e34;
+			int startindex = 0;
+			for (int i=0; i < rays; i++)  {
+				if ((a1[i][j] != velNull) and (a1[i][j] < mingrad)) {
+					mingrad = a1[i][j];
+					startindex = i;
+				}
+			}
+			// Use a much smaller azimuthal average because of radial shear across eyewall
+			int azavg = 1; //numVGatesAveraged / 6;
+			float startVelocity = veldata[startindex][j];
+			if(startVelocity!=velNull)
+			{
+				float sum = float(azavg)*startVelocity;
+				float median, mean;
+				mean = median = startVelocity;
+				float segVelocity[azavg];
+				for(int k = 0; k < azavg; k++)
+				{
+					segVelocity[k] = startVelocity;
+				}
+				for (int ri=startindex; ri < rays+startindex; ri++)
+				{
+					
+					int i = (ri >= rays) ? (ri-rays) : ri;
+					
+					//Message::toScreen("Gate "+QString().setNum(j));
+					if(veldata[i][j]!=velNull)
+					{
+						int minfold = 0;
+						mingrad = 1e34;
+						for (int fold = -1; fold < 2; fold++)
+						{
+							//double weights[5] = { -1./12., 4./3., -5./2., 4./3., -1./12. }; 
+							double weights[3] = {1.0, -2.0, 1.0};
+							sum = 0;
+							//for (int m = i-2; m < i+3; m++) {
+							for (int m = i-1; m < i+2; m++) {
+								int ri = (m >= rays) ? (m-rays) : m;
+								ri = (ri < 0) ? (ri+rays) : ri;
+								if (veldata[ri][j] != velNull) {
+									float tryVelocity = veldata[ri][j];
+									if (ri == i) tryVelocity += (2.0*fold*nyquistVelocity);
+									sum += weights[m-i+1]*tryVelocity;
+									//sum += weights[m-i]*veldata[i][j];
+								} else {
+									sum = velNull;
+									break;
+								}
+							}
+							if ((sum != velNull) and (fabs(sum) < mingrad)) {
+								mingrad = sum;
+								minfold = fold;
+							}
+						}
+						if(veldata[i][j]!=velNull)
+						{
+							veldata[i][j]+= 2.0*minfold*(nyquistVelocity);
+							ray_index = i + currentSweep->getFirstRay();
+							Ray* currentRay = radarData->getRay(ray_index);
+							float* raydata = currentRay->getVelData();
+							if ((raydata != NULL) and (j < currentRay->getVel_numgates())) {
+							   raydata[j] = veldata[i][j];
+						    }
+						}
+					}
+				}
+			}			
+		}
+		for (int i=0; i < rays; i++)  {
+			delete[] veldata[i];
+			delete[] a1[i];
+		}
+		delete[] veldata;
+		delete[] a1;
+		
+	}
+    //Message::toScreen("Getting out of dealias");
+    return true;
+}
@@ -9,6 +9,7 @@
  */
 
 #include "PressureData.h"
+#include <QDataStream>
 #include <QTextStream>
 #include "math.h"
 #include "Message.h"
@@ -172,3 +173,17 @@ void PressureData::printString()
   Message::toScreen(printMessage);
 
 }
+
+QDataStream& operator<<(QDataStream& out, const PressureData& data)
+{
+	out << data.stationName << data.time << data.latitude << data.longitude
+	    << data.altitude << data.pressure << data.windSpeed << data.windDirection;
+	return out;
+}
+
+QDataStream& operator>>(QDataStream& in, PressureData& data)
+{
+	in >> data.stationName >> data.time >> data.latitude >> data.longitude
+	   >> data.altitude >> data.pressure >> data.windSpeed >> data.windDirection;
+	return in;
+}
@@ -14,8 +14,13 @@
 #include<QDateTime>
 #include<QString>
 
+class QDataStream;
+
 class PressureData
 {
+	// Binary form used by PressureList to keep the history on disk
+	friend QDataStream& operator<<(QDataStream& out, const PressureData& data);
+	friend QDataStream& operator>>(QDataStream& in, PressureData& data);
 	
 public:
 	PressureData();
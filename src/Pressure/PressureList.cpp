@@ -22,6 +22,7 @@
 PressureList::PressureList(QString prsFilePath) : QList<PressureData>()
 {
     _filePath = prsFilePath;
+    _numSaved = 0;
 }
 PressureList::~PressureList()
 {
@@ -77,7 +78,34 @@ bool PressureList::saveXML()
   return true;
 }
 
+bool PressureList::save()
+{
+    if(_numSaved > count())
+        return rewrite();
+    _numSaved += _store.append(*this, _numSaved);
+    return _numSaved == count();
+}
+
+bool PressureList::rewrite()
+{
+    if(!_store.rewrite(*this))
+        return false;
+    _numSaved = count();
+    return true;
+}
+
 bool PressureList::restore()
 {
-    return false;
+    clear();
+    bool complete = _store.read(*this);
+    _numSaved = count();
+    // Drop whatever follows a record that could not be read
+    if(!complete && !isEmpty())
+        rewrite();
+    return !isEmpty();
+}
+
+void PressureList::setRecordPath(QString recordPath)
+{
+    _store.setFilePath(recordPath);
 }
@@ -16,6 +16,7 @@
 #include <QString>
 
 #include "Pressure/PressureData.h"
+#include "IO/RecordFile.h"
 
 class PressureList : public QList<PressureData>
 {
@@ -23,11 +24,19 @@ class PressureList : public QList<PressureData>
 public:
     PressureList(QString prsFilePath=QString());
     virtual ~PressureList();
-    bool saveXML();
+    // Same record file scheme as VortexList
+    bool save();
+    bool rewrite();
     bool restore();
+    void setRecordPath(QString recordPath);
+
+    // Write the whole list as XML, for export
+    bool saveXML();
     void setFilePath(QString prsFilePath);
 private:
     QString _filePath;
+    RecordFile _store;
+    int _numSaved;
     void createDomPressureDataEntry(const PressureData &newData);
 };
 
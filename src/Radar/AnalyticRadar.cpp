@@ -25,6 +25,7 @@
   velNull = -999.;
   data = NULL;
   elevations = NULL;
+  seeded = false;
 
   // Loads the configuration containing analytic radar parameters
   config = new Configuration();
@@ -240,7 +241,8 @@ Ray* AnalyticRadar::addRay()
 	//Message::toScreen("Random gate = "+QString().setNum(percentOfGates));
 	if(percentOfGates < noisyGates) {
 	  //Message::toScreen("Got Noise");
-	  srand(time(NULL));  // reinitializes random number generator
+	  if(!seeded)
+	    srand(time(NULL));  // reinitializes random number generator
 	  float noise = rand()%1000/1000.0 -.5;
 	  vel_data[gateNum]+= noiseScale*noise;
 	}
@@ -370,6 +372,18 @@ bool AnalyticRadar::readVolumeAnalytic()
   
   radarDateTime = QDateTime::currentDateTime();
 
+  // A fixed seed makes the volume reproducible, observed when the vortex
+  // is at the configured position
+  QString seed = config->getParam(analytic_radar, "seed");
+  if(!seed.isEmpty()) {
+    srand(seed.toUInt());
+    seeded = true;
+    QDate obsDate = QDate::fromString(mainConfig->getParam(vortex,"obsdate"),"yyyy-MM-dd");
+    QTime obsTime = QTime::fromString(mainConfig->getParam(vortex,"obstime"),"hh:mm:ss");
+    if(obsDate.isValid() && obsTime.isValid())
+      radarDateTime = QDateTime(obsDate, obsTime, Qt::UTC);
+  }
+
   radarName = QString("Analytic Radar"); 
   
   GriddedFactory *factory = new GriddedFactory();
@@ -410,6 +424,10 @@ bool AnalyticRadar::readVolumeAnalytic()
 	    if(totNumSweeps > 6) {
 	      elevations[5] = 7;
 	    }}}}}}
+  // The last sweep isn't set above, nor is anything past the seventh
+  int setSweeps = (totNumSweeps <= 2) ? totNumSweeps : qMin(totNumSweeps-1, 6);
+  for(int n = setSweeps; n < totNumSweeps; n++)
+    elevations[n] = elevations[n-1]+2;
   
   Sweeps = new Sweep[totNumSweeps];
   Rays = new Ray[totNumSweeps*numRaysPerSweep]; 
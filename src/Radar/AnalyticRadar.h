@@ -71,6 +71,10 @@ class AnalyticRadar : public RadarData
   int noisyGates;
   // Analytic radar parameter, which are read from the configuration
 
+  bool seeded;
+  // True if the configuration gives a random seed, the noise and the
+  // volume time are then the same on every run
+
   float *elevations;
   // elevations contains the sweep angles used
 
@@ -0,0 +1,107 @@
+/*
+ *  BeamGeometry.cpp
+ *  VORTRAC
+ *
+ *  Copyright 2026 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include "BeamGeometry.h"
+#include <math.h>
+
+BeamGeometry::BeamGeometry()
+{
+}
+
+BeamGeometry::~BeamGeometry()
+{
+  clear();
+}
+
+void BeamGeometry::clear(int numSweeps)
+{
+  QMutexLocker locker(&lock);
+  for (int s = 0; s < sweepTables.size(); s++)
+    qDeleteAll(sweepTables[s]);
+  qDeleteAll(retired);
+  retired.clear();
+  sweepTables.clear();
+  // One more for rays that don't know their sweep
+  sweepTables.resize(numSweeps + 1);
+}
+
+float BeamGeometry::height(float range, float elevation)
+{
+  const float REarth = 6371.0;
+  const float RE = 4*REarth/3;
+  const float REsq = RE * RE;
+
+  float elevRadians = elevation * acos(-1.0) / 180.0;
+  float sinelev = sin(elevRadians);
+  //float height = sqrt(distance * distance + REsq + 2.0 * distance * RE * sin(elevRadians)) - RE;
+  float top = range*range+2*range*RE*sinelev;
+  float bottom =  sqrt(range*range + REsq + 2.*range*RE*sinelev) + RE;
+  return top/bottom;
+}
+
+const BeamGeometry::Gates* BeamGeometry::lookup(int sweep, float elevation, int firstGate,
+                                                float gateSpacing, int numGates)
+{
+  QMutexLocker locker(&lock);
+  if (sweepTables.isEmpty())
+    sweepTables.resize(1);
+  if ((sweep < 0) or (sweep >= sweepTables.size() - 1))
+    sweep = sweepTables.size() - 1;
+
+  QList<Gates*>& tables = sweepTables[sweep];
+  for (int t = 0; t < tables.size(); t++) {
+    Gates* gates = tables.at(t);
+    if ((gates->elevation != elevation) or (gates->firstGate != firstGate)
+        or (gates->gateSpacing != gateSpacing))
+      continue;
+    if (gates->numGates >= numGates)
+      return gates;
+    // A longer ray with the same geometry, earlier rays keep the old table
+    retired.append(gates);
+    tables[t] = build(elevation, firstGate, gateSpacing, numGates);
+    return tables.at(t);
+  }
+  tables.append(build(elevation, firstGate, gateSpacing, numGates));
+  return tables.last();
+}
+
+BeamGeometry::Gates* BeamGeometry::build(float elevation, int firstGate,
+                                         float gateSpacing, int numGates)
+{
+  // Same constants and precision as the HVVP, which used to do this per gate
+  const float deg2rad = acos(-1)/180.0;
+  const float ae = 4.0*6371.0/3.0;
+
+  Gates* gates = new Gates;
+  gates->elevation = elevation;
+  gates->firstGate = firstGate;
+  gates->gateSpacing = gateSpacing;
+  gates->numGates = numGates;
+  gates->range.resize(numGates);
+  gates->height.resize(numGates);
+  gates->groundRange.resize(numGates);
+  gates->effectiveElevation.resize(numGates);
+  gates->cosEffectiveElevation.resize(numGates);
+
+  float elevRadians = elevation*deg2rad;
+  gates->cosElevation = cos(elevRadians);
+  for (int g = 0; g < numGates; g++) {
+    float range = float(firstGate + (g * gateSpacing))/1000.;
+    float alt = height(range, elevation);
+    float groundRange = range*gates->cosElevation;
+    float ee = elevRadians;
+    ee += asin(groundRange/(ae+alt));
+    gates->range[g] = range;
+    gates->height[g] = alt;
+    gates->groundRange[g] = groundRange;
+    gates->effectiveElevation[g] = ee;
+    gates->cosEffectiveElevation[g] = cos(ee);
+  }
+  return gates;
+}
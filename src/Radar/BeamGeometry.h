@@ -0,0 +1,73 @@
+/*
+ *  BeamGeometry.h
+ *  VORTRAC
+ *
+ *  Copyright 2026 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef BEAMGEOMETRY_H
+#define BEAMGEOMETRY_H
+
+#include <QList>
+#include <QMutex>
+#include <QVector>
+
+// Beam geometry by gate for one radar volume. The height of a gate only
+// depends on the elevation of the ray, the range of the first gate and the
+// gate spacing, so the rays of a sweep share a handful of tables. Each
+// table is computed once, the first time a ray with that geometry asks for
+// it, and kept until the volume goes away. Tables are never changed once
+// they are handed out, so the pointers stay good while other threads add
+// tables for other rays.
+
+class BeamGeometry
+{
+
+ public:
+
+  class Gates {
+  public:
+    float elevation;      // deg
+    int firstGate;        // m
+    float gateSpacing;    // m
+    int numGates;
+    float cosElevation;
+    QVector<float> range;                 // slant range, km
+    QVector<float> height;                // height above the radar, km
+    QVector<float> groundRange;           // range * cos(elevation), km
+    QVector<float> effectiveElevation;    // elevation plus earth curvature, rad
+    QVector<float> cosEffectiveElevation;
+  };
+
+  BeamGeometry();
+  ~BeamGeometry();
+
+  // Table of at least numGates gates for a ray in sweep (anything outside
+  // 0 .. numSweeps-1 is kept together). Safe to call from several threads.
+  const Gates* lookup(int sweep, float elevation, int firstGate,
+                      float gateSpacing, int numGates);
+
+  // Start over with room for numSweeps sweeps
+  void clear(int numSweeps = 0);
+
+  // Height above the radar in km of a gate at range km, using the 4/3
+  // earth radius model
+  static float height(float range, float elevation);
+
+ private:
+  // Not copyable, callers hold pointers into it
+  BeamGeometry(const BeamGeometry&);
+  BeamGeometry& operator=(const BeamGeometry&);
+
+  static Gates* build(float elevation, int firstGate, float gateSpacing, int numGates);
+
+  QMutex lock;
+  QVector<QList<Gates*> > sweepTables;
+  // Tables outgrown by a longer ray, still in use by the shorter ones
+  QList<Gates*> retired;
+
+};
+
+#endif
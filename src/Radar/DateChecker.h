@@ -12,6 +12,8 @@ class DateChecker {
 			   QDateTime startDateTime, QDateTime endDateTime) = 0;
 
   QDateTime getTime() { return fileDateTime; }
+  // Call before fileInRange, names that can't be parsed leave it invalid
+  void resetTime() { fileDateTime = QDateTime(); }
   
   QString baseName(QString path);
   virtual ~DateChecker() {}
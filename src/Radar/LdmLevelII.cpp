@@ -10,11 +10,14 @@
 
 #include "LdmLevelII.h"
 #include "NRL/RadarQC.h"
+#include <QThread>
+#include <QtConcurrentMap>
+#include <cstring>
 
 LdmLevelII::LdmLevelII(const QString &radarname, const float &lat, const float &lon, const QString &filename)
 	: LevelII(radarname, lat, lon, filename)
 {
-
+  serialDecompress = false;
 }
 
 bool LdmLevelII::readVolume()
@@ -31,272 +34,356 @@ bool LdmLevelII::readVolume()
   // Open the QFile object from the header
   if(!radarFile->open(QIODevice::ReadOnly)) {
     Message::report("Can't open radar volume");
+    return false;
   }
 
-  QDataStream dataIn(radarFile);
+  // Index the compressed records in one pass over the file
+  qint64 volumeSize = radarFile->size();
+  uchar* mappedVolume = radarFile->map(0, volumeSize);
+  QByteArray volumeBuffer;
+  const char* volume = (const char *)mappedVolume;
+  if (volume == NULL) {
+    // Can't map this file, so read it in one piece
+    volumeBuffer = radarFile->readAll();
+    volume = volumeBuffer.constData();
+    volumeSize = volumeBuffer.size();
+  }
 
   // Get volume header
-  dataIn.readRawData((char *)volHeader, sizeof(nexrad_vol_scan_title));
+  if (volumeSize < (qint64)sizeof(nexrad_vol_scan_title)) {
+    Message::report("Radar volume is too short");
+    radarFile->close();
+    return false;
+  }
+  memcpy(volHeader, volume, sizeof(nexrad_vol_scan_title));
   if (swap_bytes) {
     swapVolHeader();
   }
 
-  // Read in blocks of data
-  char* nexBuffer = new char[2432];
-  int recNum = 0;
-  while (!dataIn.atEnd()) {
+  QVector<LdmRecord> records;
+  qint64 offset = sizeof(nexrad_vol_scan_title);
+  while (volumeSize - offset >= 4) {
 
-	  // Try to read 4 bytes for size
+	  // 4 bytes for size
 	  int recSize;
-	  dataIn.readRawData((char *)&recSize, 4);
+	  memcpy(&recSize, volume + offset, 4);
 	  if (swap_bytes) {
 		  recSize = swap4((char *)&recSize);
 	  }
-
-	  // Read in the compressed record
 	  if (recSize < 0) {
 		  recSize = -recSize;
 	  }
-	  char* compressed = new char[recSize];
-	  dataIn.readRawData((char *)compressed,recSize);
-
-	  unsigned int uncompSize = 262144;
-	  char* uncompressed = new char[uncompSize];
-	  int error;
-	  while (1) {
-		  error = BZ2_bzBuffToBuffDecompress(uncompressed, &uncompSize,
-											 compressed, recSize, 0, 0);
-		  if (error == BZ_OUTBUFF_FULL) {
-			  // Double the array
-			  uncompSize += 262144;
-			  delete[] uncompressed;
-			  uncompressed = new char[uncompSize];
-		  } else if (!error) {
-			  // Uncompress worked!
-			  break;
-		  } else {
-			  /* Some other error, but log functionality not currently available in this class
-			  if (error == BZ_CONFIG_ERROR)
-				  emit log(Message(QString("The BZ2 library has been miscompiled"),0,
-							   this->objectName(),Red,QString("Error reading Level II File")));
-			  if (error == BZ_PARAM_ERROR)
-				  emit log(Message(QString("Parameter Error in BZ2 Decompression"),0,
-							   this->objectName(),Yellow,QString("Error reading Level II File")));
-			  if (error == BZ_MEM_ERROR)
-				  emit log(Message(QString("Insufficient memory for BZ2 Decompression"),0,
-								   this->objectName(),Red,QString("Error reading Level II File")));
-			  if (error == BZ_DATA_ERROR)
-				  emit log(Message(QString("Compressed data exceeds destLen in BZ2 unzip"),0,
-								   this->objectName(),Yellow,QString("Error reading Level II File")));
-			  if (error == BZ_DATA_ERROR_MAGIC)
-				  emit log(Message(QString("Compressed data doesn't begin with right magic bytes"),0,
-								   this->objectName(),Yellow,QString("Error reading Level II File")));
-			  if (error == BZ_UNEXPECTED_EOF)
-				  emit log(Message(QString("Compressded data ended unexpectedly"),0,
-								   this->objectName(),Yellow,QString("Error reading Level II File")));
-			  */
-			  break;
+	  offset += 4;
+	  if (volumeSize - offset < recSize) {
+		  // Truncated record at the end of the file
+		  break;
+	  }
+
+	  LdmRecord record;
+	  record.compressed = volume + offset;
+	  record.compressedSize = recSize;
+	  record.buffer = NULL;
+	  record.bufferSize = 0;
+	  record.uncompSize = 0;
+	  record.error = 0;
+	  records.append(record);
+	  offset += recSize;
+  }
+
+  // The records are independent, so decompress them a batch at a time on
+  // the thread pool. Each batch is parsed in record order while the next
+  // one decompresses into the other half of the slots.
+  const int batchSize = serialDecompress ? 1 : 2 * qMax(1, QThread::idealThreadCount());
+  QVector<LdmRecord> batchSlots(2 * batchSize);
+  for (int n = 0; n < batchSlots.size(); n++) {
+	  batchSlots[n].buffer = NULL;
+	  batchSlots[n].bufferSize = 0;
+  }
+  QFuture<void> decompressing[2];
+  int batchCount[2] = {0, 0};
+  int nextRecord = 0;
+  int recNum = 0;
+  int current = 1;
+  do {
+	  // Queue up the next batch
+	  const int queued = 1 - current;
+	  QVector<LdmRecord>::iterator first = batchSlots.begin() + queued * batchSize;
+	  batchCount[queued] = qMin(batchSize, records.size() - nextRecord);
+	  for (int n = 0; n < batchCount[queued]; n++) {
+		  first[n].compressed = records[nextRecord].compressed;
+		  first[n].compressedSize = records[nextRecord].compressedSize;
+		  nextRecord++;
+	  }
+	  if (serialDecompress) {
+		  for (int n = 0; n < batchCount[queued]; n++)
+			  decompressRecord(first[n]);
+	  } else {
+		  decompressing[queued] = QtConcurrent::map(first, first + batchCount[queued], Decompress());
+	  }
+
+	  // Parse the batch that was already running
+	  decompressing[current].waitForFinished();
+	  for (int n = 0; n < batchCount[current]; n++) {
+		  LdmRecord& record = batchSlots[current * batchSize + n];
+		  if (record.error) {
+			  // Didn't uncompress the data properly
+			  continue;
 		  }
+
+		  recNum++;
+		  // Skip the metadata at the beginning
+		  if ((recNum == 1) and (record.uncompSize == 325888)) {
+			  continue;
+		  }
+		  parseRecord(record.buffer, record.uncompSize);
 	  }
-	  delete[] compressed;
-	  if (error) {
-		  // Didn't uncompress the data properly
-		  delete[] uncompressed;
-		  continue;
+	  current = queued;
+  } while (batchCount[current] > 0);
+  decompressing[current].waitForFinished();
+
+  for (int n = 0; n < batchSlots.size(); n++) {
+	  delete[] batchSlots[n].buffer;
+  }
+  if (mappedVolume != NULL) {
+	  radarFile->unmap(mappedVolume);
+  }
+
+  // Record the number of rays in the last sweep
+  if (numSweeps > 0)
+    Sweeps[numSweeps-1].setLastRay(numRays-1);
+
+  // Should have all the data stored into memory now
+  radarFile->close();
+
+  isDealiased(false);
+
+  if(numSweeps < 5) {
+    // Corrupt radar volume
+    return false;
+  }
+
+  return true;
+
+}
+
+void LdmLevelII::decompressRecord(LdmRecord& record)
+{
+
+  // Runs on the thread pool, so it only touches its own record
+  if (record.buffer == NULL) {
+	  record.bufferSize = 262144;
+	  record.buffer = new char[record.bufferSize];
+  }
+  int error;
+  while (1) {
+	  record.uncompSize = record.bufferSize;
+	  error = BZ2_bzBuffToBuffDecompress(record.buffer, &record.uncompSize,
+										 (char *)record.compressed, record.compressedSize, 0, 0);
+	  if (error == BZ_OUTBUFF_FULL) {
+		  // Grow the slot buffer, it is kept for later records
+		  record.bufferSize += 262144;
+		  delete[] record.buffer;
+		  record.buffer = new char[record.bufferSize];
+	  } else {
+		  // Uncompress worked, or some other error that can't be logged here
+		  // (BZ_CONFIG_ERROR, BZ_PARAM_ERROR, BZ_MEM_ERROR, BZ_DATA_ERROR,
+		  // BZ_DATA_ERROR_MAGIC or BZ_UNEXPECTED_EOF)
+		  break;
 	  }
+  }
+  record.error = error;
 
-	  recNum++;
-	  // Skip the metadata at the beginning
-	  if ((recNum == 1) and (uncompSize == 325888)) {
-          delete[] uncompressed;
-          continue;
-      }
-
-	  unsigned int msgIncr = 0;
-	  //for (unsigned int i = 0; i < uncompSize; i += 2432) {
-	  while (msgIncr < uncompSize) {
-		  // Extract a packet, skipping metadata
-		  nexBuffer = (uncompressed + msgIncr);
-
-		  // Skip the CTM info
-		  //char *readPtr = nexBuffer + sizeof(CTM_info);
-		  char *readPtr = nexBuffer + 12;
-		  // Read in the message header
-		  msgHeader = (nexrad_message_header *)readPtr;
+}
+
+void LdmLevelII::parseRecord(char* uncompressed, const unsigned int& uncompSize)
+{
+
+  char* nexBuffer;
+  unsigned int msgIncr = 0;
+  //for (unsigned int i = 0; i < uncompSize; i += 2432) {
+  while (msgIncr < uncompSize) {
+	  // Extract a packet, skipping metadata
+	  nexBuffer = (uncompressed + msgIncr);
+
+	  // Skip the CTM info
+	  //char *readPtr = nexBuffer + sizeof(CTM_info);
+	  char *readPtr = nexBuffer + 12;
+	  // Read in the message header
+	  msgHeader = (nexrad_message_header *)readPtr;
+	  if (swap_bytes) {
+		  swapMsgHeader();
+	  }
+	  if (msgHeader->message_type == 1) {
+		  // Got some fixed length data
+		  sweepMsgType = 1;
+		  msg1Header = (message_1_data_header *)(readPtr + sizeof(nexrad_message_header));
 		  if (swap_bytes) {
-			  swapMsgHeader();
+			  swapMsg1Header();
 		  }
-		  if (msgHeader->message_type == 1) {
-			  // Got some fixed length data
-			  sweepMsgType = 1;
-			  msg1Header = (message_1_data_header *)(readPtr + sizeof(nexrad_message_header));
-			  if (swap_bytes) {
-				  swapMsg1Header();
-			  }
 
-			  vcp = msg1Header->vol_coverage_pattern;
+		  vcp = msg1Header->vol_coverage_pattern;
 
-			  // Is this a new sweep? Check radial status
-			  if (msg1Header->radial_status == 3) {
+		  // Is this a new sweep? Check radial status
+		  if (msg1Header->radial_status == 3) {
 
-				  // Beginning of volume
-				  volumeTime = msg1Header->milliseconds_past_midnight;
-				  volumeDate = msg1Header->julian_date;
-				  QDate initDate(1970,1,1);
-				  radarDateTime.setDate(initDate);
-				  radarDateTime.setTimeSpec(Qt::UTC);
-				  radarDateTime = radarDateTime.addDays(volumeDate - 1);
-				  radarDateTime = radarDateTime.addMSecs((qint64)volumeTime);
+			  // Beginning of volume
+			  volumeTime = msg1Header->milliseconds_past_midnight;
+			  volumeDate = msg1Header->julian_date;
+			  QDate initDate(1970,1,1);
+			  radarDateTime.setDate(initDate);
+			  radarDateTime.setTimeSpec(Qt::UTC);
+			  radarDateTime = radarDateTime.addDays(volumeDate - 1);
+			  radarDateTime = radarDateTime.addMSecs((qint64)volumeTime);
 
-				  // First sweep and ray
-				  addSweep(Sweeps);
-				  Sweeps[0].setFirstRay(0);
+			  // First sweep and ray
+			  addSweep(Sweeps);
+			  Sweeps[0].setFirstRay(0);
 
-			  } else if (msg1Header->radial_status == 0) {
+		  } else if (msg1Header->radial_status == 0) {
 
-				  // New sweep
-				  // Use Dennis' stuff here eventually
-				  // Count up rays in sweep
-				  Sweeps[numSweeps-1].setLastRay(numRays-1);
-				  // Increment array
-				  addSweep(&Sweeps[numSweeps]);
-				  // Sweeps[numSweeps].setFirstRay(numRays);
+			  // New sweep
+			  // Use Dennis' stuff here eventually
+			  // Count up rays in sweep
+			  Sweeps[numSweeps-1].setLastRay(numRays-1);
+			  // Increment array
+			  addSweep(&Sweeps[numSweeps]);
+			  // Sweeps[numSweeps].setFirstRay(numRays);
 
-			  }
+		  }
 
-			  // Read ray of data
-			  if (msg1Header->ref_ptr) {
-				  char* const ref_buffer = readPtr + sizeof(nexrad_message_header) + msg1Header->ref_ptr;
-				  decode_ref(&Rays[numRays], ref_buffer, msg1Header->ref_num_gates);
-			  }
-			  if (msg1Header->vel_ptr) {
-				  char* const vel_buffer = readPtr + sizeof(nexrad_message_header) + msg1Header->vel_ptr;
-				  decode_vel(&Rays[numRays], vel_buffer, msg1Header->vel_num_gates, msg1Header->velocity_resolution);
-			  }
-			  if (msg1Header->sw_ptr) {
-				  char* const sw_buffer = readPtr + sizeof(nexrad_message_header) + msg1Header->sw_ptr;
-				  decode_sw(&Rays[numRays], sw_buffer, msg1Header->vel_num_gates);
-			  }
+		  // Read ray of data
+		  if (msg1Header->ref_ptr) {
+			  char* const ref_buffer = readPtr + sizeof(nexrad_message_header) + msg1Header->ref_ptr;
+			  keep_ref(&Rays[numRays], ref_buffer, msg1Header->ref_num_gates);
+		  }
+		  if (msg1Header->vel_ptr) {
+			  char* const vel_buffer = readPtr + sizeof(nexrad_message_header) + msg1Header->vel_ptr;
+			  keep_vel(&Rays[numRays], vel_buffer, msg1Header->vel_num_gates, msg1Header->velocity_resolution);
+		  }
+		  if (msg1Header->sw_ptr) {
+			  char* const sw_buffer = readPtr + sizeof(nexrad_message_header) + msg1Header->sw_ptr;
+			  keep_sw(&Rays[numRays], sw_buffer, msg1Header->vel_num_gates);
+		  }
+
+		  // Put more rays in the volume, associated with the current Sweep;
+		  addRay(&Rays[numRays]);
 
-			  // Put more rays in the volume, associated with the current Sweep;
-			  addRay(&Rays[numRays]);
+	  } else if (msgHeader->message_type == 31) {
 
-		  } else if (msgHeader->message_type == 31) {
+	      // Got some variable length data
+		  sweepMsgType = 31;
 
-		      // Got some variable length data
-			  sweepMsgType = 31;
+		  msg31Header = (message_31_data_header *)(readPtr + sizeof(nexrad_message_header));
+		  if (swap_bytes) {
+			  swapMsg31Header();
+		  }
 
-			  msg31Header = (message_31_data_header *)(readPtr + sizeof(nexrad_message_header));
+		  // Read volume and radial data
+		  if (msg31Header->vol_ptr) {
+			  volume_block = (volume_data_block *)(readPtr + sizeof(nexrad_message_header) + msg31Header->vol_ptr);
 			  if (swap_bytes) {
-				  swapMsg31Header();
+				swapVolumeBlock();
 			  }
+			  vcp = volume_block->vol_coverage_pattern;
+		  }
 
-			  // Read volume and radial data
-			  if (msg31Header->vol_ptr) {
-				  volume_block = (volume_data_block *)(readPtr + sizeof(nexrad_message_header) + msg31Header->vol_ptr);
-				  if (swap_bytes) {
-					swapVolumeBlock();
-				  }
-				  vcp = volume_block->vol_coverage_pattern;
+		  if (msg31Header->radial_ptr) {
+			  radial_block = (radial_data_block *)(readPtr + sizeof(nexrad_message_header) + msg31Header->radial_ptr);
+			  if (swap_bytes) {
+				swapRadialBlock();
 			  }
+		  }
 
-			  if (msg31Header->radial_ptr) {
-				  radial_block = (radial_data_block *)(readPtr + sizeof(nexrad_message_header) + msg31Header->radial_ptr);
-				  if (swap_bytes) {
-					swapRadialBlock();
-				  }
+		  if (msg31Header->ref_ptr) {
+			  ref_block = (moment_data_block *)(readPtr + sizeof(nexrad_message_header) + msg31Header->ref_ptr);
+			  if (swap_bytes) {
+				swapMomentDataBlock(ref_block);
 			  }
-
-			  if (msg31Header->ref_ptr) {
-				  ref_block = (moment_data_block *)(readPtr + sizeof(nexrad_message_header) + msg31Header->ref_ptr);
-				  if (swap_bytes) {
-					swapMomentDataBlock(ref_block);
-				  }
-				  QString blockID(ref_block->block_type);
-				  if (blockID != QString("DREF")) {
-					// Skip this ray
-					//continue;
-				  }
-				  char* const ref_buffer = (char *)ref_block + sizeof(moment_data_block);
-				  decode_ref(&Rays[numRays], ref_buffer, ref_block->num_gates);
-				  ref_num_gates = ref_block->num_gates;
-				  ref_gate1 = ref_block->gate1;
-				  ref_gate_width = ref_block->gate_width;
-			  } else {
-			      ref_data = NULL;
-				  ref_num_gates = 0;
-				  ref_gate1 = 0;
-				  ref_gate_width = 0;
+			  QString blockID(ref_block->block_type);
+			  if (blockID != QString("DREF")) {
+				// Skip this ray
+				//continue;
 			  }
+			  char* const ref_buffer = (char *)ref_block + sizeof(moment_data_block);
+			  keep_ref(&Rays[numRays], ref_buffer, ref_block->num_gates);
+			  ref_num_gates = ref_block->num_gates;
+			  ref_gate1 = ref_block->gate1;
+			  ref_gate_width = ref_block->gate_width;
+		  } else {
+		      ref_data = NULL;
+			  ref_num_gates = 0;
+			  ref_gate1 = 0;
+			  ref_gate_width = 0;
+		  }
 
-			  if (msg31Header->vel_ptr) {
-				  vel_block = (moment_data_block *)(readPtr + sizeof(nexrad_message_header) + msg31Header->vel_ptr);
-				  if (swap_bytes) {
-					swapMomentDataBlock(vel_block);
-				  }
-				  QString blockID(ref_block->block_type);
-				  if (blockID != QString("DVEL")) {
-					// Skip this ray
-					//continue;
-				  }
-				  char* const vel_buffer = (char *)vel_block + sizeof(moment_data_block);
-				  decode_vel(&Rays[numRays], vel_buffer, vel_block->num_gates, vel_block->scale);
-				  vel_num_gates = vel_block->num_gates;
-				  vel_gate1 = vel_block->gate1;
-				  vel_gate_width = vel_block->gate_width;
-			  } else {
-				  vel_data = NULL;
-				  vel_num_gates = 0;
-				  vel_gate1 = 0;
-				  vel_gate_width = 0;
+		  if (msg31Header->vel_ptr) {
+			  vel_block = (moment_data_block *)(readPtr + sizeof(nexrad_message_header) + msg31Header->vel_ptr);
+			  if (swap_bytes) {
+				swapMomentDataBlock(vel_block);
+			  }
+			  QString blockID(ref_block->block_type);
+			  if (blockID != QString("DVEL")) {
+				// Skip this ray
+				//continue;
 			  }
+			  char* const vel_buffer = (char *)vel_block + sizeof(moment_data_block);
+			  keep_vel(&Rays[numRays], vel_buffer, vel_block->num_gates, vel_block->scale);
+			  vel_num_gates = vel_block->num_gates;
+			  vel_gate1 = vel_block->gate1;
+			  vel_gate_width = vel_block->gate_width;
+		  } else {
+			  vel_data = NULL;
+			  vel_num_gates = 0;
+			  vel_gate1 = 0;
+			  vel_gate_width = 0;
+		  }
 
-			  if (msg31Header->sw_ptr) {
-			      sw_block = (moment_data_block *)(readPtr + sizeof(nexrad_message_header) + msg31Header->sw_ptr);
-				  if (swap_bytes) {
-					swapMomentDataBlock(sw_block);
-				  }
-				  char* const sw_buffer = (char *)sw_block + sizeof(moment_data_block);
-				  decode_sw(&Rays[numRays], sw_buffer, sw_block->num_gates);
+		  if (msg31Header->sw_ptr) {
+		      sw_block = (moment_data_block *)(readPtr + sizeof(nexrad_message_header) + msg31Header->sw_ptr);
+			  if (swap_bytes) {
+				swapMomentDataBlock(sw_block);
 			  }
+			  char* const sw_buffer = (char *)sw_block + sizeof(moment_data_block);
+			  keep_sw(&Rays[numRays], sw_buffer, sw_block->num_gates);
+		  }
 
 
 
-			  // Is this a new sweep? Check radial status
-			  if (msg31Header->radial_status == 3) {
+		  // Is this a new sweep? Check radial status
+		  if (msg31Header->radial_status == 3) {
 
-				  // Beginning of volume
-				  volumeTime = msg31Header->milliseconds_past_midnight;
-				  volumeDate = msg31Header->julian_date;
-				  QDate initDate(1970,1,1);
-				  radarDateTime.setDate(initDate);
-				  radarDateTime.setTimeSpec(Qt::UTC);
-				  radarDateTime = radarDateTime.addDays(volumeDate - 1);
-				  radarDateTime = radarDateTime.addMSecs((qint64)volumeTime);
+			  // Beginning of volume
+			  volumeTime = msg31Header->milliseconds_past_midnight;
+			  volumeDate = msg31Header->julian_date;
+			  QDate initDate(1970,1,1);
+			  radarDateTime.setDate(initDate);
+			  radarDateTime.setTimeSpec(Qt::UTC);
+			  radarDateTime = radarDateTime.addDays(volumeDate - 1);
+			  radarDateTime = radarDateTime.addMSecs((qint64)volumeTime);
 
-				  // First sweep and ray
-				  addSweep(Sweeps);
-				  Sweeps[0].setFirstRay(0);
+			  // First sweep and ray
+			  addSweep(Sweeps);
+			  Sweeps[0].setFirstRay(0);
 
-			  } else if (msg31Header->radial_status == 0) {
+		  } else if (msg31Header->radial_status == 0) {
 
-				  // New sweep
-				  // Use Dennis' stuff here eventually
-				  // Count up rays in sweep
-				  Sweeps[numSweeps-1].setLastRay(numRays-1);
-				  // Increment array
-				  addSweep(&Sweeps[numSweeps]);
-				  // Sweeps[numSweeps].setFirstRay(numRays);
+			  // New sweep
+			  // Use Dennis' stuff here eventually
+			  // Count up rays in sweep
+			  Sweeps[numSweeps-1].setLastRay(numRays-1);
+			  // Increment array
+			  addSweep(&Sweeps[numSweeps]);
+			  // Sweeps[numSweeps].setFirstRay(numRays);
 
-			  } else if (msg31Header->radial_status == 2) {
-			      // Bail out?
+		  } else if (msg31Header->radial_status == 2) {
+		      // Bail out?
                   //int status = msg31Header->radial_status;
-				  //break;
-			  } else if (msg31Header->radial_status == 5) {
+			  //break;
+		  } else if (msg31Header->radial_status == 5) {
                   // Last sweep
                   Sweeps[numSweeps-1].setLastRay(numRays-1);
-				  // Increment array
-				  addSweep(&Sweeps[numSweeps]);
+			  // Increment array
+			  addSweep(&Sweeps[numSweeps]);
               } else {
                   // Shouldn't be here
                   /* Check for missing sweep demarcation!
@@ -308,34 +395,17 @@ bool LdmLevelII::readVolume()
                   } */
               }
 
-			  // Put more rays in the volume, associated with the current Sweep;
-			  addRay(&Rays[numRays]);
-
-		  } else {
-			  // Message Length is too short for binary segment
-			  msgHeader->message_len = 1210;
-		  }
-
-		  // Skip a variable # of bytes
-		  msgIncr += (msgHeader->message_len)*2 + 12;
+		  // Put more rays in the volume, associated with the current Sweep;
+		  addRay(&Rays[numRays]);
 
+	  } else {
+		  // Message Length is too short for binary segment
+		  msgHeader->message_len = 1210;
 	  }
 
-	  delete[] uncompressed;
-  }
-  // Record the number of rays in the last sweep
-  Sweeps[numSweeps-1].setLastRay(numRays-1);
-
-  // Should have all the data stored into memory now
-  radarFile->close();
-
-  isDealiased(false);
+	  // Skip a variable # of bytes
+	  msgIncr += (msgHeader->message_len)*2 + 12;
 
-  if(numSweeps < 5) {
-    // Corrupt radar volume
-    return false;
   }
 
-  return true;
-
 }
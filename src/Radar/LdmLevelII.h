@@ -11,6 +11,7 @@
 #ifndef LDMLEVELII_H
 #define LDMLEVELII_H
 
+#include <QVector>
 #include "LevelII.h"
 #include <bzlib.h>
 
@@ -20,6 +21,32 @@ class LdmLevelII : public LevelII
  public:
   LdmLevelII(const QString &radarname, const float &lat, const float &lon, const QString &filename);
   bool readVolume();
+  // Decompress one record at a time on the calling thread, as the reader
+  // did before the records were batched onto the thread pool
+  void setSerialDecompress(bool serial) { serialDecompress = serial; }
+
+ private:
+  bool serialDecompress;
+
+  // One bzip2 compressed record of the volume. The output buffer belongs
+  // to a decompression slot and is reused from batch to batch.
+  struct LdmRecord {
+    const char* compressed;
+    int compressedSize;
+    char* buffer;
+    unsigned int bufferSize;
+    unsigned int uncompSize;
+    int error;
+  };
+
+  class Decompress {
+  public:
+    typedef void result_type;
+    void operator()(LdmRecord& record) const { decompressRecord(record); }
+  };
+
+  static void decompressRecord(LdmRecord& record);
+  void parseRecord(char* uncompressed, const unsigned int& uncompSize);
   
 };
 
@@ -26,6 +26,7 @@ LevelII::LevelII(const QString &radarname, const float &lat, const float &lon, c
   msg31Header = NULL;
   Sweeps = new Sweep[20];
   Rays = new Ray[15000];
+  useMomentArena(0, 14999);
   swap_bytes = false;
   vel_data = NULL;
   sw_data = NULL;
@@ -141,67 +142,84 @@ void LevelII::addRay(Ray* newRay)
   //return *newRay;
 }
 
-void LevelII::decode_ref(Ray* newRay, const char *buffer, short int numGates)
+// Every 8-bit moment code maps to one float, so each decoder is a single
+// 256 entry table built once. Codes 0 (below threshold) and 1 (range
+// folded, set to bad for now) are missing.
+struct MomentDecodeTables
 {
-
-  newRay->allocateRefData( numGates );
-  float* refArray = newRay->getRefData();
-  // Decode each byte
-  for (short int i = 0; i <= numGates - 1; i++) {
-    unsigned char encoded = (unsigned char)buffer[i];
-    if (encoded == 0) {
-      refArray[i] = -999;
-    } else if (encoded == 1) {
-      // Ambiguous, set to bad for now
-      refArray[i] = -999;
-    } else {
-      refArray[i] = (((float)encoded - 2.)/2.) - 32.0;
+  float ref[256];
+  float vel[256];
+  float velCoarse[256];
+  float sw[256];
+
+  MomentDecodeTables()
+  {
+    for (int encoded = 0; encoded < 256; encoded++) {
+      if (encoded < 2) {
+	ref[encoded] = vel[encoded] = velCoarse[encoded] = sw[encoded] = -999;
+      } else {
+	ref[encoded] = (((float)encoded - 2.)/2.) - 32.0;
+	vel[encoded] = (((float)encoded - 2.)/2.) - 63.5;
+	velCoarse[encoded] = ((float)encoded - 2.) - 127.0;
+	sw[encoded] = (((float)encoded - 2.)/2.) - 63.5;
+      }
     }
   }
+};
 
+static const MomentDecodeTables& momentDecodeTables()
+{
+  static const MomentDecodeTables tables;
+  return tables;
 }
 
-void LevelII::decode_vel(Ray* newRay, const char *buffer, short int numGates,
-			   short int velRes)
+const float* LevelII::refDecodeTable()
 {
+  return momentDecodeTables().ref;
+}
 
-  newRay->allocateVelData( numGates );
-  float* velArray = newRay->getVelData();
-  // Decode each byte
-  for (int i = 0; i <= numGates - 1; i++) {
-    unsigned char encoded = (unsigned char)buffer[i];
-    if (encoded == 0) {
-      velArray[i] = -999;
-    } else if (encoded == 1) {
-      velArray[i] = -999;
-    } else {
-      if (velRes == 2) {
-	velArray[i] = (((float)encoded - 2.)/2.) - 63.5;
-      } else {
-	velArray[i] = ((float)encoded - 2.) - 127.0;
-      }
-    }
-  }
+const float* LevelII::velDecodeTable(short int velRes)
+{
+  if (velRes == 2)
+    return momentDecodeTables().vel;
+  return momentDecodeTables().velCoarse;
+}
 
+const float* LevelII::swDecodeTable()
+{
+  return momentDecodeTables().sw;
 }
 
-void LevelII::decode_sw(Ray* newRay, const char *buffer, short int numGates)
+void LevelII::keep_ref(Ray* newRay, const char *buffer, short int numGates)
 {
+  attach_ref(newRay, (const char *)keepEncoded(buffer, numGates), numGates);
+}
 
-  newRay->allocateSwData( numGates );
-  float* swArray = newRay->getSwData();
-  // Decode each byte
-  for (int i = 0; i <= numGates - 1; i++) {
-    unsigned char encoded = (unsigned char)buffer[i];
-    if (encoded == 0) {
-      swArray[i] = -999;
-    } else if (encoded == 1) {
-      swArray[i] = -999;
-    } else {
-      swArray[i] = (((float)encoded - 2.)/2.) - 63.5;
-    }
-  }
+void LevelII::keep_vel(Ray* newRay, const char *buffer, short int numGates,
+		       short int velRes)
+{
+  attach_vel(newRay, (const char *)keepEncoded(buffer, numGates), numGates, velRes);
+}
 
+void LevelII::keep_sw(Ray* newRay, const char *buffer, short int numGates)
+{
+  attach_sw(newRay, (const char *)keepEncoded(buffer, numGates), numGates);
+}
+
+void LevelII::attach_ref(Ray* newRay, const char *buffer, short int numGates)
+{
+  newRay->setRawRefData((const unsigned char*)buffer, numGates, refDecodeTable());
+}
+
+void LevelII::attach_vel(Ray* newRay, const char *buffer, short int numGates,
+			 short int velRes)
+{
+  newRay->setRawVelData((const unsigned char*)buffer, numGates, velDecodeTable(velRes));
+}
+
+void LevelII::attach_sw(Ray* newRay, const char *buffer, short int numGates)
+{
+  newRay->setRawSwData((const unsigned char*)buffer, numGates, swDecodeTable());
 }
 
 void LevelII::swapVolHeader()
@@ -50,9 +50,19 @@ class LevelII : public RadarData
   int ref_num_gates;
   int vel_num_gates;
   
-  void decode_ref(Ray* newRay, const char *buffer, short int numGates);
-  void decode_vel(Ray* newRay, const char *buffer, short int numGates, short int velRes);
-  void decode_sw(Ray* newRay, const char *buffer,  short int numGates);
+  // Copy the encoded moment into the volume and attach the copy, for
+  // records whose buffers are reused before the volume is done
+  void keep_ref(Ray* newRay, const char *buffer, short int numGates);
+  void keep_vel(Ray* newRay, const char *buffer, short int numGates, short int velRes);
+  void keep_sw(Ray* newRay, const char *buffer,  short int numGates);
+  // Point the ray at the encoded moment instead of decoding it; the
+  // buffer must stay valid for the life of the volume
+  void attach_ref(Ray* newRay, const char *buffer, short int numGates);
+  void attach_vel(Ray* newRay, const char *buffer, short int numGates, short int velRes);
+  void attach_sw(Ray* newRay, const char *buffer,  short int numGates);
+  static const float* refDecodeTable();
+  static const float* velDecodeTable(short int velRes);
+  static const float* swDecodeTable();
   long int volumeTime;
   short int volumeDate;
   void swapVolHeader();
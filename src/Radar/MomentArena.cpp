@@ -0,0 +1,86 @@
+/*
+ *  MomentArena.cpp
+ *  VORTRAC
+ *
+ *  Copyright 2026 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include "MomentArena.h"
+
+// Blocks left over from volumes that have been deleted
+static QMutex poolLock;
+static QVector<char*> blockPool;
+
+MomentArena::MomentArena()
+{
+}
+
+MomentArena::~MomentArena()
+{
+  release();
+}
+
+char* MomentArena::takeBlock()
+{
+  {
+    QMutexLocker locker(&poolLock);
+    if (!blockPool.isEmpty()) {
+      return blockPool.takeLast();
+    }
+  }
+  return new char[blockSize];
+}
+
+void MomentArena::returnBlocks(QVector<char*>& blocks)
+{
+  QMutexLocker locker(&poolLock);
+  for (int i = 0; i < blocks.size(); i++) {
+    if (blockPool.size() < maxPooledBlocks)
+      blockPool.append(blocks[i]);
+    else
+      delete [] blocks[i];
+  }
+  blocks.clear();
+}
+
+void* MomentArena::allocate(int sweep, Field field, int size)
+{
+  const int padded = (size + 7) & ~7;
+  QMutexLocker locker(&lock);
+
+  if (padded > blockSize) {
+    // Too big to share a block, and not worth pooling
+    char* large = new char[padded];
+    largeBlocks.append(large);
+    return large;
+  }
+
+  if (sweep < -1)
+    sweep = -1;
+  const int index = (sweep + 1) * NumFields + field;
+  if (index >= regions.size())
+    regions.resize(index + 1);
+
+  Region& region = regions[index];
+  if (region.left < padded) {
+    region.next = takeBlock();
+    region.left = blockSize;
+    blocks.append(region.next);
+  }
+  char* memory = region.next;
+  region.next += padded;
+  region.left -= padded;
+  return memory;
+}
+
+void MomentArena::release()
+{
+  QMutexLocker locker(&lock);
+  returnBlocks(blocks);
+  for (int i = 0; i < largeBlocks.size(); i++)
+    delete [] largeBlocks[i];
+  largeBlocks.clear();
+  regions.clear();
+}
@@ -0,0 +1,67 @@
+/*
+ *  MomentArena.h
+ *  VORTRAC
+ *
+ *  Copyright 2026 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#ifndef MOMENTARENA_H
+#define MOMENTARENA_H
+
+#include <QMutex>
+#include <QVector>
+
+// Bump allocator for the moment data of one radar volume. Each sweep and
+// field fills its own run of blocks, so the gates of one field in a sweep
+// are not interleaved with other sweeps or fields. Within the run they are
+// in the order the rays asked for them, which is the decoding order, and a
+// run moves on to a new block whenever the current one can't fit the next
+// ray. Nothing is freed until the volume goes away, and then the blocks go
+// back to a pool shared by all volumes, so reading the next volume does
+// not go back to the heap.
+
+class MomentArena
+{
+
+ public:
+  enum Field { Reflectivity, Velocity, SpectrumWidth, Encoded, NumFields };
+
+  MomentArena();
+  ~MomentArena();
+
+  // size bytes, 8 byte aligned, for a field of a ray in sweep (-1 if the
+  // sweep isn't known). Safe to call from several threads.
+  void* allocate(int sweep, Field field, int size);
+  float* allocateGates(int sweep, Field field, int numGates)
+    { return (float*)allocate(sweep, field, numGates * (int)sizeof(float)); }
+
+  // Give every block back to the pool
+  void release();
+
+ private:
+  // Not copyable, the rays point into it
+  MomentArena(const MomentArena&);
+  MomentArena& operator=(const MomentArena&);
+
+  struct Region {
+    Region() : next(NULL), left(0) {}
+    char* next;
+    int left;
+  };
+
+  static const int blockSize = 1 << 20;
+  static const int maxPooledBlocks = 256;
+
+  static char* takeBlock();
+  static void returnBlocks(QVector<char*>& blocks);
+
+  QMutex lock;
+  QVector<Region> regions;
+  QVector<char*> blocks;
+  QVector<char*> largeBlocks;
+
+};
+
+#endif
@@ -10,6 +10,7 @@
 
 #include "NcdcLevelII.h"
 #include "NRL/RadarQC.h"
+#include <cstring>
 
 NcdcLevelII::NcdcLevelII(const QString &radarname, const float &lat, const float &lon, const QString &filename) : LevelII(radarname, lat, lon, filename)
 {
@@ -22,6 +23,7 @@ NcdcLevelII::NcdcLevelII(const QString &radarname, const float &lat, const float
     //Sweeps = new Sweep[20];
     //Rays = new Ray[7500];
     //swap_bytes = false;
+    mappedVolume = NULL;
 
 }
 
@@ -42,42 +44,62 @@ bool NcdcLevelII::readVolume()
         return false;
     }
 
-    QDataStream dataIn(radarFile);
+    // Map the whole volume instead of copying it record by record. The
+    // mapping is private so the headers can still be byte swapped in place,
+    // and the rays decode their moments straight out of it on demand.
+    qint64 volumeSize = radarFile->size();
+    char* volume = (char *)radarFile->map(0, volumeSize, QFileDevice::MapPrivateOption);
+    if (volume != NULL) {
+        mappedVolume = (uchar *)volume;
+    } else {
+        // Can't map this file, so read it in one piece
+        volumeBuffer = radarFile->readAll();
+        radarFile->close();
+        volume = volumeBuffer.data();
+        volumeSize = volumeBuffer.size();
+    }
+    const char* const volumeEnd = volume + volumeSize;
 
     // Get volume header
-    dataIn.readRawData((char *)volHeader, sizeof(nexrad_vol_scan_title));
+    if (volumeSize < (qint64)sizeof(nexrad_vol_scan_title)) {
+        Message::report("Radar volume is too short");
+        return false;
+    }
+    memcpy(volHeader, volume, sizeof(nexrad_vol_scan_title));
     if (swap_bytes) {
         swapVolHeader();
     }
 
-    // Read in blocks of data
-    char* const headBuffer = new char[28];
-    char* const nexBuffer = new char[131054];
+    // Walk the blocks of data
+    const int headSize = sizeof(nexrad_message_header) + 12;
+    char* recPtr = volume + sizeof(nexrad_vol_scan_title);
     int recNum = 0;
-    //int recSize, headSize;
-    while (!dataIn.atEnd()) {
+    while (volumeEnd - recPtr >= headSize) {
 
         recNum++;
-        int recSize = 0;
-        int headSize = sizeof(nexrad_message_header) + 12;
-        dataIn.readRawData(headBuffer,headSize);
 
         // Skip the CTM info
-        char *headPtr = headBuffer + 12;
+        char *headPtr = recPtr + 12;
 
         // Read in the message header
         msgHeader = (nexrad_message_header *)headPtr;
         if (swap_bytes) {
             swapMsgHeader();
         }
-        // Read a variable # of bytes
+        // Records have a variable # of bytes
+        int recSize = 0;
         if (msgHeader->message_type == 31) {
-            recSize = (msgHeader->message_len)*2 + 12 - headSize;
+            recSize = (msgHeader->message_len)*2 + 12;
         } else {
-            recSize = 2432 - headSize;
+            recSize = 2432;
+        }
+        if ((recSize < headSize) || (volumeEnd - recPtr < recSize)) {
+            // Truncated record at the end of the file
+            break;
         }
-        dataIn.readRawData(nexBuffer,recSize);
-        char *readPtr = nexBuffer;
+        char *readPtr = recPtr + headSize;
+        const char* const recEnd = recPtr + recSize;
+        recPtr += recSize;
 
         if (msgHeader->message_type == 1) {
             // Got some fixed length data
@@ -110,25 +132,38 @@ bool NcdcLevelII::readVolume()
                 // New sweep
                 // Use Dennis' stuff here eventually
                 // Count up rays in sweep
-                Sweeps[numSweeps-1].setLastRay(numRays-1);
+                if (numSweeps > 0)
+                    Sweeps[numSweeps-1].setLastRay(numRays-1);
                 // Increment array
                 addSweep(&Sweeps[numSweeps]);
                 // Sweeps[numSweeps].setFirstRay(numRays);
 
             }
 
-            // Read ray of data
-            if (msg1Header->ref_ptr) {
+            // Read ray of data. addRay takes the gate counts from the
+            // header, so a moment that isn't all in the record gets no
+            // gates rather than a count with no data behind it.
+            const bool hasRef = msg1Header->ref_ptr &&
+                (readPtr + msg1Header->ref_ptr + msg1Header->ref_num_gates <= recEnd);
+            const bool hasVel = msg1Header->vel_ptr &&
+                (readPtr + msg1Header->vel_ptr + msg1Header->vel_num_gates <= recEnd);
+            const bool hasSw = msg1Header->sw_ptr &&
+                (readPtr + msg1Header->sw_ptr + msg1Header->vel_num_gates <= recEnd);
+            if (hasRef) {
                 char* const ref_buffer = readPtr + msg1Header->ref_ptr;
-                decode_ref(&Rays[numRays], ref_buffer, msg1Header->ref_num_gates);
-            }
-            if (msg1Header->vel_ptr) {
-                char* const vel_buffer = readPtr + msg1Header->vel_ptr;
-                decode_vel(&Rays[numRays], vel_buffer, msg1Header->vel_num_gates, msg1Header->velocity_resolution);
+                attach_ref(&Rays[numRays], ref_buffer, msg1Header->ref_num_gates);
+            } else {
+                msg1Header->ref_num_gates = 0;
             }
-            if (msg1Header->sw_ptr) {
+            if (hasSw) {
                 char* const sw_buffer = readPtr + msg1Header->sw_ptr;
-                decode_sw(&Rays[numRays], sw_buffer, msg1Header->vel_num_gates);
+                attach_sw(&Rays[numRays], sw_buffer, msg1Header->vel_num_gates);
+            }
+            if (hasVel) {
+                char* const vel_buffer = readPtr + msg1Header->vel_ptr;
+                attach_vel(&Rays[numRays], vel_buffer, msg1Header->vel_num_gates, msg1Header->velocity_resolution);
+            } else {
+                msg1Header->vel_num_gates = 0;
             }
 
             // Put more rays in the volume, associated with the current Sweep;
@@ -160,18 +195,14 @@ bool NcdcLevelII::readVolume()
                 }
             }
 
-            if (msg31Header->ref_ptr) {
-                ref_block = (moment_data_block *)(readPtr + msg31Header->ref_ptr);
-                if (swap_bytes) {
-                    swapMomentDataBlock(ref_block);
-                }
+            if (attachMoment(ref_block, msg31Header->ref_ptr, readPtr, recEnd)) {
                 QString blockID(ref_block->block_type);
                 if (blockID != QString("DREF")) {
                     // Report this ray
                     Message::report("Error in reflectivity block");
                 }
                 char* const ref_buffer = (char *)ref_block + sizeof(moment_data_block);
-                decode_ref(&Rays[numRays], ref_buffer, ref_block->num_gates);
+                attach_ref(&Rays[numRays], ref_buffer, ref_block->num_gates);
                 ref_num_gates = ref_block->num_gates;
                 ref_gate1 = ref_block->gate1;
                 ref_gate_width = ref_block->gate_width;
@@ -182,18 +213,14 @@ bool NcdcLevelII::readVolume()
                 ref_gate_width = 0;
             }
 
-            if (msg31Header->vel_ptr) {
-                vel_block = (moment_data_block *)(readPtr + msg31Header->vel_ptr);
-                if (swap_bytes) {
-                    swapMomentDataBlock(vel_block);
-                }
+            if (attachMoment(vel_block, msg31Header->vel_ptr, readPtr, recEnd)) {
                 QString blockID(vel_block->block_type);
                 if (blockID != QString("DVEL")) {
                     // Report this ray
                     Message::report("Error in velocity block");
                 }
                 char* const vel_buffer = (char *)vel_block + sizeof(moment_data_block);
-                decode_vel(&Rays[numRays], vel_buffer, vel_block->num_gates, vel_block->scale);
+                attach_vel(&Rays[numRays], vel_buffer, vel_block->num_gates, vel_block->scale);
                 vel_num_gates = vel_block->num_gates;
                 vel_gate1 = vel_block->gate1;
                 vel_gate_width = vel_block->gate_width;
@@ -204,13 +231,9 @@ bool NcdcLevelII::readVolume()
                 vel_gate_width = 0;
             }
 
-            if (msg31Header->sw_ptr) {
-                sw_block = (moment_data_block *)(readPtr + msg31Header->sw_ptr);
-                if (swap_bytes) {
-                    swapMomentDataBlock(sw_block);
-                }
+            if (attachMoment(sw_block, msg31Header->sw_ptr, readPtr, recEnd)) {
                 char* const sw_buffer = (char *)sw_block + sizeof(moment_data_block);
-                decode_sw(&Rays[numRays], sw_buffer, sw_block->num_gates);
+                attach_sw(&Rays[numRays], sw_buffer, sw_block->num_gates);
             }
 
 
@@ -236,7 +259,8 @@ bool NcdcLevelII::readVolume()
                 // New sweep
                 // Use Dennis' stuff here eventually
                 // Count up rays in sweep
-                Sweeps[numSweeps-1].setLastRay(numRays-1);
+                if (numSweeps > 0)
+                    Sweeps[numSweeps-1].setLastRay(numRays-1);
                 // Increment array
                 addSweep(&Sweeps[numSweeps]);
                 // Sweeps[numSweeps].setFirstRay(numRays);
@@ -256,16 +280,12 @@ bool NcdcLevelII::readVolume()
 
     }
     // Record the number of rays in the last sweep
-    Sweeps[numSweeps-1].setLastRay(numRays-1);
-
-    // Should have all the data stored into memory now
-    radarFile->close();
+    if (numSweeps > 0)
+        Sweeps[numSweeps-1].setLastRay(numRays-1);
 
+    // The rays still point into the mapped file, so it stays open
     isDealiased(false);
 
-    delete[] headBuffer;
-    delete[] nexBuffer;
-
     if(numSweeps < 5) {
       // Corrupt radar volume
       return false;
@@ -275,6 +295,39 @@ bool NcdcLevelII::readVolume()
 
 }
 
+bool NcdcLevelII::attachMoment(moment_data_block* &block, const int& blockPtr,
+                               const char* msgPtr, const char* recEnd)
+{
+    // Find a message 31 moment block and make sure all of its gates are
+    // inside the record before a ray points at them
+    block = NULL;
+    if (blockPtr <= 0)
+        return false;
+    const char* const blockStart = msgPtr + blockPtr;
+    if (recEnd - blockStart < (long)sizeof(moment_data_block)) {
+        Message::report("Moment block is outside of the record");
+        return false;
+    }
+    block = (moment_data_block *)blockStart;
+    if (swap_bytes) {
+        swapMomentDataBlock(block);
+    }
+    if ((block->num_gates < 0) ||
+        (recEnd - (blockStart + sizeof(moment_data_block)) < block->num_gates)) {
+        Message::report("Moment block is truncated");
+        block = NULL;
+        return false;
+    }
+    return true;
+}
+
 NcdcLevelII::~NcdcLevelII()
 {
+    // Rays are done with the moment data
+    if (mappedVolume != NULL) {
+        radarFile->unmap(mappedVolume);
+        mappedVolume = NULL;
+    }
+    if (radarFile->isOpen())
+        radarFile->close();
 }
@@ -11,6 +11,7 @@
 #ifndef NCDCLEVELII_H
 #define NCDCLEVELII_H
 
+#include <QByteArray>
 #include "LevelII.h"
 
 class NcdcLevelII : public LevelII
@@ -21,6 +22,13 @@ public:
     ~NcdcLevelII();
     bool readVolume();
 
+private:
+    // The volume stays mapped while the rays point into it
+    uchar* mappedVolume;
+    QByteArray volumeBuffer;
+    bool attachMoment(moment_data_block* &block, const int& blockPtr,
+                      const char* msgPtr, const char* recEnd);
+
 };
 
 #endif
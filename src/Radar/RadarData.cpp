@@ -10,6 +10,7 @@
 
 #include "RadarData.h"
 #include <math.h>
+#include <cstring>
 #include <QFile>
 #include <QTextStream>
 #include "Message.h"
@@ -37,6 +38,44 @@ RadarData::~RadarData()
   delete radarFile;
 }
 
+void RadarData::useMomentArena(int firstRay, int lastRay)
+{
+  for (int i = firstRay; i <= lastRay; i++)
+    Rays[i].setArena(&momentArena);
+}
+
+const void* RadarData::keepEncoded(const void *data, int size)
+{
+  void *copy = momentArena.allocate(-1, MomentArena::Encoded, size);
+  memcpy(copy, data, size);
+  return copy;
+}
+
+void RadarData::buildBeamGeometry()
+{
+  beamGeometry.clear(numSweeps);
+  for (int i = 0; i < numRays; i++) {
+    if (Rays[i].getRef_numgates() > 0)
+      getRefGeometry(&Rays[i]);
+    if (Rays[i].getVel_numgates() > 0)
+      getVelGeometry(&Rays[i]);
+  }
+}
+
+const BeamGeometry::Gates* RadarData::getRefGeometry(Ray* ray)
+{
+  return beamGeometry.lookup(ray->getSweepIndex(), ray->getElevation(),
+                             ray->getFirst_ref_gate(), ray->getRef_gatesp(),
+                             ray->getRef_numgates());
+}
+
+const BeamGeometry::Gates* RadarData::getVelGeometry(Ray* ray)
+{
+  return beamGeometry.lookup(ray->getSweepIndex(), ray->getElevation(),
+                             ray->getFirst_vel_gate(), ray->getVel_gatesp(),
+                             ray->getVel_numgates());
+}
+
 bool RadarData::readVolume()
 {
   
@@ -109,21 +148,8 @@ float* RadarData::getRadarLon()
 
 float RadarData::radarBeamHeight(float &distance, float elevation)
 {
-
-  const float REarth = 6371.0;
-  const float RE = 4*REarth/3;
-  const float REsq = RE * RE;
-
-  float elevRadians = elevation * acos(-1.0) / 180.0;
-  float sinelev = sin(elevRadians);
-  //float height = sqrt(distance * distance + REsq + 2.0 * distance * RE * sin(elevRadians)) - RE;
-  float top = distance*distance+2*distance*RE*sinelev;
-  float bottom =  sqrt(distance*distance + REsq + 2.*distance*RE*sinelev) + RE;
-  float height = top/bottom;
-  // height+=altitude;
-
-  return height; 
   // returns height in km
+  return BeamGeometry::height(distance, elevation);
 }
 
 float RadarData::absoluteRadarBeamHeight(float &distance, float elevation)
@@ -17,6 +17,8 @@
 #include <QDomElement>
 #include "Sweep.h"
 #include "Ray.h"
+#include "MomentArena.h"
+#include "BeamGeometry.h"
 
 class RadarData
 {
@@ -40,6 +42,12 @@ public:
     // returns height in km from radar;
     float absoluteRadarBeamHeight(float &distance, float elevation);
     // returns height in km from sea level;
+    // Range, height and effective elevation of each gate of a ray, shared
+    // by every ray with the same geometry
+    const BeamGeometry::Gates* getRefGeometry(Ray* ray);
+    const BeamGeometry::Gates* getVelGeometry(Ray* ray);
+    // Fill the tables for every ray once the volume has been read
+    void buildBeamGeometry();
     int getVCP() {return vcp;}
     void setAltitude(const float newAltitude);
     bool writeToFile(const QString fileName);
@@ -67,7 +75,18 @@ protected:
     int vcp;
     float altitude; // Tower height from sea level in km
 
+    // Moment buffers of every ray that uses it; freed with the volume
+    MomentArena momentArena;
+    void useMomentArena(int firstRay, int lastRay);
+
+    // Copy encoded moment data that the rays will decode later, for
+    // readers whose input buffers go away before the volume does. The copy
+    // lives until the volume is deleted and is 8 byte aligned.
+    const void* keepEncoded(const void *data, int size);
+
 private:
+
+    BeamGeometry beamGeometry;
     bool dealiased;
     float maxRange;   // max unambiguated range
     bool preGridded;
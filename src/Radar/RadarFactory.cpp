@@ -9,8 +9,13 @@
  */
 
 #include <iostream>
+#include <algorithm>
 #include <QPushButton>
+#include <QFileInfo>
 #include <unistd.h>
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#endif
 
 #include "RadarFactory.h"
 #include "DateChecker.h"
@@ -55,6 +60,11 @@ RadarFactory::RadarFactory(Configuration* radarConfig, QObject *parent): QObject
         // Will implement more later but give error for now
         emit log(Message("Data format not supported"));
     }
+
+    directoryScanned = false;
+    inputFilesOnly = false;
+    watchFd = -1;
+    watchDirectory();
 }
 
 RadarFactory::~RadarFactory()
@@ -62,6 +72,8 @@ RadarFactory::~RadarFactory()
     mainConfig = NULL;
     delete mainConfig;
     delete radarQueue;
+    if (watchFd >= 0)
+        close(watchFd);
 }
 
 RadarData* RadarFactory::getUnprocessedData()
@@ -77,16 +89,7 @@ RadarData* RadarFactory::getUnprocessedData()
     // Get the files off the queue
     QString fileName = dataPath.filePath(radarQueue->dequeue());
 
-    // Test file to make sure it is not growing
-    QFile radarFile(fileName);
-    qint64 newFilesize = radarFile.size();
-    qint64 prevFilesize = 0;
-    while (prevFilesize != newFilesize) {
-        prevFilesize = newFilesize;
-        sleep(1);
-        newFilesize = radarFile.size();
-    }
-    sleep(1);
+    // Files are only queued once they have stopped growing
     // Mark it as processed
     fileAnalyzed[fileName] = true;
 
@@ -148,29 +151,41 @@ RadarData* RadarFactory::getUnprocessedData()
 
 bool RadarFactory::hasUnprocessedData()
 {
-    // Check the unprocessed list first, if it has files no need to reread directory yet
+    // Check the unprocessed list first, if it has files no need to look at the directory yet
 
     if ( ! radarQueue->isEmpty() ) {
         return true;
     }
-
-    // Get a list of files in the radar directory
-
-    dataPath.setFilter(QDir::Files);
-    dataPath.setSorting(QDir::Name);
-    QStringList filenames = dataPath.entryList();
+    if (inputFilesOnly) {
+        return false;
+    }
 
     DateChecker *checker = DateCheckerFactory::newChecker(radarFormat);
+    QStringList candidates = pendingFiles;
+    pendingFiles.clear();
 
-    for (int i = 0; i < filenames.size(); i++) {
-      QString file = filenames.at(i);
-
-      if ( fileAnalyzed[dataPath.filePath(file)])	// been there, done that?
-	continue;
+    if (!directoryScanned) {
+        // Index the whole directory once
+        directoryModified = QFileInfo(dataPath.absolutePath()).lastModified();
+        dataPath.setFilter(QDir::Files);
+        dataPath.setSorting(QDir::Name);
+        // Everything the checker accepts, queued in time order below
+        indexFiles(dataPath.entryList(), checker, candidates);
+        directoryScanned = true;
+    } else {
+        // Only parse the files that showed up since the last look
+        QStringList newFiles;
+        if (directoryChanged(newFiles))
+            indexFiles(newFiles, checker, candidates);
+    }
 
-      // Get the date info from the file name
-      if(checker->fileInRange(file, radarName, startDateTime, endDateTime))
-	radarQueue->enqueue(file);
+    queueSettledFiles(candidates);
+    if (radarQueue->isEmpty() && !pendingFiles.isEmpty()) {
+        // Give files that are still being written a chance to finish
+        sleep(fileSettleSecs);
+        candidates = pendingFiles;
+        pendingFiles.clear();
+        queueSettledFiles(candidates);
     }
 
     delete checker;
@@ -486,6 +501,144 @@ void RadarFactory::updateDataQueue(const VortexList* list)
     }
 }
 
+void RadarFactory::setInputFiles(const QStringList& files)
+{
+    // Process just these files, in time order, instead of the data directory.
+    // They are used whatever the configured time window.
+    inputFilesOnly = true;
+    directoryScanned = true;
+    if (watchFd >= 0) {
+        close(watchFd);
+        watchFd = -1;
+    }
+
+    DateChecker *checker = DateCheckerFactory::newChecker(radarFormat);
+    QList<QPair<QDateTime, QString> > ordered;
+    for (int i = 0; i < files.size(); i++) {
+        QString file = QFileInfo(files.at(i)).absoluteFilePath();
+        QDateTime fileDateTime;
+        if (checker != NULL) {
+            checker->resetTime();
+            checker->fileInRange(file, radarName, startDateTime, endDateTime);
+            fileDateTime = checker->getTime();
+        }
+        fileTimes.insert(file, fileDateTime);
+        ordered.append(qMakePair(fileDateTime, file));
+    }
+    delete checker;
+
+    std::stable_sort(ordered.begin(), ordered.end());
+    radarQueue->clear();
+    for (int i = 0; i < ordered.size(); i++)
+        radarQueue->enqueue(ordered.at(i).second);
+}
+
+void RadarFactory::watchDirectory()
+{
+    // Ask the kernel for files that are closed after writing or moved into
+    // the data directory. Elsewhere the directory time stamp is checked.
+#ifdef Q_OS_LINUX
+    watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watchFd < 0)
+        return;
+    QByteArray path = dataPath.absolutePath().toLocal8Bit();
+    if (inotify_add_watch(watchFd, path.constData(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(watchFd);
+        watchFd = -1;
+    }
+#endif
+}
+
+bool RadarFactory::directoryChanged(QStringList& newFiles)
+{
+    bool rescan = false;
+
+#ifdef Q_OS_LINUX
+    if (watchFd >= 0) {
+        char buffer[8192] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+        ssize_t length;
+        while ((length = read(watchFd, buffer, sizeof(buffer))) > 0) {
+            char *ptr = buffer;
+            while (ptr < buffer + length) {
+                const struct inotify_event *event = (const struct inotify_event *)ptr;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    // Missed some events, fall back to a listing
+                    rescan = true;
+                } else if ((event->len > 0) && !(event->mask & IN_ISDIR)) {
+                    QString file = QString::fromLocal8Bit(event->name);
+                    if (!newFiles.contains(file))
+                        newFiles.append(file);
+                }
+                ptr += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        if (!rescan)
+            return !newFiles.isEmpty();
+    }
+#endif
+
+    if (!rescan) {
+        // No watcher, so only list the directory when it has been modified
+        QFileInfo dirInfo(dataPath.absolutePath());
+        if (dirInfo.lastModified() == directoryModified)
+            return false;
+        directoryModified = dirInfo.lastModified();
+    }
+
+    // Rewritten files keep their place in the index; only new names are parsed
+    dataPath.setFilter(QDir::Files);
+    dataPath.setSorting(QDir::Name);
+    QStringList files = dataPath.entryList();
+    for (int i = 0; i < files.size(); i++) {
+        if (!fileTimes.contains(files.at(i)) && !newFiles.contains(files.at(i)))
+            newFiles.append(files.at(i));
+    }
+    return !newFiles.isEmpty();
+}
+
+void RadarFactory::indexFiles(const QStringList& files, DateChecker* checker,
+                              QStringList& candidates)
+{
+    // Parse each new file name once and keep the ones in the time window
+    // that have not been analyzed yet
+    for (int i = 0; i < files.size(); i++) {
+        const QString& file = files.at(i);
+        if (fileTimes.contains(file))
+            continue;
+        // Names the checker can't parse are remembered without a time, so
+        // they are not parsed again
+        checker->resetTime();
+        bool inRange = checker->fileInRange(file, radarName, startDateTime, endDateTime);
+        QDateTime fileDateTime = checker->getTime();
+        fileTimes.insert(file, fileDateTime);
+        if (inRange && !fileAnalyzed[dataPath.filePath(file)])
+            candidates.append(file);
+    }
+}
+
+void RadarFactory::queueSettledFiles(QStringList& candidates)
+{
+    // Queue the candidates in time order. Files that were modified in the
+    // last few seconds may still be growing and wait for the next look.
+    QList<QPair<QDateTime, QString> > ordered;
+    for (int i = 0; i < candidates.size(); i++)
+        ordered.append(qMakePair(fileTimes.value(candidates.at(i)), candidates.at(i)));
+    std::stable_sort(ordered.begin(), ordered.end());
+
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    for (int i = 0; i < ordered.size(); i++) {
+        const QString& file = ordered.at(i).second;
+        if (radarQueue->contains(file) || pendingFiles.contains(file))
+            continue;
+        QFileInfo fileInfo(dataPath.filePath(file));
+        if (fileInfo.lastModified().toUTC().secsTo(now) < fileSettleSecs)
+            pendingFiles.append(file);
+        else
+            radarQueue->enqueue(file);
+    }
+    candidates.clear();
+}
+
 int RadarFactory::getNumProcessed() const
 {
     // Returns the number of volumes that RadarFactory has sent to be processed
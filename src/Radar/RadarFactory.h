@@ -17,6 +17,7 @@
 #include <QDomElement>
 #include <QQueue>
 #include <QHash>
+#include <QMap>
 #include "Radar/RadarData.h"
 #include "Radar/LevelII.h"
 #include "Radar/NcdcLevelII.h"
@@ -28,6 +29,8 @@
 #include "GUI/ConfigTree.h"
 #include "DataObjects/VortexList.h"
 
+class DateChecker;
+
 class RadarFactory : public QObject
 {
 
@@ -40,6 +43,7 @@ public:
     RadarData* getUnprocessedData();
     bool hasUnprocessedData();
     int getNumProcessed() const;
+    void setInputFiles(const QStringList& files);
 
     enum dataFormat {
       ncdclevelII,
@@ -72,6 +76,21 @@ private:
     QHash<QString, bool> fileAnalyzed;
     QDateTime radarDateTime;
     Configuration* mainConfig;
+
+    // Every file name is parsed once, and the directory is only read
+    // again when it changes.
+    QHash<QString, QDateTime> fileTimes;
+    QStringList pendingFiles;
+    bool directoryScanned;
+    bool inputFilesOnly;
+    QDateTime directoryModified;
+    int watchFd;
+    static const int fileSettleSecs = 2;
+
+    void watchDirectory();
+    bool directoryChanged(QStringList& newFiles);
+    void indexFiles(const QStringList& files, DateChecker* checker, QStringList& candidates);
+    void queueSettledFiles(QStringList& candidates);
 };
 
 #endif
@@ -32,13 +32,11 @@ RadxData::~RadxData()
   Rays = NULL;
 }
 
-// TODO
-// This essentially takes an array of float from the Radx library, and shove it into an array
-// of float in the Radar object.
-// See if we can change the RadarData interface to access the Radx data directly
-// - Maybe put a handle to the field instead of the arrays
+// Copy a field of the ray in its native encoding into the volume, and
+// fill in how the ray should decode it. The float values are only made when
+// something asks for them. Returns false if the ray doesn't have the field.
 
-float *RadxData::getRayData(RadxRay *fileRay, const char *fieldName)
+bool RadxData::keepRayData(RadxRay *fileRay, const char *fieldName, Ray::RawMoment &raw)
 {
   const RadxRay::FieldNameMap fieldMap = fileRay->getFieldNameMap();
 
@@ -49,37 +47,42 @@ float *RadxData::getRayData(RadxRay *fileRay, const char *fieldName)
   name_it = fieldMap.find(fieldName);
 
   if (name_it == fieldMap.end())
-    return NULL;
+    return false;
 
   RadxField *field = fileRay->getField(name_it->second);
   //Error with getField -BS 
   //RadxField *field =fileRay->getFieldNameMap();
   if (field == NULL)
-    return NULL;
+    return false;
 
-  float *retVal = new float[field->getNPoints()];
-  if (retVal == NULL) {
-    std::cerr << "RadxData::fillRayData: Failed to allocate data array" << std::endl;
-    return NULL;
+  raw.table = NULL;
+  raw.numGates = field->getNPoints();
+  raw.scale = field->getScale();
+  raw.offset = field->getOffset();
+
+  switch (field->getDataType()) {
+  case Radx::SI08:
+    raw.encoding = Ray::Scaled8;
+    raw.missing = field->getMissingSi08();
+    break;
+  case Radx::SI16:
+    raw.encoding = Ray::Scaled16;
+    raw.missing = field->getMissingSi16();
+    break;
+  default:
+    // Anything else is kept as float32
+    field->convertToFl32();
+    // fall through
+  case Radx::FL32:
+    raw.encoding = Ray::Float32;
+    // When homebrew picks up the fixed version, setMissingFl32(-999.0)
+    // could be used instead of the missing value check in Ray
+    raw.missing = field->getMissingFl32();
+    break;
   }
 
-  // Convert field to float32
-  field->convertToFl32();
-
-  // When homebrew picks up the fixed version, uncomment the next line, and remove the check
-  // for missingFl32.
-  // field->setMissingFl32(-999.0);
-
-  const float missing32 = field->getMissingFl32();
-
-  const Radx::fl32 *fieldPtr = field->getDataFl32();
-  for(size_t index = 0; index < field->getNPoints(); index++) {
-    float val = fieldPtr[index];
-    if (val == missing32)
-      val = -999.0;
-    retVal[index] = val;
-  }
-  return retVal;
+  raw.data = keepEncoded(field->getData(), field->getNPoints() * field->getByteWidth());
+  return true;
 }
 
 bool RadxData::readVolume()
@@ -115,6 +118,7 @@ bool RadxData::readVolume()
 
   Sweeps = new Sweep[numSweeps];
   Rays = new Ray[numRays];
+  useMomentArena(0, numRays - 1);
 
   // Iterate on the rays (since they have info we need for the sweep)
 
@@ -168,19 +172,19 @@ bool RadxData::readVolume()
     // With file.setReadPreserveSweeps(true) above (to match what the old reader was doing),
     //    we might have long rays that don't have VEL and SW
 
-    myRay->setRefData(getRayData(fileRay, "REF"));
-    myRay->setVelData(getRayData(fileRay, "VEL"));
-    myRay->setSwData( getRayData(fileRay, "SW"));
+    Ray::RawMoment raw;
+    if (keepRayData(fileRay, "REF", raw))
+      myRay->setRawRefData(raw);
 
-    // Lots of algorithms (QC Cappi, can't deal with missing Vel)
-    // So fill in the Velocity data with -999)
+    // Rays without velocity have no velocity gates, as in the Level II
+    // readers, so the QC and gridding loops pass over them
+    if (keepRayData(fileRay, "VEL", raw))
+      myRay->setRawVelData(raw);
+    else
+      myRay->setVel_numgates(0);
 
-    if(myRay->getVelData() == NULL) {
-      float *buffer = new float[nGates];
-      for(int i = 0; i < nGates; i++)
-	buffer[i] = -999;
-      myRay->setVelData(buffer);
-    }
+    if (keepRayData(fileRay, "SW", raw))
+      myRay->setRawSwData(raw);
   }
 
   // Iterate on the sweeps
@@ -13,7 +13,7 @@ class RadxData : public RadarData
   ~RadxData();
 
   bool readVolume();
-  float *getRayData(RadxRay *fileRay, const char *fieldName);
+  bool keepRayData(RadxRay *fileRay, const char *fieldName, Ray::RawMoment &raw);
   
 };
 
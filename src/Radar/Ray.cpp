@@ -13,6 +13,7 @@
 
 Ray::Ray()
 {
+  arena = NULL;
   sweepIndex = -999;
   time = -999;
   date = -999;
@@ -23,6 +24,7 @@ Ray::Ray()
   refData = NULL;
   velData = NULL;
   swData = NULL;
+  rawRef = rawVel = rawSw = codedMoment(NULL, 0, NULL);
   unambig_range = -999;
   nyquist_vel = -999;
   first_ref_gate = -999;
@@ -36,6 +38,8 @@ Ray::Ray()
 
 Ray::~Ray()
 {
+  // Arena buffers go with the volume
+  if (arena != NULL) return;
   if (refData != NULL) delete [] refData;
   if (velData != NULL) delete [] velData;
   if (swData != NULL) delete [] swData;
@@ -71,16 +75,91 @@ void Ray::setSweepIndex(const int &value) {
   sweepIndex = value;
 }
 
+float* Ray::allocateGates(MomentArena::Field field, const short int numGates) {
+  if (arena != NULL)
+    return arena->allocateGates(sweepIndex, field, numGates);
+  return new float[numGates];
+}
+
 void Ray::allocateRefData(const short int numGates) {
-  refData = new float[numGates];
+  refData = allocateGates(MomentArena::Reflectivity, numGates);
+  rawRef.data = NULL;
 }
 
 void Ray::allocateVelData(const short int numGates) {
-  velData = new float[numGates];
+  velData = allocateGates(MomentArena::Velocity, numGates);
+  rawVel.data = NULL;
 }
 
 void Ray::allocateSwData(const short int numGates) {
-  swData = new float[numGates];
+  swData = allocateGates(MomentArena::SpectrumWidth, numGates);
+  rawSw.data = NULL;
+}
+
+Ray::RawMoment Ray::codedMoment(const unsigned char *buffer, const short int numGates,
+				const float *table) {
+  RawMoment raw;
+  raw.data = buffer;
+  raw.table = table;
+  raw.numGates = numGates;
+  raw.encoding = Coded8;
+  raw.scale = 1;
+  raw.offset = 0;
+  raw.missing = -999;
+  return raw;
+}
+
+void Ray::setRawRefData(const unsigned char *buffer, const short int numGates,
+			const float *table) {
+  rawRef = codedMoment(buffer, numGates, table);
+}
+
+void Ray::setRawVelData(const unsigned char *buffer, const short int numGates,
+			const float *table) {
+  rawVel = codedMoment(buffer, numGates, table);
+}
+
+void Ray::setRawSwData(const unsigned char *buffer, const short int numGates,
+		       const float *table) {
+  rawSw = codedMoment(buffer, numGates, table);
+}
+
+float* Ray::decodeMoment(RawMoment &raw, MomentArena::Field field) {
+  const short int numGates = raw.numGates;
+  float *decoded = allocateGates(field, numGates);
+  switch (raw.encoding) {
+  case Coded8: {
+    // Table lookup keeps the decoded values identical to the eager decoders
+    const unsigned char *encoded = (const unsigned char *)raw.data;
+    const float *table = raw.table;
+    for (short int i = 0; i < numGates; i++)
+      decoded[i] = table[encoded[i]];
+    break;
+  }
+  case Scaled8: {
+    const signed char *encoded = (const signed char *)raw.data;
+    for (short int i = 0; i < numGates; i++)
+      decoded[i] = (encoded[i] == raw.missing) ? -999.0f
+	: (float)(encoded[i] * raw.scale + raw.offset);
+    break;
+  }
+  case Scaled16: {
+    const short int *encoded = (const short int *)raw.data;
+    for (short int i = 0; i < numGates; i++)
+      decoded[i] = (encoded[i] == raw.missing) ? -999.0f
+	: (float)(encoded[i] * raw.scale + raw.offset);
+    break;
+  }
+  case Float32: {
+    const float *encoded = (const float *)raw.data;
+    const float missing = (float)raw.missing;
+    for (short int i = 0; i < numGates; i++)
+      decoded[i] = (encoded[i] == missing) ? -999.0f : encoded[i];
+    break;
+  }
+  }
+  raw.data = NULL;
+  return decoded;
 }
 
 void Ray::setUnambig_range(const float &value) {
@@ -151,14 +230,20 @@ int Ray::getSweepIndex() {
 }
 
 float* Ray::getRefData() {
+  if ((refData == NULL) && (rawRef.data != NULL))
+    refData = decodeMoment(rawRef, MomentArena::Reflectivity);
   return refData;
 }
 
 float* Ray::getVelData() {
+  if ((velData == NULL) && (rawVel.data != NULL))
+    velData = decodeMoment(rawVel, MomentArena::Velocity);
   return velData;
 }
 
 float* Ray::getSwData() {
+  if ((swData == NULL) && (rawSw.data != NULL))
+    swData = decodeMoment(rawSw, MomentArena::SpectrumWidth);
   return swData;
 }
 
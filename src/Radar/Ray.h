@@ -11,6 +11,8 @@
 #ifndef RAY_H
 #define RAY_H
 
+#include "MomentArena.h"
+
 class Ray
 {
 
@@ -44,9 +46,46 @@ class Ray
   void setVcp(const int &value);
   void emptyRefgates(const short int numGates);
 
-  void setRefData(float *buffer) { refData = buffer; };
-  void setVelData(float *buffer) { velData = buffer; };
-  void setSwData(float *buffer)  { swData = buffer; };
+  // Take the gate buffers from the volume's arena instead of the heap.
+  // The Ray then never frees its buffers, including ones passed to
+  // setRefData and friends, which must come from the same arena.
+  void setArena(MomentArena *volumeArena) { arena = volumeArena; }
+
+  void setRefData(float *buffer) { refData = buffer; rawRef.data = 0; };
+  void setVelData(float *buffer) { velData = buffer; rawVel.data = 0; };
+  void setSwData(float *buffer)  { swData = buffer; rawSw.data = 0; };
+
+  // Encodings a moment can be left in until it is first used
+  enum Encoding {
+    Coded8,     // unsigned byte codes, looked up in a 256 entry table
+    Scaled8,    // signed bytes, value = code * scale + offset
+    Scaled16,   // signed shorts, value = code * scale + offset
+    Float32
+  };
+
+  struct RawMoment {
+    const void *data;
+    const float *table;
+    short int numGates;
+    Encoding encoding;
+    double scale;
+    double offset;
+    double missing;   // stored value meaning no data, decoded to -999
+  };
+
+  // Leave a moment in its archive encoding. The gates are decoded to
+  // float the first time the data is asked for, so fields that are never
+  // used are never expanded. The encoded data is not copied and must
+  // outlive the Ray. A moment that was never set costs nothing and its
+  // data is NULL.
+  void setRawRefData(const RawMoment &raw) { rawRef = raw; }
+  void setRawVelData(const RawMoment &raw) { rawVel = raw; }
+  void setRawSwData(const RawMoment &raw)  { rawSw = raw; }
+  void setRawRefData(const unsigned char *buffer, const short int numGates, const float *table);
+  void setRawVelData(const unsigned char *buffer, const short int numGates, const float *table);
+  void setRawSwData(const unsigned char *buffer, const short int numGates, const float *table);
+  static RawMoment codedMoment(const unsigned char *buffer, const short int numGates,
+			       const float *table);
   
   int getTime();
   int getDate();
@@ -74,6 +113,10 @@ class Ray
   void dumpFloat(int size, float *buf);
   
  private:
+  float* allocateGates(MomentArena::Field field, const short int numGates);
+  float* decodeMoment(RawMoment &raw, MomentArena::Field field);
+
+  MomentArena *arena;
   int sweepIndex;
   int time;
   int date;
@@ -84,6 +127,9 @@ class Ray
   float *refData;
   float *velData;
   float *swData;
+  RawMoment rawRef;
+  RawMoment rawVel;
+  RawMoment rawSw;
   float unambig_range;
   float nyquist_vel;
   int first_ref_gate;
@@ -9,6 +9,7 @@
  */
 
 #include <QtGui>
+#include <QtConcurrentMap>
 #include <math.h>
 #include "SimplexThread.h"
 #include "DataObjects/Coefficient.h"
@@ -28,13 +29,12 @@ SimplexThread::SimplexThread(QObject* parent):QObject(parent)
     configData = NULL;
 
     _dataGaps = NULL;
-    _vtdCoeffs = NULL;
+    _vtd = NULL;
+    _iterations = 0;
 }
 
 SimplexThread::~SimplexThread()
 {
-    delete   _simplexVTD;
-    delete[] _vtdCoeffs;
     delete[] _dataGaps;
 }
 
@@ -58,9 +58,9 @@ bool SimplexThread::findCenter(SimplexList* simplexList)
     //STEP 1: retrieve all the parameters for Simplex algorithm
 
     QDomElement simplexCfg = configData->getConfig("center");
-    QString geometry = configData->getParam(simplexCfg,QString("geometry"));
-    QString velField = configData->getParam(simplexCfg,QString("velocity"));
-    QString closure = configData->getParam(simplexCfg,QString("closure"));
+    _geometry = configData->getParam(simplexCfg,QString("geometry"));
+    _velField = configData->getParam(simplexCfg,QString("velocity"));
+    _closure = configData->getParam(simplexCfg,QString("closure"));
 
     firstLevel= configData->getParam(simplexCfg,QString("bottomlevel")).toFloat();
     lastLevel = configData->getParam(simplexCfg,QString("toplevel")).toFloat();
@@ -79,26 +79,22 @@ bool SimplexThread::findCenter(SimplexList* simplexList)
     float boxRowLength = sqrt(numPoints);
     float boxIncr = boxSize / (sqrt(numPoints) - 1);
 
-    float radiusOfInfluence = configData->getParam(simplexCfg,QString("influenceradius")).toFloat();
-    float convergeCriterion = configData->getParam(simplexCfg,QString("convergence")).toFloat();
-    float maxIterations = configData->getParam(simplexCfg,QString("maxiterations")).toFloat();
+    _radiusOfInfluence = configData->getParam(simplexCfg,QString("influenceradius")).toFloat();
+    _convergeCriterion = configData->getParam(simplexCfg,QString("convergence")).toFloat();
+    _maxIterations = configData->getParam(simplexCfg,QString("maxiterations")).toFloat();
     float ringWidth = configData->getParam(simplexCfg,QString("ringwidth")).toFloat();
-    int   maxWave = configData->getParam(simplexCfg,QString("maxwavenumber")).toInt();
+    _maxWave = configData->getParam(simplexCfg,QString("maxwavenumber")).toInt();
 
     // Define the maximum allowable data gaps
 
-    _dataGaps = new float[maxWave+1];
-    for (int i = 0; i <= maxWave; i++) {
+    delete[] _dataGaps;
+    _dataGaps = new float[_maxWave+1];
+    for (int i = 0; i <= _maxWave; i++) {
         _dataGaps[i] = configData->getParam(simplexCfg, QString("maxdatagap"), QString("wavenum"),
 					    QString().setNum(i)).toFloat();
     }
 
-    //SETP 2: initialize a VTD object for whole simplex to use
-
-    _simplexVTD = VTDFactory::createVTD(geometry, closure, maxWave, _dataGaps);
-    _vtdCoeffs  = new Coefficient[20];
-
-    //STEP 3: perform simplex algorithm
+    //STEP 2: perform simplex algorithm
 
     // Set ring width in cappi so that griddedData access function use this
 
@@ -117,23 +113,23 @@ bool SimplexThread::findCenter(SimplexList* simplexList)
     // the ring count should be divided by the ring width
     simplexData->setNumPointsUsed((int)numPoints);
 
-    // Allocate memory for the vertices
-    float** vertex = new float*[3];
-    vertex[0 ]= new float[2];
-    vertex[1] = new float[2];
-    vertex[2] = new float[2];
-    float* VT = new float[3];
-    float* vertexSum = new float[2];
-
-    // Loop through the levels and rings,
+    // Loop through the levels and rings and lay out the work. Every initial
+    // guess is an independent search, so they are all handed to the thread
+    // pool at once and the results are combined below in the original order.
     // TODO Should this have some reference to grid spacing?
     // see GriddedData::setAbsoluteReferencePoint
     // TODO firstLevel is 1. How come not 0.5?
 
+    QList<float> cellHeight;
+    QList<float> cellRadius;
+    QList<bool> cellInside;
+    QVector<SimplexTask> tasks;
+
     // for (float height = firstLevel; height <= lastLevel; height++) {
     for (float height = firstLevel; height <= lastLevel; height += gridData->getKGridsp()) {
         for (float radius = firstRing; radius <= lastRing; radius++) {
 
+            gridData->prepareCylindricalRing(radius);
             gridData->setAbsoluteReferencePoint(_latGuess, _lonGuess, height);
             // Set the corner of the box
             float CornerI = gridData->getCartesianRefPointI();
@@ -145,22 +141,18 @@ bool SimplexThread::findCenter(SimplexList* simplexList)
             float RefI = CornerI;
             float RefJ = CornerJ;
 
+            int cell = cellHeight.size();
+            cellHeight.append(height);
+            cellRadius.append(radius);
+
             if ((gridData->getRefPointI() < 0) || (gridData->getRefPointJ() < 0) || (gridData->getRefPointK() < 0))  {
                 emit log(Message(QString("Initial simplex guess is outside CAPPI"),0,this->objectName()));
-                archiveNull(simplexData, radius, height, numPoints);
+                cellInside.append(false);
                 continue;
             }
+            cellInside.append(true);
 
-            // Initialize mean values
-
-            int meanCount = 0;
-            meanXall = meanYall = meanVTall = 0;
-            meanX = meanY = meanVT = 0;
-            stdDevVertexAll = stdDevVTAll = 0;
-            stdDevVertex = stdDevVT = 0;
-            convergingCenters = 0;
-
-            // Loop through the initial guesses
+            // Lay out the initial guesses
 	    // std::cout << "** Num of points: " << numPoints << std::endl;
 
             for (int point = 0; point < numPoints; point++) {
@@ -171,110 +163,202 @@ bool SimplexThread::findCenter(SimplexList* simplexList)
 
                 RefJ = CornerJ + float(point / int(boxRowLength)) * boxIncr;
 
-                startX[point] = RefI;
-                startY[point] = RefJ;
-
-                // Initialize vertices
-                float sqr32 = 0.866025;
-                vertex[0][0] = RefI;
-                vertex[0][1] = RefJ + radiusOfInfluence;
-                vertex[1][0] = RefI + sqr32 * radiusOfInfluence;
-                vertex[1][1] = RefJ - 0.5 * radiusOfInfluence;
-                vertex[2][0] = RefI - sqr32 * radiusOfInfluence;
-                vertex[2][1] = RefJ - 0.5 * radiusOfInfluence;
-                vertexSum[0] = 0;
-                vertexSum[1] = 0;
-
-                for (int v = 0; v <= 2; v++) {
-		  //Calculate mean wind at each vertex
-		  VT[v] = _getSymWind(vertex[v][0], vertex[v][1], int(RefK), radius, height, velField);
-                }
-
-                // Run the simplex search loop
-                float VTsolution = .0, Xsolution = 0. , Ysolution=0.;
-                _getVertexSum(vertex, vertexSum);
-                _centerIterate(vertex, vertexSum, VT, maxIterations, convergeCriterion, RefK, radius,
-			       height, velField, VTsolution, Xsolution, Ysolution);
-
-                // Done with simplex loop, should have values for the current point
-                if ((VTsolution < 100.) and (VTsolution > 0.)) {
-                    // Add to sum
-                    meanXall  += Xsolution;
-                    meanYall  += Ysolution;
-                    meanVTall += VTsolution;
-                    meanCount++;
-                    // Add to array for storage
-                    endX[point]  = Xsolution;
-                    endY[point]  = Ysolution;
-                    VTind[point] = VTsolution;
-                } else {
-                    endX[point]  = Center::_fillv;
-                    endY[point]  = Center::_fillv;
-                    VTind[point] = Center::_fillv;
-                }
-            } //point loop end
+                SimplexTask task;
+                task.cell = cell;
+                task.point = point;
+                task.height = height;
+                task.radius = radius;
+                task.RefK = RefK;
+                task.startX = RefI;
+                task.startY = RefJ;
+                tasks.append(task);
+            }
+        } //ring loop end
+    } //height loop end
 
-	    // std::cout << "Mean count before: " << meanCount << std::endl;
+    // Run the simplex searches. The VTD object is shared, each task
+    // brings its own workspace.
+    _iterations = 0;
+    _vtd = VTDFactory::createVTD(_geometry, _closure, _maxWave, _dataGaps);
+    if (_vtd == NULL) {
+        delete simplexData;
+        return false;
+    }
+    QtConcurrent::blockingMap(tasks, TaskRunner(this));
+    delete _vtd;
+    _vtd = NULL;
+
+    // Combine the guesses for each level and ring
+    int nextTask = 0;
+    for (int cell = 0; cell < cellHeight.size(); cell++) {
+        float height = cellHeight[cell];
+        float radius = cellRadius[cell];
+        if (!cellInside[cell]) {
+            archiveNull(simplexData, radius, height, numPoints);
+            continue;
+        }
 
-            if (meanCount == 0) {
-                archiveNull(simplexData, radius, height, numPoints);
+        // Initialize mean values
+
+        int meanCount = 0;
+        meanXall = meanYall = meanVTall = 0;
+        meanX = meanY = meanVT = 0;
+        stdDevVertexAll = stdDevVTAll = 0;
+        stdDevVertex = stdDevVT = 0;
+        convergingCenters = 0;
+
+        for (int point = 0; point < numPoints; point++) {
+            const SimplexTask& task = tasks[nextTask++];
+            _iterations += task.iterations;
+            if (task.missingVTC0)
+                emit log(Message("Error retrieving VTC0 in simplex!"));
+            if (task.iterationsExceeded)
+                emit log(Message(QString("Maximum iterations exceeded in Simplex"),0,this->objectName()));
+
+            startX[point] = task.startX;
+            startY[point] = task.startY;
+            float VTsolution = task.VT;
+            float Xsolution = task.endX;
+            float Ysolution = task.endY;
+
+            // Done with simplex loop, should have values for the current point
+            if ((VTsolution < 100.) and (VTsolution > 0.)) {
+                // Add to sum
+                meanXall  += Xsolution;
+                meanYall  += Ysolution;
+                meanVTall += VTsolution;
+                meanCount++;
+                // Add to array for storage
+                endX[point]  = Xsolution;
+                endY[point]  = Ysolution;
+                VTind[point] = VTsolution;
             } else {
-                meanXall = meanXall / float(meanCount);
-                meanYall = meanYall / float(meanCount);
-                meanVTall = meanVTall / float(meanCount);
-                for (int i = 0; i < numPoints; i++) {
-                    if ((endX[i] != -999.) and (endY[i] != -999.) and (VTind[i] != -999.)) {
-                        stdDevVertexAll += ((endX[i] - meanXall)
-					    * (endX[i] - meanXall) + (endY[i] - meanYall)
-					    * (endY[i] - meanYall));
-                        stdDevVTAll += (VTind[i] - meanVTall) * (VTind[i] - meanVTall);
-                    }
+                endX[point]  = Center::_fillv;
+                endY[point]  = Center::_fillv;
+                VTind[point] = Center::_fillv;
+            }
+        } //point loop end
+
+        // std::cout << "Mean count before: " << meanCount << std::endl;
+
+        if (meanCount == 0) {
+            archiveNull(simplexData, radius, height, numPoints);
+        } else {
+            meanXall = meanXall / float(meanCount);
+            meanYall = meanYall / float(meanCount);
+            meanVTall = meanVTall / float(meanCount);
+            for (int i = 0; i < numPoints; i++) {
+                if ((endX[i] != -999.) and (endY[i] != -999.) and (VTind[i] != -999.)) {
+                    stdDevVertexAll += ((endX[i] - meanXall)
+                                        * (endX[i] - meanXall) + (endY[i] - meanYall)
+                                        * (endY[i] - meanYall));
+                    stdDevVTAll += (VTind[i] - meanVTall) * (VTind[i] - meanVTall);
                 }
-                stdDevVertexAll = sqrt(stdDevVertexAll/float(meanCount - 1));
-                stdDevVTAll = sqrt(stdDevVTAll/float(meanCount - 1));
-
-                // Now remove centers beyond 1 standard deviation
-                meanCount = 0;
-                for (int i = 0; i < numPoints; i++) {
-                    if ((endX[i] != -999.) and (endY[i] != -999.) and (VTind[i] != -999.)) {
-                        float vertexDist = sqrt((endX[i] - meanXall) * (endX[i] - meanXall)
-						+ (endY[i] - meanYall) * (endY[i] - meanYall));
-                        if (vertexDist < stdDevVertexAll) {
-                            Xconv[meanCount] = endX[i];
-                            Yconv[meanCount] = endY[i];
-                            VTconv[meanCount] = VTind[i];
-                            meanX += endX[i];
-                            meanY += endY[i];
-                            meanVT+= VTind[i];
-                            meanCount++;
-                        }
+            }
+            stdDevVertexAll = sqrt(stdDevVertexAll/float(meanCount - 1));
+            stdDevVTAll = sqrt(stdDevVTAll/float(meanCount - 1));
+
+            // Now remove centers beyond 1 standard deviation
+            meanCount = 0;
+            for (int i = 0; i < numPoints; i++) {
+                if ((endX[i] != -999.) and (endY[i] != -999.) and (VTind[i] != -999.)) {
+                    float vertexDist = sqrt((endX[i] - meanXall) * (endX[i] - meanXall)
+                                            + (endY[i] - meanYall) * (endY[i] - meanYall));
+                    if (vertexDist < stdDevVertexAll) {
+                        Xconv[meanCount] = endX[i];
+                        Yconv[meanCount] = endY[i];
+                        VTconv[meanCount] = VTind[i];
+                        meanX += endX[i];
+                        meanY += endY[i];
+                        meanVT+= VTind[i];
+                        meanCount++;
                     }
                 }
-		// std::cout << "Mean count after: " << meanCount << std::endl;
-
-                if (meanCount == 0) {
-                    archiveNull(simplexData, radius, height, numPoints);
-                } else {
-                    meanX = meanX / float(meanCount);
-                    meanY = meanY / float(meanCount);
-                    meanVT = meanVT / float(meanCount);
-                    convergingCenters = meanCount;
-                    for (int i = 0; i < convergingCenters - 1; i++) {
-                        stdDevVertex += ((Xconv[i] - meanX) * (Xconv[i] - meanX)+ (Yconv[i] - meanY) * (Yconv[i] - meanY));
-                        stdDevVT += (VTconv[i] - meanVT) * (VTconv[i] - meanVT);
-                    }
-                    stdDevVertex = sqrt(stdDevVertex / float(meanCount - 1));
-                    stdDevVT = sqrt(stdDevVT / float(meanCount - 1));
+            }
+            // std::cout << "Mean count after: " << meanCount << std::endl;
 
-                    // All done with this radius and height, archive it
-                    archiveCenters(simplexData, radius, height, numPoints);
+            if (meanCount == 0) {
+                archiveNull(simplexData, radius, height, numPoints);
+            } else {
+                meanX = meanX / float(meanCount);
+                meanY = meanY / float(meanCount);
+                meanVT = meanVT / float(meanCount);
+                convergingCenters = meanCount;
+                for (int i = 0; i < convergingCenters - 1; i++) {
+                    stdDevVertex += ((Xconv[i] - meanX) * (Xconv[i] - meanX)+ (Yconv[i] - meanY) * (Yconv[i] - meanY));
+                    stdDevVT += (VTconv[i] - meanVT) * (VTconv[i] - meanVT);
                 }
+                stdDevVertex = sqrt(stdDevVertex / float(meanCount - 1));
+                stdDevVT = sqrt(stdDevVT / float(meanCount - 1));
+
+                // All done with this radius and height, archive it
+                archiveCenters(simplexData, radius, height, numPoints);
             }
-        } //ring loop end
-    } //height loop end
+        }
+    } //level and ring loop end
 
     simplexList->append(*simplexData);
     delete simplexData;
+
+    return true;
+}
+
+void SimplexThread::_runTask(SimplexTask& task) const
+{
+    // Set up private scratch space so nothing is shared with other tasks
+    SimplexWorkspace work;
+    work.vtdCoeffs = new Coefficient[20];
+    work.ringSize = gridData->getCylindricalAzimuthMaxLength(task.radius, task.height);
+    work.vtdWork.reserve(work.ringSize, _maxWave);
+    work.ringData = new float[work.ringSize];
+    work.ringAzimuths = new float[work.ringSize];
+    work.iterations = 0;
+    work.iterationsExceeded = false;
+    work.missingVTC0 = false;
+
+    // Allocate memory for the vertices
+    float** vertex = new float*[3];
+    vertex[0 ]= new float[2];
+    vertex[1] = new float[2];
+    vertex[2] = new float[2];
+    float* VT = new float[3];
+    float* vertexSum = new float[2];
+
+    float RefI = task.startX;
+    float RefJ = task.startY;
+    float RefK = task.RefK;
+    float radius = task.radius;
+    float height = task.height;
+
+    // Initialize vertices
+    float sqr32 = 0.866025;
+    vertex[0][0] = RefI;
+    vertex[0][1] = RefJ + _radiusOfInfluence;
+    vertex[1][0] = RefI + sqr32 * _radiusOfInfluence;
+    vertex[1][1] = RefJ - 0.5 * _radiusOfInfluence;
+    vertex[2][0] = RefI - sqr32 * _radiusOfInfluence;
+    vertex[2][1] = RefJ - 0.5 * _radiusOfInfluence;
+    vertexSum[0] = 0;
+    vertexSum[1] = 0;
+
+    for (int v = 0; v <= 2; v++) {
+        //Calculate mean wind at each vertex
+        VT[v] = _getSymWind(work, vertex[v][0], vertex[v][1], int(RefK), radius, height);
+    }
+
+    // Run the simplex search loop
+    float VTsolution = .0, Xsolution = 0. , Ysolution=0.;
+    _getVertexSum(vertex, vertexSum);
+    _centerIterate(work, vertex, vertexSum, VT, _maxIterations, _convergeCriterion, RefK, radius,
+                   height, VTsolution, Xsolution, Ysolution);
+
+    task.VT = VTsolution;
+    task.endX = Xsolution;
+    task.endY = Ysolution;
+    task.iterations = work.iterations;
+    task.iterationsExceeded = work.iterationsExceeded;
+    task.missingVTC0 = work.missingVTC0;
+
     // Deallocate memory for the vertices
     delete[] vertex[0];
     delete[] vertex[1];
@@ -283,7 +367,9 @@ bool SimplexThread::findCenter(SimplexList* simplexList)
     delete[] VT;
     delete[] vertexSum;
 
-    return true;
+    delete[] work.vtdCoeffs;
+    delete[] work.ringData;
+    delete[] work.ringAzimuths;
 }
 
 void SimplexThread::archiveCenters(SimplexData* simplexData, float radius, float height, float numPoints)
@@ -339,7 +425,7 @@ void SimplexThread::catchLog(const Message& message)
     emit log(message);
 }
 
-inline void SimplexThread::_getVertexSum(float** vertex,float* vertexSum)
+inline void SimplexThread::_getVertexSum(float** vertex,float* vertexSum) const
 {
 
     float sum;
@@ -351,42 +437,38 @@ inline void SimplexThread::_getVertexSum(float** vertex,float* vertexSum)
     }
 }
 
-float SimplexThread::_simplexTest(float**& vertex,float*& VT,float*& vertexSum,
+float SimplexThread::_simplexTest(SimplexWorkspace& work, float**& vertex,float*& VT,float*& vertexSum,
                                  float& radius, float& height, float& RefK,
-                                 QString& velField, int& low, double factor)
+                                 int& low, double factor) const
 {
     // Test a simplex vertex
     float VTtest = -999;
-    float* vertexTest = new float[2];
+    float vertexTest[2];
     float factor1 = (1.0 - factor)/2;
     float factor2 = factor1 - factor;
     for (int i=0; i<=1; i++)
         vertexTest[i] = vertexSum[i]*factor1 - vertex[low][i]*factor2;
 
     // Get the data
-    gridData->setCartesianReferencePoint(int(vertexTest[0]),int(vertexTest[1]),int(RefK));
-    int numData = gridData->getCylindricalAzimuthLength(radius, height);
-    float* ringData = new float[numData];
-    float* ringAzimuths = new float[numData];
-    gridData->getCylindricalAzimuthData(velField, numData, radius, height, ringData);
-    gridData->getCylindricalAzimuthPosition(numData, radius, height, ringAzimuths);
+    float refI = gridData->getReferenceIndexI(int(vertexTest[0]));
+    float refJ = gridData->getReferenceIndexJ(int(vertexTest[1]));
+    int numData = gridData->getCylindricalAzimuthRing(_velField, refI, refJ, radius, height,
+                                                      work.ringSize, work.ringData, work.ringAzimuths);
 
     // Call vtd
-    if (_simplexVTD->analyzeRing(vertexTest[0], vertexTest[1], radius, height, numData,
-				 ringData,ringAzimuths, _vtdCoeffs, vtdStdDev)) {
-        if (_vtdCoeffs[0].getParameter() == "VTC0") {
-            VTtest = _vtdCoeffs[0].getValue();
+    float vtdStdDev;
+    if (_vtd->analyzeRing(vertexTest[0], vertexTest[1], radius, height, numData,
+                          work.ringData, work.ringAzimuths, work.vtdCoeffs, vtdStdDev, work.vtdWork)) {
+        if (work.vtdCoeffs[0].getParameter() == Coefficient::VTC0) {
+            VTtest = work.vtdCoeffs[0].getValue();
         } else {
-            emit log(Message("Error retrieving VTC0 in simplex!"));
+            work.missingVTC0 = true;
         }
     } else {
         VTtest = -999;
         // emit log(Message("Not enough data in simplex ring"));
     }
 
-    delete[] ringData;
-    delete[] ringAzimuths;
-
     // If its a better point than the worst, replace it
     if (VTtest > VT[low]) {
         VT[low] = VTtest;
@@ -395,47 +477,42 @@ float SimplexThread::_simplexTest(float**& vertex,float*& VT,float*& vertexSum,
             vertex[low][i] = vertexTest[i];
         }
     }
-    delete[] vertexTest;
     return VTtest;
 
 }
 
-float SimplexThread::_getSymWind(float vertex_x,float vertex_y,int RefK,float radius,float height,QString velField)
+float SimplexThread::_getSymWind(SimplexWorkspace& work, float vertex_x,float vertex_y,int RefK,float radius,float height) const
 {
     float VT=-999.0f;
-    gridData->setCartesianReferencePoint(int(vertex_x),int(vertex_y),RefK);
-    int numData = gridData->getCylindricalAzimuthLength(radius, height);    // TODO
-    float* ringData = new float[numData];
-    float* ringAzimuths = new float[numData];
-    gridData->getCylindricalAzimuthData(velField, numData, radius, height, ringData);
+    float refI = gridData->getReferenceIndexI(int(vertex_x));
+    float refJ = gridData->getReferenceIndexJ(int(vertex_y));
     // azimuth data should look like sine wave
-    gridData->getCylindricalAzimuthPosition(numData, radius, height, ringAzimuths);
+    int numData = gridData->getCylindricalAzimuthRing(_velField, refI, refJ, radius, height,
+                                                      work.ringSize, work.ringData, work.ringAzimuths);
 #if 0
     // TODO debug
     for(int d = 0; d < numData; d++) {
-      std::cout <<  "d: " << d << " val: " << ringData[d]
-		<< " azimuth: " << ringAzimuths[d] << std::endl;
+      std::cout <<  "d: " << d << " val: " << work.ringData[d]
+		<< " azimuth: " << work.ringAzimuths[d] << std::endl;
     }
 #endif
-    Coefficient*  vtdCoeffs=new Coefficient[20];
     float   vtdStdDev;
 
     // vtCoeff[0..numCoeffs].value will be set by this call
 
-    if (_simplexVTD->analyzeRing(vertex_x, vertex_y, radius, height, numData, ringData, ringAzimuths, vtdCoeffs, vtdStdDev)) {
-        if (vtdCoeffs[0].getParameter() == "VTC0")
-            VT = vtdCoeffs[0].getValue();
+    if (_vtd->analyzeRing(vertex_x, vertex_y, radius, height, numData, work.ringData,
+                          work.ringAzimuths, work.vtdCoeffs, vtdStdDev, work.vtdWork)) {
+        if (work.vtdCoeffs[0].getParameter() == Coefficient::VTC0)
+            VT = work.vtdCoeffs[0].getValue();
     }
 
-    delete[] ringData;
-    delete[] ringAzimuths;
-    delete[] vtdCoeffs;
     return VT;
 }
 
-void SimplexThread::_centerIterate(float** vertex, float* vertexSum, float* VT, int maxIterations, float convergeCriterion,
-                                   float RefK, float radius, float height, QString velField,
-                                   float& VTsolution, float& Xsolution, float& Ysolution)
+void SimplexThread::_centerIterate(SimplexWorkspace& work, float** vertex, float* vertexSum, float* VT,
+                                   int maxIterations, float convergeCriterion,
+                                   float RefK, float radius, float height,
+                                   float& VTsolution, float& Xsolution, float& Ysolution) const
 {
     VTsolution = Xsolution = Ysolution = 0.0f;
 
@@ -466,26 +543,26 @@ void SimplexThread::_centerIterate(float** vertex, float* vertexSum, float* VT,
 
         // Check iterations
         if (numIterations > maxIterations) {
-            emit log(Message(QString("Maximum iterations exceeded in Simplex"),0,this->objectName()));
+            work.iterationsExceeded = true;
             break;
         }
 
         numIterations += 2;
         // Reflection
-        float VTtest = _simplexTest(vertex, VT, vertexSum, radius, height,RefK, velField, low, -1.0);
+        float VTtest = _simplexTest(work, vertex, VT, vertexSum, radius, height,RefK, low, -1.0);
         if (VTtest >= VT[high])
             // Better point than highest, so try expansion
-            VTtest = _simplexTest(vertex, VT, vertexSum, radius, height,RefK, velField, low, 2.0);
+            VTtest = _simplexTest(work, vertex, VT, vertexSum, radius, height,RefK, low, 2.0);
         else if (VTtest <= VT[mid]) {
             // Worse point than second highest, so try contraction
             float VTsave = VT[low];
-            VTtest = _simplexTest(vertex, VT, vertexSum, radius, height,RefK, velField, low, 0.5);
+            VTtest = _simplexTest(work, vertex, VT, vertexSum, radius, height,RefK, low, 0.5);
             if (VTtest <= VTsave) {
                 for (int v=0; v<=2; v++) {
                     if (v != high) {
                         for (int i=0; i<=1; i++)
                             vertex[v][i] = vertexSum[i] = 0.5*(vertex[v][i] + vertex[high][i]);
-                        VT[v]=_getSymWind(vertex[v][0],vertex[v][1],int(RefK),radius,height,velField);
+                        VT[v]=_getSymWind(work, vertex[v][0],vertex[v][1],int(RefK),radius,height);
                     }
                 }
                 numIterations += 2;
@@ -495,4 +572,5 @@ void SimplexThread::_centerIterate(float** vertex, float* vertexSum, float* VT,
         else
             --numIterations;
     }
+    work.iterations = numIterations;
 }
@@ -34,6 +34,8 @@ public:
     ~SimplexThread();
     void initParam(Configuration *wholeConfig, GriddedData *dataPtr,float latGuess, float lonGuess);
     bool findCenter(SimplexList* simplexList);
+    // Simplex iterations of all the searches in the last findCenter
+    long getIterations() const { return _iterations; }
 
 public slots:
     void catchLog(const Message& message);
@@ -42,20 +44,53 @@ signals:
     void log(const Message& message);
 
 private:
+    // One (level, ring, initial guess) simplex search. Tasks only read the
+    // grid and write their own results, so they can run in any order.
+    class SimplexTask {
+    public:
+        int cell;
+        int point;
+        float height;
+        float radius;
+        float RefK;
+        float startX, startY;
+        float endX, endY, VT;
+        int iterations;
+        bool iterationsExceeded;
+        bool missingVTC0;
+    };
+
+    // Per-task scratch space: VTD workspace, coefficients and ring buffers
+    class SimplexWorkspace {
+    public:
+        VTDWorkspace vtdWork;
+        Coefficient* vtdCoeffs;
+        float* ringData;
+        float* ringAzimuths;
+        int ringSize;
+        int iterations;
+        bool iterationsExceeded;
+        bool missingVTC0;
+    };
+
+    class TaskRunner {
+    public:
+        TaskRunner(const SimplexThread* simplex) : simplex(simplex) {}
+        typedef void result_type;
+        void operator()(SimplexTask& task) const { simplex->_runTask(task); }
+    private:
+        const SimplexThread* simplex;
+    };
+
     GriddedData   *gridData;
     Configuration *configData;
     float _latGuess;
     float _lonGuess;
     float* _dataGaps;
-    VTD* _simplexVTD;
-    Coefficient* _vtdCoeffs;
-    float* VT;
-    float* vertexSum;
     float firstLevel;
     float lastLevel;
     float firstRing;
     float lastRing;
-    float vtdStdDev;
     float meanXall, meanYall, meanVTall;
     float meanX, meanY, meanVT;
     float stdDevVertexAll, stdDevVTAll;
@@ -65,19 +100,30 @@ private:
     float Xconv[25],Yconv[25],VTconv[25];
     float startX[25], startY[25];
 
+    // Read-only search settings shared by all tasks
+    QString _geometry;
+    QString _closure;
+    QString _velField;
+    int _maxWave;
+    float _radiusOfInfluence;
+    float _convergeCriterion;
+    float _maxIterations;
+    VTD* _vtd;
+    long _iterations;
 
     void archiveCenters(SimplexData* simplexData,float radius,float height,float numPoints);
     void archiveNull(SimplexData* simplexData,float& radius,float& height,float& numPoints);
-    inline void _getVertexSum(float** vertex,float* vertexSum);
-    float _simplexTest(float**& vertex, float*& VT, float*& vertexSum,
+    inline void _getVertexSum(float** vertex,float* vertexSum) const;
+    float _simplexTest(SimplexWorkspace& work, float**& vertex, float*& VT, float*& vertexSum,
                       float& radius, float& height, float& RefK,
-                      QString& velField, int& high,double factor);
+                      int& high,double factor) const;
 
     // Choosecenter variables
     float velNull;
-    float _getSymWind(float vertex_x,float vertex_y,int RefK,float radius,float height,QString velField);
-    void  _centerIterate(float** vertex,float* vertexSum, float* VT,int maxIterations,float convergeCriterion,
-                          float RefK,float radius,float height,QString velField,float& VTsolution,float& Xsolution,float& Ysolution);
+    void  _runTask(SimplexTask& task) const;
+    float _getSymWind(SimplexWorkspace& work, float vertex_x,float vertex_y,int RefK,float radius,float height) const;
+    void  _centerIterate(SimplexWorkspace& work, float** vertex,float* vertexSum, float* VT,int maxIterations,float convergeCriterion,
+                          float RefK,float radius,float height,float& VTsolution,float& Xsolution,float& Ysolution) const;
 };
 
 #endif
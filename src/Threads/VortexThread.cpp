@@ -9,6 +9,8 @@
  */
 
 #include <QtGui>
+#include <QtConcurrentMap>
+#include <QElapsedTimer>
 #include <math.h>
 #include "VortexThread.h"
 #include "DataObjects/Coefficient.h"
@@ -46,6 +48,10 @@ VortexThread::VortexThread(QObject *parent) : QObject(parent)
     pressureList = NULL;
     configData = NULL;
     dataGaps = NULL;
+    metrics = NULL;
+
+    connect(&hvvpService, SIGNAL(log(const Message&)), this, SLOT(catchLog(const Message&)),
+            Qt::DirectConnection);
 }
 
 VortexThread::~VortexThread()
@@ -65,6 +71,8 @@ void VortexThread::getWinds(Configuration *wholeConfig, GriddedData *dataPtr, Ra
     vortexData = vortexPtr;
     // Set the configuration info
     configData = wholeConfig;
+    hvvpService.setConfig(configData);
+    hvvpService.setRadarData(radarVolume);
 
     run();
 }
@@ -96,6 +104,9 @@ void VortexThread::run()
     vortexData->setAveRMW(rmw);
     // RMW is the average rmw taken over all levels of the vortexData
 
+    QElapsedTimer stageClock;
+    stageClock.start();
+
     // Create a {GB|G}VTD object to process the rings
 
     hvvpResult = 0.0;
@@ -111,6 +122,7 @@ void VortexThread::run()
     vtd = VTDFactory::createVTD(geometry, closure, maxWave, dataGaps,
 				hvvpResult);
     Coefficient* vtdCoeffs = new Coefficient[20];
+    VTDWorkspace vtdWork;
 
     // Placeholders for centers
 
@@ -127,6 +139,7 @@ void VortexThread::run()
 
     // How do I get simplexData->getNumLevels() from here?
     int maxIndex = (int) floor( (lastLevel - firstLevel) / kGridSpacing + 1.5);
+    long rings = 0;
 
     for(storageIndex = 0; storageIndex < maxIndex; storageIndex++) {
 
@@ -161,13 +174,8 @@ void VortexThread::run()
 
         float* distance = gridData->getCartesianPoint(&radarLat, &radarLon, &vortexLat, &vortexLon);
         float rt = sqrt(distance[0]*distance[0]+distance[1]*distance[1]);
-        float cca = atan2(distance[0], distance[1])*180/acos(-1);
         delete [] distance;
 
-        Hvvp *hvvp = new Hvvp;
-        hvvp->setConfig(configData);
-        hvvp->setRadarData(radarVolume, rt, cca, vortexData->getAveRMW());
-
 	float Vm = 0.0;
 
         // should we be incrementing radius using ringwidth? -LM
@@ -177,16 +185,17 @@ void VortexThread::run()
             yCenter = gridData->getCartesianRefPointJ();
 
             // Get the data
-            int numData = gridData->getCylindricalAzimuthLength(radius, height);
-            float* ringData = new float[numData];
-            float* ringAzimuths = new float[numData];
-            gridData->getCylindricalAzimuthData(velField, numData, radius, height, ringData);
-            gridData->getCylindricalAzimuthPosition(numData, radius, height, ringAzimuths);
+            int maxData = gridData->getCylindricalAzimuthMaxLength(radius, height);
+            float* ringData = new float[maxData];
+            float* ringAzimuths = new float[maxData];
+            int numData = gridData->getCylindricalAzimuthRing(velField, radius, height, maxData,
+                                                              ringData, ringAzimuths);
 
             // Call gbvtd
+            rings++;
             if (vtd->analyzeRing(xCenter, yCenter, radius, height, numData, ringData,
-                                 ringAzimuths, vtdCoeffs, vtdStdDev)) {
-                if (vtdCoeffs[0].getParameter() == "VTC0") {
+                                 ringAzimuths, vtdCoeffs, vtdStdDev, vtdWork)) {
+                if (vtdCoeffs[0].getParameter() == Coefficient::VTC0) {
                     // VT[v] = vtdCoeffs[0].getValue();
                     if(vtdCoeffs[0].getValue() != -999.f){
                         vtdCoeffs[0].setValue( vtdCoeffs[0].getValue()-Vm*radius/rt );
@@ -214,6 +223,12 @@ void VortexThread::run()
 
     // Clean up
     delete vtd;
+    // The HVVP fits are timed as a stage of their own
+    qint64 vtdHvvpMsecs = hvvpService.getFitMsecs();
+    if (metrics != NULL) {
+        metrics->addTime("vtd", stageClock.restart() - vtdHvvpMsecs);
+        metrics->addCount("vtd_rings", rings);
+    }
 
     // Integrate the winds to get the pressure deficit at the 2nd level (presumably 2km)
     // Gradient height is in km
@@ -236,6 +251,16 @@ void VortexThread::run()
 
     delete [] vtdCoeffs;
     delete [] pressureDeficit;
+    if (metrics != NULL) {
+        metrics->addTime("pressure", stageClock.elapsed() - (hvvpService.getFitMsecs() - vtdHvvpMsecs));
+        if (closure.contains(QString("hvvp"), Qt::CaseInsensitive)) {
+            metrics->addTime("hvvp", hvvpService.getFitMsecs());
+            metrics->addCount("hvvp_fits", hvvpService.getVolumeFits());
+        }
+    }
+
+    if (closure.contains(QString("hvvp"), Qt::CaseInsensitive))
+        emit log(Message(hvvpService.counterSummary(), 0, this->objectName()));
 }
 
 void VortexThread::archiveWinds(float radius, int hIndex, int maxCoeffs, Coefficient* vtdCoeffs)
@@ -245,13 +270,13 @@ void VortexThread::archiveWinds(float radius, int hIndex, int maxCoeffs, Coeffic
     int ring = int(radius - firstRing);
 
     for (int coeff = 0; coeff < maxCoeffs; coeff++) {
-        vortexData->setCoefficient(level, ring, coeff, vtdCoeffs[coeff]);
+        vortexData->setCoefficient(level, ring, vtdCoeffs[coeff]);
         Coefficient current = vtdCoeffs[coeff];
 
 	// DEBUG
 	// std::cout << "level: " << current.getLevel()
 	// 	  << ", radius: " << current.getRadius() << ", value: " << current.getValue()
-	// 	  << ", param: " << current.getParameter().toLatin1().data()
+	// 	  << ", param: " << current.getParameterName().toLatin1().data()
 	// 	  << std::endl;
 
 	if((current.getValue() != -999) && (current.getValue() != 0)) {
@@ -261,18 +286,18 @@ void VortexThread::archiveWinds(float radius, int hIndex, int maxCoeffs, Coeffic
     }
 }
 
-void VortexThread::archiveWinds(VortexData& data, float& radius, int& hIndex, int& maxCoeffs, Coefficient* vtdCoeffs)
+void VortexThread::archiveWinds(VortexData& data, float& radius, int& hIndex, int& maxCoeffs, Coefficient* vtdCoeffs) const
 {
     // Save the centers to the VortexData object
     int level = hIndex;
     int ring = int(radius - firstRing);
 
     for (int coeff = 0; coeff < maxCoeffs; coeff++) {
-        data.setCoefficient(level, ring, coeff, vtdCoeffs[coeff]);
+        data.setCoefficient(level, ring, vtdCoeffs[coeff]);
     }
 }
 
-void VortexThread::getPressureDeficit(VortexData* data, float* pDeficit,const float& height)
+void VortexThread::getPressureDeficit(VortexData* data, float* pDeficit,const float& height) const
 {
     float* dpdr = new float[ (int) lastRing + 1];
 
@@ -292,9 +317,9 @@ void VortexThread::getPressureDeficit(VortexData* data, float* pDeficit,const fl
     float f = 2 * 7.29e-5 * sin(data->getLat(heightIndex) * 3.141592653589793238462643 / 180.);
 
     for (float radius = firstRing; radius <= lastRing; radius++) {
-      // if (!(data->getCoefficient(height, radius, QString("VTC0")) == Coefficient())) {
-      if ( (data->getCoefficient(height, radius, QString("VTC0"))).isValid()) {
-            float meanVT = data->getCoefficient(height, radius, QString("VTC0")).getValue();
+      // if (!(data->getCoefficient(height, radius, Coefficient::VTC0) == Coefficient())) {
+      if ( (data->getCoefficient(height, radius, Coefficient::VTC0)).isValid()) {
+            float meanVT = data->getCoefficient(height, radius, Coefficient::VTC0).getValue();
             if (meanVT != 0) {
                 dpdr[(int)radius] = ((f * meanVT) + (meanVT * meanVT)/(radius * deltar)) * rhoBar[ (int) height - 1];
             }
@@ -430,7 +455,6 @@ void VortexThread::calcPressureUncertainty(float setLimit, QString nameAddition)
     // Acquire vortexData center uncertainty for the second level we examined
     int goodLevel = heightToIndex(gradientHeight);
     float height = vortexData->getHeight(goodLevel);
-    int   maxCoeffs = maxWave * 2 + 3;
     float centerStd = vortexData->getCenterStdDev(goodLevel);
 
     //Message::toScreen("VortexThread: CalcPressureUncertainty: Uncertainty of center from vortexData is "+QString().setNum(centerStd));
@@ -442,8 +466,7 @@ void VortexThread::calcPressureUncertainty(float setLimit, QString nameAddition)
     if(nameAddition!=QString())
         nameAddition = nameAddition+QString().setNum(centerStd);
 
-    // Now move this amount of space in each cardinal direction to get 4 additional pressure estimates
-    int numErrorPoints = 4;
+    // Now move this amount of space in numErrorPoints directions to get additional pressure estimates
     float angle = 2 * acos(-1) / numErrorPoints;
 
     // Create a {GB|G}VTD object to process the rings
@@ -462,16 +485,20 @@ void VortexThread::calcPressureUncertainty(float setLimit, QString nameAddition)
     vtd = VTDFactory::createVTD(geometry, closure, maxWave, dataGaps,
 				hvvpResult);
 
-    Coefficient* vtdCoeffs = new Coefficient[20];
-    VortexList errorVertices;
     float refLat = vortexData->getLat(goodLevel);
     float refLon = vortexData->getLon(goodLevel);
-    float sqDeficitSum = 0;
 
+    // Lay out the perturbed centers. The grid's reference point is only
+    // used here, the tasks get the indices.
+    QVector<PerturbationTask> tasks(numErrorPoints);
     for(int p = 0; p < numErrorPoints; p++) {
-        VortexData* errorVertex = new VortexData(1, vortexData->getNumRadii(), vortexData->getNumWaveNum());
-        errorVertex->setTime(vortexData->getTime().addDays(p).addYears(2));
-        errorVertex->setHeight(0, vortexData->getHeight(goodLevel));
+        PerturbationTask& task = tasks[p];
+        task.height = height;
+        task.level = goodLevel;
+        task.missingVTC0 = false;
+        task.rings = 0;
+        task.pressure = -999;
+        task.deficit = -999;
         // Set the reference point
         float* newLatLon = gridData->getAdjustedLatLon(refLat, refLon,
 						       centerStd * cos(p * angle),
@@ -479,91 +506,51 @@ void VortexThread::calcPressureUncertainty(float setLimit, QString nameAddition)
         gridData->setAbsoluteReferencePoint(newLatLon[0], newLatLon[1], height);
         delete  [] newLatLon;
 
-        if ((gridData->getRefPointI() < 0) || (gridData->getRefPointJ() < 0) || (gridData->getRefPointK() < 0)) {
+        task.inside = (gridData->getRefPointI() >= 0) && (gridData->getRefPointJ() >= 0)
+            && (gridData->getRefPointK() >= 0);
+        task.refI = gridData->getRefPointI();
+        task.refJ = gridData->getRefPointJ();
+        task.xCenter = gridData->getCartesianRefPointI();
+        task.yCenter = gridData->getCartesianRefPointJ();
+    }
+    for (float radius = firstRing; radius <= lastRing; radius++)
+        gridData->prepareCylindricalRing(radius);
+
+    // The VTD object is shared, each task brings its own workspace
+    QtConcurrent::blockingMap(tasks, PerturbationRunner(this));
+    delete vtd;
+    vtd = NULL;
+
+    float sqDeficitSum = 0;
+    QList<float> errorPressures;
+    long rings = 0;
+    for(int p = 0; p < numErrorPoints; p++) {
+        const PerturbationTask& task = tasks[p];
+        rings += task.rings;
+        if (!task.inside) {
             // Out of bounds problem
             emit log(Message(QString("Error Vertex is outside CAPPI"), 0, this->objectName()));
             continue;
         }
-
-        for (float radius = firstRing; radius <= lastRing; radius++) {
-            // Get the cartesian points
-            float xCenter = gridData->getCartesianRefPointI();
-            float yCenter = gridData->getCartesianRefPointJ();
-
-            // Get the data
-            int numData = gridData->getCylindricalAzimuthLength(radius, height);
-            float* ringData = new float[numData];
-            float* ringAzimuths = new float[numData];
-
-            gridData->getCylindricalAzimuthData(velField, numData, radius, height, ringData);
-            gridData->getCylindricalAzimuthPosition(numData, radius, height, ringAzimuths);
-
-            // Call gbvtd
-            if (vtd->analyzeRing(xCenter, yCenter, radius, height, numData, ringData, ringAzimuths, vtdCoeffs, vtdStdDev)) {
-                if (vtdCoeffs[0].getParameter() != "VTC0") {
-                    emit log(Message(QString("CalcPressureUncertainty:Error retrieving VTC0 in vortex!"), 0, this->objectName()));
-                }
-
-                // All done with this radius and height, archive it
-                archiveWinds(*errorVertex, radius, goodLevel, maxCoeffs, vtdCoeffs);
-
-                // Clean up
-                delete[] ringData;
-                delete[] ringAzimuths;
-            }
+        if (task.missingVTC0) {
+            emit log(Message(QString("CalcPressureUncertainty:Error retrieving VTC0 in vortex!"), 0, this->objectName()));
         }
-        // Now calculate central pressure for each of these
-        float* errorPressureDeficit = new float[(int)lastRing + 1];
-        getPressureDeficit(errorVertex,errorPressureDeficit, height);
-        errorVertex->setPressureDeficit(fabs(*errorPressureDeficit));
 
         // Sum for Deficit Uncertainty
-        sqDeficitSum += (errorVertex->getPressureDeficit() - vortexData->getPressureDeficit())
-	  * (errorVertex->getPressureDeficit() - vortexData->getPressureDeficit());
-
-        // Add in uncertainty from multiple pressure measurements
-        if(_presObs.size() < 1){
-            // No outside data available use the 1013 bit.
-            errorVertex->setPressure(1013 - (errorPressureDeficit[(int)lastRing] - errorPressureDeficit[0]));
-            errorVertex->setPressureDeficit(errorPressureDeficit[(int)lastRing] - errorPressureDeficit[0]);
-        }
-        else {
-            for(int j = 0; j < _presObs.size(); j++) {
-
-                float obPressure = _presObs[j].getPressure();
-                float vortexLat = errorVertex->getLat(0);
-                float vortexLon = errorVertex->getLon(0);
-                float obLat = _presObs[j].getLat();
-                float obLon = _presObs[j].getLon();
-                float* relDist = gridData->getCartesianPoint(&vortexLat, &vortexLon, &obLat, &obLon);
-                float obRadius = sqrt(relDist[0] * relDist[0] + relDist[1] * relDist[1]);
-                delete [] relDist;
-                float pPrimeOuter;
-                if (obRadius >= lastRing) {
-                    pPrimeOuter = errorPressureDeficit[(int)lastRing];
-                } else {
-                    pPrimeOuter = errorPressureDeficit[(int)obRadius];
-                }
-                //Message::toScreen("Calculating uncertainty calib "+QString().setNum(j)+" = "+QString().setNum(obPressure)+" @ "+QString().setNum(obRadius));
-                errorVertex->setPressure(obPressure - (pPrimeOuter - errorPressureDeficit[0]));
-                errorVertex->setPressureDeficit(errorPressureDeficit[(int)lastRing] - errorPressureDeficit[0]);
-            }
-        }
-        errorVertices.append(*errorVertex);
-        delete [] errorPressureDeficit;
-        delete errorVertex;
+        sqDeficitSum += (task.deficit - vortexData->getPressureDeficit())
+	  * (task.deficit - vortexData->getPressureDeficit());
+        errorPressures.append(task.pressure);
     }
-
-    delete[] vtdCoeffs;
-    delete vtd;
+    if (metrics != NULL)
+        metrics->addCount("uncertainty_rings", rings);
 
     // Standard deviation from the center point
     float sqPressureSum = 0;
-    for(int i = 1; i < errorVertices.count();i++) {
-        float prsDelta=errorVertices.at(i).getPressure() - vortexData->getPressure();
+    for(int i = 1; i < errorPressures.count();i++) {
+        float prsDelta=errorPressures.at(i) - vortexData->getPressure();
         sqPressureSum += pow(prsDelta, 2);
     }
-    float pressureUncertainty = sqrt(sqPressureSum / (errorVertices.count() - 2));
+    float pressureUncertainty = sqrt(sqPressureSum / (errorPressures.count() - 2));
     float deficitUncertainty = sqrt(sqDeficitSum / (numErrorPoints - 1));
     if((numEstimates <= 1)&&(pressureUncertainty < 2.5)) {
         pressureUncertainty = 2.5;
@@ -592,7 +579,85 @@ void VortexThread::calcPressureUncertainty(float setLimit, QString nameAddition)
     vortexData->setAveRMWUncertainty(aveRMWUncertainty / (1.0 * goodrmw));
 }
 
-int VortexThread::heightToIndex(const float height)
+void VortexThread::runPerturbation(PerturbationTask& task) const
+{
+    if (!task.inside)
+        return;
+
+    // Winds for the perturbed center only live as long as the task
+    VortexData* errorVertex = new VortexData(1, vortexData->getNumRadii(), vortexData->getNumWaveNum());
+    errorVertex->setHeight(0, task.height);
+
+    const GriddedData* grid = gridData;
+    int   maxCoeffs = maxWave * 2 + 3;
+    Coefficient* vtdCoeffs = new Coefficient[20];
+    VTDWorkspace vtdWork;
+    QVector<float> ringData;
+    QVector<float> ringAzimuths;
+    float height = task.height;
+
+    for (float radius = firstRing; radius <= lastRing; radius++) {
+        // Get the data
+        int maxData = grid->getCylindricalAzimuthMaxLength(radius, height);
+        if (ringData.size() < maxData) {
+            ringData.resize(maxData);
+            ringAzimuths.resize(maxData);
+        }
+        float* values = ringData.data();
+        float* azimuths = ringAzimuths.data();
+        int numData = grid->getCylindricalAzimuthRing(velField, task.refI, task.refJ, radius, height,
+                                                      maxData, values, azimuths);
+
+        // Call gbvtd
+        float stdDev;
+        task.rings++;
+        if (vtd->analyzeRing(task.xCenter, task.yCenter, radius, height, numData, values, azimuths,
+                             vtdCoeffs, stdDev, vtdWork)) {
+            if (vtdCoeffs[0].getParameter() != Coefficient::VTC0) {
+                task.missingVTC0 = true;
+            }
+
+            // All done with this radius and height, archive it
+            archiveWinds(*errorVertex, radius, task.level, maxCoeffs, vtdCoeffs);
+        }
+    }
+    delete[] vtdCoeffs;
+
+    // Now calculate central pressure for this center
+    float* errorPressureDeficit = new float[(int)lastRing + 1];
+    getPressureDeficit(errorVertex,errorPressureDeficit, height);
+    task.deficit = fabs(*errorPressureDeficit);
+
+    // Add in uncertainty from multiple pressure measurements
+    if(_presObs.size() < 1){
+        // No outside data available use the 1013 bit.
+        task.pressure = 1013 - (errorPressureDeficit[(int)lastRing] - errorPressureDeficit[0]);
+    }
+    else {
+        for(int j = 0; j < _presObs.size(); j++) {
+
+            float obPressure = _presObs[j].getPressure();
+            float vortexLat = errorVertex->getLat(0);
+            float vortexLon = errorVertex->getLon(0);
+            float obLat = _presObs[j].getLat();
+            float obLon = _presObs[j].getLon();
+            float* relDist = GriddedData::getCartesianPoint(&vortexLat, &vortexLon, &obLat, &obLon);
+            float obRadius = sqrt(relDist[0] * relDist[0] + relDist[1] * relDist[1]);
+            delete [] relDist;
+            float pPrimeOuter;
+            if (obRadius >= lastRing) {
+                pPrimeOuter = errorPressureDeficit[(int)lastRing];
+            } else {
+                pPrimeOuter = errorPressureDeficit[(int)obRadius];
+            }
+            task.pressure = obPressure - (pPrimeOuter - errorPressureDeficit[0]);
+        }
+    }
+    delete [] errorPressureDeficit;
+    delete errorVertex;
+}
+
+int VortexThread::heightToIndex(const float height) const
 {
   return  (int) ( (height - firstLevel) / gridData->getKGridsp() );
 }
@@ -653,6 +718,15 @@ void VortexThread::readInConfig()
       gradientHeight = firstLevel;
       std::cout << "Warning: VortexThread gradientHeight adjusted to " << firstLevel << std::endl;
     }
+    // The perturbations run concurrently, so more of them cost little extra time
+    numErrorPoints = 4;
+    QString pointsConfig = configData->getParam(pressureConfig, "uncertainty_points");
+    if(pointsConfig != "")
+      numErrorPoints = pointsConfig.toInt();
+    if(numErrorPoints < 4) {
+      numErrorPoints = 4;
+      std::cout << "Warning: VortexThread uncertainty_points adjusted to " << numErrorPoints << std::endl;
+    }
     envPressure = -999;
 }
 
@@ -691,16 +765,12 @@ bool VortexThread::calcHVVP(bool printOutput)
         //Message::toScreen(hvvpInput);
     }
 
-    Hvvp *envWindFinder = new Hvvp;
-    envWindFinder->setConfig(configData);
-    envWindFinder->setPrintOutput(printOutput);
-    connect(envWindFinder, SIGNAL(log(const Message)),this, SLOT(catchLog(const Message)));
-    envWindFinder->setRadarData(radarVolume,rt, cca, vortexData->getAveRMW());
+    // Worked out once per center and RMW, later calls reuse the result
+    hvvpService.setCenter(rt, cca, vortexData->getAveRMW());
     emit log(Message(QString(), 1,this->objectName()));
-    //envWindFinder->findHVVPWinds(false); for first fit only
-    bool hasHVVP = envWindFinder->findHVVPWinds(true);
-    hvvpResult = envWindFinder->getAvAcrossBeamWinds();
-    hvvpUncertainty = envWindFinder->getAvAcrossBeamWindsStdError();
+    bool hasHVVP = hvvpService.findHVVPWinds(printOutput);
+    hvvpResult = hvvpService.getAvAcrossBeamWinds();
+    hvvpUncertainty = hvvpService.getAvAcrossBeamWindsStdError();
     if(std::isnan(hvvpResult)||(hvvpResult == -999)||
             std::isnan(hvvpUncertainty)||(hvvpUncertainty == -999)){
         hvvpResult = 0;
@@ -713,7 +783,6 @@ bool VortexThread::calcHVVP(bool printOutput)
         finalHVVP = QString("Hvvp finds mean wind "+QString().setNum(hvvpResult)+" +/- "+QString().setNum(fabs(hvvpUncertainty)));
 
     emit log(Message(finalHVVP, 0,this->objectName()));
-    delete envWindFinder;
 
     return hasHVVP;
 }
@@ -759,14 +828,14 @@ void VortexThread::getMaxSfcWind(VortexData* data)
 	    // float centerDistance = sqrt(xCenter * xCenter + yCenter * yCenter);
 
             // Get the winds
-	    // if (!(data->getCoefficient(height, radius, QString("VTC0")) == Coefficient())) {
-	    if ( (data->getCoefficient(height, radius, QString("VTC0"))).isValid()) {
-
-	      float vtc0 = data->getCoefficient(height, radius, QString("VTC0")).getValue();
-	      float vrc0 = data->getCoefficient(height, radius, QString("VRC0")).getValue();
-	      float vmc0 = data->getCoefficient(height, radius, QString("VMC0")).getValue();
-	      float vtc1 = data->getCoefficient(height, radius, QString("VTC1")).getValue();
-	      float vts1 = data->getCoefficient(height, radius, QString("VTS1")).getValue();
+	    // if (!(data->getCoefficient(height, radius, Coefficient::VTC0) == Coefficient())) {
+	    if ( (data->getCoefficient(height, radius, Coefficient::VTC0)).isValid()) {
+
+	      float vtc0 = data->getCoefficient(height, radius, Coefficient::VTC0).getValue();
+	      float vrc0 = data->getCoefficient(height, radius, Coefficient::VRC0).getValue();
+	      float vmc0 = data->getCoefficient(height, radius, Coefficient::VMC0).getValue();
+	      float vtc1 = data->getCoefficient(height, radius, Coefficient::VTC1).getValue();
+	      float vts1 = data->getCoefficient(height, radius, Coefficient::VTS1).getValue();
 	      double PI = acos(-1.0);
 
 	      for (int i = 0; i < 360; i++) {
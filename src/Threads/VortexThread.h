@@ -23,6 +23,8 @@
 #include "DataObjects/VortexData.h"
 #include "Pressure/PressureList.h"
 #include "Radar/RadarData.h"
+#include "NRL/HvvpService.h"
+#include "IO/VolumeMetrics.h"
 
 class VortexThread : public QObject
 {
@@ -37,6 +39,9 @@ class VortexThread : public QObject
   void run();
     void setEnvPressure(const float& pressure) { envPressure = pressure; }
     void setOuterRadius(const float& radius) { maxObRadius = radius; }
+    // Where to add the VTD, pressure and HVVP times and the ring counts,
+    // may be NULL
+    void setMetrics(VolumeMetrics* volumeMetrics) { metrics = volumeMetrics; }
     
  public slots:
      void catchLog(const Message& message);
@@ -53,6 +58,7 @@ class VortexThread : public QObject
      VortexData *vortexData;
      PressureList *pressureList;
      Configuration *configData;
+     VolumeMetrics *metrics;
      
      float* dataGaps;
      VTD* vtd;
@@ -73,6 +79,8 @@ class VortexThread : public QObject
      float maxObTimeDiff;
      float hvvpResult;
      float hvvpUncertainty;
+     // HVVP fits for this volume, shared by the wind and pressure passes
+     HvvpService hvvpService;
      float envPressure;
      float outerRadius;
      int numEstimates;
@@ -81,21 +89,49 @@ class VortexThread : public QObject
      float vtdStdDev;
      float convergingCenters;
      float rhoBar[16];
+     // Number of perturbed centers for the pressure uncertainty
+     int numErrorPoints;
+
+     // One perturbed center of the pressure uncertainty ensemble. Tasks
+     // only read the grid and the VTD object and write their own results,
+     // so the whole ensemble runs at once.
+     class PerturbationTask {
+     public:
+         float height;
+         int level;
+         float refI, refJ;          // grid indices of the perturbed center
+         float xCenter, yCenter;    // km
+         bool inside;
+         bool missingVTC0;
+         int rings;
+         float pressure;
+         float deficit;
+     };
+
+     class PerturbationRunner {
+     public:
+         PerturbationRunner(const VortexThread* vortex) : vortex(vortex) {}
+         typedef void result_type;
+         void operator()(PerturbationTask& task) const { vortex->runPerturbation(task); }
+     private:
+         const VortexThread* vortex;
+     };
 
      void archiveWinds(float radius,int height,int maxCoeffs, Coefficient *vtdCoeffs);
-     void archiveWinds(VortexData& data, float& radius,int& height,int& maxCoeffs, Coefficient *vtdCoeffs);
+     void archiveWinds(VortexData& data, float& radius,int& height,int& maxCoeffs, Coefficient *vtdCoeffs) const;
      // void getPressureDeficit(const float& height);
-     void getPressureDeficit(VortexData* data, float* pDeficit,const float& height);
+     void getPressureDeficit(VortexData* data, float* pDeficit,const float& height) const;
      //void calcCentralPressure();
      void calcCentralPressure(VortexData* vortex, float* pD, float height);
      void calcPressureUncertainty(float setLimit, QString nameAddition);
+     void runPerturbation(PerturbationTask& task) const;
      void storePressureUncertaintyData(QString& fileLocation);
      void readInConfig();
      bool calcHVVP(bool printOutput);
      void getMaxSfcWind(VortexData* data);
      float fixAngle(float& angle);
 
-     int heightToIndex(const float height);
+     int heightToIndex(const float height) const;
      float indexToHeight(const int index);
 };
 
@@ -8,7 +8,9 @@
 */
 
 #include <fstream>
+#include <cstdio>
 #include <QtGui>
+#include <QtConcurrentRun>
 #include "workThread.h"
 #include "Message.h"
 #include <math.h>
@@ -26,6 +28,8 @@ workThread::workThread(QObject *parent)
 	dataSource= NULL;
 	pressureSource= NULL;
 	configData= NULL;
+	_centerFinder = NULL;
+	_prepareIdle = false;
 }
 
 workThread::~workThread()
@@ -74,15 +78,29 @@ void workThread::run()
 	QString namePrefix = vortexName + "_" + radarName + "_" + year + "_";
 
 	//initialize the saving path of data-list
+	// The lists are saved to their record files after every volume,
+	// the XML files are only written when the run ends
 	_simplexList.setFilePath(workingDir.filePath(namePrefix+"simplexlist.xml"));
 	_vortexList.setFilePath(workingDir.filePath(namePrefix+"vortexlist.xml"));
 	_pressureList.setFilePath(workingDir.filePath(namePrefix+"pressurelist.xml"));
+	_simplexList.setRecordPath(workingDir.filePath(namePrefix+"simplexlist.dat"));
+	_vortexList.setRecordPath(workingDir.filePath(namePrefix+"vortexlist.dat"));
+	_pressureList.setRecordPath(workingDir.filePath(namePrefix+"pressurelist.dat"));
 
 	if(continuePreviousRun){
 		_simplexList.restore();
 		_vortexList.restore();
 		_pressureList.restore();
+		emit log(Message(QString("Restored ") + QString().setNum(_vortexList.count())
+				 + " analyzed volumes from a previous run", 0, this->objectName()));
+	} else {
+		// Start new histories rather than appending to an old run
+		_simplexList.rewrite();
+		_vortexList.rewrite();
+		_pressureList.rewrite();
 	}
+	delete _centerFinder;
+	_centerFinder = new ChooseCenter(configData, &_simplexList, NULL);
 
 	// where to save coefficients.
 	QString coeffFilePath = workingDir.filePath(namePrefix + "coefficientlist.csv");
@@ -91,9 +109,22 @@ void workThread::run()
 	outfile << "# level, radius, param, value" << std::endl;
 	outfile.close();
 
+	// Per volume metrics go next to the coefficients
+	_metricsPath = workingDir.filePath(namePrefix + "metrics.json");
+	if (!continuePreviousRun)
+		QFile::remove(_metricsPath);
+	_prometheusPath = configData->getParam(configData->getConfig("vortex"), "metrics_prometheus");
+	if (!_prometheusPath.isEmpty())
+		_prometheusPath = workingDir.filePath(_prometheusPath);
+	_runMetrics.clear();
+
 	//create data monitor object
 	dataSource = new RadarFactory(configData);
-	connect(dataSource, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)));
+	// The factory is used from the prefetch thread, so relay its log directly
+	connect(dataSource, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)),
+		Qt::DirectConnection);
+	if (!inputFiles.isEmpty())
+		dataSource->setInputFiles(inputFiles);
 	PressureFactory *pressureSource = new PressureFactory(configData);
 	connect(pressureSource, SIGNAL(log(const Message&)),this, SLOT(catchLog(const Message&)));
 
@@ -102,41 +133,42 @@ void workThread::run()
 
 	bool just_display = "true" == configData->getParam(configData->getConfig("cappi"),
 							 "just_display");
+
+	// Start reading volumes ahead of the analysis. Only the volumes that
+	// were already processed in a previous run are skipped.
+	_preparedVolumes.clear();
+	_preparedMetrics.clear();
+	_prepareIdle = false;
+	QFuture<void> prefetch = QtConcurrent::run(this, &workThread::_prefetchVolumes, preGridded,
+						   configData->getConfig("qc"), _vortexList);
+
 	// Begin working loop
 
 	while(!abort) {
-		//STEP 1: Check for new data
-		if (dataSource->hasUnprocessedData()) {
-			if(abort) break;
-			// Update the data queue with any knowledge of any volumes that might have already been processed
-			dataSource->updateDataQueue(&_vortexList);
-
-			//STEP 2: Select a volume off the queue,try to read it
-			RadarData *newVolume = dataSource->getUnprocessedData();
-			if(newVolume == NULL) {
-				continue;
+		//STEP 1 and 2: Take the next new volume, already read and dealiased
+		RadarData *newVolume = _nextPreparedVolume(&_volumeMetrics);
+		if (newVolume != NULL) {
+			if(abort) {
+				delete newVolume;
+				break;
 			}
 
-			emit log(Message("Found file:" + newVolume->getFileName(), -1, this->objectName()));
-
-			// Check to makes sure that the file still exists and is readable
-			if((!newVolume->fileIsReadable()) or (!newVolume->readVolume())) {
-			  emit log(Message(QString("The radar data file " + newVolume->getFileName() +
-						   " is not readable"), -1, this->objectName()));
-			  delete newVolume;
-			  continue;
-			}
 			std::cout << newVolume->getDateTimeString().toStdString() << ": ";
 
 			// TODO what do we do with that? not needed, will it break anything "volume coverage pattern"
 			emit newVCP(newVolume->getVCP());
 
 			GriddedFactory *gridFactory = new GriddedFactory();
-			GriddedData *gridData;
+			// The grid is shared with the display, it goes away once the
+			// analysis and the last viewer are done with it
+			QSharedPointer<GriddedData> gridData;
 
 			if (preGridded) {
 
-			  gridData = gridFactory->fillPreGriddedData(newVolume, configData);
+			  {
+			    VolumeMetrics::Timer timer(&_volumeMetrics, "gridding");
+			    gridData = QSharedPointer<GriddedData>(gridFactory->fillPreGriddedData(newVolume, configData));
+			  }
 			  newVolume->setPreGridded();
 
 			  // See if the config wants to overwrite the default max unambiguated range
@@ -156,18 +188,7 @@ void workThread::run()
 			  if(abort) break;
 			} else {
 
-			  //radar data quality control
-			  RadarQC* dealiaser=new RadarQC(newVolume);
-			  connect(dealiaser,SIGNAL(log(const Message&)),
-				  this,SLOT(catchLog(const Message&)));
-			  dealiaser->getConfig(configData->getConfig("qc"));
-			  dealiaser->dealias();
-			  emit log(Message("Finished QC and Dealiasing",10, this->objectName()));
-			  delete dealiaser;
-			  if(abort) {
-			    delete newVolume;
-			    break;
-			  }
+			  // Quality control and dealiasing were done when the volume was read
 
 			  //STEP 3: get the first guess of center Lat,Lon for simplex
 
@@ -180,17 +201,21 @@ void workThread::run()
 			  if(abort) break;
 
 			  //STEP 4: from Radardata ---> Griddata, make cappi
-			  gridData = gridFactory->makeCappi(newVolume, configData, &_firstGuessLat, &_firstGuessLon);
+			  {
+			    VolumeMetrics::Timer timer(&_volumeMetrics, "gridding");
+			    gridData = QSharedPointer<GriddedData>(gridFactory->makeCappi(newVolume, configData,
+											    &_firstGuessLat, &_firstGuessLon));
+			  }
+			  _volumeMetrics.addCount("gates_gridded", gridData->getGatesGridded());
 			}
 
 			gridData->writeAsi();
 			emit log(Message("Done with Cappi", 15, this->objectName()));
-			emit newCappi(*gridData);
+			emit newCappi(gridData);
 
 			if(abort) {
 			  delete newVolume;
 			  delete gridFactory;
-			  delete gridData;
 			  break;
 			}
 
@@ -204,15 +229,15 @@ void workThread::run()
 			int bestLevel;
 
 			if (runSimplex) {
-			  if ( ! findCenter(newVolume, gridData, bottomLevel, &vortexData, &bestLevel) ) {
+			  if ( ! findCenter(newVolume, gridData.data(), bottomLevel, &vortexData, &bestLevel) ) {
+			    _finishVolumeMetrics();
 			    delete newVolume;
 			    delete gridFactory;
-			    delete gridData;
 			    continue;
 			  }
 			} else {
 			  vortexData = useBestGuessCenter(newVolume, bottomLevel, gridData->getKGridsp());
-			  updateCappiDisplayInfo(gridData, vortexData, radarLat, radarLon, _firstGuessLat, _firstGuessLon);
+			  updateCappiDisplayInfo(gridData.data(), vortexData, radarLat, radarLon, _firstGuessLat, _firstGuessLon);
   			}
 
 			//STEP 6: Check for new pressure data to process for the current volume
@@ -238,7 +263,6 @@ void workThread::run()
 			if(abort) {
 				delete newVolume;
 				delete gridFactory;
-				delete gridData;
 				break;
 			}
 
@@ -255,13 +279,14 @@ void workThread::run()
 			  emit log(Message("Estimating pressure", 1, this->objectName()));
 
 			  VortexThread* pVtd = new VortexThread();
+			  pVtd->setMetrics(&_volumeMetrics);
 
 	            if (mode == "operational") {
 	                pVtd->setEnvPressure(atcf->getEnvPressure());
 	                pVtd->setOuterRadius(atcf->getOuterRadius());
 	            }
 
-		    pVtd->getWinds(configData, gridData, newVolume, vortexData, &_pressureList); // Runs the VortexThread
+		    pVtd->getWinds(configData, gridData.data(), newVolume, vortexData, &_pressureList); // Runs the VortexThread
 	            delete pVtd;
 
 		    if (vortexData->getMaxValidRadius() != -999) {
@@ -303,15 +328,23 @@ void workThread::run()
             emit log(Message(QString("Completed Analysis On Volume "+newVolume->getFileName()),100,this->objectName()));
             delete newVolume;
             delete gridFactory;
-            delete gridData;
 
         if(abort) break;
 
-            //STEP 9: after finish process each volume,save data to XML
-            _vortexList.saveXML();
-            _simplexList.saveXML();
-            _pressureList.saveXML();
-	    vortexData->saveCoefficients(coeffFilePath);
+            //STEP 9: after finish process each volume, save the new records
+	    {
+		VolumeMetrics::Timer timer(&_volumeMetrics, "save");
+		_vortexList.save();
+		_simplexList.save();
+		_pressureList.save();
+		vortexData->saveCoefficients(coeffFilePath);
+	    }
+	    _finishVolumeMetrics();
+        } else if (runOnce) {
+            // Headless runs stop as soon as the data is used up
+            std::cout<<"Finished processing all files\n";
+            abort = true;
+            emit finished();
         } else {
             //if there's no data, have a little rest
             sleep(2);
@@ -324,10 +357,170 @@ void workThread::run()
         }
 
 	} // while ! abort
+
+	// Let the prefetch finish whatever it is reading before cleaning up
+	abort = true;
+	_queueSpace.wakeAll();
+	prefetch.waitForFinished();
+	while (!_preparedVolumes.isEmpty())
+		delete _preparedVolumes.dequeue();
+	_preparedMetrics.clear();
+
+	// Export the complete histories. That is not part of any volume, so
+	// it is recorded on its own, without a volume name.
+	VolumeMetrics exportMetrics;
+	{
+		VolumeMetrics::Timer timer(&exportMetrics, "xml");
+		_vortexList.saveXML();
+		_simplexList.saveXML();
+		_pressureList.saveXML();
+	}
+	_runMetrics.add(exportMetrics);
+	_writeMetrics(exportMetrics);
+
+	delete _centerFinder;
+	_centerFinder = NULL;
+
     delete dataSource;
     delete pressureSource;
 }
 
+void workThread::_prefetchVolumes(bool preGridded, QDomElement qcConfig, VortexList processedList)
+{
+	// Runs on the thread pool until the analysis stops
+	while(!abort) {
+		VolumeMetrics metrics;
+		RadarData *volume = _prepareVolume(preGridded, qcConfig, &processedList, &metrics);
+
+		QMutexLocker locker(&_prepareMutex);
+		if (volume == NULL) {
+			// Nothing new, let the analysis know and look again in a bit
+			_prepareIdle = true;
+			_volumePrepared.wakeAll();
+			_queueSpace.wait(&_prepareMutex, 2000);
+			continue;
+		}
+
+		// Bounded queue, wait for the analysis to catch up
+		while (!abort && (_preparedVolumes.size() >= maxPreparedVolumes))
+			_queueSpace.wait(&_prepareMutex, 1000);
+		if (abort) {
+			delete volume;
+			break;
+		}
+		_preparedVolumes.enqueue(volume);
+		_preparedMetrics.enqueue(metrics);
+		_prepareIdle = false;
+		_volumePrepared.wakeAll();
+	}
+
+	QMutexLocker locker(&_prepareMutex);
+	_prepareIdle = true;
+	_volumePrepared.wakeAll();
+}
+
+RadarData* workThread::_prepareVolume(bool preGridded, const QDomElement &qcConfig, VortexList *processedList,
+				      VolumeMetrics *metrics)
+{
+	// Returns the next readable volume, dealiased unless it is pre-gridded,
+	// or NULL when there is no new data
+	while (!abort && dataSource->hasUnprocessedData()) {
+		// Update the data queue with any knowledge of any volumes that might have already been processed
+		dataSource->updateDataQueue(processedList);
+
+		// Select a volume off the queue,try to read it
+		RadarData *newVolume = dataSource->getUnprocessedData();
+		if(newVolume == NULL) {
+			continue;
+		}
+
+		emit log(Message("Found file:" + newVolume->getFileName(), -1, this->objectName()));
+
+		// Check to makes sure that the file still exists and is readable
+		metrics->clear();
+		metrics->setVolume(newVolume->getFileName());
+		bool readable;
+		{
+			VolumeMetrics::Timer timer(metrics, "read");
+			readable = newVolume->fileIsReadable() and newVolume->readVolume();
+		}
+		metrics->addCount("bytes_read", QFileInfo(newVolume->getFileName()).size());
+		if(!readable) {
+			emit log(Message(QString("The radar data file " + newVolume->getFileName() +
+						 " is not readable"), -1, this->objectName()));
+			delete newVolume;
+			continue;
+		}
+
+		if (!preGridded) {
+			VolumeMetrics::Timer timer(metrics, "qc");
+			// Gate heights and ranges for QC, gridding and the HVVP
+			newVolume->buildBeamGeometry();
+
+			//radar data quality control
+			RadarQC* dealiaser=new RadarQC(newVolume);
+			connect(dealiaser,SIGNAL(log(const Message&)),
+				this,SLOT(catchLog(const Message&)), Qt::DirectConnection);
+			dealiaser->getConfig(qcConfig);
+			dealiaser->dealias();
+			emit log(Message("Finished QC and Dealiasing",10, this->objectName()));
+			delete dealiaser;
+		}
+		return newVolume;
+	}
+	return NULL;
+}
+
+void workThread::_finishVolumeMetrics()
+{
+	_runMetrics.add(_volumeMetrics);
+	_runMetrics.addCount("volumes", 1);
+	emit log(Message("Volume metrics: " + _volumeMetrics.summary(), 0, this->objectName()));
+	_writeMetrics(_volumeMetrics);
+	emit volumeMetrics(_volumeMetrics);
+}
+
+void workThread::_writeMetrics(const VolumeMetrics& metrics)
+{
+	QFile record(_metricsPath);
+	if (record.open(QIODevice::Append | QIODevice::Text)) {
+		record.write((metrics.toJson() + "\n").toUtf8());
+		record.close();
+	} else {
+		emit log(Message("Can't write metrics to " + _metricsPath, 0, this->objectName()));
+	}
+
+	if (_prometheusPath.isEmpty())
+		return;
+
+	// Replaced in one go so a scraper never sees half a file
+	QString tempPath = _prometheusPath + ".tmp";
+	QFile text(tempPath);
+	if (!text.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+		emit log(Message("Can't write metrics to " + tempPath, 0, this->objectName()));
+		return;
+	}
+	text.write(metrics.toPrometheus("vortrac_volume", false).toUtf8());
+	text.write(_runMetrics.toPrometheus("vortrac_run", true).toUtf8());
+	text.close();
+	if (std::rename(tempPath.toLocal8Bit().constData(), _prometheusPath.toLocal8Bit().constData()) != 0)
+		emit log(Message("Can't write metrics to " + _prometheusPath, 0, this->objectName()));
+}
+
+RadarData* workThread::_nextPreparedVolume(VolumeMetrics *metrics)
+{
+	// Wait for the next volume, NULL if the prefetch ran out of data
+	QMutexLocker locker(&_prepareMutex);
+	while (_preparedVolumes.isEmpty() && !_prepareIdle && !abort)
+		_volumePrepared.wait(&_prepareMutex, 1000);
+	if (_preparedVolumes.isEmpty())
+		return NULL;
+	RadarData *volume = _preparedVolumes.dequeue();
+	*metrics = _preparedMetrics.dequeue();
+	_queueSpace.wakeAll();
+	return volume;
+}
+
 // This slot is used for log message relaying
 // Any objects created by this object must be connected
 // to this slot
@@ -343,7 +536,7 @@ void workThread::catchVCP(const int vcp)
 	emit newVCP(vcp);
 }
 
-void workThread::catchCappi(const GriddedData& cappi)
+void workThread::catchCappi(GriddedDataPtr cappi)
 {
 	emit newCappi(cappi);
 }
@@ -460,9 +653,9 @@ void workThread::checkListConsistency()
 	// Removing the last ones for safety, any partially formed file could do serious damage
 	// to data integrity
 	_simplexList.removeAt(_simplexList.count()-1);
-	_simplexList.saveXML();
+	_simplexList.rewrite();
 	_vortexList.removeAt(_vortexList.count()-1);
-	_vortexList.saveXML();
+	_vortexList.rewrite();
 }
 
 void workThread::catchCappiInfo(float x, float y, float rmwEstimate, float sMin, float sMax, float vMax,
@@ -618,14 +811,18 @@ bool workThread::findCenter(RadarData *radar_data, GriddedData *grid_data, float
 
   std::cout << "Vortex time: " << radar_data->getDateTime().toString("hh:mm").toLatin1().data() << std::endl;
 
-  SimplexThread* pSimplex = new SimplexThread();
-  pSimplex->initParam(configData, grid_data, _firstGuessLat, _firstGuessLon);
+  {
+    VolumeMetrics::Timer timer(&_volumeMetrics, "simplex");
+    SimplexThread* pSimplex = new SimplexThread();
+    pSimplex->initParam(configData, grid_data, _firstGuessLat, _firstGuessLon);
 
-  // TODO this does the work.
-  // We get "Center Not Found" if we pick a center bottom_level too low in the config file.
+    // TODO this does the work.
+    // We get "Center Not Found" if we pick a center bottom_level too low in the config file.
 
-  pSimplex->findCenter(&_simplexList);  // TODO check the return value!
-  delete pSimplex;
+    pSimplex->findCenter(&_simplexList);  // TODO check the return value!
+    _volumeMetrics.addCount("simplex_iterations", pSimplex->getIterations());
+    delete pSimplex;
+  }
   _simplexList.last().setTime(vortexData->getTime());
 
   //Postprocess simplex result
@@ -665,9 +862,11 @@ bool workThread::findCenter(RadarData *radar_data, GriddedData *grid_data, float
   if (maxConvergedLevel > -1) {
     _simplexList.timeSort();
 
-    ChooseCenter *centerFinder = new ChooseCenter(configData, &_simplexList, vortexData);
-    centerFinder->findCenter(maxConvergedLevel);
-    delete centerFinder;
+    {
+      VolumeMetrics::Timer timer(&_volumeMetrics, "choosecenter");
+      _centerFinder->setVortexData(vortexData);
+      _centerFinder->findCenter(maxConvergedLevel);
+    }
 
     // Find the best std dev among all the levels that have enough converged rings.
 
@@ -14,6 +14,8 @@
 #include <QThread>
 #include <QList>
 #include <QMutex>
+#include <QQueue>
+#include <QWaitCondition>
 #include <QTextStream>
 
 #include "Radar/RadarFactory.h"
@@ -26,6 +28,7 @@
 #include "Pressure/PressureList.h"
 #include "ChooseCenter.h"
 #include "IO/ATCF.h"
+#include "IO/VolumeMetrics.h"
 
 class workThread : public QObject
 {
@@ -39,6 +42,7 @@ public:
     ~workThread();
     void setConfig(Configuration *configPtr) {configData = configPtr;}
     void setATCF(ATCF *atcfPtr) {atcf = atcfPtr;}
+    void setInputFiles(const QStringList &files) {inputFiles = files;}
     void stop();
     bool findCenter(RadarData *radar_data, GriddedData *grid_data, float bottom_evel,
 		    VortexData **vortex_data, int *best_level);
@@ -50,7 +54,7 @@ public:
 public slots:
     void catchLog(const Message& message);
     void catchVCP(const int vcp);
-    void catchCappi(const GriddedData& cappi);
+    void catchCappi(GriddedDataPtr cappi);
     void catchCappiInfo(float x,float y,float rmwEstimate,float sMin,float sMax,float vMax,
                         float userLat,float userLon,float lat,float lon);
     void setOnlyRunOnce(const bool newRunOnce = true);
@@ -61,16 +65,19 @@ signals:
     void log(const Message& message);
     void newVCP(const int);
     void vortexListUpdate(VortexList* list);
-    void newCappi(const GriddedData& cappi);
+    void newCappi(GriddedDataPtr cappi);
     void newCappiInfo(float x,float y,float rmwEstimate,float sMin,float sMax,float vMax,
                       float userLat,float userLon,float lat,float lon);
     void finished();
+    // Stage times of a volume once the analysis is done with it
+    void volumeMetrics(const VolumeMetrics& metrics);
 
 private:
     
     bool runOnce;
     volatile bool abort;
     bool continuePreviousRun;
+    QStringList inputFiles;
 
     RadarFactory    *dataSource;
     PressureFactory *pressureSource;
@@ -80,6 +87,9 @@ private:
     SimplexList  _simplexList;
     PressureList _pressureList;
 
+    // Kept for the whole run so earlier volumes are not scored again
+    ChooseCenter *_centerFinder;
+
     float _firstGuessLat;
     float _firstGuessLon;
     
@@ -87,6 +97,32 @@ private:
     void checkIntensification();
     void checkListConsistency();
     void loadCenterLocations(QString centerFile);
+
+    // Reading and dealiasing don't depend on earlier results, so they run
+    // ahead of the analysis on the thread pool. The analysis takes the
+    // volumes off a short queue in file order.
+    static const int maxPreparedVolumes = 2;
+    QQueue<RadarData*> _preparedVolumes;
+    QQueue<VolumeMetrics> _preparedMetrics;
+    QMutex _prepareMutex;
+    QWaitCondition _volumePrepared;
+    QWaitCondition _queueSpace;
+    bool _prepareIdle;
+    void _prefetchVolumes(bool preGridded, QDomElement qcConfig, VortexList processedList);
+    RadarData* _prepareVolume(bool preGridded, const QDomElement &qcConfig, VortexList *processedList,
+                              VolumeMetrics *metrics);
+    RadarData* _nextPreparedVolume(VolumeMetrics *metrics);
+
+    // Stage times and work counts of the volume being analysed, and their
+    // totals for the run. Each volume is logged, appended as a JSON line to
+    // _metricsPath and, if the vortex group has a metrics_prometheus file,
+    // written there in the Prometheus text format.
+    VolumeMetrics _volumeMetrics;
+    VolumeMetrics _runMetrics;
+    QString _metricsPath;
+    QString _prometheusPath;
+    void _finishVolumeMetrics();
+    void _writeMetrics(const VolumeMetrics& metrics);
     
     ATCF *atcf;
 
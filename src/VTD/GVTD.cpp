@@ -13,7 +13,7 @@
 #include "GVTD.h"
 #include <math.h>
 #include "IO/Message.h"
-#include "Math/Matrix.h"
+#include "Math/LeastSquares.h"
 
 
 GVTD::GVTD(QString& initClosure, int& wavenumbers, float*& gaps, float hvvpwind)
@@ -26,22 +26,26 @@ GVTD::~GVTD()
 }
 
 bool GVTD::analyzeRing(float& xCenter, float& yCenter, float& radius, float& height, int& numData, 
-                        float*& ringData, float*& ringAzimuths, Coefficient*& vtdCoeffs, float& vtdStdDev)
+                        float*& ringData, float*& ringAzimuths, Coefficient*& vtdCoeffs, float& vtdStdDev,
+                        VTDWorkspace& work) const
 {
   // Implement GVTD by Ting-Yu Cha, 11/03/2017
   // Analye a ring of data
 
   // Make a Psi array
   
-  ringPsi = new float[numData];
-  vel = new float[numData];
-  psi = new float[numData];
-  float *ringDistance = new float[numData];
+  work.reserve(numData, _maxWaveNum);
+  float* ringPsi = work.ringPsi;
+  float* vel = work.vel;
+  float* psi = work.psi;
+  float* ringDistance = work.ringDistance;
 
   // Get thetaT
-  thetaT = atan2(yCenter,xCenter);
+  float thetaT = atan2(yCenter,xCenter);
   thetaT = fixAngle(thetaT);
-  centerDistance = sqrt(xCenter * xCenter + yCenter * yCenter);
+  float centerDistance = sqrt(xCenter * xCenter + yCenter * yCenter);
+  work.thetaT = thetaT;
+  work.centerDistance = centerDistance;
 
   for (int i = 0; i < numData; i++) {
     // Convert to Psi
@@ -67,82 +71,50 @@ bool GVTD::analyzeRing(float& xCenter, float& yCenter, float& radius, float& hei
   numData = goodCount;
 
   // Get the maximum number of coefficients for the given data distribution and geometry
-  int numCoeffs = getNumCoefficients(numData);
+  int numCoeffs = getNumCoefficients(psi, numData);
 
   if (numCoeffs == 0) {
     // Too much missing data, set everything to 0 and return
     for (int i = 0; i <= (_maxWaveNum * 2 + 2); i++) {
-      FourierCoeffs[i] = 0.;
+      work.FourierCoeffs[i] = 0.;
     }
     vtdStdDev = -999;
-    setWindCoefficients(radius, height, numCoeffs, FourierCoeffs, vtdCoeffs);
-    delete[] ringPsi;
-    delete[] vel;
-    delete[] psi;
-    delete[] ringDistance;
+    setWindCoefficients(radius, height, numCoeffs, work, vtdCoeffs);
     return false;
   }
 
-  // Least squares
-  
-  float** xLLS = new float*[numCoeffs];
-  for (int i = 0; i <= numCoeffs - 1; i++) {
-    xLLS[i] = new float[numData];
-  }
-  float* yLLS = new float[numData];
+  // Least squares, building the design matrix one row at a time
+  LeastSquares<MaxCoefficients> fit(numCoeffs);
+  float xLLS[MaxCoefficients];
   for (int i = 0; i <= numData - 1; i++) {
-    xLLS[0][i] = 1.;
+    xLLS[0] = 1.;
     for (int j = 1; j <= (numCoeffs / 2); j++) {
-      xLLS[2 * j - 1][i] = sin(float(j) * psi[i]);
-      xLLS[ 2 * j][i] = cos(float(j) * psi[i]);
+      xLLS[2 * j - 1] = sin(float(j) * psi[i]);
+      xLLS[ 2 * j] = cos(float(j) * psi[i]);
     }
-    yLLS[i] = vel[i];
+    fit.addRow(xLLS, vel[i]);
   }
 
-  float* stdError = new float[numCoeffs];
-  if( ! Matrix::lls(numCoeffs, numData, xLLS, yLLS, vtdStdDev, FourierCoeffs, stdError)) {
-    for (int i = 0; i <= numCoeffs - 1; i++)
-      delete[] xLLS[i];
-    delete[] yLLS;
-    delete[] stdError;
-    delete[] ringPsi;
-    delete[] vel;
-    delete[] psi;
+  if( ! fit.solve(vtdStdDev, work.FourierCoeffs, work.stdError)) {
     return false;
   }
 
   // Convert Fourier coefficients into wind coefficients
-  setWindCoefficients(radius, height, numCoeffs, FourierCoeffs, vtdCoeffs);
+  setWindCoefficients(radius, height, numCoeffs, work, vtdCoeffs);
   
-  for (int i = 0; i <= numCoeffs - 1; i++)
-    delete[] xLLS[i];
-  
-  delete[] xLLS;
-  delete[] yLLS;
-  delete[] stdError;
-  delete[] ringPsi;
-  delete[] vel;
-  delete[] psi;
-
   return true;
 }
 
-void GVTD::setWindCoefficients(float& radius, float& level, int& numCoeffs, float*& FourierCoeffs,
-				Coefficient*& vtdCoeffs)
+void GVTD::setWindCoefficients(float& radius, float& level, int& numCoeffs,
+				VTDWorkspace& work, Coefficient*& vtdCoeffs) const
 {
-    // Allocate and initialize the A & B coefficient arrays
+    // Initialize the A & B coefficient arrays
   
-    float* A;
-    float* B;
-    int maxIndex = numCoeffs / 2 + 1;
-    
-    if (maxIndex > 5) {
-        A = new float[numCoeffs / 2 + 1];
-        B = new float[numCoeffs / 2 + 1];
-    } else {
-        A = new float[5];
-        B = new float[5];
-    }
+    float* A = work.A;
+    float* B = work.B;
+    float* FourierCoeffs = work.FourierCoeffs;
+    float centerDistance = work.centerDistance;
+
     for (int i=0; i <= 4; i++) {
         A[i] = 0;
         B[i] = 0;
@@ -189,14 +161,14 @@ void GVTD::setWindCoefficients(float& radius, float& level, int& numCoeffs, floa
       // Implement GVTD by Ting-Yu Cha 11/03/2017
       vtdCoeffs[0].setLevel(level);
       vtdCoeffs[0].setRadius(radius);
-      vtdCoeffs[0].setParameter("VTC0");
+      vtdCoeffs[0].setParameter(Coefficient::VTC0);
       float value;
       value = - B[1] - B[3];
       vtdCoeffs[0].setValue(value);
 
       vtdCoeffs[1].setLevel(level);
       vtdCoeffs[1].setRadius(radius);
-      vtdCoeffs[1].setParameter("VRC0");
+      vtdCoeffs[1].setParameter(Coefficient::VRC0);
       value = (A[0] + A[1] + A[2] + A[3] + A[4]) / ( 1 + radius / centerDistance);
       vtdCoeffs[1].setValue(value);
 
@@ -206,27 +178,22 @@ void GVTD::setWindCoefficients(float& radius, float& level, int& numCoeffs, floa
       for (int i=3; i <= numCoeffs - 1; i += 2) {
 	vtdCoeffs[i].setLevel(level);
 	vtdCoeffs[i].setRadius(radius);
-	QString param = "VTC" + QString().setNum(int(i / 2));
-	vtdCoeffs[i].setParameter(param);
+	vtdCoeffs[i].setParameter(Coefficient::VTC(i / 2));
 	value = -2. * B[i / 2 + 1];
 	vtdCoeffs[i].setValue(value);
 
 	vtdCoeffs[i+1].setLevel(level);
 	vtdCoeffs[i+1].setRadius(radius);
-	param = "VTS" + QString().setNum(int(i / 2));
-	vtdCoeffs[i + 1].setParameter(param);
+	vtdCoeffs[i + 1].setParameter(Coefficient::VTS(i / 2));
 	value = 2 * A[i / 2 + 1];
 	vtdCoeffs[i + 1].setValue(value);
       }
       
       vtdCoeffs[2].setLevel(level);
       vtdCoeffs[2].setRadius(radius);
-      vtdCoeffs[2].setParameter("VMC0");
+      vtdCoeffs[2].setParameter(Coefficient::VMC0);
       value = A[0] - ( radius / centerDistance * vtdCoeffs[1].getValue() ) + 0.5 * vtdCoeffs[4].getValue();
       // rhs value is VRC0 value computed just above
       vtdCoeffs[2].setValue(value);
     }
-
-    delete[] A;
-    delete[] B;
 }
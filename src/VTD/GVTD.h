@@ -24,11 +24,11 @@ public:
     bool analyzeRing(float& xCenter, float& yCenter, float& radius,
 		     float& height, int& numData, float*& ringData,
 		     float*& ringAzimuths, Coefficient*& vtdCoeffs,
-		     float& stdDev);
+		     float& stdDev, VTDWorkspace& work) const;
 
     void  setWindCoefficients(float& radius, float& height,
-			      int& numCoefficients, float*& FourierCoeffs,
-			      Coefficient*& vtdCoeffs);
+			      int& numCoefficients, VTDWorkspace& work,
+			      Coefficient*& vtdCoeffs) const;
 };
 
 #endif
@@ -1,98 +1,167 @@
-/*
- *  GBVTD.cpp
- *  vortrac
- *
- *  Created by Michael Bell on 5/6/06.
- *  Copyright 2006 University Corporation for Atmospheric Research.
- *  All rights reserved.
- *
- */
-
-#include "VTD.h"
-#include "GBVTD.h"
-#include "GVTD.h"
-
-#include <math.h>
-#include "IO/Message.h"
-#include "Math/Matrix.h"
-
-const float VTD::PI      = 3.1415926f;
-const float VTD::DEG2RAD = PI/180.f;
-const float VTD::RAD2DEG = 180.f/PI;
-
-VTD::VTD(QString& initClosure, int& wavenumbers, float*& gaps, float hvvpwind)
-{
-    closure = initClosure;
-    _maxWaveNum = wavenumbers;
-    dataGaps = gaps;
-    FourierCoeffs = new float[_maxWaveNum * 2 + 3];
-    _hvvpMean = hvvpwind;
-}
-
-VTD::~VTD()
-{
-    // Default destructor
-    delete[] FourierCoeffs;
-}
-
-int VTD::getNumCoefficients(int& numData)
-{
-    int maxCoeffs = _maxWaveNum*2 + 3;
-    int numCoeffs = maxCoeffs;
-
-    // Find the data gaps
-    bool degreeSector[360];
-    for (int i=0; i<360; i++) degreeSector[i]=false;
-
-    for (int i=0; i<=numData-1; i++) {
-        int j = int(psi[i]*RAD2DEG);
-        if (j > 359) j = j - 360;
-        degreeSector[j] = true;
-    }
-
-    // Check the width of the gap
-    // Run completely around circle in case there is a gap at the beginning
-
-    int gapSum = 0;
-    for (int deg=0; deg<720; deg++) {
-        int j = deg%360;
-        if (degreeSector[j]) {
-            gapSum = 0;
-            if (deg >= 360) {
-                // We've come back around the circle, send back the current coefficient number
-                return numCoeffs;
-            }
-        } else {
-            gapSum++;
-            for (int i=_maxWaveNum; i>=1; i--) {
-                if (gapSum > dataGaps[i]) {
-                    // Gap is too large, reduce the number of coefficients
-                    numCoeffs = (i-1)*2 + 3;
-                }
-            }
-            if (gapSum > dataGaps[0]) {
-                // Can't even fit wavenumber zero
-                return 0;
-            }
-        }
-    }
-
-    // Shouldn't get here, if we do return 0
-    return 0;
-}
-
-float VTD::fixAngle(float& angle)
-{
-    // Make sure an angle is between 0 and 2Pi
-  
-    if (fabs(angle) < 1.0e-06) angle = 0.0;
-    if (angle > (2*PI)) angle = angle - 2*PI;
-    if (angle < 0.) angle = angle + 2*PI;
-    return angle;
-
-}
-
-void VTD::setHVVP(const float& meanWind)
-{
-    _hvvpMean = meanWind;
-}
+/*
+ *  GBVTD.cpp
+ *  vortrac
+ *
+ *  Created by Michael Bell on 5/6/06.
+ *  Copyright 2006 University Corporation for Atmospheric Research.
+ *  All rights reserved.
+ *
+ */
+
+#include "VTD.h"
+#include "GBVTD.h"
+#include "GVTD.h"
+
+#include <math.h>
+#include <iostream>
+#include "IO/Message.h"
+#include "Math/Matrix.h"
+
+const float VTD::PI      = 3.1415926f;
+const float VTD::DEG2RAD = PI/180.f;
+const float VTD::RAD2DEG = 180.f/PI;
+
+VTD::VTD(QString& initClosure, int& wavenumbers, float*& gaps, float hvvpwind)
+{
+    closure = initClosure;
+    _maxWaveNum = wavenumbers;
+    if (_maxWaveNum > MaxWaveNum) {
+        std::cerr << "VTD: maximum wavenumber " << _maxWaveNum
+                  << " reduced to " << MaxWaveNum << std::endl;
+        _maxWaveNum = MaxWaveNum;
+    }
+    dataGaps = gaps;
+    _hvvpMean = hvvpwind;
+}
+
+VTD::~VTD()
+{
+    // Default destructor
+}
+
+int VTD::getNumCoefficients(const float* psi, int& numData) const
+{
+    int maxCoeffs = _maxWaveNum*2 + 3;
+    int numCoeffs = maxCoeffs;
+
+    // Find the data gaps
+    bool degreeSector[360];
+    for (int i=0; i<360; i++) degreeSector[i]=false;
+
+    for (int i=0; i<=numData-1; i++) {
+        int j = int(psi[i]*RAD2DEG);
+        if (j > 359) j = j - 360;
+        degreeSector[j] = true;
+    }
+
+    // Check the width of the gap
+    // Run completely around circle in case there is a gap at the beginning
+
+    int gapSum = 0;
+    for (int deg=0; deg<720; deg++) {
+        int j = deg%360;
+        if (degreeSector[j]) {
+            gapSum = 0;
+            if (deg >= 360) {
+                // We've come back around the circle, send back the current coefficient number
+                return numCoeffs;
+            }
+        } else {
+            gapSum++;
+            for (int i=_maxWaveNum; i>=1; i--) {
+                if (gapSum > dataGaps[i]) {
+                    // Gap is too large, reduce the number of coefficients
+                    numCoeffs = (i-1)*2 + 3;
+                }
+            }
+            if (gapSum > dataGaps[0]) {
+                // Can't even fit wavenumber zero
+                return 0;
+            }
+        }
+    }
+
+    // Shouldn't get here, if we do return 0
+    return 0;
+}
+
+float VTD::fixAngle(float& angle) const
+{
+    // Make sure an angle is between 0 and 2Pi
+  
+    if (fabs(angle) < 1.0e-06) angle = 0.0;
+    if (angle > (2*PI)) angle = angle - 2*PI;
+    if (angle < 0.) angle = angle + 2*PI;
+    return angle;
+
+}
+
+void VTD::setHVVP(const float& meanWind)
+{
+    _hvvpMean = meanWind;
+}
+
+VTDWorkspace::VTDWorkspace()
+  : ringPsi(NULL), vel(NULL), psi(NULL), ringDistance(NULL),
+    stdError(NULL), FourierCoeffs(NULL), A(NULL), B(NULL),
+    thetaT(0), centerDistance(0), _maxData(0), _maxCoeffs(0)
+{
+}
+
+VTDWorkspace::VTDWorkspace(int maxData, int maxWaveNum)
+  : ringPsi(NULL), vel(NULL), psi(NULL), ringDistance(NULL),
+    stdError(NULL), FourierCoeffs(NULL), A(NULL), B(NULL),
+    thetaT(0), centerDistance(0), _maxData(0), _maxCoeffs(0)
+{
+    reserve(maxData, maxWaveNum);
+}
+
+VTDWorkspace::~VTDWorkspace()
+{
+    release();
+}
+
+void VTDWorkspace::reserve(int maxData, int maxWaveNum)
+{
+    int maxCoeffs = maxWaveNum * 2 + 3;
+    if (maxData < 1) maxData = 1;
+    if ((maxData <= _maxData) && (maxCoeffs <= _maxCoeffs))
+        return;
+
+    // Only ever grow, so a workspace sized for the largest ring is reused
+    if (maxData < _maxData) maxData = _maxData;
+    if (maxCoeffs < _maxCoeffs) maxCoeffs = _maxCoeffs;
+    release();
+    _maxData = maxData;
+    _maxCoeffs = maxCoeffs;
+
+    ringPsi = new float[_maxData];
+    vel = new float[_maxData];
+    psi = new float[_maxData];
+    ringDistance = new float[_maxData];
+    stdError = new float[_maxCoeffs];
+    FourierCoeffs = new float[_maxCoeffs];
+
+    // The closures always look at the first five A & B terms
+    int maxIndex = _maxCoeffs / 2 + 1;
+    if (maxIndex < 5) maxIndex = 5;
+    A = new float[maxIndex];
+    B = new float[maxIndex];
+}
+
+void VTDWorkspace::release()
+{
+    delete[] ringPsi;
+    delete[] vel;
+    delete[] psi;
+    delete[] ringDistance;
+    delete[] stdError;
+    delete[] FourierCoeffs;
+    delete[] A;
+    delete[] B;
+
+    ringPsi = vel = psi = ringDistance = NULL;
+    stdError = FourierCoeffs = A = B = NULL;
+    _maxData = 0;
+    _maxCoeffs = 0;
+}
@@ -13,6 +13,45 @@
 #include <QString>
 #include "DataObjects/Coefficient.h"
 
+// Scratch space for VTD::analyzeRing. The caller owns one workspace per
+// thread and reuses it from ring to ring, so the ring analysis does not
+// touch the heap once the buffers are large enough and a single VTD object
+// can be shared between threads.
+
+class VTDWorkspace
+{
+
+ public:
+
+  VTDWorkspace();
+  VTDWorkspace(int maxData, int maxWaveNum);
+  ~VTDWorkspace();
+
+  // Grow the buffers to hold maxData ring points and maxWaveNum wavenumbers
+  void reserve(int maxData, int maxWaveNum);
+
+  float* ringPsi;
+  float* vel;
+  float* psi;
+  float* ringDistance;
+  float* stdError;
+  float* FourierCoeffs;
+  float* A;
+  float* B;
+  float thetaT;
+  float centerDistance;
+
+ private:
+
+  VTDWorkspace(const VTDWorkspace&);
+  VTDWorkspace& operator=(const VTDWorkspace&);
+  void release();
+
+  int _maxData;
+  int _maxCoeffs;
+
+};
+
 class VTD
 {
 
@@ -23,21 +62,27 @@ class VTD
     
   virtual ~VTD();
 
-  // Analyze one ring of data
+  // Analyze one ring of data. All scratch storage comes from work,
+  // which must not be shared between concurrent calls.
     
   virtual bool analyzeRing(float& xCenter, float& yCenter, float& radius,
 			   float& height, int& numData, float*& ringData,
 			   float*& ringAzimuths, Coefficient*& vtdCoeffs,
-			   float& stdDev) = 0;
+			   float& stdDev, VTDWorkspace& work) const = 0;
 
+  // Convert work.FourierCoeffs into wind coefficients
   virtual void  setWindCoefficients(float& radius, float& height,
-				    int& numCoefficients, float*& FourierCoeffs,
-				    Coefficient*& vtdCoeffs) = 0;
+				    int& numCoefficients, VTDWorkspace& work,
+				    Coefficient*& vtdCoeffs) const = 0;
     
   void setHVVP(const float& meanWind);
 
-  int   getNumCoefficients(int& numData);
-  float fixAngle(float& angle);
+  // Largest supported wavenumber, and the matching coefficient count
+  static const int MaxWaveNum = 8;
+  static const int MaxCoefficients = MaxWaveNum * 2 + 3;
+
+  int   getNumCoefficients(const float* psi, int& numData) const;
+  float fixAngle(float& angle) const;
 
  protected:
     
@@ -50,14 +95,6 @@ class VTD
   int _maxWaveNum;
   float* dataGaps;
 
-  float* ringPsi;
-  float* vel;
-  float* psi;
-  float thetaT;
-  float centerDistance;
-  float level;
-  float* FourierCoeffs;
-
   float _hvvpMean;
 
 };
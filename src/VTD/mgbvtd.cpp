@@ -22,33 +22,33 @@ m_cappi(cappi)
 	m_rmw     = rmw;
 }
 
-float MGBVTD::computeCrossBeamWind(float guessMax, QString& velField, GBVTD* gbvtd, Hvvp* hvvp)
+float MGBVTD::computeCrossBeamWind(float guessMax, QString& velField, GBVTD* gbvtd, HvvpService* hvvp)
 {
 	const float Rt = sqrt(m_centerx*m_centerx+m_centery*m_centery);
 
 	//1. calculate Vt profile first
 	std::vector<float> vt;
 	std::vector<float> vt_rng;
+	Coefficient* coeff = new Coefficient[20];
+	VTDWorkspace vtdWork;
 	//1. compute the radial profile of symmetric tangential wind  
 	for(float rng=m_rmw*1.2; rng<=.6*Rt; rng+=1.){
 		m_cappi.setCartesianReferencePoint(m_centerx, m_centery, m_centerz);
-		int numData = m_cappi.getCylindricalAzimuthLength(rng, m_centerz);
-		float* ringData = new float[numData];
-		float* ringAzi  = new float[numData];
-		m_cappi.getCylindricalAzimuthData(velField, numData, rng, m_centerz, ringData);
-        m_cappi.getCylindricalAzimuthPosition(numData, rng, m_centerz, ringAzi);
-		Coefficient* coeff = new Coefficient[20];
+		int maxData = m_cappi.getCylindricalAzimuthMaxLength(rng, m_centerz);
+		float* ringData = new float[maxData];
+		float* ringAzi  = new float[maxData];
+		int numData = m_cappi.getCylindricalAzimuthRing(velField, rng, m_centerz, maxData, ringData, ringAzi);
 		float vtdDev;
-		if(gbvtd->analyzeRing(m_centerx, m_centery, rng, m_centerz, numData, ringData, ringAzi, coeff, vtdDev)){
-			if(coeff[0].getParameter()=="VTC0"){
+		if(gbvtd->analyzeRing(m_centerx, m_centery, rng, m_centerz, numData, ringData, ringAzi, coeff, vtdDev, vtdWork)){
+			if(coeff[0].getParameter()==Coefficient::VTC0){
 				vt.push_back(coeff[0].getValue());
 				vt_rng.push_back(rng);
 			}
 		}
 		delete[] ringAzi;
 		delete[] ringData;
-		delete[] coeff;
 	}
+	delete[] coeff;
 	if(vt.size()<15) {
 		// std::cout<<std::endl;
 		return 0.f;
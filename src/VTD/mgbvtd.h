@@ -13,14 +13,14 @@
 
 #include <QString>
 #include "DataObjects/GriddedData.h"
-#include "NRL/Hvvp.h"
+#include "NRL/HvvpService.h"
 #include "VTD/GBVTD.h"
 
 class MGBVTD
 {
 public:
 	MGBVTD(float x0, float y0, float hgt, float rmw, GriddedData& cappi);
-	float computeCrossBeamWind(float guessMax, QString& velField, GBVTD* gbvtd, Hvvp* hvvp);
+	float computeCrossBeamWind(float guessMax, QString& velField, GBVTD* gbvtd, HvvpService* hvvp);
 
 private:
 	GriddedData& m_cappi;
@@ -9,15 +9,18 @@
  */
 
 #include <QApplication>
+#include <QCoreApplication>
 #include <QtCore>
 #include <QtXml>
 #include <iostream>
 
-#include <sys/resource.h>
 #include <unistd.h>
 
 #include "GUI/MainWindow.h"
 #include "Batch/BatchWindow.h"
+#include "Batch/DriverHeadless.h"
+#include "Batch/DriverBenchmark.h"
+#include "Batch/DriverKernelCheck.h"
 
 void usage(const char *s) {
   std::cout << "Usage: " << std::endl
@@ -27,6 +30,10 @@ void usage(const char *s) {
 	    << std::endl
     	    << "\t" << s << " -c <config file>.xml [input_files]+\t(Just run on these files)"
     	    << std::endl
+    	    << "\t" << s << " -b <benchmark file>.xml\t\t(Run synthetic storm benchmarks)"
+    	    << std::endl
+    	    << "\t" << s << " -k <kernel> [arguments]\t\t(Compare a kernel with the code it replaced)"
+    	    << std::endl
 	    << std::endl
 	    << "Optional arguments:"
     	    << std::endl
@@ -38,27 +45,16 @@ void usage(const char *s) {
 
 int main(int argc, char *argv[])
 {
-    // Increase the size of the stack to account for some of the large 3D array local variables
-    // (unless the user has already done it from the command line
-    // limit.rlim_max / 2 is arbitrary. But that works both on iMac and Linux
-  
-    struct rlimit limit;
-    getrlimit(RLIMIT_STACK, &limit);
-    if (limit.rlim_cur < limit.rlim_max / 2) {
-      limit.rlim_cur = limit.rlim_max / 2;
-      if ( setrlimit(RLIMIT_STACK, &limit) )
-	std::cout << "setrlimit failed. Set 'ulimit -s 48000' "
-		  << "in the shell if Vortrac crashes after reading the config file"
-		  << std::endl;
-    }
-
     // Handle options
     
     int opt;
     char *conf_file = NULL;
+    char *benchmark_file = NULL;
+    char *kernel_name = NULL;
     bool debug = false;
+    QStringList inputFiles;
     
-    while( (opt = getopt(argc, argv, "c:hd")) != -1)
+    while( (opt = getopt(argc, argv, "b:c:k:hd")) != -1)
     switch(opt){
     case 'd':
       debug = true;
@@ -66,6 +62,12 @@ int main(int argc, char *argv[])
     case 'c':
       conf_file = strdup(optarg);
       break;
+    case 'b':
+      benchmark_file = strdup(optarg);
+      break;
+    case 'k':
+      kernel_name = strdup(optarg);
+      break;
     case 'h':
     case '?':
       usage(argv[0]);
@@ -76,6 +78,26 @@ int main(int argc, char *argv[])
       std::cerr << "==>> conf_file: " << conf_file << std::endl;
     }
 
+    // Benchmarks make their own configurations, nothing else is needed
+    if (benchmark_file != NULL) {
+      std::cout << "Benchmark mode with " << benchmark_file << std::endl;
+      QCoreApplication app(argc, argv);
+      DriverBenchmark driver(QString::fromLocal8Bit(benchmark_file));
+      if (!driver.initialize())
+        return EXIT_FAILURE;
+      return driver.run();
+    }
+
+    // Kernel checks take their inputs from the remaining arguments
+    if (kernel_name != NULL) {
+      QCoreApplication app(argc, argv);
+      QStringList arguments;
+      for(int index = optind; index < argc; index++)
+        arguments << QString::fromLocal8Bit(argv[index]);
+      DriverKernelCheck driver(QString::fromLocal8Bit(kernel_name), arguments);
+      return driver.run();
+    }
+
     // A bit more complex than I'd like, but this preserves the historical usage
     // vortrac             <- GUI mode
     // vortrac file.xml    <- Batch mode
@@ -99,8 +121,11 @@ int main(int argc, char *argv[])
 	}
       } else {
 	std::cout << "Command mode. Running on these files:" << std::endl;
-	for(int index = optind; index < argc; index++)
+	for(int index = optind; index < argc; index++) {
 	  std::cout << "\t" << argv[index];
+	  inputFiles << QString::fromLocal8Bit(argv[index]);
+	}
+	std::cout << std::endl;
       }
     }
     
@@ -161,6 +186,20 @@ int main(int argc, char *argv[])
              }
          }
 
+        // Archive runs don't need any widgets, only the operational data
+        // feeds still go through the batch window
+        QString mode = root.firstChildElement("vortex").firstChildElement("mode").text();
+        if (mode != "operational") {
+            std::cout << "Headless batch mode started for " << xmlfile.toStdString() << " ...\n";
+            QCoreApplication app(argc, argv);
+            DriverHeadless driver(xmlfile, inputFiles);
+            if (!driver.initialize())
+                return EXIT_FAILURE;
+            return driver.run();
+        }
+        if (!inputFiles.isEmpty())
+            std::cout << "Input files are ignored in operational mode\n";
+
         std::cout << "Batch Mode started for " << xmlfile.toStdString() << " ...\n";
         QApplication app(argc,argv);
         BatchWindow mainWin(0, xmlfile);
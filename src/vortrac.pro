@@ -84,9 +84,12 @@ HEADERS += Threads/workThread.h \
            GUI/StormSignal.h \
            GUI/StartDialog.h \
            NRL/Hvvp.h \
+           NRL/HvvpService.h \
            IO/Message.h \
            IO/Log.h \
            IO/ATCF.h \
+           IO/RecordFile.h \
+           IO/VolumeMetrics.h \
            Radar/DateChecker.h \
            Radar/RadarFactory.h \
            Radar/LevelII.h \
@@ -99,6 +102,8 @@ HEADERS += Threads/workThread.h \
            NRL/RadarQC.h \
            Radar/RadarData.h \
            Radar/Ray.h \
+           Radar/MomentArena.h \
+           Radar/BeamGeometry.h \
            Radar/Sweep.h \
            VTD/VTD.h \
            VTD/GVTD.h \
@@ -106,6 +111,7 @@ HEADERS += Threads/workThread.h \
            VTD/mgbvtd.h \
            VTD/VTDFactory.h \
            Math/Matrix.h \
+           Math/LeastSquares.h \
            ChooseCenter.h \
            Pressure/PressureData.h \
            Pressure/PressureList.h \
@@ -117,6 +123,9 @@ HEADERS += Threads/workThread.h \
            Radar/FetchRemote.h \
            Batch/DriverBatch.h \
            Batch/BatchWindow.h \
+           Batch/DriverHeadless.h \
+           Batch/DriverBenchmark.h \
+           Batch/DriverKernelCheck.h \
            DriverAnalysis.h
 
 SOURCES += main.cpp \
@@ -149,9 +158,12 @@ SOURCES += main.cpp \
            GUI/StormSignal.cpp \
            GUI/StartDialog.cpp \
            NRL/Hvvp.cpp \
+           NRL/HvvpService.cpp \
            IO/Message.cpp \
            IO/Log.cpp \
            IO/ATCF.cpp \
+           IO/RecordFile.cpp \
+           IO/VolumeMetrics.cpp \
            Radar/DateChecker.cpp \
            Radar/RadarFactory.cpp \
            Radar/LevelII.cpp \
@@ -163,6 +175,8 @@ SOURCES += main.cpp \
            NRL/RadarQC.cpp \
            Radar/RadarData.cpp \
            Radar/Ray.cpp \
+           Radar/MomentArena.cpp \
+           Radar/BeamGeometry.cpp \
            Radar/Sweep.cpp \
            VTD/VTD.cpp \
            VTD/GVTD.cpp \
@@ -181,11 +195,22 @@ SOURCES += main.cpp \
            Radar/FetchRemote.cpp \
            Batch/DriverBatch.cpp \
            Batch/BatchWindow.cpp \
+           Batch/DriverHeadless.cpp \
+           Batch/DriverBenchmark.cpp \
+           Batch/DriverKernelCheck.cpp \
            DriverAnalysis.cpp
 
+# The serial quality control stages the sweep passes are checked against
+# ("vortrac -k qc") are not part of the normal build:
+#   qmake CONFIG+=kernelcheck
+kernelcheck {
+  DEFINES += VORTRAC_KERNEL_CHECK
+  SOURCES += NRL/RadarQCReference.cpp
+}
+
 RESOURCES += vortrac.qrc
 LIBS += -lRadx -lNcxx -lnetcdf -lhdf5_cpp -lhdf5 -larmadillo -lz -lbz2
-QT += xml network widgets
+QT += xml network widgets concurrent
 
 # CONFIG += debug
 #CONFIG -= app_bundle